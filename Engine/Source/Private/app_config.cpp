@@ -1,6 +1,9 @@
 #include "app_config.h"
 #include <GLFW/glfw3.h>
 
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include <stdexcept>
 
 
@@ -14,7 +17,52 @@ void app_config_init(AppConfig* config)
 	config->width = 800;
 	config->title = "Game";
 
+	config->asset_root = ".";
+	config->asset_pack = "assets.hpak";
+	config->shader_cache = "shader_cache";
+
+	config->asset_worker_count = 2;
+	config->asset_memory_budget = 64ull * 1024 * 1024;
+	config->asset_upload_budget_ms = 2.0;
+
+	// 16 MB holds a 2048x2048 RGBA8 image or a 4096x4096 BC7 level.
+	config->texture_upload_slot_count = 4;
+	config->texture_upload_slot_size = 16ull * 1024 * 1024;
+
+#if defined(ENGINE_DEBUG)
+	config->hot_reload = true;
+	config->gpu_profile = "gpu_profile.csv";
+#else
+	config->hot_reload = false;
+	config->gpu_profile = nullptr;
+#endif
+
+	config->headless = false;
+	config->frame_limit = 0;
+	config->null_backend = false;
+
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 }
+
+bool app_config_parse_args(AppConfig* config, int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--headless") == 0) {
+			config->headless = true;
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			config->frame_limit = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--null-backend") == 0) {
+			config->null_backend = true;
+		}
+		else {
+			std::cout << "ERROR::APP_CONFIG::UNKNOWN_ARGUMENT " << argv[i] << std::endl;
+			std::cout << "usage: [--headless] [--frames <count>] [--null-backend]" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
@@ -2,7 +2,113 @@
 #include "engine_config.h"
 #include "engine_arena.h"
 
-bool application_init(Application* app, Arena* global_storage) { 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+// Both stages are rebuilt together; rereads the loose files so edits win over a mounted pack.
+void reload_main_shader(const char*, void* user_data)
+{
+	Application* app = static_cast<Application*>(user_data);
+	const std::filesystem::path root = app->app_config.asset_root;
+	shader_reloader_request(app->shader_reloader, &app->renderer_interface->shader,
+		(root / "shader.vert").string().c_str(), (root / "shader.frag").string().c_str());
+}
+
+void reload_asset(const char*, void* user_data)
+{
+	const AssetReload* reload = static_cast<const AssetReload*>(user_data);
+	asset_stream_request(reload->stream, reload->request);
+}
+
+// Asset stream request hook. Assets are requested from the main thread, the one hot reload handlers
+// run on, so the handler list needs no lock.
+void watch_asset(const AssetRequest& request, void* user_data)
+{
+	Application* app = static_cast<Application*>(user_data);
+
+	// The watcher reports paths relative to asset_root; assets outside it are not watched.
+	const std::string watched = std::filesystem::path(request.path)
+		.lexically_relative(app->app_config.asset_root).generic_string();
+	if (watched.empty() || watched.compare(0, 2, "..") == 0) {
+		return;
+	}
+	// Several loads may share a file; each is reloaded.
+	for (const std::unique_ptr<AssetReload>& reload : app->asset_reloads) {
+		if (reload->request.path == request.path && reload->request.user_data == request.user_data) {
+			reload->request = request;
+			return;
+		}
+	}
+
+	app->asset_reloads.push_back(std::make_unique<AssetReload>(AssetReload{ app->asset_stream, request }));
+	hot_reload_register(app->hot_reload, watched.c_str(), reload_asset, app->asset_reloads.back().get());
+}
+
+// Asset stream forget hook.
+void unwatch_asset(void* request_user_data, void* user_data)
+{
+	Application* app = static_cast<Application*>(user_data);
+	std::erase_if(app->asset_reloads, [app, request_user_data](const std::unique_ptr<AssetReload>& reload) {
+		if (reload->request.user_data != request_user_data) {
+			return false;
+		}
+		hot_reload_unregister(app->hot_reload, reload_asset, reload.get());
+		return true;
+	});
+}
+
+// A window that is never shown, preferring GLFW's null platform so no display is needed at all. On
+// Mesa its EGL context is surfaceless (llvmpipe when there is no GPU) and OSMesa is the fallback;
+// without either, a hidden window on the native platform still works on a desktop.
+GLFWwindow* create_headless_window(const AppConfig* config)
+{
+	const int context_apis[] = { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API };
+	for (int platform : { GLFW_PLATFORM_NULL, GLFW_ANY_PLATFORM }) {
+		glfwTerminate();
+		glfwInitHint(GLFW_PLATFORM, platform);
+		if (!glfwInit()) {
+			continue;
+		}
+		for (int context_api : context_apis) {
+			// glfwInit reset the hints app_config_init set.
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+			glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, platform == GLFW_PLATFORM_NULL ? context_api : GLFW_NATIVE_CONTEXT_API);
+			if (GLFWwindow* window = glfwCreateWindow(config->width, config->height, config->title, nullptr, nullptr)) {
+				return window;
+			}
+			if (platform != GLFW_PLATFORM_NULL) {
+				break;
+			}
+		}
+	}
+	std::cout << "ERROR::APPLICATION::HEADLESS_CONTEXT_FAILED" << std::endl;
+	return nullptr;
+}
+
+// The null backend needs a window only for GLFW's input and timing, never a context.
+GLFWwindow* create_null_backend_window(const AppConfig* config)
+{
+	glfwTerminate();
+	glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+	if (!glfwInit()) {
+		std::cout << "ERROR::APPLICATION::NULL_PLATFORM_FAILED" << std::endl;
+		return nullptr;
+	}
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	return glfwCreateWindow(config->width, config->height, config->title, nullptr, nullptr);
+}
+
+} // namespace
+
+bool application_init(Application* app, Arena* global_storage, int argc, char** argv) { 
 	glfwInit();
 
 	if (!app) {
@@ -10,16 +116,77 @@ bool application_init(Application* app, Arena* global_storage) {
 	}
 
 	app_config_init(&app->app_config);
+	if (!app_config_parse_args(&app->app_config, argc, argv)) {
+		return false;
+	}
 
-	app->game_window = glfwCreateWindow(app->app_config.height, app->app_config.width,
-		app->app_config.title,nullptr, nullptr);
+	if (app->app_config.null_backend) {
+		app->game_window = create_null_backend_window(&app->app_config);
+		if (!app->game_window) {
+			return false;
+		}
+	}
+	else if (app->app_config.headless) {
+		app->game_window = create_headless_window(&app->app_config);
+		if (!app->game_window) {
+			return false;
+		}
+	}
+	else {
+		app->game_window = glfwCreateWindow(app->app_config.height, app->app_config.width,
+			app->app_config.title,nullptr, nullptr);
+	}
 	
+	// Loose files are the fallback; a pack, when present, overrides them.
+	app->vfs = engine_allocate<Vfs>(global_storage);
+	vfs_mount_directory(app->vfs, app->app_config.asset_root, 0);
+	if (std::filesystem::exists(app->app_config.asset_pack)) {
+		vfs_mount_pack(app->vfs, app->app_config.asset_pack, 10);
+	}
+
+	const char* vertex_source = vfs_load_text(app->vfs, asset_id("shader.vert"), global_storage);
+	const char* fragment_source = vfs_load_text(app->vfs, asset_id("shader.frag"), global_storage);
+
 	app->renderer_interface = engine_allocate<RendererInterface>(global_storage);
-	renderer_init(app->game_window, app->renderer_interface);
+	renderer_init(app->game_window, app->renderer_interface, vertex_source, fragment_source, app->app_config.shader_cache,
+		app->app_config.null_backend ? RENDER_BACKEND_NULL : RENDER_BACKEND_GL);
 
 	if (!app->renderer_interface) {
 		return false;
 	}
+	// The null platform's contexts have no default framebuffer, and a hidden window's is not
+	// guaranteed to be rendered to.
+	if (app->app_config.headless
+		&& !renderer_enable_offscreen(app->renderer_interface, app->app_config.width, app->app_config.height)) {
+		return false;
+	}
+
+	app->world = engine_allocate<EcsWorld>(global_storage);
+	ecs_init(app->world, global_storage);
+
+	app->texture_uploader = engine_allocate<TextureUploader>(global_storage);
+	texture_uploader_init(app->texture_uploader, app->app_config.texture_upload_slot_count,
+		app->app_config.texture_upload_slot_size);
+
+	app->asset_stream = engine_allocate<AssetStream>(global_storage);
+	asset_stream_init(app->asset_stream, app->app_config.asset_worker_count, app->app_config.asset_memory_budget);
+
+	if (app->app_config.hot_reload) {
+		app->shader_reloader = engine_allocate<ShaderReloader>(global_storage);
+		shader_reloader_init(app->shader_reloader, app->game_window);
+
+		app->hot_reload = engine_allocate<HotReload>(global_storage);
+		if (!hot_reload_init(app->hot_reload, app->app_config.asset_root)) {
+			app->hot_reload = nullptr;
+		}
+		else {
+			hot_reload_register(app->hot_reload, "shader.vert", reload_main_shader, app);
+			hot_reload_register(app->hot_reload, "shader.frag", reload_main_shader, app);
+			app->asset_stream->request_hook = watch_asset;
+			app->asset_stream->forget_hook = unwatch_asset;
+			app->asset_stream->hook_data = app;
+		}
+	}
 
 	return true;
 }
@@ -28,19 +195,75 @@ void application_run(Application* app, Arena* frame_arena)
 {
 	RT_ASSERT(frame_arena != nullptr, "Frame arena is nullptr");
 
-	while (!glfwWindowShouldClose(app->game_window)) {
+	using clock = std::chrono::steady_clock;
+	const unsigned int frame_limit = app->app_config.frame_limit;
+	unsigned int frames = 0;
+	double total_ms = 0.0;
+	double min_ms = 0.0;
+	double max_ms = 0.0;
+
+	while (!glfwWindowShouldClose(app->game_window) && (frame_limit == 0 || frames < frame_limit)) {
+		const clock::time_point frame_start = clock::now();
 		float deltaTime = 0;
-		renderer_draw_frame(app->game_window, app->renderer_interface, deltaTime);
+		if (app->hot_reload) {
+			hot_reload_update(app->hot_reload);
+		}
+		if (app->shader_reloader) {
+			shader_reloader_apply(app->shader_reloader);
+		}
+		texture_uploader_update(app->texture_uploader);
+		asset_stream_drain(app->asset_stream, app->app_config.asset_upload_budget_ms);
+		renderer_draw_frame(app->game_window, app->renderer_interface, frame_arena, deltaTime);
 		
-		renderer_swap_buffers(app->game_window);
+		// There is nothing to present to offscreen, and a surfaceless context can't swap.
+		if (!app->app_config.headless && !app->app_config.null_backend) {
+			renderer_swap_buffers(app->game_window);
+		}
 		renderer_poll_events();
 
 
 		engine_reset_arena(frame_arena);
+
+		const double frame_ms = std::chrono::duration<double, std::milli>(clock::now() - frame_start).count();
+		min_ms = frames == 0 ? frame_ms : std::min(min_ms, frame_ms);
+		max_ms = frames == 0 ? frame_ms : std::max(max_ms, frame_ms);
+		total_ms += frame_ms;
+		frames++;
+	}
+
+	if (frame_limit != 0 && frames > 0) {
+		std::cout << "Frames: " << frames << " average_ms: " << total_ms / frames
+			<< " min_ms: " << min_ms << " max_ms: " << max_ms << std::endl;
+	}
+	if (app->app_config.null_backend) {
+		const NullBackendStats& calls = app->renderer_interface->null_calls;
+		std::cout << "Null backend, last frame: calls: " << calls.calls << " draws: " << calls.draws
+			<< " instances: " << calls.instances << " barriers: " << calls.barriers << " errors: " << calls.errors << std::endl;
 	}
 }
 
 void application_end(Application* app)
 {
+	// Workers may be blocked waiting for a staging slot; release them before joining.
+	texture_uploader_stop(app->texture_uploader);
+	asset_stream_shutdown(app->asset_stream);
+	texture_uploader_shutdown(app->texture_uploader);
+	if (app->hot_reload) {
+		hot_reload_shutdown(app->hot_reload);
+	}
+	app->asset_reloads.clear();
+	if (app->shader_reloader) {
+		shader_reloader_shutdown(app->shader_reloader);
+	}
+	ecs_shutdown(app->world);
+	vfs_shutdown(app->vfs);
+	if (app->app_config.gpu_profile) {
+		gpu_profiler_export_csv(&app->renderer_interface->gpu_profiler, app->app_config.gpu_profile);
+	}
+	gpu_profiler_destroy(&app->renderer_interface->gpu_profiler);
+	stream_buffer_destroy(&app->renderer_interface->frame_stream);
+	geometry_pool_destroy(&app->renderer_interface->geometry);
+	render_graph_destroy(&app->renderer_interface->graph);
+	offscreen_target_destroy(&app->renderer_interface->offscreen);
 	renderer_cleanup();
 }
@@ -0,0 +1,368 @@
+#include "asset_pack.h"
+#include "engine_hash.h"
+#include "engine_lz4.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Compressed entries that don't save at least this much are stored raw so they can be mapped directly.
+constexpr double MIN_COMPRESSION_SAVING = 0.1;
+
+uint64 align_up(uint64 value, uint64 alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool map_file(AssetPack* pack, const char* path)
+{
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size{};
+	GetFileSizeEx(file, &size);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view) {
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	pack->file_handle = file;
+	pack->mapping_handle = mapping;
+	pack->base = static_cast<const char*>(view);
+	pack->size = static_cast<uint64>(size.QuadPart);
+	return true;
+#else
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info {};
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps the file alive.
+	close(fd);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+
+	pack->base = static_cast<const char*>(view);
+	pack->size = static_cast<uint64>(info.st_size);
+	return true;
+#endif
+}
+
+// offset + count * element_size <= size, written so it can't wrap.
+bool in_bounds(uint64 offset, uint64 count, uint64 element_size, uint64 size)
+{
+	return offset <= size && count <= (size - offset) / element_size;
+}
+
+// Everything asset_pack_read and asset_pack_view trust about an entry, checked once at open.
+bool entry_valid(const AssetPack* pack, const PackEntry& entry)
+{
+	const PackHeader* header = pack->header;
+	if (entry.name_offset >= header->names_size) {
+		return false;
+	}
+	if (!(entry.flags & PACK_ENTRY_COMPRESSED)) {
+		return in_bounds(entry.offset, entry.size, 1, pack->size);
+	}
+
+	if (!in_bounds(entry.first_chunk, entry.chunk_count, 1, header->chunk_count)) {
+		return false;
+	}
+	uint64 total = 0;
+	for (uint32 i = 0; i < entry.chunk_count; ++i) {
+		const PackChunk& chunk = pack->chunks[entry.first_chunk + i];
+		if (chunk.size > PACK_CHUNK_SIZE || chunk.stored_size > chunk.size
+			|| !in_bounds(chunk.offset, chunk.stored_size, 1, pack->size)) {
+			return false;
+		}
+		total += chunk.size;
+	}
+	return total == entry.size;
+}
+
+void write_padding(std::ofstream& out, uint64 target)
+{
+	static const char zeros[PACK_ALIGNMENT] = {};
+	uint64 position = static_cast<uint64>(out.tellp());
+	while (position < target) {
+		const uint64 count = std::min<uint64>(target - position, PACK_ALIGNMENT);
+		out.write(zeros, static_cast<std::streamsize>(count));
+		position += count;
+	}
+}
+
+} // namespace
+
+bool asset_pack_open(AssetPack* pack, const char* path)
+{
+	RT_ASSERT(pack != nullptr, "Asset pack is nullptr");
+
+	if (!map_file(pack, path)) {
+		std::cout << "ERROR::ASSET_PACK::OPEN_FAILED " << path << std::endl;
+		return false;
+	}
+
+	const PackHeader* header = reinterpret_cast<const PackHeader*>(pack->base);
+	// The name blob ends in a terminator so no name can run off its end.
+	const bool valid = pack->size >= sizeof(PackHeader)
+		&& header->magic == PACK_MAGIC
+		&& header->version == PACK_VERSION
+		&& in_bounds(header->toc_offset, header->entry_count, sizeof(PackEntry), pack->size)
+		&& in_bounds(header->chunk_table_offset, header->chunk_count, sizeof(PackChunk), pack->size)
+		&& in_bounds(header->names_offset, header->names_size, 1, pack->size)
+		&& (header->entry_count == 0 || (header->names_size > 0 && pack->base[header->names_offset + header->names_size - 1] == '\0'));
+
+	if (!valid) {
+		std::cout << "ERROR::ASSET_PACK::INVALID_HEADER " << path << std::endl;
+		asset_pack_close(pack);
+		return false;
+	}
+
+	pack->header = header;
+	pack->entries = reinterpret_cast<const PackEntry*>(pack->base + header->toc_offset);
+	pack->chunks = reinterpret_cast<const PackChunk*>(pack->base + header->chunk_table_offset);
+	pack->names = pack->base + header->names_offset;
+
+	for (uint32 i = 0; i < header->entry_count; ++i) {
+		if (!entry_valid(pack, pack->entries[i])) {
+			std::cout << "ERROR::ASSET_PACK::INVALID_ENTRY " << path << " entry " << i << std::endl;
+			asset_pack_close(pack);
+			return false;
+		}
+	}
+	return true;
+}
+
+void asset_pack_close(AssetPack* pack)
+{
+	if (!pack->base) {
+		return;
+	}
+
+#if defined(_WIN32)
+	UnmapViewOfFile(pack->base);
+	CloseHandle(pack->mapping_handle);
+	CloseHandle(pack->file_handle);
+#else
+	munmap(const_cast<char*>(pack->base), static_cast<size_t>(pack->size));
+#endif
+	*pack = {};
+}
+
+const PackEntry* asset_pack_find(const AssetPack* pack, uint64 path_hash)
+{
+	const PackEntry* begin = pack->entries;
+	const PackEntry* end = pack->entries + pack->header->entry_count;
+
+	const PackEntry* it = std::lower_bound(begin, end, path_hash,
+		[](const PackEntry& entry, uint64 hash) { return entry.path_hash < hash; });
+	return (it != end && it->path_hash == path_hash) ? it : nullptr;
+}
+
+const char* asset_pack_entry_name(const AssetPack* pack, const PackEntry* entry)
+{
+	return pack->names + entry->name_offset;
+}
+
+const void* asset_pack_view(const AssetPack* pack, const PackEntry* entry)
+{
+	if (entry->flags & PACK_ENTRY_COMPRESSED) {
+		return nullptr;
+	}
+	return pack->base + entry->offset;
+}
+
+bool asset_pack_read(const AssetPack* pack, const PackEntry* entry, void* destination)
+{
+	if (!(entry->flags & PACK_ENTRY_COMPRESSED)) {
+		std::memcpy(destination, pack->base + entry->offset, static_cast<std::size_t>(entry->size));
+		return true;
+	}
+
+	char* out = static_cast<char*>(destination);
+	for (uint32 i = 0; i < entry->chunk_count; ++i) {
+		const PackChunk& chunk = pack->chunks[entry->first_chunk + i];
+		const char* source = pack->base + chunk.offset;
+
+		if (chunk.stored_size == chunk.size) {
+			std::memcpy(out, source, chunk.size);
+		}
+		else if (lz4_decompress(source, chunk.stored_size, out, chunk.size) != static_cast<int64>(chunk.size)) {
+			std::cout << "ERROR::ASSET_PACK::CORRUPT_CHUNK " << asset_pack_entry_name(pack, entry) << std::endl;
+			return false;
+		}
+		out += chunk.size;
+	}
+	return true;
+}
+
+const void* asset_pack_load(const AssetPack* pack, const PackEntry* entry, Arena* arena)
+{
+	if (const void* view = asset_pack_view(pack, entry)) {
+		return view;
+	}
+
+	void* destination = engine_allocate_bytes(arena, static_cast<std::size_t>(entry->size), 16);
+	if (!destination || !asset_pack_read(pack, entry, destination)) {
+		return nullptr;
+	}
+	return destination;
+}
+
+void asset_pack_writer_add(AssetPackWriter* writer, const char* name, const void* data, std::size_t size, bool compress)
+{
+	AssetPackWriter::Source source{};
+	source.name = name;
+	std::replace(source.name.begin(), source.name.end(), '\\', '/');
+	source.data.assign(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+	source.compress = compress;
+	writer->sources.push_back(std::move(source));
+}
+
+bool asset_pack_writer_finish(AssetPackWriter* writer, const char* output_path)
+{
+	std::vector<AssetPackWriter::Source>& sources = writer->sources;
+
+	std::vector<PackEntry> entries(sources.size());
+	std::vector<PackChunk> chunks;
+	std::string names;
+
+	for (std::size_t i = 0; i < sources.size(); ++i) {
+		entries[i].path_hash = hash_path(sources[i].name.c_str(), sources[i].name.size());
+		entries[i].name_offset = static_cast<uint32>(names.size());
+		names.append(sources[i].name);
+		names.push_back('\0');
+	}
+
+	// Only the TOC is sorted by hash. Data keeps the order files were added in, so assets the packer
+	// places next to each other stay next to each other on disk.
+	std::vector<std::size_t> order(sources.size());
+	for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+		return entries[a].path_hash < entries[b].path_hash;
+	});
+	for (std::size_t i = 1; i < order.size(); ++i) {
+		if (entries[order[i]].path_hash == entries[order[i - 1]].path_hash) {
+			std::cout << "ERROR::ASSET_PACK::HASH_COLLISION " << sources[order[i]].name
+				<< " and " << sources[order[i - 1]].name << std::endl;
+			return false;
+		}
+	}
+
+	std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cout << "ERROR::ASSET_PACK::WRITE_FAILED " << output_path << std::endl;
+		return false;
+	}
+
+	PackHeader header{};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	std::vector<char> compressed(lz4_compress_bound(PACK_CHUNK_SIZE));
+
+	for (std::size_t index = 0; index < sources.size(); ++index) {
+		const AssetPackWriter::Source& source = sources[index];
+		PackEntry& entry = entries[index];
+
+		write_padding(out, align_up(static_cast<uint64>(out.tellp()), PACK_ALIGNMENT));
+		entry.offset = static_cast<uint64>(out.tellp());
+		entry.size = source.data.size();
+
+		if (source.compress && !source.data.empty()) {
+			const std::size_t first_chunk = chunks.size();
+			uint64 stored = 0;
+
+			for (std::size_t position = 0; position < source.data.size(); position += PACK_CHUNK_SIZE) {
+				const std::size_t size = std::min<std::size_t>(PACK_CHUNK_SIZE, source.data.size() - position);
+				std::size_t compressed_size = lz4_compress(source.data.data() + position, size,
+					compressed.data(), compressed.size());
+
+				PackChunk chunk{};
+				chunk.offset = static_cast<uint64>(out.tellp());
+				chunk.size = static_cast<uint32>(size);
+				// Incompressible chunks are stored as-is, flagged by stored_size == size.
+				if (compressed_size == 0 || compressed_size >= size) {
+					chunk.stored_size = chunk.size;
+					out.write(source.data.data() + position, static_cast<std::streamsize>(size));
+				}
+				else {
+					chunk.stored_size = static_cast<uint32>(compressed_size);
+					out.write(compressed.data(), static_cast<std::streamsize>(compressed_size));
+				}
+				stored += chunk.stored_size;
+				chunks.push_back(chunk);
+			}
+
+			if (static_cast<double>(stored) <= static_cast<double>(entry.size) * (1.0 - MIN_COMPRESSION_SAVING)) {
+				entry.flags = PACK_ENTRY_COMPRESSED;
+				entry.stored_size = stored;
+				entry.first_chunk = static_cast<uint32>(first_chunk);
+				entry.chunk_count = static_cast<uint32>(chunks.size() - first_chunk);
+				continue;
+			}
+
+			// Not worth it: rewind and store raw.
+			chunks.resize(first_chunk);
+			out.seekp(static_cast<std::streamoff>(entry.offset));
+		}
+
+		out.write(source.data.data(), static_cast<std::streamsize>(source.data.size()));
+		entry.stored_size = entry.size;
+	}
+
+	write_padding(out, align_up(static_cast<uint64>(out.tellp()), 16));
+	header.chunk_table_offset = static_cast<uint64>(out.tellp());
+	header.chunk_count = static_cast<uint32>(chunks.size());
+	out.write(reinterpret_cast<const char*>(chunks.data()), static_cast<std::streamsize>(chunks.size() * sizeof(PackChunk)));
+
+	header.toc_offset = static_cast<uint64>(out.tellp());
+	header.entry_count = static_cast<uint32>(entries.size());
+	for (std::size_t index : order) {
+		out.write(reinterpret_cast<const char*>(&entries[index]), sizeof(PackEntry));
+	}
+
+	header.names_offset = static_cast<uint64>(out.tellp());
+	header.names_size = names.size();
+	out.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	out.seekp(0);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	if (!out.good()) {
+		std::cout << "ERROR::ASSET_PACK::WRITE_FAILED " << output_path << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,297 @@
+#include "asset_stream.h"
+#include "engine_assert.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+bool read_file(const std::string& path, std::vector<char>* bytes)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+
+	const std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	bytes->resize(static_cast<std::size_t>(size));
+	return size == 0 || file.read(bytes->data(), size).good();
+}
+
+void release_memory(AssetStream* stream, AssetLoad* load)
+{
+	if (load->memory_bytes == 0) {
+		return;
+	}
+
+	{
+		// Taken so a worker can't miss the wakeup between checking the budget and waiting.
+		std::lock_guard lock(stream->request_mutex);
+		stream->memory_in_flight.fetch_sub(load->memory_bytes);
+	}
+	load->memory_bytes = 0;
+	stream->request_cv.notify_all();
+}
+
+void worker_main(AssetStream* stream, uint32 index)
+{
+	for (;;) {
+		std::unique_ptr<AssetLoad> load;
+		uint64 file_size = 0;
+
+		{
+			std::unique_lock lock(stream->request_mutex);
+
+			for (;;) {
+				stream->request_cv.wait(lock, [stream] { return !stream->running || !stream->requests.empty(); });
+				if (!stream->running) {
+					return;
+				}
+
+				std::error_code error;
+				file_size = std::filesystem::file_size(stream->requests.top().load->request.path, error);
+				if (error) {
+					file_size = 0;
+				}
+
+				// Wait for uploads to hand memory back, unless nothing is in flight and the asset
+				// is simply larger than the whole budget.
+				const uint64 in_flight = stream->memory_in_flight.load();
+				if (in_flight == 0 || in_flight + file_size <= stream->memory_budget) {
+					break;
+				}
+				stream->request_cv.wait(lock);
+			}
+
+			load = std::move(const_cast<AssetStream::Pending&>(stream->requests.top()).load);
+			stream->requests.pop();
+
+			load->memory_bytes = file_size;
+			stream->memory_in_flight.fetch_add(file_size);
+			stream->decoding[index] = load.get();
+		}
+
+		bool ok = read_file(load->request.path, &load->bytes);
+		if (ok && load->request.decode) {
+			ok = load->request.decode(load.get());
+		}
+
+		{
+			// asset_stream_forget may have cancelled it meanwhile.
+			std::lock_guard lock(stream->request_mutex);
+			stream->decoding[index] = nullptr;
+			if (load->status != ASSET_STATUS_CANCELLED) {
+				load->status = ok ? ASSET_STATUS_LOADED : ASSET_STATUS_FAILED;
+			}
+		}
+
+		std::lock_guard lock(stream->completed_mutex);
+		stream->completed.push_back(std::move(load));
+	}
+}
+
+} // namespace
+
+void asset_stream_init(AssetStream* stream, uint32 worker_count, uint64 memory_budget)
+{
+	RT_ASSERT(stream != nullptr, "Asset stream is nullptr");
+	RT_ASSERT(worker_count > 0, "Asset stream needs at least one worker");
+
+	stream->memory_budget = memory_budget;
+	stream->running = true;
+
+	stream->decoding.assign(worker_count, nullptr);
+	stream->workers.reserve(worker_count);
+	for (uint32 i = 0; i < worker_count; ++i) {
+		stream->workers.emplace_back(worker_main, stream, i);
+	}
+}
+
+void asset_stream_shutdown(AssetStream* stream)
+{
+	{
+		std::lock_guard lock(stream->request_mutex);
+		stream->running = false;
+	}
+	stream->request_cv.notify_all();
+
+	for (std::thread& worker : stream->workers) {
+		worker.join();
+	}
+	stream->workers.clear();
+
+	stream->requests = {};
+	stream->completed.clear();
+	stream->decoding.clear();
+	stream->memory_in_flight = 0;
+}
+
+void asset_stream_request(AssetStream* stream, AssetRequest request)
+{
+	RT_ASSERT(stream != nullptr, "Asset stream is nullptr");
+
+	if (stream->request_hook) {
+		stream->request_hook(request, stream->hook_data);
+	}
+
+	auto load = std::make_unique<AssetLoad>();
+	const AssetPriority priority = request.priority;
+	load->request = std::move(request);
+
+	{
+		std::lock_guard lock(stream->request_mutex);
+		stream->requests.push({ priority, stream->next_sequence++, std::move(load) });
+	}
+	stream->requested++;
+	stream->request_cv.notify_one();
+}
+
+void asset_stream_forget(AssetStream* stream, void* user_data)
+{
+	RT_ASSERT(stream != nullptr, "Asset stream is nullptr");
+	RT_ASSERT(user_data != nullptr, "Only requests with user_data can be forgotten");
+
+	if (stream->forget_hook) {
+		stream->forget_hook(user_data, stream->hook_data);
+	}
+
+	uint32 cancelled = 0;
+	{
+		std::lock_guard lock(stream->request_mutex);
+
+		std::priority_queue<AssetStream::Pending> kept;
+		while (!stream->requests.empty()) {
+			AssetStream::Pending& pending = const_cast<AssetStream::Pending&>(stream->requests.top());
+			if (pending.load->request.user_data == user_data) {
+				++cancelled;
+			}
+			else {
+				kept.push(std::move(pending));
+			}
+			stream->requests.pop();
+		}
+		stream->requests = std::move(kept);
+
+		// Decode never touches user_data, so a load a worker is on can finish; it is dropped when drained.
+		for (AssetLoad* load : stream->decoding) {
+			if (load && load->request.user_data == user_data) {
+				load->status = ASSET_STATUS_CANCELLED;
+				++cancelled;
+			}
+		}
+	}
+
+	std::vector<std::unique_ptr<AssetLoad>> dropped;
+	{
+		std::lock_guard lock(stream->completed_mutex);
+		auto it = std::stable_partition(stream->completed.begin(), stream->completed.end(),
+			[user_data](const std::unique_ptr<AssetLoad>& load) {
+				return load->request.user_data != user_data || load->status == ASSET_STATUS_CANCELLED;
+			});
+		dropped.assign(std::make_move_iterator(it), std::make_move_iterator(stream->completed.end()));
+		stream->completed.erase(it, stream->completed.end());
+	}
+	for (std::unique_ptr<AssetLoad>& load : dropped) {
+		release_memory(stream, load.get());
+		++cancelled;
+	}
+	// Called from an upload callback: the rest of the loads asset_stream_drain took are still ahead.
+	for (std::size_t i = stream->upload_next; i < stream->uploading.size(); ++i) {
+		AssetLoad* load = stream->uploading[i].get();
+		if (load->request.user_data == user_data && load->status != ASSET_STATUS_CANCELLED) {
+			release_memory(stream, load);
+			load->status = ASSET_STATUS_CANCELLED;
+			load->decoded.reset();
+			++cancelled;
+		}
+	}
+	stream->cancelled += cancelled;
+}
+
+uint32 asset_stream_drain(AssetStream* stream, double time_budget_ms)
+{
+	RT_ASSERT(stream != nullptr, "Asset stream is nullptr");
+
+	using clock = std::chrono::steady_clock;
+	const clock::time_point start = clock::now();
+
+	std::vector<std::unique_ptr<AssetLoad>>& ready = stream->uploading;
+	{
+		std::lock_guard lock(stream->completed_mutex);
+		if (stream->completed.empty()) {
+			return 0;
+		}
+		ready.swap(stream->completed);
+	}
+
+	// Workers finish out of order; upload the most important assets first.
+	std::stable_sort(ready.begin(), ready.end(), [](const auto& a, const auto& b) {
+		return a->request.priority < b->request.priority;
+	});
+
+	uint32 uploaded = 0;
+	std::size_t i = 0;
+	for (; i < ready.size(); ++i) {
+		if (uploaded > 0) {
+			const std::chrono::duration<double, std::milli> elapsed = clock::now() - start;
+			if (elapsed.count() >= time_budget_ms) {
+				break;
+			}
+		}
+
+		AssetLoad* load = ready[i].get();
+		// An upload callback may forget what comes after it.
+		stream->upload_next = i + 1;
+		if (load->status == ASSET_STATUS_CANCELLED) {
+			release_memory(stream, load);
+			continue;
+		}
+		if (load->status == ASSET_STATUS_LOADED) {
+			if (load->request.upload) {
+				load->request.upload(load);
+			}
+			stream->uploaded++;
+		}
+		else {
+			std::cout << "ERROR::ASSET_STREAM::LOAD_FAILED " << load->request.path << std::endl;
+			stream->failed++;
+		}
+
+		release_memory(stream, load);
+		++uploaded;
+	}
+
+	// Whatever did not fit in this frame's budget goes back in front of newer completions.
+	for (std::size_t j = i; j < ready.size(); ++j) {
+		if (ready[j]->status == ASSET_STATUS_CANCELLED) {
+			release_memory(stream, ready[j].get());
+		}
+	}
+	ready.erase(std::remove_if(ready.begin() + i, ready.end(),
+		[](const std::unique_ptr<AssetLoad>& load) { return load->status == ASSET_STATUS_CANCELLED; }), ready.end());
+	if (i < ready.size()) {
+		std::lock_guard lock(stream->completed_mutex);
+		stream->completed.insert(stream->completed.begin(),
+			std::make_move_iterator(ready.begin() + i), std::make_move_iterator(ready.end()));
+	}
+	ready.clear();
+	stream->upload_next = 0;
+
+	return uploaded;
+}
+
+AssetStreamStats asset_stream_stats(AssetStream* stream)
+{
+	AssetStreamStats stats{};
+	stats.requested = stream->requested.load();
+	stats.uploaded = stream->uploaded.load();
+	stats.failed = stream->failed.load();
+	stats.cancelled = stream->cancelled.load();
+	stats.pending = stats.requested - stats.uploaded - stats.failed - stats.cancelled;
+	stats.memory_in_flight = stream->memory_in_flight.load();
+	return stats;
+}
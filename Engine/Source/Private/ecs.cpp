@@ -0,0 +1,528 @@
+#include "ecs.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+enum EcsCommandType : uint32 {
+	ECS_COMMAND_CREATE,
+	ECS_COMMAND_DESTROY,
+	ECS_COMMAND_ADD,
+	ECS_COMMAND_REMOVE
+};
+
+// Followed by size bytes of component value, padded to alignof(EcsCommand).
+struct EcsCommand {
+	EcsCommandType type;
+	uint32 component;
+	Entity entity;
+	EcsComponentMask mask;
+	uint32 size;
+	uint32 padding;
+};
+
+uint32 align_up(uint32 value, uint32 alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Lays out capacity entities and returns the bytes they need.
+uint32 layout_chunk(const EcsWorld* world, EcsArchetype* archetype, uint32 capacity)
+{
+	uint32 offset = static_cast<uint32>(sizeof(Entity)) * capacity;
+	for (uint32 component : archetype->components) {
+		const EcsComponentInfo& info = world->components[component];
+		offset = align_up(offset, std::max(ECS_COLUMN_ALIGNMENT, info.alignment));
+		archetype->offsets[component] = offset;
+		offset += info.size * capacity;
+	}
+	return offset;
+}
+
+uint32 find_archetype(EcsWorld* world, EcsComponentMask mask)
+{
+	const auto found = world->archetype_lookup.find(mask);
+	if (found != world->archetype_lookup.end()) {
+		return found->second;
+	}
+
+	EcsArchetype archetype{};
+	archetype.mask = mask;
+	uint32 entity_bytes = sizeof(Entity);
+	for (uint32 component = 0; component < ECS_MAX_COMPONENTS; ++component) {
+		archetype.offsets[component] = ECS_NONE;
+		archetype.add_edge[component] = ECS_NONE;
+		archetype.remove_edge[component] = ECS_NONE;
+		if (mask & ecs_mask(component)) {
+			RT_ASSERT(component < world->component_count, "Archetype uses an unregistered component");
+			archetype.components.push_back(component);
+			entity_bytes += world->components[component].size;
+		}
+	}
+	// Start from what fits without padding and back off until the aligned columns fit too.
+	archetype.capacity = ECS_CHUNK_SIZE / entity_bytes;
+	while (archetype.capacity > 0 && layout_chunk(world, &archetype, archetype.capacity) > ECS_CHUNK_SIZE) {
+		--archetype.capacity;
+	}
+	RT_ASSERT(archetype.capacity > 0, "Components do not fit in a chunk");
+
+	const uint32 index = static_cast<uint32>(world->archetypes.size());
+	world->archetypes.push_back(std::move(archetype));
+	world->archetype_lookup.emplace(mask, index);
+	return index;
+}
+
+uint32 archetype_with(EcsWorld* world, uint32 from, uint32 component)
+{
+	uint32 to = world->archetypes[from].add_edge[component];
+	if (to == ECS_NONE) {
+		to = find_archetype(world, world->archetypes[from].mask | ecs_mask(component));
+		world->archetypes[from].add_edge[component] = to;
+	}
+	return to;
+}
+
+uint32 archetype_without(EcsWorld* world, uint32 from, uint32 component)
+{
+	uint32 to = world->archetypes[from].remove_edge[component];
+	if (to == ECS_NONE) {
+		to = find_archetype(world, world->archetypes[from].mask & ~ecs_mask(component));
+		world->archetypes[from].remove_edge[component] = to;
+	}
+	return to;
+}
+
+uint8* column(const EcsWorld* world, const EcsArchetype* archetype, const EcsChunk& chunk, uint32 component, uint32 row)
+{
+	return chunk.data + archetype->offsets[component] + static_cast<std::size_t>(world->components[component].size) * row;
+}
+
+// Appends a row with zeroed components for entity and returns its record.
+EcsEntityRecord push_row(EcsWorld* world, uint32 archetype_index, Entity entity)
+{
+	EcsArchetype* archetype = &world->archetypes[archetype_index];
+	if (archetype->chunks.empty() || archetype->chunks.back().count == archetype->capacity) {
+		uint8* data = nullptr;
+		if (!world->free_chunks.empty()) {
+			data = world->free_chunks.back();
+			world->free_chunks.pop_back();
+		}
+		else {
+			data = static_cast<uint8*>(engine_allocate_bytes(world->storage, ECS_CHUNK_SIZE, ECS_COLUMN_ALIGNMENT));
+		}
+		archetype->chunks.push_back({ data, 0 });
+	}
+
+	EcsChunk& chunk = archetype->chunks.back();
+	const uint32 row = chunk.count++;
+	++archetype->count;
+	reinterpret_cast<Entity*>(chunk.data)[row] = entity;
+	for (uint32 component : archetype->components) {
+		std::memset(column(world, archetype, chunk, component, row), 0, world->components[component].size);
+	}
+	return { archetype_index, static_cast<uint32>(archetype->chunks.size() - 1), row, entity.generation };
+}
+
+// Fills the hole with the archetype's last entity so only the last chunk is ever partly empty.
+void remove_row(EcsWorld* world, uint32 archetype_index, uint32 chunk_index, uint32 row)
+{
+	EcsArchetype* archetype = &world->archetypes[archetype_index];
+	EcsChunk& last = archetype->chunks.back();
+	const uint32 last_chunk = static_cast<uint32>(archetype->chunks.size() - 1);
+	const uint32 last_row = last.count - 1;
+
+	if (chunk_index != last_chunk || row != last_row) {
+		EcsChunk& chunk = archetype->chunks[chunk_index];
+		const Entity moved = reinterpret_cast<Entity*>(last.data)[last_row];
+		reinterpret_cast<Entity*>(chunk.data)[row] = moved;
+		for (uint32 component : archetype->components) {
+			std::memcpy(column(world, archetype, chunk, component, row), column(world, archetype, last, component, last_row),
+				world->components[component].size);
+		}
+		world->entities[moved.index].chunk = chunk_index;
+		world->entities[moved.index].row = row;
+	}
+
+	--last.count;
+	--archetype->count;
+	if (last.count == 0) {
+		world->free_chunks.push_back(last.data);
+		archetype->chunks.pop_back();
+	}
+}
+
+void move_entity(EcsWorld* world, Entity entity, uint32 to)
+{
+	EcsEntityRecord* record = &world->entities[entity.index];
+	const uint32 from = record->archetype;
+	const EcsEntityRecord moved = push_row(world, to, entity);
+
+	const EcsArchetype* source = &world->archetypes[from];
+	const EcsArchetype* target = &world->archetypes[to];
+	const EcsChunk& source_chunk = source->chunks[record->chunk];
+	const EcsChunk& target_chunk = target->chunks[moved.chunk];
+	for (uint32 component : target->components) {
+		if (source->offsets[component] != ECS_NONE) {
+			std::memcpy(column(world, target, target_chunk, component, moved.row),
+				column(world, source, source_chunk, component, record->row), world->components[component].size);
+		}
+	}
+
+	remove_row(world, from, record->chunk, record->row);
+	*record = moved;
+}
+
+Entity reserve_entity(EcsWorld* world)
+{
+	std::lock_guard<std::mutex> lock(world->entity_mutex);
+	uint32 index = world->next_entity;
+	if (!world->free_entities.empty()) {
+		index = world->free_entities.back();
+		world->free_entities.pop_back();
+	}
+	else {
+		++world->next_entity;
+	}
+	return { index, index < world->entities.size() ? world->entities[index].generation : 0 };
+}
+
+void grow_entities(EcsWorld* world, Entity entity)
+{
+	if (entity.index >= world->entities.size()) {
+		world->entities.resize(static_cast<std::size_t>(entity.index) + 1, { ECS_NONE, 0, 0, 0 });
+	}
+}
+
+void place_entity(EcsWorld* world, Entity entity, EcsComponentMask mask)
+{
+	grow_entities(world, entity);
+	world->entities[entity.index] = push_row(world, find_archetype(world, mask), entity);
+	++world->entity_count;
+}
+
+void free_entity(EcsWorld* world, Entity entity)
+{
+	EcsEntityRecord* record = &world->entities[entity.index];
+	remove_row(world, record->archetype, record->chunk, record->row);
+	--world->entity_count;
+	record->archetype = ECS_NONE;
+	record->generation = entity.generation + 1;
+	world->free_entities.push_back(entity.index);
+}
+
+void assert_not_iterating(const EcsWorld* world)
+{
+	RT_ASSERT(world->iterating.load(std::memory_order_relaxed) == 0, "Structural change while a query is running; use a command buffer");
+}
+
+void update_query(const EcsWorld* world, EcsQuery* query)
+{
+	for (uint32 i = query->archetypes_seen; i < world->archetypes.size(); ++i) {
+		const EcsComponentMask mask = world->archetypes[i].mask;
+		if ((mask & query->all) == query->all && (mask & query->none) == 0) {
+			query->archetypes.push_back(i);
+		}
+	}
+	query->archetypes_seen = static_cast<uint32>(world->archetypes.size());
+}
+
+struct ChunkJob {
+	const EcsChunkView* views;
+	EcsChunkFn function;
+	void* user_data;
+};
+
+void run_chunks(void* user_data, uint32 begin, uint32 end)
+{
+	const ChunkJob* job = static_cast<const ChunkJob*>(user_data);
+	for (uint32 i = begin; i < end; ++i) {
+		job->function(job->user_data, &job->views[i]);
+	}
+}
+
+void append_command(EcsCommandBuffer* commands, const EcsCommand& command, const void* value)
+{
+	const std::size_t at = commands->data.size();
+	const std::size_t padded = align_up(command.size, alignof(EcsCommand));
+	commands->data.resize(at + sizeof(EcsCommand) + padded);
+	std::memcpy(commands->data.data() + at, &command, sizeof(EcsCommand));
+	if (command.size > 0) {
+		std::memcpy(commands->data.data() + at + sizeof(EcsCommand), value, command.size);
+	}
+	++commands->count;
+}
+
+struct PhaseJob {
+	EcsWorld* world;
+	EcsSchedule* schedule;
+	uint32 begin;
+};
+
+void run_systems(void* user_data, uint32 begin, uint32 end)
+{
+	const PhaseJob* job = static_cast<const PhaseJob*>(user_data);
+	for (uint32 i = job->begin + begin; i < job->begin + end; ++i) {
+		const EcsSystem& system = job->schedule->systems[i];
+		system.function(job->world, &job->schedule->commands[i], system.user_data);
+	}
+}
+
+bool systems_conflict(const EcsSystem& a, const EcsSystem& b)
+{
+	return (a.writes & (b.reads | b.writes)) != 0 || (b.writes & a.reads) != 0;
+}
+
+} // namespace
+
+void ecs_init(EcsWorld* world, Arena* storage)
+{
+	RT_ASSERT(world != nullptr && storage != nullptr, "ECS world needs storage for its chunks");
+	world->storage = storage;
+	find_archetype(world, 0);
+}
+
+void ecs_shutdown(EcsWorld* world)
+{
+	assert_not_iterating(world);
+	// Swapped with empty containers to free their memory; clear() would keep it.
+	std::vector<EcsArchetype>().swap(world->archetypes);
+	std::unordered_map<EcsComponentMask, uint32>().swap(world->archetype_lookup);
+	std::vector<uint8*>().swap(world->free_chunks);
+	std::vector<EcsEntityRecord>().swap(world->entities);
+	std::vector<uint32>().swap(world->free_entities);
+	world->next_entity = 0;
+	world->entity_count = 0;
+	world->component_count = 0;
+}
+
+uint32 ecs_register_component(EcsWorld* world, const char* name, uint32 size, uint32 alignment)
+{
+	RT_ASSERT(world->component_count < ECS_MAX_COMPONENTS, "Too many component types");
+	RT_ASSERT(alignment <= ECS_COLUMN_ALIGNMENT, "Component alignment exceeds the chunk's");
+	const uint32 component = world->component_count++;
+	world->components[component] = { name, size, alignment };
+	return component;
+}
+
+Entity ecs_create(EcsWorld* world, EcsComponentMask mask)
+{
+	assert_not_iterating(world);
+	const Entity entity = reserve_entity(world);
+	place_entity(world, entity, mask);
+	return entity;
+}
+
+void ecs_destroy(EcsWorld* world, Entity entity)
+{
+	assert_not_iterating(world);
+	if (ecs_alive(world, entity)) {
+		free_entity(world, entity);
+	}
+}
+
+bool ecs_alive(const EcsWorld* world, Entity entity)
+{
+	return entity.index < world->entities.size()
+		&& world->entities[entity.index].generation == entity.generation
+		&& world->entities[entity.index].archetype != ECS_NONE;
+}
+
+void ecs_add(EcsWorld* world, Entity entity, uint32 component)
+{
+	assert_not_iterating(world);
+	if (!ecs_alive(world, entity) || ecs_has(world, entity, component)) {
+		return;
+	}
+	move_entity(world, entity, archetype_with(world, world->entities[entity.index].archetype, component));
+}
+
+void ecs_remove(EcsWorld* world, Entity entity, uint32 component)
+{
+	assert_not_iterating(world);
+	if (!ecs_has(world, entity, component)) {
+		return;
+	}
+	move_entity(world, entity, archetype_without(world, world->entities[entity.index].archetype, component));
+}
+
+bool ecs_has(const EcsWorld* world, Entity entity, uint32 component)
+{
+	return ecs_alive(world, entity) && (world->archetypes[world->entities[entity.index].archetype].mask & ecs_mask(component)) != 0;
+}
+
+void* ecs_get(EcsWorld* world, Entity entity, uint32 component)
+{
+	if (!ecs_has(world, entity, component)) {
+		return nullptr;
+	}
+	const EcsEntityRecord& record = world->entities[entity.index];
+	const EcsArchetype* archetype = &world->archetypes[record.archetype];
+	return column(world, archetype, archetype->chunks[record.chunk], component, record.row);
+}
+
+EcsQuery ecs_query(EcsComponentMask all, EcsComponentMask none)
+{
+	EcsQuery query{};
+	query.all = all;
+	query.none = none;
+	return query;
+}
+
+void ecs_query_for_each(EcsWorld* world, EcsQuery* query, EcsChunkFn function, void* user_data, JobSystem* jobs)
+{
+	update_query(world, query);
+	world->iterating.fetch_add(1, std::memory_order_relaxed);
+
+	if (!jobs) {
+		for (uint32 archetype_index : query->archetypes) {
+			const EcsArchetype* archetype = &world->archetypes[archetype_index];
+			for (const EcsChunk& chunk : archetype->chunks) {
+				const EcsChunkView view{ archetype, chunk.data, chunk.count };
+				function(user_data, &view);
+			}
+		}
+	}
+	else {
+		std::vector<EcsChunkView> views;
+		for (uint32 archetype_index : query->archetypes) {
+			const EcsArchetype* archetype = &world->archetypes[archetype_index];
+			for (const EcsChunk& chunk : archetype->chunks) {
+				views.push_back({ archetype, chunk.data, chunk.count });
+			}
+		}
+		ChunkJob job{ views.data(), function, user_data };
+		job_system_parallel_for(jobs, static_cast<uint32>(views.size()), 4, run_chunks, &job);
+	}
+
+	world->iterating.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint32 ecs_query_count(EcsWorld* world, EcsQuery* query)
+{
+	update_query(world, query);
+	uint32 count = 0;
+	for (uint32 archetype_index : query->archetypes) {
+		count += world->archetypes[archetype_index].count;
+	}
+	return count;
+}
+
+Entity ecs_commands_create(EcsCommandBuffer* commands, EcsWorld* world, EcsComponentMask mask)
+{
+	const Entity entity = reserve_entity(world);
+	append_command(commands, { ECS_COMMAND_CREATE, 0, entity, mask, 0, 0 }, nullptr);
+	return entity;
+}
+
+void ecs_commands_destroy(EcsCommandBuffer* commands, Entity entity)
+{
+	append_command(commands, { ECS_COMMAND_DESTROY, 0, entity, 0, 0, 0 }, nullptr);
+}
+
+void ecs_commands_add(EcsCommandBuffer* commands, Entity entity, uint32 component, const void* value, uint32 size)
+{
+	append_command(commands, { ECS_COMMAND_ADD, component, entity, 0, value ? size : 0, 0 }, value);
+}
+
+void ecs_commands_remove(EcsCommandBuffer* commands, Entity entity, uint32 component)
+{
+	append_command(commands, { ECS_COMMAND_REMOVE, component, entity, 0, 0, 0 }, nullptr);
+}
+
+void ecs_commands_apply(EcsWorld* world, EcsCommandBuffer* commands)
+{
+	assert_not_iterating(world);
+	std::size_t at = 0;
+	while (at < commands->data.size()) {
+		EcsCommand command;
+		std::memcpy(&command, commands->data.data() + at, sizeof(EcsCommand));
+		const uint8* value = commands->data.data() + at + sizeof(EcsCommand);
+		at += sizeof(EcsCommand) + align_up(command.size, alignof(EcsCommand));
+
+		switch (command.type) {
+		case ECS_COMMAND_CREATE:
+			place_entity(world, command.entity, command.mask);
+			break;
+		case ECS_COMMAND_DESTROY:
+			if (ecs_alive(world, command.entity)) {
+				free_entity(world, command.entity);
+			}
+			break;
+		case ECS_COMMAND_ADD:
+			ecs_add(world, command.entity, command.component);
+			if (command.size > 0 && ecs_has(world, command.entity, command.component)) {
+				RT_ASSERT(command.size == world->components[command.component].size, "Command value does not match the component's size");
+				std::memcpy(ecs_get(world, command.entity, command.component), value, command.size);
+			}
+			break;
+		case ECS_COMMAND_REMOVE:
+			ecs_remove(world, command.entity, command.component);
+			break;
+		}
+	}
+	commands->data.clear();
+	commands->count = 0;
+}
+
+void ecs_commands_discard(EcsWorld* world, EcsCommandBuffer* commands)
+{
+	assert_not_iterating(world);
+	std::size_t at = 0;
+	while (at < commands->data.size()) {
+		EcsCommand command;
+		std::memcpy(&command, commands->data.data() + at, sizeof(EcsCommand));
+		at += sizeof(EcsCommand) + align_up(command.size, alignof(EcsCommand));
+
+		if (command.type == ECS_COMMAND_CREATE) {
+			// Bumped like a destroyed entity's, so handles to the reservation never resolve.
+			grow_entities(world, command.entity);
+			world->entities[command.entity.index].generation = command.entity.generation + 1;
+			std::lock_guard<std::mutex> lock(world->entity_mutex);
+			world->free_entities.push_back(command.entity.index);
+		}
+	}
+	commands->data.clear();
+	commands->count = 0;
+}
+
+void ecs_schedule_build(EcsSchedule* schedule, const EcsSystem* systems, uint32 count)
+{
+	std::vector<uint32> phase(count, 0);
+	uint32 phase_count = 0;
+	for (uint32 j = 0; j < count; ++j) {
+		for (uint32 i = 0; i < j; ++i) {
+			if (systems_conflict(systems[i], systems[j])) {
+				phase[j] = std::max(phase[j], phase[i] + 1);
+			}
+		}
+		phase_count = std::max(phase_count, phase[j] + 1);
+	}
+
+	schedule->systems.clear();
+	schedule->phases.clear();
+	for (uint32 p = 0; p < phase_count; ++p) {
+		schedule->phases.push_back(static_cast<uint32>(schedule->systems.size()));
+		for (uint32 i = 0; i < count; ++i) {
+			if (phase[i] == p) {
+				schedule->systems.push_back(systems[i]);
+			}
+		}
+	}
+	schedule->commands.assign(count, EcsCommandBuffer{});
+}
+
+void ecs_schedule_run(EcsWorld* world, EcsSchedule* schedule, JobSystem* jobs)
+{
+	const uint32 system_count = static_cast<uint32>(schedule->systems.size());
+	for (uint32 p = 0; p < schedule->phases.size(); ++p) {
+		const uint32 begin = schedule->phases[p];
+		const uint32 end = p + 1 < schedule->phases.size() ? schedule->phases[p + 1] : system_count;
+		PhaseJob job{ world, schedule, begin };
+		job_system_parallel_for(jobs, end - begin, 1, run_systems, &job);
+		for (uint32 i = begin; i < end; ++i) {
+			ecs_commands_apply(world, &schedule->commands[i]);
+		}
+	}
+}
@@ -0,0 +1,174 @@
+#include "engine_lz4.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t MIN_MATCH = 4;
+constexpr std::size_t LAST_LITERALS = 5;
+constexpr std::size_t MATCH_FIND_LIMIT = 12;
+constexpr std::size_t MAX_OFFSET = 65535;
+constexpr uint32 HASH_BITS = 12;
+
+uint32 read32(const uint8* p)
+{
+	uint32 value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+uint32 hash_sequence(uint32 sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+bool write_length(uint8*& op, const uint8* end, std::size_t length)
+{
+	while (length >= 255) {
+		if (op >= end) return false;
+		*op++ = 255;
+		length -= 255;
+	}
+	if (op >= end) return false;
+	*op++ = static_cast<uint8>(length);
+	return true;
+}
+
+bool emit_sequence(uint8*& op, const uint8* end, const uint8* literals, std::size_t literal_length,
+	std::size_t offset, std::size_t match_length)
+{
+	if (op >= end) return false;
+	uint8* token = op++;
+
+	*token = static_cast<uint8>((literal_length >= 15 ? 15 : literal_length) << 4);
+	if (literal_length >= 15 && !write_length(op, end, literal_length - 15)) return false;
+
+	if (static_cast<std::size_t>(end - op) < literal_length) return false;
+	if (literal_length > 0) {
+		std::memcpy(op, literals, literal_length);
+		op += literal_length;
+	}
+
+	if (match_length == 0) {
+		return true;
+	}
+
+	if (end - op < 2) return false;
+	*op++ = static_cast<uint8>(offset & 0xFF);
+	*op++ = static_cast<uint8>(offset >> 8);
+
+	const std::size_t encoded = match_length - MIN_MATCH;
+	*token |= static_cast<uint8>(encoded >= 15 ? 15 : encoded);
+	if (encoded >= 15 && !write_length(op, end, encoded - 15)) return false;
+	return true;
+}
+
+} // namespace
+
+std::size_t lz4_compress(const void* source, std::size_t size, void* destination, std::size_t capacity)
+{
+	const uint8* src = static_cast<const uint8*>(source);
+	uint8* op = static_cast<uint8*>(destination);
+	const uint8* op_end = op + capacity;
+
+	std::size_t anchor = 0;
+
+	if (size >= MATCH_FIND_LIMIT + 1) {
+		// Positions are stored +1 so zero means empty.
+		std::vector<uint32> table(std::size_t(1) << HASH_BITS, 0);
+		const std::size_t match_limit = size - MATCH_FIND_LIMIT;
+		const std::size_t extend_limit = size - LAST_LITERALS;
+
+		std::size_t ip = 0;
+		while (ip < match_limit) {
+			const uint32 sequence = read32(src + ip);
+			const uint32 h = hash_sequence(sequence);
+			const std::size_t candidate = table[h];
+			table[h] = static_cast<uint32>(ip + 1);
+
+			if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || read32(src + candidate - 1) != sequence) {
+				++ip;
+				continue;
+			}
+
+			const std::size_t ref = candidate - 1;
+			std::size_t length = MIN_MATCH;
+			while (ip + length < extend_limit && src[ref + length] == src[ip + length]) {
+				++length;
+			}
+
+			if (!emit_sequence(op, op_end, src + anchor, ip - anchor, ip - ref, length)) {
+				return 0;
+			}
+
+			ip += length;
+			anchor = ip;
+		}
+	}
+
+	if (!emit_sequence(op, op_end, src + anchor, size - anchor, 0, 0)) {
+		return 0;
+	}
+	return static_cast<std::size_t>(op - static_cast<uint8*>(destination));
+}
+
+int64 lz4_decompress(const void* source, std::size_t size, void* destination, std::size_t capacity)
+{
+	const uint8* ip = static_cast<const uint8*>(source);
+	const uint8* ip_end = ip + size;
+	uint8* const out = static_cast<uint8*>(destination);
+	uint8* op = out;
+	uint8* const op_end = op + capacity;
+
+	auto read_length = [&](std::size_t length) -> int64 {
+		uint8 byte;
+		do {
+			if (ip >= ip_end) return -1;
+			byte = *ip++;
+			length += byte;
+		} while (byte == 255);
+		return static_cast<int64>(length);
+	};
+
+	while (ip < ip_end) {
+		const uint8 token = *ip++;
+
+		int64 literal_length = token >> 4;
+		if (literal_length == 15) {
+			literal_length = read_length(15);
+			if (literal_length < 0) return -1;
+		}
+
+		if (ip_end - ip < literal_length || op_end - op < literal_length) return -1;
+		std::memcpy(op, ip, static_cast<std::size_t>(literal_length));
+		ip += literal_length;
+		op += literal_length;
+
+		// The last sequence carries only literals.
+		if (ip >= ip_end) {
+			break;
+		}
+
+		if (ip_end - ip < 2) return -1;
+		const std::size_t offset = static_cast<std::size_t>(ip[0]) | (static_cast<std::size_t>(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<std::size_t>(op - out)) return -1;
+
+		int64 match_length = token & 15;
+		if (match_length == 15) {
+			match_length = read_length(15);
+			if (match_length < 0) return -1;
+		}
+		match_length += MIN_MATCH;
+		if (op_end - op < match_length) return -1;
+
+		// Byte copy: matches may overlap their own output.
+		const uint8* match = op - offset;
+		for (int64 i = 0; i < match_length; ++i) {
+			*op++ = *match++;
+		}
+	}
+
+	return static_cast<int64>(op - out);
+}
@@ -0,0 +1,570 @@
+#include "file_io.h"
+#include "engine_assert.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// Larger reads are split; the short-read path stitches them back together.
+constexpr uint64 MAX_READ_CHUNK = 1ull << 30;
+
+int64 read_at(FileHandle file, void* destination, uint64 size, uint64 offset)
+{
+	size = std::min(size, MAX_READ_CHUNK);
+
+#if defined(_WIN32)
+	OVERLAPPED overlapped{};
+	overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFull);
+	overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+	DWORD bytes_read = 0;
+	if (!ReadFile(file, destination, static_cast<DWORD>(size), &bytes_read, &overlapped)) {
+		const DWORD error = GetLastError();
+		return error == ERROR_HANDLE_EOF ? 0 : -static_cast<int64>(error);
+	}
+	return static_cast<int64>(bytes_read);
+#else
+	const ssize_t bytes_read = pread(file, destination, static_cast<size_t>(size), static_cast<off_t>(offset));
+	return bytes_read < 0 ? -static_cast<int64>(errno) : static_cast<int64>(bytes_read);
+#endif
+}
+
+#if defined(__linux__)
+
+int ring_setup(unsigned entries, io_uring_params* params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int ring_register(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+	return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+bool uring_init(FileIo* io)
+{
+	FileIo::Ring& ring = io->ring;
+
+	io_uring_params params{};
+	ring.fd = ring_setup(io->queue_depth, &params);
+	if (ring.fd < 0) {
+		return false;
+	}
+
+	ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (single_mmap) {
+		ring.sq_ring_size = ring.cq_ring_size = std::max(ring.sq_ring_size, ring.cq_ring_size);
+	}
+
+	ring.sq_ring = mmap(nullptr, ring.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring.fd, IORING_OFF_SQ_RING);
+	if (ring.sq_ring == MAP_FAILED) {
+		close(ring.fd);
+		ring.fd = -1;
+		return false;
+	}
+
+	ring.cq_ring = single_mmap
+		? ring.sq_ring
+		: mmap(nullptr, ring.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			ring.fd, IORING_OFF_CQ_RING);
+
+	ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	ring.sqes = mmap(nullptr, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring.fd, IORING_OFF_SQES);
+
+	if (ring.cq_ring == MAP_FAILED || ring.sqes == MAP_FAILED) {
+		if (ring.sqes != MAP_FAILED) munmap(ring.sqes, ring.sqes_size);
+		if (!single_mmap && ring.cq_ring != MAP_FAILED) munmap(ring.cq_ring, ring.cq_ring_size);
+		munmap(ring.sq_ring, ring.sq_ring_size);
+		close(ring.fd);
+		ring = {};
+		return false;
+	}
+
+	char* sq = static_cast<char*>(ring.sq_ring);
+	ring.sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	ring.sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	ring.sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	ring.sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+	char* cq = static_cast<char*>(ring.cq_ring);
+	ring.cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	ring.cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	ring.cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	ring.cqes = cq + params.cq_off.cqes;
+
+	// The kernel may round the ring up; never keep more reads in flight than the CQ can hold.
+	io->queue_depth = std::min(io->queue_depth, params.cq_entries);
+	return true;
+}
+
+void uring_destroy(FileIo* io)
+{
+	FileIo::Ring& ring = io->ring;
+	if (ring.fd < 0) {
+		return;
+	}
+
+	munmap(ring.sqes, ring.sqes_size);
+	if (ring.cq_ring != ring.sq_ring) {
+		munmap(ring.cq_ring, ring.cq_ring_size);
+	}
+	munmap(ring.sq_ring, ring.sq_ring_size);
+	close(ring.fd);
+	ring = {};
+}
+
+void uring_push(FileIo* io, uint32 slot)
+{
+	FileIo::Ring& ring = io->ring;
+	const FileIo::InFlight& entry = io->slots[slot];
+	const FileReadRequest& request = entry.request;
+
+	const unsigned tail = *ring.sq_tail;
+	const unsigned index = tail & *ring.sq_mask;
+
+	io_uring_sqe* sqe = static_cast<io_uring_sqe*>(ring.sqes) + index;
+	std::memset(sqe, 0, sizeof(*sqe));
+	const bool fixed = request.buffer_index >= 0 && ring.fixed_buffers;
+	sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+	sqe->fd = request.file;
+	sqe->off = request.offset + entry.bytes_done;
+	sqe->addr = reinterpret_cast<uint64>(static_cast<char*>(request.destination) + entry.bytes_done);
+	sqe->len = static_cast<uint32>(std::min(request.size - entry.bytes_done, MAX_READ_CHUNK));
+	sqe->buf_index = fixed ? static_cast<uint16>(request.buffer_index) : 0;
+	sqe->user_data = slot;
+
+	ring.sq_array[index] = index;
+	__atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+void uring_submit(FileIo* io, uint32 count)
+{
+	while (count > 0) {
+		const int submitted = ring_enter(io->ring.fd, count, 0, 0);
+		if (submitted < 0) {
+			if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+				continue;
+			}
+			RT_ASSERT(false, "io_uring_enter failed to submit reads");
+			return;
+		}
+		count -= static_cast<uint32>(submitted);
+	}
+}
+
+#endif
+
+void worker_main(FileIo* io)
+{
+	for (;;) {
+		uint32 slot;
+		{
+			std::unique_lock lock(io->mutex);
+			io->work_cv.wait(lock, [io] { return !io->running || !io->work.empty(); });
+			if (!io->running) {
+				return;
+			}
+			slot = io->work.front();
+			io->work.pop_front();
+		}
+
+		const FileIo::InFlight& entry = io->slots[slot];
+		const int64 result = read_at(entry.request.file,
+			static_cast<char*>(entry.request.destination) + entry.bytes_done,
+			entry.request.size - entry.bytes_done, entry.request.offset + entry.bytes_done);
+
+		{
+			std::lock_guard lock(io->mutex);
+			io->done.emplace_back(slot, result);
+		}
+		io->done_cv.notify_one();
+	}
+}
+
+// Hands as much of the backlog to the backend as there are free slots, in one submission.
+void pump_backlog(FileIo* io)
+{
+	uint32 started = 0;
+
+	while (!io->backlog.empty() && !io->free_slots.empty()) {
+		const uint32 slot = io->free_slots.back();
+		io->free_slots.pop_back();
+
+		io->slots[slot].request = io->backlog.front();
+		io->slots[slot].bytes_done = 0;
+		io->backlog.pop_front();
+		io->in_flight++;
+
+#if defined(__linux__)
+		if (io->backend == FILE_IO_BACKEND_IO_URING) {
+			uring_push(io, slot);
+			started++;
+			continue;
+		}
+#endif
+		{
+			std::lock_guard lock(io->mutex);
+			io->work.push_back(slot);
+		}
+		started++;
+	}
+
+	if (started == 0) {
+		return;
+	}
+
+#if defined(__linux__)
+	if (io->backend == FILE_IO_BACKEND_IO_URING) {
+		uring_submit(io, started);
+		return;
+	}
+#endif
+	io->work_cv.notify_all();
+}
+
+void resubmit(FileIo* io, uint32 slot)
+{
+#if defined(__linux__)
+	if (io->backend == FILE_IO_BACKEND_IO_URING) {
+		uring_push(io, slot);
+		uring_submit(io, 1);
+		return;
+	}
+#endif
+	{
+		std::lock_guard lock(io->mutex);
+		io->work.push_back(slot);
+	}
+	io->work_cv.notify_one();
+}
+
+enum CompletionOutcome {
+	COMPLETION_CONTINUED,
+	COMPLETION_FINISHED,
+	COMPLETION_NO_ROOM
+};
+
+CompletionOutcome complete(FileIo* io, uint32 slot, int64 result, FileReadResult* results, uint32 max_results,
+	uint32* written)
+{
+	FileIo::InFlight& entry = io->slots[slot];
+
+	// Short read that is not end-of-file: continue where the kernel stopped.
+	if (result > 0 && entry.bytes_done + static_cast<uint64>(result) < entry.request.size) {
+		entry.bytes_done += static_cast<uint64>(result);
+		resubmit(io, slot);
+		return COMPLETION_CONTINUED;
+	}
+
+	if (!entry.request.callback && *written >= max_results) {
+		return COMPLETION_NO_ROOM;
+	}
+
+	FileReadResult read{};
+	read.destination = entry.request.destination;
+	read.user_data = entry.request.user_data;
+	read.result = result < 0 ? result : static_cast<int64>(entry.bytes_done) + result;
+
+	io->in_flight--;
+	io->free_slots.push_back(slot);
+
+	if (entry.request.callback) {
+		entry.request.callback(&read);
+	}
+	else {
+		results[(*written)++] = read;
+	}
+	return COMPLETION_FINISHED;
+}
+
+} // namespace
+
+bool file_io_init(FileIo* io, uint32 queue_depth, uint32 fallback_worker_count)
+{
+	RT_ASSERT(io != nullptr, "File io is nullptr");
+	RT_ASSERT(queue_depth > 0, "File io queue depth must be positive");
+
+	io->queue_depth = queue_depth;
+	io->backend = FILE_IO_BACKEND_THREAD_POOL;
+
+#if defined(__linux__)
+	if (uring_init(io)) {
+		io->backend = FILE_IO_BACKEND_IO_URING;
+	}
+	else {
+		std::cout << "io_uring unavailable (errno " << errno << "), using thread pool file io" << std::endl;
+	}
+#endif
+
+	io->slots.resize(io->queue_depth);
+	io->free_slots.reserve(io->queue_depth);
+	for (uint32 i = io->queue_depth; i > 0; --i) {
+		io->free_slots.push_back(i - 1);
+	}
+
+	if (io->backend == FILE_IO_BACKEND_THREAD_POOL) {
+		io->running = true;
+		const uint32 worker_count = std::max(fallback_worker_count, 1u);
+		for (uint32 i = 0; i < worker_count; ++i) {
+			io->workers.emplace_back(worker_main, io);
+		}
+	}
+	return true;
+}
+
+void file_io_shutdown(FileIo* io)
+{
+	// Drain first: the kernel or a worker may still be writing into caller memory.
+	while (io->in_flight > 0 || !io->backlog.empty()) {
+		FileReadResult discard[16];
+		file_io_poll(io, discard, 16, 1);
+	}
+
+	{
+		std::lock_guard lock(io->mutex);
+		io->running = false;
+	}
+	io->work_cv.notify_all();
+	for (std::thread& worker : io->workers) {
+		worker.join();
+	}
+	io->workers.clear();
+
+#if defined(__linux__)
+	uring_destroy(io);
+#endif
+
+	io->registered_buffers.clear();
+	io->slots.clear();
+	io->free_slots.clear();
+}
+
+FileHandle file_io_open(const char* path, uint32 open_flags)
+{
+#if defined(_WIN32)
+	DWORD attributes = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+	if (open_flags & FILE_OPEN_DIRECT) {
+		attributes = FILE_FLAG_NO_BUFFERING;
+	}
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, attributes, nullptr);
+	return file == INVALID_HANDLE_VALUE ? nullptr : file;
+#else
+	int flags = O_RDONLY | O_CLOEXEC;
+#if defined(O_DIRECT)
+	if (open_flags & FILE_OPEN_DIRECT) {
+		flags |= O_DIRECT;
+	}
+#endif
+	return open(path, flags);
+#endif
+}
+
+void file_io_close(FileHandle file)
+{
+	if (!file_io_is_valid(file)) {
+		return;
+	}
+#if defined(_WIN32)
+	CloseHandle(file);
+#else
+	close(file);
+#endif
+}
+
+bool file_io_is_valid(FileHandle file)
+{
+#if defined(_WIN32)
+	return file != nullptr;
+#else
+	return file >= 0;
+#endif
+}
+
+int64 file_io_size(FileHandle file)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER size{};
+	return GetFileSizeEx(file, &size) ? static_cast<int64>(size.QuadPart) : -1;
+#else
+	struct stat info {};
+	return fstat(file, &info) == 0 ? static_cast<int64>(info.st_size) : -1;
+#endif
+}
+
+int64 file_io_read(FileHandle file, void* destination, uint64 size, uint64 offset)
+{
+	uint64 done = 0;
+	while (done < size) {
+		const int64 result = read_at(file, static_cast<char*>(destination) + done, size - done, offset + done);
+		if (result < 0) {
+			return result;
+		}
+		if (result == 0) {
+			break;
+		}
+		done += static_cast<uint64>(result);
+	}
+	return static_cast<int64>(done);
+}
+
+int32 file_io_register_buffer(FileIo* io, void* base, uint64 size)
+{
+	RT_ASSERT(io->in_flight == 0, "Buffers can only be registered while no reads are in flight");
+
+	io->registered_buffers.push_back({ static_cast<char*>(base), size });
+
+#if defined(__linux__)
+	if (io->backend == FILE_IO_BACKEND_IO_URING) {
+		// The kernel only takes the full table, so re-register everything.
+		std::vector<iovec> iovecs;
+		iovecs.reserve(io->registered_buffers.size());
+		for (const FileIo::Registered& buffer : io->registered_buffers) {
+			iovecs.push_back({ buffer.base, static_cast<size_t>(buffer.size) });
+		}
+
+		const unsigned previous = static_cast<unsigned>(iovecs.size() - 1);
+		if (previous > 0) {
+			ring_register(io->ring.fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+		}
+		if (ring_register(io->ring.fd, IORING_REGISTER_BUFFERS, iovecs.data(),
+			static_cast<unsigned>(iovecs.size())) < 0) {
+			// Put the old table back, or fixed reads into buffers registered earlier would fail.
+			io->registered_buffers.pop_back();
+			if (previous > 0 && ring_register(io->ring.fd, IORING_REGISTER_BUFFERS, iovecs.data(), previous) < 0) {
+				std::cout << "ERROR::FILE_IO::BUFFER_REREGISTER_FAILED" << std::endl;
+				io->ring.fixed_buffers = false;
+			}
+			return -1;
+		}
+		io->ring.fixed_buffers = true;
+	}
+#endif
+
+	return static_cast<int32>(io->registered_buffers.size() - 1);
+}
+
+void file_io_submit(FileIo* io, const FileReadRequest* requests, uint32 count)
+{
+	RT_ASSERT(io != nullptr, "File io is nullptr");
+
+	for (uint32 i = 0; i < count; ++i) {
+		const FileReadRequest& request = requests[i];
+
+		if (request.buffer_index >= 0) {
+			RT_ASSERT(request.buffer_index < static_cast<int32>(io->registered_buffers.size()),
+				"Read targets an unknown registered buffer");
+			const FileIo::Registered& buffer = io->registered_buffers[request.buffer_index];
+			const char* destination = static_cast<const char*>(request.destination);
+			RT_ASSERT(destination >= buffer.base && destination + request.size <= buffer.base + buffer.size,
+				"Read destination is outside its registered buffer");
+		}
+
+		io->backlog.push_back(request);
+	}
+
+	pump_backlog(io);
+}
+
+uint32 file_io_poll(FileIo* io, FileReadResult* results, uint32 max_results, uint32 min_complete)
+{
+	RT_ASSERT(io != nullptr, "File io is nullptr");
+
+	uint32 written = 0;
+	uint32 finished = 0;
+
+	for (;;) {
+		bool no_room = false;
+
+#if defined(__linux__)
+		if (io->backend == FILE_IO_BACKEND_IO_URING) {
+			FileIo::Ring& ring = io->ring;
+			unsigned head = *ring.cq_head;
+			const unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+			while (head != tail) {
+				const io_uring_cqe* cqe = static_cast<const io_uring_cqe*>(ring.cqes) + (head & *ring.cq_mask);
+				const CompletionOutcome outcome = complete(io, static_cast<uint32>(cqe->user_data), cqe->res,
+					results, max_results, &written);
+				if (outcome == COMPLETION_NO_ROOM) {
+					no_room = true;
+					break;
+				}
+				finished += outcome == COMPLETION_FINISHED ? 1 : 0;
+				++head;
+				__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+			}
+		}
+		else
+#endif
+		{
+			std::vector<std::pair<uint32, int64>> done;
+			{
+				std::lock_guard lock(io->mutex);
+				done.swap(io->done);
+			}
+
+			std::size_t i = 0;
+			for (; i < done.size(); ++i) {
+				const CompletionOutcome outcome = complete(io, done[i].first, done[i].second,
+					results, max_results, &written);
+				if (outcome == COMPLETION_NO_ROOM) {
+					no_room = true;
+					break;
+				}
+				finished += outcome == COMPLETION_FINISHED ? 1 : 0;
+			}
+
+			if (i < done.size()) {
+				std::lock_guard lock(io->mutex);
+				io->done.insert(io->done.begin(), done.begin() + i, done.end());
+			}
+		}
+
+		pump_backlog(io);
+
+		if (no_room || finished >= min_complete || (io->in_flight == 0 && io->backlog.empty())) {
+			return written;
+		}
+
+#if defined(__linux__)
+		if (io->backend == FILE_IO_BACKEND_IO_URING) {
+			ring_enter(io->ring.fd, 0, 1, IORING_ENTER_GETEVENTS);
+			continue;
+		}
+#endif
+		std::unique_lock lock(io->mutex);
+		io->done_cv.wait(lock, [io] { return !io->done.empty(); });
+	}
+}
+
+uint32 file_io_pending(const FileIo* io)
+{
+	return io->in_flight + static_cast<uint32>(io->backlog.size());
+}
@@ -0,0 +1,269 @@
+#include "file_watcher.h"
+#include "engine_assert.h"
+
+#include <cerrno>
+#include <filesystem>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+void note_change(FileWatcher* watcher, std::string path)
+{
+	std::lock_guard lock(watcher->mutex);
+	watcher->pending[std::move(path)] = clock::now();
+}
+
+// Promotes paths that have been quiet long enough. Returns true while anything is still settling.
+bool settle(FileWatcher* watcher)
+{
+	const clock::time_point now = clock::now();
+	std::lock_guard lock(watcher->mutex);
+
+	for (auto it = watcher->pending.begin(); it != watcher->pending.end();) {
+		if (now - it->second >= std::chrono::milliseconds(FILE_WATCHER_SETTLE_MS)) {
+			watcher->settled.push_back(it->first);
+			it = watcher->pending.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	return !watcher->pending.empty();
+}
+
+#if defined(_WIN32)
+
+void watch_main(FileWatcher* watcher)
+{
+	alignas(DWORD) char buffer[64 * 1024];
+	OVERLAPPED overlapped{};
+	overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	const HANDLE handles[2] = { overlapped.hEvent, watcher->stop_event };
+	bool settling = false;
+
+	for (;;) {
+		ResetEvent(overlapped.hEvent);
+		if (!ReadDirectoryChangesW(watcher->directory, buffer, sizeof(buffer), TRUE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+			nullptr, &overlapped, nullptr)) {
+			std::cout << "ERROR::FILE_WATCHER::READ_CHANGES_FAILED " << GetLastError() << std::endl;
+			break;
+		}
+
+		for (;;) {
+			const DWORD wait = WaitForMultipleObjects(2, handles, FALSE, settling ? FILE_WATCHER_SETTLE_MS / 2 : INFINITE);
+			if (wait == WAIT_OBJECT_0 + 1) {
+				CancelIoEx(watcher->directory, &overlapped);
+				DWORD ignored = 0;
+				GetOverlappedResult(watcher->directory, &overlapped, &ignored, TRUE);
+				CloseHandle(overlapped.hEvent);
+				return;
+			}
+			if (wait == WAIT_OBJECT_0) {
+				break;
+			}
+			settling = settle(watcher);
+		}
+
+		// Zero bytes means the buffer overflowed and this batch of events is lost.
+		DWORD bytes = 0;
+		if (GetOverlappedResult(watcher->directory, &overlapped, &bytes, FALSE) && bytes > 0) {
+			const char* cursor = buffer;
+			for (;;) {
+				const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+				if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED
+					|| info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+					const int wide_length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+					const int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide_length, nullptr, 0, nullptr, nullptr);
+					std::string path(static_cast<std::size_t>(length), '\0');
+					WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide_length, path.data(), length, nullptr, nullptr);
+					for (char& c : path) {
+						if (c == '\\') c = '/';
+					}
+					note_change(watcher, std::move(path));
+				}
+				if (info->NextEntryOffset == 0) {
+					break;
+				}
+				cursor += info->NextEntryOffset;
+			}
+		}
+		settling = settle(watcher);
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+
+#elif defined(__linux__)
+
+constexpr uint32 WATCH_MASK = IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE;
+
+// inotify is not recursive: every directory in the tree gets its own watch.
+void add_watch_tree(FileWatcher* watcher, const std::string& relative)
+{
+	const fs::path directory = relative.empty() ? fs::path(watcher->root) : fs::path(watcher->root) / relative;
+	const int wd = inotify_add_watch(watcher->inotify_fd, directory.c_str(), WATCH_MASK);
+	if (wd < 0) {
+		return;
+	}
+	watcher->directories[wd] = relative;
+
+	std::error_code error;
+	for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+		if (it->is_directory(error)) {
+			const std::string name = it->path().filename().string();
+			add_watch_tree(watcher, relative.empty() ? name : relative + "/" + name);
+		}
+	}
+}
+
+void watch_main(FileWatcher* watcher)
+{
+	alignas(inotify_event) char buffer[16 * 1024];
+	pollfd fds[2] = { { watcher->inotify_fd, POLLIN, 0 }, { watcher->wake_fd, POLLIN, 0 } };
+	bool settling = false;
+
+	for (;;) {
+		fds[0].revents = 0;
+		fds[1].revents = 0;
+		if (poll(fds, 2, settling ? static_cast<int>(FILE_WATCHER_SETTLE_MS / 2) : -1) < 0 && errno != EINTR) {
+			break;
+		}
+		if (fds[1].revents & POLLIN) {
+			break;
+		}
+
+		if (fds[0].revents & POLLIN) {
+			const ssize_t length = read(watcher->inotify_fd, buffer, sizeof(buffer));
+			for (ssize_t offset = 0; offset < length;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+				if (event->mask & IN_IGNORED) {
+					watcher->directories.erase(event->wd);
+					continue;
+				}
+				auto directory = watcher->directories.find(event->wd);
+				if (directory == watcher->directories.end() || event->len == 0) {
+					continue;
+				}
+
+				const std::string name = event->name;
+				std::string path = directory->second.empty() ? name : directory->second + "/" + name;
+				if (event->mask & IN_ISDIR) {
+					if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+						add_watch_tree(watcher, path);
+					}
+					continue;
+				}
+				note_change(watcher, std::move(path));
+			}
+		}
+		settling = settle(watcher);
+	}
+}
+
+#endif
+
+} // namespace
+
+bool file_watcher_init(FileWatcher* watcher, const char* root)
+{
+	RT_ASSERT(watcher != nullptr, "File watcher is nullptr");
+	watcher->root = root;
+
+#if defined(_WIN32)
+	watcher->directory = CreateFileA(root, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (watcher->directory == INVALID_HANDLE_VALUE) {
+		watcher->directory = nullptr;
+		std::cout << "ERROR::FILE_WATCHER::OPEN_FAILED " << root << std::endl;
+		return false;
+	}
+	watcher->stop_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+#elif defined(__linux__)
+	watcher->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	watcher->wake_fd = eventfd(0, EFD_CLOEXEC);
+	if (watcher->inotify_fd < 0 || watcher->wake_fd < 0) {
+		std::cout << "ERROR::FILE_WATCHER::INOTIFY_FAILED " << root << std::endl;
+		file_watcher_shutdown(watcher);
+		return false;
+	}
+	add_watch_tree(watcher, "");
+	if (watcher->directories.empty()) {
+		std::cout << "ERROR::FILE_WATCHER::WATCH_FAILED " << root << std::endl;
+		file_watcher_shutdown(watcher);
+		return false;
+	}
+#else
+	std::cout << "ERROR::FILE_WATCHER::UNSUPPORTED_PLATFORM" << std::endl;
+	return false;
+#endif
+
+	watcher->running = true;
+	watcher->thread = std::thread(watch_main, watcher);
+	return true;
+}
+
+void file_watcher_shutdown(FileWatcher* watcher)
+{
+#if defined(_WIN32)
+	if (watcher->running) {
+		SetEvent(watcher->stop_event);
+		watcher->thread.join();
+	}
+	if (watcher->directory) {
+		CloseHandle(watcher->directory);
+		watcher->directory = nullptr;
+	}
+	if (watcher->stop_event) {
+		CloseHandle(watcher->stop_event);
+		watcher->stop_event = nullptr;
+	}
+#elif defined(__linux__)
+	if (watcher->running) {
+		const uint64 wake = 1;
+		[[maybe_unused]] const ssize_t written = write(watcher->wake_fd, &wake, sizeof(wake));
+		watcher->thread.join();
+	}
+	if (watcher->inotify_fd >= 0) {
+		close(watcher->inotify_fd);
+		watcher->inotify_fd = -1;
+	}
+	if (watcher->wake_fd >= 0) {
+		close(watcher->wake_fd);
+		watcher->wake_fd = -1;
+	}
+	watcher->directories.clear();
+#endif
+
+	watcher->running = false;
+	watcher->pending.clear();
+	watcher->settled.clear();
+}
+
+uint32 file_watcher_poll(FileWatcher* watcher, std::vector<std::string>* changed)
+{
+	std::lock_guard lock(watcher->mutex);
+	const uint32 count = static_cast<uint32>(watcher->settled.size());
+	for (std::string& path : watcher->settled) {
+		changed->push_back(std::move(path));
+	}
+	watcher->settled.clear();
+	return count;
+}
@@ -0,0 +1,70 @@
+#include "hot_reload.h"
+#include "engine_assert.h"
+
+#include <algorithm>
+#include <iostream>
+
+bool hot_reload_init(HotReload* hot_reload, const char* root)
+{
+	RT_ASSERT(hot_reload != nullptr, "Hot reload is nullptr");
+
+	if (!file_watcher_init(&hot_reload->watcher, root)) {
+		return false;
+	}
+	std::cout << "Hot reload watching " << root << std::endl;
+	return true;
+}
+
+void hot_reload_shutdown(HotReload* hot_reload)
+{
+	file_watcher_shutdown(&hot_reload->watcher);
+	hot_reload->handlers.clear();
+	hot_reload->changed.clear();
+}
+
+void hot_reload_register(HotReload* hot_reload, const char* path, HotReloadFn function, void* user_data)
+{
+	hot_reload->handlers.push_back({ hash_path(path), function, user_data });
+}
+
+void hot_reload_unregister(HotReload* hot_reload, HotReloadFn function, void* user_data)
+{
+	std::erase_if(hot_reload->handlers, [function, user_data](const HotReloadHandler& handler) {
+		return handler.function == function && handler.user_data == user_data;
+	});
+}
+
+uint32 hot_reload_update(HotReload* hot_reload)
+{
+	hot_reload->changed.clear();
+	if (file_watcher_poll(&hot_reload->watcher, &hot_reload->changed) == 0) {
+		return 0;
+	}
+
+	struct Pending {
+		const HotReloadHandler* handler;
+		const std::string* path;
+	};
+	std::vector<Pending> pending;
+
+	for (const std::string& path : hot_reload->changed) {
+		const AssetId id = hash_path(path.c_str(), path.size());
+		for (const HotReloadHandler& handler : hot_reload->handlers) {
+			if (handler.id != id) {
+				continue;
+			}
+			const bool queued = std::any_of(pending.begin(), pending.end(), [&handler](const Pending& p) {
+				return p.handler->function == handler.function && p.handler->user_data == handler.user_data;
+			});
+			if (!queued) {
+				pending.push_back({ &handler, &path });
+			}
+		}
+	}
+
+	for (const Pending& p : pending) {
+		std::cout << "Hot reload: " << *p.path << std::endl;
+		p.handler->function(p.path->c_str(), p.handler->user_data);
+	}
+	return static_cast<uint32>(pending.size());
+}
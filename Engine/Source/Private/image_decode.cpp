@@ -0,0 +1,118 @@
+#include "image_decode.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr std::size_t IMAGE_ALLOCATION_ALIGNMENT = 16;
+
+// Arena serving stb allocations on this thread; only set for the duration of a decode call.
+thread_local Arena* t_scratch = nullptr;
+
+bool in_arena(const Arena* arena, const void* pointer)
+{
+	const char* p = static_cast<const char*>(pointer);
+	return arena && p >= arena->buffer && p < arena->buffer + arena->total_size;
+}
+
+void* image_malloc(std::size_t size)
+{
+	Arena* arena = t_scratch;
+	if (arena) {
+		const std::size_t start = (arena->current_position + IMAGE_ALLOCATION_ALIGNMENT - 1) & ~(IMAGE_ALLOCATION_ALIGNMENT - 1);
+		if (start + size <= arena->total_size) {
+			arena->current_position = start + size;
+			return arena->buffer + start;
+		}
+	}
+	return std::malloc(size);
+}
+
+void* image_realloc(void* pointer, std::size_t old_size, std::size_t new_size)
+{
+	if (!pointer) {
+		return image_malloc(new_size);
+	}
+
+	Arena* arena = t_scratch;
+	if (!in_arena(arena, pointer)) {
+		return std::realloc(pointer, new_size);
+	}
+
+	// stb grows its output buffers one at a time, so the block being resized is usually the last one.
+	char* p = static_cast<char*>(pointer);
+	if (p + old_size == arena->buffer + arena->current_position
+		&& static_cast<std::size_t>(p - arena->buffer) + new_size <= arena->total_size) {
+		arena->current_position = static_cast<std::size_t>(p - arena->buffer) + new_size;
+		return pointer;
+	}
+
+	void* moved = image_malloc(new_size);
+	if (moved) {
+		std::memcpy(moved, pointer, old_size < new_size ? old_size : new_size);
+	}
+	return moved;
+}
+
+void image_free(void* pointer)
+{
+	if (pointer && !in_arena(t_scratch, pointer)) {
+		std::free(pointer);
+	}
+}
+
+struct ScopedScratch {
+	explicit ScopedScratch(Arena* arena) { t_scratch = arena; }
+	~ScopedScratch() { t_scratch = nullptr; }
+};
+
+} // namespace
+
+#define STBI_MALLOC(size) image_malloc(size)
+#define STBI_REALLOC_SIZED(pointer, old_size, new_size) image_realloc(pointer, old_size, new_size)
+#define STBI_FREE(pointer) image_free(pointer)
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+bool image_decode_info(const void* data, uint64 size, ImageInfo* info)
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	if (!stbi_info_from_memory(static_cast<const stbi_uc*>(data), static_cast<int>(size), &width, &height, &channels)) {
+		return false;
+	}
+
+	info->width = static_cast<uint32>(width);
+	info->height = static_cast<uint32>(height);
+	info->channels = static_cast<uint32>(channels);
+	return true;
+}
+
+uint8* image_decode_rgba8(const void* data, uint64 size, Arena* scratch, ImageInfo* info)
+{
+	ScopedScratch scope(scratch);
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* pixels = stbi_load_from_memory(static_cast<const stbi_uc*>(data), static_cast<int>(size),
+		&width, &height, &channels, 4);
+	if (!pixels) {
+		std::cout << "ERROR::IMAGE_DECODE::FAILED " << stbi_failure_reason() << std::endl;
+		return nullptr;
+	}
+
+	info->width = static_cast<uint32>(width);
+	info->height = static_cast<uint32>(height);
+	info->channels = static_cast<uint32>(channels);
+	return pixels;
+}
+
+void image_decode_free(Arena* scratch, uint8* pixels)
+{
+	ScopedScratch scope(scratch);
+	stbi_image_free(pixels);
+}
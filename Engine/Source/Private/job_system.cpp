@@ -0,0 +1,120 @@
+#include "job_system.h"
+#include "engine_assert.h"
+
+#include <algorithm>
+
+namespace {
+
+void run_batches(JobBatch* job)
+{
+	for (;;) {
+		const uint32 begin = job->next.fetch_add(job->batch_size);
+		if (begin >= job->count) {
+			return;
+		}
+		const uint32 end = std::min(begin + job->batch_size, job->count);
+		job->function(job->user_data, begin, end);
+		job->done.fetch_add(end - begin);
+	}
+}
+
+void worker_main(JobSystem* jobs)
+{
+	std::unique_lock<std::mutex> lock(jobs->mutex);
+	for (;;) {
+		jobs->work_cv.wait(lock, [jobs] { return !jobs->running || !jobs->jobs.empty(); });
+		if (!jobs->running) {
+			return;
+		}
+
+		JobBatch* job = jobs->jobs.front();
+		if (job->next.load() >= job->count) {
+			// Every batch is claimed; whoever is running them will finish the job.
+			jobs->jobs.pop_front();
+			continue;
+		}
+
+		job->active++;
+		lock.unlock();
+		run_batches(job);
+		lock.lock();
+		job->active--;
+		if (job->active == 0) {
+			jobs->done_cv.notify_all();
+		}
+	}
+}
+
+} // namespace
+
+bool job_system_init(JobSystem* jobs, uint32 worker_count)
+{
+	RT_ASSERT(jobs != nullptr, "JobSystem is nullptr");
+
+	if (worker_count == 0) {
+		const uint32 hardware = std::thread::hardware_concurrency();
+		worker_count = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	jobs->running = true;
+	jobs->workers.reserve(worker_count);
+	for (uint32 i = 0; i < worker_count; ++i) {
+		jobs->workers.emplace_back(worker_main, jobs);
+	}
+	return true;
+}
+
+void job_system_shutdown(JobSystem* jobs)
+{
+	{
+		std::lock_guard<std::mutex> lock(jobs->mutex);
+		jobs->running = false;
+	}
+	jobs->work_cv.notify_all();
+
+	for (std::thread& worker : jobs->workers) {
+		worker.join();
+	}
+	jobs->workers.clear();
+	jobs->jobs.clear();
+}
+
+uint32 job_system_thread_count(const JobSystem* jobs)
+{
+	return static_cast<uint32>(jobs->workers.size()) + 1;
+}
+
+void job_system_parallel_for(JobSystem* jobs, uint32 count, uint32 batch_size, JobRangeFn function, void* user_data)
+{
+	if (count == 0) {
+		return;
+	}
+	batch_size = std::max(batch_size, 1u);
+
+	if (!jobs || jobs->workers.empty() || count <= batch_size) {
+		function(user_data, 0, count);
+		return;
+	}
+
+	JobBatch job{};
+	job.function = function;
+	job.user_data = user_data;
+	job.count = count;
+	job.batch_size = batch_size;
+
+	{
+		std::lock_guard<std::mutex> lock(jobs->mutex);
+		jobs->jobs.push_back(&job);
+	}
+	jobs->work_cv.notify_all();
+
+	run_batches(&job);
+
+	// The batch lives on this stack frame, so wait until no worker can still be touching it.
+	std::unique_lock<std::mutex> lock(jobs->mutex);
+	auto queued = std::find(jobs->jobs.begin(), jobs->jobs.end(), &job);
+	if (queued != jobs->jobs.end()) {
+		jobs->jobs.erase(queued);
+	}
+	jobs->done_cv.wait(lock, [&job] { return job.active == 0 && job.done.load() == job.count; });
+}
@@ -3,7 +3,7 @@
 #include "engine_config.h"
 #include <stdexcept>
 
-int main() {
+int main(int argc, char** argv) {
 	EngineConfig engine_config{ 
 		.frame_memory_size{16 * MB},
 		.global_storage_size{256 * MB}
@@ -17,7 +17,7 @@ int main() {
 
 	Application* app = engine_allocate<Application>(&global_storage);
 	
-	if (!application_init(app, &global_storage)) {
+	if (!application_init(app, &global_storage, argc, argv)) {
 		return EXIT_FAILURE;
 	}
 	application_run(app, &frame_storage);
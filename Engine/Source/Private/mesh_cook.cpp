@@ -0,0 +1,82 @@
+#include "mesh_cook.h"
+#include "object_loader.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+uint64 align_up(uint64 value, uint64 alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+template<typename T>
+void write_section(std::vector<uint8>* output, HmshHeader* header, HmshSection section, const std::vector<T>& elements)
+{
+	const uint64 offset = align_up(output->size(), HMSH_ALIGNMENT);
+	const uint64 bytes = elements.size() * sizeof(T);
+	output->resize(offset + bytes);
+	if (bytes > 0) {
+		std::memcpy(output->data() + offset, elements.data(), bytes);
+	}
+	header->sections[section] = { offset, elements.size() };
+}
+
+template<typename T>
+void read_section(const uint8* data, const HmshHeader* header, HmshSection section, std::vector<T>* elements)
+{
+	const HmshRange& range = header->sections[section];
+	elements->resize(range.count);
+	if (range.count > 0) {
+		std::memcpy(elements->data(), data + range.offset, range.count * sizeof(T));
+	}
+}
+
+} // namespace
+
+bool mesh_cook(const char* obj_path, uint64 source_hash, std::vector<uint8>* output)
+{
+	ObjectLoader loader{};
+	object_loader_init(&loader);
+	loader.input_path = obj_path;
+
+	ImportedMesh mesh{};
+	if (!object_loader_import(&loader, &mesh) || mesh.indices.empty()) {
+		std::cout << "ERROR::MESH_COOK::IMPORT_FAILED " << obj_path << std::endl;
+		return false;
+	}
+
+	HmshHeader header{};
+	header.magic = HMSH_MAGIC;
+	header.version = HMSH_VERSION;
+	header.source_hash = source_hash;
+
+	output->assign(sizeof(HmshHeader), 0);
+	write_section(output, &header, HMSH_SECTION_POSITIONS, mesh.positions);
+	write_section(output, &header, HMSH_SECTION_INDICES, mesh.indices);
+	write_section(output, &header, HMSH_SECTION_MESHLETS, mesh.meshlets.meshlets);
+	write_section(output, &header, HMSH_SECTION_MESHLET_VERTICES, mesh.meshlets.meshlet_vertices);
+	write_section(output, &header, HMSH_SECTION_MESHLET_TRIANGLES, mesh.meshlets.meshlet_triangles);
+	write_section(output, &header, HMSH_SECTION_MESHLET_INDICES, mesh.meshlets.indices);
+	std::memcpy(output->data(), &header, sizeof(header));
+	return true;
+}
+
+bool mesh_load_cooked(const void* data, uint64 size, ImportedMesh* mesh)
+{
+	const HmshHeader* header = hmsh_validate(data, size);
+	if (!header) {
+		std::cout << "ERROR::MESH_COOK::INVALID_HMSH" << std::endl;
+		return false;
+	}
+
+	const uint8* bytes = static_cast<const uint8*>(data);
+	read_section(bytes, header, HMSH_SECTION_POSITIONS, &mesh->positions);
+	read_section(bytes, header, HMSH_SECTION_INDICES, &mesh->indices);
+	read_section(bytes, header, HMSH_SECTION_MESHLETS, &mesh->meshlets.meshlets);
+	read_section(bytes, header, HMSH_SECTION_MESHLET_VERTICES, &mesh->meshlets.meshlet_vertices);
+	read_section(bytes, header, HMSH_SECTION_MESHLET_TRIANGLES, &mesh->meshlets.meshlet_triangles);
+	read_section(bytes, header, HMSH_SECTION_MESHLET_INDICES, &mesh->meshlets.indices);
+	return !mesh->indices.empty();
+}
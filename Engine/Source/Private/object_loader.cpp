@@ -0,0 +1,115 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "object_loader.h"
+#include "engine_assert.h"
+#include "mesh_cook.h"
+
+#include <iostream>
+#include <unordered_map>
+
+void object_loader_init(ObjectLoader* objectLoader)
+{
+	RT_ASSERT(objectLoader != nullptr, "Object loader is nullptr");
+
+	objectLoader->reader_config.triangulate = true;
+	objectLoader->reader_config.vertex_color = false;
+}
+
+namespace {
+
+bool build_mesh(const tinyobj::ObjReader& reader, ImportedMesh* mesh)
+{
+	const tinyobj::attrib_t& attrib = reader.GetAttrib();
+
+	mesh->positions.clear();
+	mesh->indices.clear();
+
+	std::unordered_map<int, uint32> remap;
+	for (const tinyobj::shape_t& shape : reader.GetShapes()) {
+		for (const tinyobj::index_t& index : shape.mesh.indices) {
+			auto [it, inserted] = remap.try_emplace(index.vertex_index, static_cast<uint32>(mesh->positions.size()));
+			if (inserted) {
+				const float* p = &attrib.vertices[3 * static_cast<std::size_t>(index.vertex_index)];
+				mesh->positions.emplace_back(p[0], p[1], p[2]);
+			}
+			mesh->indices.push_back(it->second);
+		}
+	}
+
+	meshlet_build(&mesh->meshlets, mesh->positions.data(), mesh->positions.size(),
+		mesh->indices.data(), mesh->indices.size());
+	return !mesh->indices.empty();
+}
+
+bool decode_obj(AssetLoad* load)
+{
+	auto mesh = std::make_shared<ImportedMesh>();
+	load->decoded = mesh;
+
+	const std::string& path = load->request.path;
+	if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".hmsh") == 0) {
+		return mesh_load_cooked(load->bytes.data(), load->bytes.size(), mesh.get());
+	}
+
+	ObjectLoader loader{};
+	object_loader_init(&loader);
+	loader.input_path = load->request.path;
+
+	return object_loader_import_from_memory(&loader, load->bytes.data(), load->bytes.size(), mesh.get());
+}
+
+// The caller's mesh is only written here, on the draining thread, so it can be read between loads.
+void upload_mesh(AssetLoad* load)
+{
+	*static_cast<ImportedMesh*>(load->request.user_data) = std::move(*static_cast<ImportedMesh*>(load->decoded.get()));
+	if (load->request.on_loaded) {
+		load->request.on_loaded(load);
+	}
+}
+
+} // namespace
+
+bool object_loader_import(ObjectLoader* objectLoader, ImportedMesh* mesh)
+{
+	RT_ASSERT(objectLoader != nullptr && mesh != nullptr, "Object loader passed nullptr");
+
+	tinyobj::ObjReader reader;
+	if (!reader.ParseFromFile(objectLoader->input_path, objectLoader->reader_config)) {
+		std::cout << "ERROR::OBJECT_LOADER::PARSE_FAILED " << objectLoader->input_path << "\n"
+			<< reader.Error() << std::endl;
+		return false;
+	}
+
+	build_mesh(reader, mesh);
+
+	std::cout << "Imported " << objectLoader->input_path << ": " << mesh->indices.size() / 3
+		<< " triangles in " << mesh->meshlets.meshlets.size() << " meshlets" << std::endl;
+	return true;
+}
+
+bool object_loader_import_from_memory(ObjectLoader* objectLoader, const char* data, std::size_t size, ImportedMesh* mesh)
+{
+	RT_ASSERT(objectLoader != nullptr && mesh != nullptr, "Object loader passed nullptr");
+
+	// Materials are not resolved from memory; mesh import only needs positions.
+	tinyobj::ObjReader reader;
+	if (!reader.ParseFromString(std::string(data, size), std::string(), objectLoader->reader_config)) {
+		std::cout << "ERROR::OBJECT_LOADER::PARSE_FAILED " << objectLoader->input_path << "\n"
+			<< reader.Error() << std::endl;
+		return false;
+	}
+
+	return build_mesh(reader, mesh);
+}
+
+void object_loader_import_async(AssetStream* stream, ImportedMesh* mesh, const char* path,
+	AssetPriority priority, AssetUploadFn on_loaded)
+{
+	AssetRequest request{};
+	request.path = path;
+	request.priority = priority;
+	request.decode = decode_obj;
+	request.upload = upload_mesh;
+	request.on_loaded = on_loaded;
+	request.user_data = mesh;
+	asset_stream_request(stream, std::move(request));
+}
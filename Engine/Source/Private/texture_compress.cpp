@@ -0,0 +1,513 @@
+#include "texture_compress.h"
+#include "job_system.h"
+#include "engine_assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int BLOCK_PIXELS = 16;
+constexpr int POWER_ITERATIONS = 8;
+constexpr int REFINE_ITERATIONS = 2;
+
+constexpr uint32 BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+void load_block(const uint8* rgba, float pixels[BLOCK_PIXELS][4])
+{
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		for (int c = 0; c < 4; ++c) {
+			pixels[i][c] = rgba[i * 4 + c];
+		}
+	}
+}
+
+// Mean and dominant eigenvector of the covariance over the first `channels` channels. The axis is
+// left at zero for blocks without any spread.
+void principal_axis(const float pixels[BLOCK_PIXELS][4], int channels, float mean[4], float axis[4])
+{
+	for (int c = 0; c < 4; ++c) {
+		mean[c] = 0.0f;
+		axis[c] = 0.0f;
+	}
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		for (int c = 0; c < channels; ++c) {
+			mean[c] += pixels[i][c];
+		}
+	}
+	for (int c = 0; c < channels; ++c) {
+		mean[c] /= BLOCK_PIXELS;
+	}
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		float d[4];
+		for (int c = 0; c < channels; ++c) {
+			d[c] = pixels[i][c] - mean[c];
+		}
+		for (int r = 0; r < channels; ++r) {
+			for (int c = 0; c < channels; ++c) {
+				covariance[r][c] += d[r] * d[c];
+			}
+		}
+	}
+
+	// Start from the row of the widest channel so the iteration never begins orthogonal to the answer.
+	int widest = 0;
+	for (int c = 1; c < channels; ++c) {
+		if (covariance[c][c] > covariance[widest][widest]) {
+			widest = c;
+		}
+	}
+	if (covariance[widest][widest] < 1e-3f) {
+		return;
+	}
+
+	float v[4];
+	for (int c = 0; c < channels; ++c) {
+		v[c] = covariance[widest][c];
+	}
+	for (int iteration = 0; iteration < POWER_ITERATIONS; ++iteration) {
+		float next[4] = {};
+		float length = 0.0f;
+		for (int r = 0; r < channels; ++r) {
+			for (int c = 0; c < channels; ++c) {
+				next[r] += covariance[r][c] * v[c];
+			}
+			length += next[r] * next[r];
+		}
+		if (length < 1e-12f) {
+			return;
+		}
+		length = 1.0f / std::sqrt(length);
+		for (int c = 0; c < channels; ++c) {
+			v[c] = next[c] * length;
+		}
+	}
+	for (int c = 0; c < channels; ++c) {
+		axis[c] = v[c];
+	}
+}
+
+// Block endpoints at the extremes of the pixels projected onto the principal axis.
+void axis_endpoints(const float pixels[BLOCK_PIXELS][4], int channels, float low[4], float high[4])
+{
+	float mean[4];
+	float axis[4];
+	principal_axis(pixels, channels, mean, axis);
+
+	float t_min = 0.0f;
+	float t_max = 0.0f;
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		float t = 0.0f;
+		for (int c = 0; c < channels; ++c) {
+			t += (pixels[i][c] - mean[c]) * axis[c];
+		}
+		t_min = std::min(t_min, t);
+		t_max = std::max(t_max, t);
+	}
+
+	for (int c = 0; c < 4; ++c) {
+		low[c] = std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+		high[c] = std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+	}
+}
+
+// Least-squares endpoints for fixed indices: every pixel is weights[i] * a + (1 - weights[i]) * b.
+bool solve_endpoints(const float pixels[BLOCK_PIXELS][4], int channels, const uint8* indices, const float* weights,
+	float a[4], float b[4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		const float wa = weights[indices[i]];
+		const float wb = 1.0f - wa;
+		aa += wa * wa;
+		ab += wa * wb;
+		bb += wb * wb;
+		for (int c = 0; c < channels; ++c) {
+			ax[c] += wa * pixels[i][c];
+			bx[c] += wb * pixels[i][c];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (std::fabs(determinant) < 1e-6f) {
+		return false;
+	}
+	const float inverse = 1.0f / determinant;
+	for (int c = 0; c < channels; ++c) {
+		a[c] = std::clamp((ax[c] * bb - bx[c] * ab) * inverse, 0.0f, 255.0f);
+		b[c] = std::clamp((bx[c] * aa - ax[c] * ab) * inverse, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+// ---- BC1 -------------------------------------------------------------------------------------
+
+// Weight of colour0 for each 4-colour mode index.
+constexpr float BC1_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+uint16 pack_565(const float color[4])
+{
+	const uint32 r = static_cast<uint32>(std::lround(color[0] * 31.0f / 255.0f));
+	const uint32 g = static_cast<uint32>(std::lround(color[1] * 63.0f / 255.0f));
+	const uint32 b = static_cast<uint32>(std::lround(color[2] * 31.0f / 255.0f));
+	return static_cast<uint16>((r << 11) | (g << 5) | b);
+}
+
+void unpack_565(uint16 packed, int color[3])
+{
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+uint32 bc1_pick_indices(const float pixels[BLOCK_PIXELS][4], uint16 c0, uint16 c1, uint8 indices[BLOCK_PIXELS])
+{
+	int palette[4][3];
+	unpack_565(c0, palette[0]);
+	unpack_565(c1, palette[1]);
+	for (int c = 0; c < 3; ++c) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32 total = 0;
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		uint32 best_error = UINT32_MAX;
+		for (uint8 p = 0; p < 4; ++p) {
+			uint32 error = 0;
+			for (int c = 0; c < 3; ++c) {
+				const int d = static_cast<int>(pixels[i][c]) - palette[p][c];
+				error += static_cast<uint32>(d * d);
+			}
+			if (error < best_error) {
+				best_error = error;
+				indices[i] = p;
+			}
+		}
+		total += best_error;
+	}
+	return total;
+}
+
+void bc1_encode_colors(const float pixels[BLOCK_PIXELS][4], uint8* out)
+{
+	float high[4], low[4];
+	axis_endpoints(pixels, 3, low, high);
+
+	uint16 c0 = pack_565(high);
+	uint16 c1 = pack_565(low);
+	uint8 indices[BLOCK_PIXELS];
+	uint32 error = bc1_pick_indices(pixels, c0, c1, indices);
+
+	for (int iteration = 0; iteration < REFINE_ITERATIONS && error > 0; ++iteration) {
+		float a[4], b[4];
+		if (!solve_endpoints(pixels, 3, indices, BC1_WEIGHTS, a, b)) {
+			break;
+		}
+		const uint16 r0 = pack_565(a);
+		const uint16 r1 = pack_565(b);
+		uint8 refined[BLOCK_PIXELS];
+		const uint32 refined_error = bc1_pick_indices(pixels, r0, r1, refined);
+		if (refined_error >= error) {
+			break;
+		}
+		c0 = r0;
+		c1 = r1;
+		error = refined_error;
+		std::memcpy(indices, refined, sizeof(indices));
+	}
+
+	// Four-colour mode needs colour0 > colour1; swapping the endpoints swaps index pairs 0/1 and 2/3.
+	if (c0 < c1) {
+		std::swap(c0, c1);
+		for (uint8& index : indices) {
+			index ^= 1;
+		}
+	}
+	else if (c0 == c1) {
+		std::memset(indices, 0, sizeof(indices));
+	}
+
+	uint32 bits = 0;
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		bits |= static_cast<uint32>(indices[i]) << (i * 2);
+	}
+	out[0] = static_cast<uint8>(c0);
+	out[1] = static_cast<uint8>(c0 >> 8);
+	out[2] = static_cast<uint8>(c1);
+	out[3] = static_cast<uint8>(c1 >> 8);
+	std::memcpy(out + 4, &bits, 4);
+}
+
+// ---- BC7 -------------------------------------------------------------------------------------
+
+struct Bc7Endpoint {
+	uint8 value[4];	// 7 bits per channel
+	uint8 p;
+};
+
+Bc7Endpoint bc7_quantize(const float color[4])
+{
+	Bc7Endpoint best{};
+	float best_error = 1e30f;
+	for (uint8 p = 0; p < 2; ++p) {
+		Bc7Endpoint candidate{};
+		candidate.p = p;
+		float error = 0.0f;
+		for (int c = 0; c < 4; ++c) {
+			const long q = std::clamp(std::lround((color[c] - p) * 0.5f), 0l, 127l);
+			candidate.value[c] = static_cast<uint8>(q);
+			const float d = static_cast<float>((q << 1) | p) - color[c];
+			error += d * d;
+		}
+		if (error < best_error) {
+			best_error = error;
+			best = candidate;
+		}
+	}
+	return best;
+}
+
+uint32 bc7_pick_indices(const float pixels[BLOCK_PIXELS][4], const Bc7Endpoint& e0, const Bc7Endpoint& e1,
+	uint8 indices[BLOCK_PIXELS])
+{
+	int palette[16][4];
+	for (int c = 0; c < 4; ++c) {
+		const int a = (e0.value[c] << 1) | e0.p;
+		const int b = (e1.value[c] << 1) | e1.p;
+		for (int w = 0; w < 16; ++w) {
+			palette[w][c] = static_cast<int>(((64 - BC7_WEIGHTS[w]) * a + BC7_WEIGHTS[w] * b + 32) >> 6);
+		}
+	}
+
+	uint32 total = 0;
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		uint32 best_error = UINT32_MAX;
+		for (uint8 w = 0; w < 16; ++w) {
+			uint32 error = 0;
+			for (int c = 0; c < 4; ++c) {
+				const int d = static_cast<int>(pixels[i][c]) - palette[w][c];
+				error += static_cast<uint32>(d * d);
+			}
+			if (error < best_error) {
+				best_error = error;
+				indices[i] = w;
+			}
+		}
+		total += best_error;
+	}
+	return total;
+}
+
+struct BitWriter {
+	uint8* out;
+	uint32 position;
+
+	void put(uint32 value, uint32 bits)
+	{
+		for (uint32 i = 0; i < bits; ++i, ++position) {
+			if ((value >> i) & 1) {
+				out[position >> 3] |= static_cast<uint8>(1u << (position & 7));
+			}
+		}
+	}
+};
+
+// ---- Whole levels ----------------------------------------------------------------------------
+
+struct CompressJob {
+	TextureFormat format;
+	const uint8* rgba;
+	uint32 width;
+	uint32 height;
+	uint32 blocks_x;
+	uint32 block_bytes;
+	uint8* out;
+};
+
+void compress_block_rows(void* user_data, uint32 begin, uint32 end)
+{
+	const CompressJob* job = static_cast<const CompressJob*>(user_data);
+	uint8 block[BLOCK_PIXELS * 4];
+
+	for (uint32 by = begin; by < end; ++by) {
+		for (uint32 bx = 0; bx < job->blocks_x; ++bx) {
+			for (uint32 y = 0; y < 4; ++y) {
+				const uint32 sy = std::min(by * 4 + y, job->height - 1);
+				for (uint32 x = 0; x < 4; ++x) {
+					const uint32 sx = std::min(bx * 4 + x, job->width - 1);
+					std::memcpy(block + (y * 4 + x) * 4, job->rgba + (static_cast<uint64>(sy) * job->width + sx) * 4, 4);
+				}
+			}
+
+			uint8* out = job->out + (static_cast<uint64>(by) * job->blocks_x + bx) * job->block_bytes;
+			switch (job->format) {
+			case TEXTURE_FORMAT_BC1: bc1_encode_block(block, out); break;
+			case TEXTURE_FORMAT_BC3: bc3_encode_block(block, out); break;
+			case TEXTURE_FORMAT_BC5: bc5_encode_block(block, out); break;
+			case TEXTURE_FORMAT_BC7: bc7_encode_block(block, out); break;
+			default: break;
+			}
+		}
+	}
+}
+
+} // namespace
+
+void bc1_encode_block(const uint8* rgba, uint8* out)
+{
+	float pixels[BLOCK_PIXELS][4];
+	load_block(rgba, pixels);
+	bc1_encode_colors(pixels, out);
+}
+
+void bc4_encode_block(const uint8* values, uint8* out)
+{
+	uint8 low = values[0];
+	uint8 high = values[0];
+	for (int i = 1; i < BLOCK_PIXELS; ++i) {
+		low = std::min(low, values[i]);
+		high = std::max(high, values[i]);
+	}
+
+	out[0] = high;
+	out[1] = low;
+	uint64 bits = 0;
+
+	if (high != low) {
+		// Eight-value mode (a0 > a1): index 0 and 1 are the endpoints, 2..7 step from a0 towards a1.
+		int palette[8];
+		palette[0] = high;
+		palette[1] = low;
+		for (int k = 2; k < 8; ++k) {
+			palette[k] = ((8 - k) * high + (k - 1) * low) / 7;
+		}
+
+		for (int i = 0; i < BLOCK_PIXELS; ++i) {
+			int best = 0;
+			int best_error = 256;
+			for (int k = 0; k < 8; ++k) {
+				const int error = std::abs(values[i] - palette[k]);
+				if (error < best_error) {
+					best_error = error;
+					best = k;
+				}
+			}
+			bits |= static_cast<uint64>(best) << (i * 3);
+		}
+	}
+
+	for (int i = 0; i < 6; ++i) {
+		out[2 + i] = static_cast<uint8>(bits >> (i * 8));
+	}
+}
+
+void bc3_encode_block(const uint8* rgba, uint8* out)
+{
+	uint8 alpha[BLOCK_PIXELS];
+	for (int i = 0; i < BLOCK_PIXELS; ++i) {
+		alpha[i] = rgba[i * 4 + 3];
+	}
+	bc4_encode_block(alpha, out);
+
+	float pixels[BLOCK_PIXELS][4];
+	load_block(rgba, pixels);
+	bc1_encode_colors(pixels, out + 8);
+}
+
+void bc5_encode_block(const uint8* rgba, uint8* out)
+{
+	uint8 channel[BLOCK_PIXELS];
+	for (int c = 0; c < 2; ++c) {
+		for (int i = 0; i < BLOCK_PIXELS; ++i) {
+			channel[i] = rgba[i * 4 + c];
+		}
+		bc4_encode_block(channel, out + c * 8);
+	}
+}
+
+void bc7_encode_block(const uint8* rgba, uint8* out)
+{
+	float pixels[BLOCK_PIXELS][4];
+	load_block(rgba, pixels);
+
+	float low[4], high[4];
+	axis_endpoints(pixels, 4, low, high);
+
+	Bc7Endpoint e0 = bc7_quantize(low);
+	Bc7Endpoint e1 = bc7_quantize(high);
+	uint8 indices[BLOCK_PIXELS];
+	uint32 error = bc7_pick_indices(pixels, e0, e1, indices);
+
+	float weights[16];
+	for (int w = 0; w < 16; ++w) {
+		weights[w] = (64 - BC7_WEIGHTS[w]) / 64.0f;
+	}
+	for (int iteration = 0; iteration < REFINE_ITERATIONS && error > 0; ++iteration) {
+		float a[4], b[4];
+		if (!solve_endpoints(pixels, 4, indices, weights, a, b)) {
+			break;
+		}
+		const Bc7Endpoint r0 = bc7_quantize(a);
+		const Bc7Endpoint r1 = bc7_quantize(b);
+		uint8 refined[BLOCK_PIXELS];
+		const uint32 refined_error = bc7_pick_indices(pixels, r0, r1, refined);
+		if (refined_error >= error) {
+			break;
+		}
+		e0 = r0;
+		e1 = r1;
+		error = refined_error;
+		std::memcpy(indices, refined, sizeof(indices));
+	}
+
+	// The anchor index is stored without its top bit, so pixel 0 must use the lower half of the ramp.
+	if (indices[0] & 8) {
+		std::swap(e0, e1);
+		for (uint8& index : indices) {
+			index = static_cast<uint8>(15 - index);
+		}
+	}
+
+	std::memset(out, 0, 16);
+	BitWriter writer{ out, 0 };
+	writer.put(1u << 6, 7);
+	for (int c = 0; c < 4; ++c) {
+		writer.put(e0.value[c], 7);
+		writer.put(e1.value[c], 7);
+	}
+	writer.put(e0.p, 1);
+	writer.put(e1.p, 1);
+	writer.put(indices[0], 3);
+	for (int i = 1; i < BLOCK_PIXELS; ++i) {
+		writer.put(indices[i], 4);
+	}
+}
+
+void texture_compress(JobSystem* jobs, TextureFormat format, const uint8* rgba, uint32 width, uint32 height, uint8* out)
+{
+	RT_ASSERT(width > 0 && height > 0, "Texture has no pixels");
+
+	if (!texture_format_is_compressed(format)) {
+		std::memcpy(out, rgba, texture_level_size(format, width, height));
+		return;
+	}
+
+	CompressJob job{};
+	job.format = format;
+	job.rgba = rgba;
+	job.width = width;
+	job.height = height;
+	job.blocks_x = (width + 3) / 4;
+	job.block_bytes = texture_format_block_bytes(format);
+	job.out = out;
+
+	job_system_parallel_for(jobs, (height + 3) / 4, 1, compress_block_rows, &job);
+}
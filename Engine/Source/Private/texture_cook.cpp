@@ -0,0 +1,402 @@
+#include "texture_cook.h"
+#include "texture_compress.h"
+#include "job_system.h"
+#include "engine_hash.h"
+#include "image_decode.h"
+#include "engine_assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXTURE_COOK_SSE2 1
+#endif
+
+namespace {
+
+// Kaiser filter support, in destination pixels either side of the centre.
+constexpr float KAISER_WIDTH = 3.0f;
+constexpr float KAISER_ALPHA = 4.0f;
+// Halving with the support above touches source pixels 2x-5 .. 2x+6.
+constexpr int KAISER_TAPS = 12;
+constexpr int KAISER_FIRST_TAP = -5;
+
+struct ColorTables {
+	float srgb_to_linear[256];
+	// Linear value halfway between consecutive sRGB codes; encoding is a search over these.
+	float srgb_thresholds[255];
+};
+
+float srgb_decode(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+const ColorTables& color_tables()
+{
+	static const ColorTables tables = [] {
+		ColorTables result{};
+		for (int i = 0; i < 256; ++i) {
+			result.srgb_to_linear[i] = srgb_decode(i / 255.0f);
+		}
+		for (int i = 0; i < 255; ++i) {
+			result.srgb_thresholds[i] = srgb_decode((i + 0.5f) / 255.0f);
+		}
+		return result;
+	}();
+	return tables;
+}
+
+double bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 32; ++k) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+struct KaiserTaps {
+	float weights[KAISER_TAPS];
+};
+
+const KaiserTaps& kaiser_taps()
+{
+	static const KaiserTaps taps = [] {
+		constexpr double pi = 3.14159265358979323846;
+		KaiserTaps result{};
+		double total = 0.0;
+		for (int i = 0; i < KAISER_TAPS; ++i) {
+			// Distance from the destination pixel centre, in destination pixels.
+			const double d = (KAISER_FIRST_TAP + i - 0.5) * 0.5;
+			const double t = d / KAISER_WIDTH;
+			const double sinc = d == 0.0 ? 1.0 : std::sin(pi * d) / (pi * d);
+			const double window = t * t < 1.0 ? bessel_i0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) / bessel_i0(KAISER_ALPHA) : 0.0;
+			result.weights[i] = static_cast<float>(sinc * window);
+			total += result.weights[i];
+		}
+		for (float& weight : result.weights) {
+			weight = static_cast<float>(weight / total);
+		}
+		return result;
+	}();
+	return taps;
+}
+
+// One RGBA pixel in a register. Every filter below is written against these few operations.
+#if TEXTURE_COOK_SSE2
+using Pixel = __m128;
+inline Pixel pixel_zero() { return _mm_setzero_ps(); }
+inline Pixel pixel_load(const float* p) { return _mm_loadu_ps(p); }
+inline void pixel_store(float* p, Pixel v) { _mm_storeu_ps(p, v); }
+inline Pixel pixel_add(Pixel a, Pixel b) { return _mm_add_ps(a, b); }
+inline Pixel pixel_scale(Pixel a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+#else
+struct Pixel { float v[4]; };
+inline Pixel pixel_zero() { return {}; }
+inline Pixel pixel_load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+inline void pixel_store(float* p, Pixel a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline Pixel pixel_add(Pixel a, Pixel b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+inline Pixel pixel_scale(Pixel a, float s) { return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+#endif
+
+struct DownsampleJob {
+	const float* source;
+	float* destination;
+	uint32 width;
+	uint32 height;
+	uint32 half_width;
+	uint32 half_height;
+};
+
+void box_rows(void* user_data, uint32 begin, uint32 end)
+{
+	const DownsampleJob* job = static_cast<const DownsampleJob*>(user_data);
+	for (uint32 y = begin; y < end; ++y) {
+		const float* row0 = job->source + static_cast<uint64>(std::min(2 * y, job->height - 1)) * job->width * 4;
+		const float* row1 = job->source + static_cast<uint64>(std::min(2 * y + 1, job->height - 1)) * job->width * 4;
+		float* out = job->destination + static_cast<uint64>(y) * job->half_width * 4;
+
+		for (uint32 x = 0; x < job->half_width; ++x) {
+			const uint32 x0 = std::min(2 * x, job->width - 1) * 4;
+			const uint32 x1 = std::min(2 * x + 1, job->width - 1) * 4;
+			const Pixel top = pixel_add(pixel_load(row0 + x0), pixel_load(row0 + x1));
+			const Pixel bottom = pixel_add(pixel_load(row1 + x0), pixel_load(row1 + x1));
+			pixel_store(out + x * 4, pixel_scale(pixel_add(top, bottom), 0.25f));
+		}
+	}
+}
+
+// Horizontal Kaiser pass: width x height -> half_width x height.
+void kaiser_rows_horizontal(void* user_data, uint32 begin, uint32 end)
+{
+	const DownsampleJob* job = static_cast<const DownsampleJob*>(user_data);
+	const KaiserTaps& taps = kaiser_taps();
+	const int last = static_cast<int>(job->width) - 1;
+
+	for (uint32 y = begin; y < end; ++y) {
+		const float* row = job->source + static_cast<uint64>(y) * job->width * 4;
+		float* out = job->destination + static_cast<uint64>(y) * job->half_width * 4;
+
+		for (uint32 x = 0; x < job->half_width; ++x) {
+			Pixel sum = pixel_zero();
+			for (int i = 0; i < KAISER_TAPS; ++i) {
+				const int sx = std::clamp(static_cast<int>(2 * x) + KAISER_FIRST_TAP + i, 0, last);
+				sum = pixel_add(sum, pixel_scale(pixel_load(row + sx * 4), taps.weights[i]));
+			}
+			pixel_store(out + x * 4, sum);
+		}
+	}
+}
+
+// Vertical Kaiser pass: half_width x height -> half_width x half_height.
+void kaiser_rows_vertical(void* user_data, uint32 begin, uint32 end)
+{
+	const DownsampleJob* job = static_cast<const DownsampleJob*>(user_data);
+	const KaiserTaps& taps = kaiser_taps();
+	const int last = static_cast<int>(job->height) - 1;
+	const uint64 stride = static_cast<uint64>(job->half_width) * 4;
+
+	for (uint32 y = begin; y < end; ++y) {
+		const float* rows[KAISER_TAPS];
+		for (int i = 0; i < KAISER_TAPS; ++i) {
+			rows[i] = job->source + std::clamp(static_cast<int>(2 * y) + KAISER_FIRST_TAP + i, 0, last) * stride;
+		}
+		float* out = job->destination + y * stride;
+
+		for (uint32 x = 0; x < job->half_width; ++x) {
+			Pixel sum = pixel_zero();
+			for (int i = 0; i < KAISER_TAPS; ++i) {
+				sum = pixel_add(sum, pixel_scale(pixel_load(rows[i] + x * 4), taps.weights[i]));
+			}
+			pixel_store(out + x * 4, sum);
+		}
+	}
+}
+
+struct ConvertJob {
+	uint8* bytes;
+	float* linear;
+	uint32 width;
+	bool srgb;
+};
+
+void to_linear_rows(void* user_data, uint32 begin, uint32 end)
+{
+	const ConvertJob* job = static_cast<const ConvertJob*>(user_data);
+	const ColorTables& tables = color_tables();
+
+	for (uint64 i = static_cast<uint64>(begin) * job->width; i < static_cast<uint64>(end) * job->width; ++i) {
+		const uint8* in = job->bytes + i * 4;
+		float* out = job->linear + i * 4;
+		for (int c = 0; c < 3; ++c) {
+			out[c] = job->srgb ? tables.srgb_to_linear[in[c]] : in[c] / 255.0f;
+		}
+		out[3] = in[3] / 255.0f;
+	}
+}
+
+void to_bytes_rows(void* user_data, uint32 begin, uint32 end)
+{
+	const ConvertJob* job = static_cast<const ConvertJob*>(user_data);
+	const ColorTables& tables = color_tables();
+	const float* thresholds_end = tables.srgb_thresholds + 255;
+
+	for (uint64 i = static_cast<uint64>(begin) * job->width; i < static_cast<uint64>(end) * job->width; ++i) {
+		const float* in = job->linear + i * 4;
+		uint8* out = job->bytes + i * 4;
+		for (int c = 0; c < 4; ++c) {
+			const float value = std::clamp(in[c], 0.0f, 1.0f);
+			if (job->srgb && c < 3) {
+				out[c] = static_cast<uint8>(std::upper_bound(tables.srgb_thresholds, thresholds_end, value) - tables.srgb_thresholds);
+			}
+			else {
+				out[c] = static_cast<uint8>(std::lround(value * 255.0f));
+			}
+		}
+	}
+}
+
+uint64 align_up(uint64 value, uint64 alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool read_file(const char* path, std::vector<uint8>* bytes)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	const std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	bytes->resize(static_cast<std::size_t>(size));
+	return size == 0 || file.read(reinterpret_cast<char*>(bytes->data()), size).good();
+}
+
+} // namespace
+
+uint64 texture_cook_hash(const void* source, uint64 source_size, const TextureCookSettings* settings)
+{
+	const uint32 fields[] = {
+		HTEX_VERSION,
+		static_cast<uint32>(settings->format),
+		settings->srgb ? 1u : 0u,
+		settings->generate_mips ? 1u : 0u,
+		static_cast<uint32>(settings->mip_filter)
+	};
+	return hash_bytes(fields, sizeof(fields), hash_bytes(source, static_cast<std::size_t>(source_size)));
+}
+
+void texture_downsample(JobSystem* jobs, MipFilter filter, const float* source, uint32 width, uint32 height, float* destination)
+{
+	DownsampleJob job{};
+	job.source = source;
+	job.destination = destination;
+	job.width = width;
+	job.height = height;
+	job.half_width = std::max(width / 2, 1u);
+	job.half_height = std::max(height / 2, 1u);
+
+	if (filter == MIP_FILTER_BOX) {
+		job_system_parallel_for(jobs, job.half_height, 8, box_rows, &job);
+		return;
+	}
+
+	std::vector<float> horizontal(static_cast<std::size_t>(job.half_width) * height * 4);
+	job.destination = horizontal.data();
+	job_system_parallel_for(jobs, height, 8, kaiser_rows_horizontal, &job);
+
+	job.source = horizontal.data();
+	job.destination = destination;
+	job_system_parallel_for(jobs, job.half_height, 8, kaiser_rows_vertical, &job);
+}
+
+bool texture_cook(JobSystem* jobs, const void* source, uint64 source_size, const TextureCookSettings* settings,
+	std::vector<uint8>* output)
+{
+	RT_ASSERT(settings != nullptr && output != nullptr, "Texture cook needs settings and an output");
+
+	ImageInfo info{};
+	uint8* pixels = image_decode_rgba8(source, source_size, nullptr, &info);
+	if (!pixels) {
+		return false;
+	}
+	const uint32 width = info.width;
+	const uint32 height = info.height;
+
+	const TextureFormat format = settings->format;
+	// BC5 holds data, never colour.
+	const bool srgb = settings->srgb && format != TEXTURE_FORMAT_BC5;
+	const uint32 mip_count = settings->generate_mips ? texture_mip_count(width, height) : 1;
+
+	HtexMip mips[HTEX_MAX_MIPS] = {};
+	uint64 offset = align_up(sizeof(HtexHeader) + mip_count * sizeof(HtexMip), HTEX_ALIGNMENT);
+	uint32 level_width = width;
+	uint32 level_height = height;
+	for (uint32 level = 0; level < mip_count; ++level) {
+		mips[level].offset = offset;
+		mips[level].size = texture_level_size(format, level_width, level_height);
+		mips[level].width = level_width;
+		mips[level].height = level_height;
+		offset = align_up(offset + mips[level].size, HTEX_ALIGNMENT);
+		level_width = std::max(level_width / 2, 1u);
+		level_height = std::max(level_height / 2, 1u);
+	}
+
+	output->assign(static_cast<std::size_t>(offset), 0);
+	HtexHeader header{};
+	header.magic = HTEX_MAGIC;
+	header.version = HTEX_VERSION;
+	header.format = format;
+	header.flags = srgb ? static_cast<uint32>(TEXTURE_FLAG_SRGB) : 0u;
+	header.width = width;
+	header.height = height;
+	header.mip_count = mip_count;
+	header.source_hash = texture_cook_hash(source, source_size, settings);
+	std::memcpy(output->data(), &header, sizeof(header));
+	std::memcpy(output->data() + sizeof(header), mips, mip_count * sizeof(HtexMip));
+
+	// The top level is encoded straight from the decoded bytes; smaller levels are filtered in
+	// linear light and converted back once per level.
+	texture_compress(jobs, format, pixels, header.width, header.height, output->data() + mips[0].offset);
+
+	if (mip_count > 1) {
+		std::vector<float> current(static_cast<std::size_t>(header.width) * header.height * 4);
+		std::vector<float> next;
+		std::vector<uint8> bytes;
+
+		ConvertJob convert{ pixels, current.data(), header.width, srgb };
+		job_system_parallel_for(jobs, header.height, 16, to_linear_rows, &convert);
+
+		for (uint32 level = 1; level < mip_count; ++level) {
+			const HtexMip& parent = mips[level - 1];
+			const HtexMip& mip = mips[level];
+			next.resize(static_cast<std::size_t>(mip.width) * mip.height * 4);
+			texture_downsample(jobs, settings->mip_filter, current.data(), parent.width, parent.height, next.data());
+
+			bytes.resize(static_cast<std::size_t>(mip.width) * mip.height * 4);
+			convert = { bytes.data(), next.data(), mip.width, srgb };
+			job_system_parallel_for(jobs, mip.height, 16, to_bytes_rows, &convert);
+
+			texture_compress(jobs, format, bytes.data(), mip.width, mip.height, output->data() + mip.offset);
+			current.swap(next);
+		}
+	}
+
+	image_decode_free(nullptr, pixels);
+	return true;
+}
+
+bool texture_cook_file(JobSystem* jobs, const char* source_path, const char* output_path,
+	const TextureCookSettings* settings, bool* cooked)
+{
+	if (cooked) {
+		*cooked = false;
+	}
+
+	std::vector<uint8> source;
+	if (!read_file(source_path, &source)) {
+		std::cout << "ERROR::TEXTURE_COOK::READ_FAILED " << source_path << std::endl;
+		return false;
+	}
+
+	const uint64 hash = texture_cook_hash(source.data(), source.size(), settings);
+	{
+		std::ifstream existing(output_path, std::ios::binary);
+		HtexHeader header{};
+		if (existing && existing.read(reinterpret_cast<char*>(&header), sizeof(header))
+			&& header.magic == HTEX_MAGIC && header.version == HTEX_VERSION && header.source_hash == hash) {
+			return true;
+		}
+	}
+
+	std::vector<uint8> output;
+	if (!texture_cook(jobs, source.data(), source.size(), settings, &output)) {
+		return false;
+	}
+
+	const std::filesystem::path parent = std::filesystem::path(output_path).parent_path();
+	if (!parent.empty()) {
+		std::error_code error;
+		std::filesystem::create_directories(parent, error);
+	}
+
+	std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+	if (!out || !out.write(reinterpret_cast<const char*>(output.data()), static_cast<std::streamsize>(output.size()))) {
+		std::cout << "ERROR::TEXTURE_COOK::WRITE_FAILED " << output_path << std::endl;
+		return false;
+	}
+
+	if (cooked) {
+		*cooked = true;
+	}
+	return true;
+}
@@ -0,0 +1,146 @@
+#include "texture_loader.h"
+#include "image_decode.h"
+#include "engine_arena.h"
+#include "engine_assert.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+// stb's peak working set for a decode; larger images spill to the heap.
+constexpr std::size_t TEXTURE_DECODE_SCRATCH_SIZE = 64 * 1024 * 1024;
+
+struct DecodeScratch {
+	Arena arena{ .total_size = TEXTURE_DECODE_SCRATCH_SIZE };
+
+	DecodeScratch() { engine_create_arena(&arena); }
+	~DecodeScratch() { engine_destroy_arena(&arena); }
+};
+
+// One per asset worker, created on its first texture.
+thread_local DecodeScratch t_decode_scratch;
+
+// What decode reads; fixed when the load is requested.
+struct TextureDecodeParams {
+	TextureUploader* uploader;
+	bool srgb;
+};
+
+// What decode produces. A load that never uploads hands its slot back when this is freed.
+struct TextureDecoded {
+	TextureUploader* uploader = nullptr;
+	TextureUploadSlot* slot = nullptr;
+	HtexHeader header{};
+	HtexMip mips[HTEX_MAX_MIPS]{};
+
+	~TextureDecoded()
+	{
+		if (slot) {
+			texture_uploader_release(uploader, slot);
+		}
+	}
+};
+
+bool copy_cooked(TextureDecoded* decoded, const HtexHeader* header, const void* data, uint64 size)
+{
+	decoded->header = *header;
+	std::memcpy(decoded->mips, htex_mips(header), header->mip_count * sizeof(HtexMip));
+
+	decoded->slot = texture_uploader_acquire(decoded->uploader, size);
+	if (!decoded->slot) {
+		return false;
+	}
+	// Mip offsets are relative to the start of the file, which is also the start of the slot.
+	std::memcpy(decoded->slot->mapped, data, size);
+	return true;
+}
+
+bool decode_image(TextureDecoded* decoded, bool srgb, const void* data, uint64 size)
+{
+	Arena* scratch = &t_decode_scratch.arena;
+	ImageInfo info{};
+	uint8* pixels = image_decode_rgba8(data, size, scratch, &info);
+	if (!pixels) {
+		engine_reset_arena(scratch);
+		return false;
+	}
+
+	const uint64 level_size = texture_level_size(TEXTURE_FORMAT_RGBA8, info.width, info.height);
+	decoded->header = {};
+	decoded->header.magic = HTEX_MAGIC;
+	decoded->header.version = HTEX_VERSION;
+	decoded->header.format = TEXTURE_FORMAT_RGBA8;
+	decoded->header.flags = srgb ? static_cast<uint32>(TEXTURE_FLAG_SRGB) : 0u;
+	decoded->header.width = info.width;
+	decoded->header.height = info.height;
+	decoded->header.mip_count = 1;
+	decoded->mips[0] = { 0, level_size, info.width, info.height };
+
+	decoded->slot = texture_uploader_acquire(decoded->uploader, level_size);
+	if (decoded->slot) {
+		std::memcpy(decoded->slot->mapped, pixels, level_size);
+	}
+
+	image_decode_free(scratch, pixels);
+	engine_reset_arena(scratch);
+	return decoded->slot != nullptr;
+}
+
+bool decode_texture(AssetLoad* load)
+{
+	const TextureDecodeParams* params = static_cast<const TextureDecodeParams*>(load->request.decode_data.get());
+	auto decoded = std::make_shared<TextureDecoded>();
+	decoded->uploader = params->uploader;
+	load->decoded = decoded;
+
+	const uint64 size = load->bytes.size();
+	if (const HtexHeader* header = htex_validate(load->bytes.data(), size)) {
+		return copy_cooked(decoded.get(), header, load->bytes.data(), size);
+	}
+	return decode_image(decoded.get(), params->srgb, load->bytes.data(), size);
+}
+
+void upload_texture(AssetLoad* load)
+{
+	TextureLoad* texture_load = static_cast<TextureLoad*>(load->request.user_data);
+	TextureDecoded* decoded = static_cast<TextureDecoded*>(load->decoded.get());
+
+	// Hot reload loads an edited file again for the same TextureLoad; the old texture stays until the
+	// new one exists.
+	Texture texture{};
+	const bool created = texture_uploader_upload(decoded->uploader, decoded->slot, &texture,
+		&decoded->header, decoded->mips, texture_load->generate_mips);
+	decoded->slot = nullptr;
+	if (!created) {
+		std::cout << "ERROR::TEXTURE_LOADER::UPLOAD_FAILED " << load->request.path << std::endl;
+		return;
+	}
+	texture_destroy(&texture_load->texture);
+	texture_load->texture = texture;
+
+	if (texture_load->on_loaded) {
+		texture_load->on_loaded(load);
+	}
+}
+
+} // namespace
+
+void texture_load_async(AssetStream* stream, TextureUploader* uploader, TextureLoad* load, const char* path,
+	AssetPriority priority, AssetUploadFn on_loaded)
+{
+	RT_ASSERT(stream != nullptr && uploader != nullptr && load != nullptr, "Texture load passed nullptr");
+
+	load->uploader = uploader;
+	load->on_loaded = on_loaded;
+
+	AssetRequest request{};
+	request.path = path;
+	request.priority = priority;
+	request.decode = decode_texture;
+	request.decode_data = std::make_shared<const TextureDecodeParams>(TextureDecodeParams{ uploader, load->srgb });
+	request.upload = upload_texture;
+	request.user_data = load;
+	asset_stream_request(stream, std::move(request));
+}
@@ -0,0 +1,271 @@
+#include "vfs.h"
+#include "file_io.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32 VFS_MIN_SLOTS = 256;
+
+const VfsSlot* find_slot(const Vfs* vfs, AssetId id)
+{
+	if (vfs->slots.empty()) {
+		return nullptr;
+	}
+
+	const std::size_t mask = vfs->slots.size() - 1;
+	for (std::size_t i = static_cast<std::size_t>(id) & mask;; i = (i + 1) & mask) {
+		const VfsSlot& slot = vfs->slots[i];
+		if (slot.mount == 0) {
+			return nullptr;
+		}
+		if (slot.id == id) {
+			return &slot;
+		}
+	}
+}
+
+void insert_slot(std::vector<VfsSlot>& slots, const std::vector<VfsMount>& mounts, const VfsSlot& entry, uint32* count)
+{
+	const std::size_t mask = slots.size() - 1;
+	for (std::size_t i = static_cast<std::size_t>(entry.id) & mask;; i = (i + 1) & mask) {
+		VfsSlot& slot = slots[i];
+		if (slot.mount == 0) {
+			slot = entry;
+			(*count)++;
+			return;
+		}
+		if (slot.id == entry.id) {
+			if (mounts[entry.mount - 1].priority >= mounts[slot.mount - 1].priority) {
+				slot = entry;
+			}
+			return;
+		}
+	}
+}
+
+// Keeps the table at most half full so probe sequences stay short.
+void reserve_slots(Vfs* vfs, std::size_t additional)
+{
+	std::size_t capacity = vfs->slots.empty() ? VFS_MIN_SLOTS : vfs->slots.size();
+	while ((vfs->count + additional) * 2 > capacity) {
+		capacity *= 2;
+	}
+	if (capacity == vfs->slots.size()) {
+		return;
+	}
+
+	std::vector<VfsSlot> old;
+	old.swap(vfs->slots);
+	vfs->slots.assign(capacity, VfsSlot{});
+	vfs->count = 0;
+	for (const VfsSlot& slot : old) {
+		if (slot.mount != 0) {
+			insert_slot(vfs->slots, vfs->mounts, slot, &vfs->count);
+		}
+	}
+}
+
+int64 read_directory_file(const std::string& path, void* destination, uint64 size)
+{
+	FileHandle file = file_io_open(path.c_str(), FILE_OPEN_DEFAULT);
+	if (!file_io_is_valid(file)) {
+		return -1;
+	}
+	const int64 result = file_io_read(file, destination, size, 0);
+	file_io_close(file);
+	return result;
+}
+
+int64 directory_file_size(const std::string& path)
+{
+	FileHandle file = file_io_open(path.c_str(), FILE_OPEN_DEFAULT);
+	if (!file_io_is_valid(file)) {
+		return -1;
+	}
+	const int64 size = file_io_size(file);
+	file_io_close(file);
+	return size;
+}
+
+} // namespace
+
+bool vfs_mount_directory(Vfs* vfs, const char* root, int32 priority)
+{
+	RT_ASSERT(vfs != nullptr, "Vfs is nullptr");
+
+	std::error_code error;
+	if (!fs::is_directory(root, error)) {
+		std::cout << "ERROR::VFS::NOT_A_DIRECTORY " << root << std::endl;
+		return false;
+	}
+
+	VfsMount mount{};
+	mount.type = VFS_MOUNT_DIRECTORY;
+	mount.priority = priority;
+	mount.root = root;
+
+	for (fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, error), end;
+		it != end; it.increment(error)) {
+		if (error) {
+			break;
+		}
+		if (it->is_regular_file(error)) {
+			mount.files.push_back(it->path().string());
+		}
+	}
+
+	vfs->mounts.push_back(std::move(mount));
+	const uint32 mount_number = static_cast<uint32>(vfs->mounts.size());
+	const VfsMount& mounted = vfs->mounts.back();
+
+	reserve_slots(vfs, mounted.files.size());
+	for (uint32 i = 0; i < mounted.files.size(); ++i) {
+		const std::string relative = fs::path(mounted.files[i]).lexically_relative(root).generic_string();
+		insert_slot(vfs->slots, vfs->mounts, { hash_path(relative.c_str(), relative.size()), mount_number, i }, &vfs->count);
+	}
+
+	std::cout << "Mounted directory " << root << " (" << mounted.files.size() << " files)" << std::endl;
+	return true;
+}
+
+bool vfs_mount_pack(Vfs* vfs, const char* pack_path, int32 priority)
+{
+	RT_ASSERT(vfs != nullptr, "Vfs is nullptr");
+
+	VfsMount mount{};
+	mount.type = VFS_MOUNT_PACK;
+	mount.priority = priority;
+	mount.root = pack_path;
+	mount.pack = std::make_unique<AssetPack>();
+
+	if (!asset_pack_open(mount.pack.get(), pack_path)) {
+		return false;
+	}
+
+	vfs->mounts.push_back(std::move(mount));
+	const uint32 mount_number = static_cast<uint32>(vfs->mounts.size());
+	const AssetPack* pack = vfs->mounts.back().pack.get();
+
+	reserve_slots(vfs, pack->header->entry_count);
+	for (uint32 i = 0; i < pack->header->entry_count; ++i) {
+		insert_slot(vfs->slots, vfs->mounts, { pack->entries[i].path_hash, mount_number, i }, &vfs->count);
+	}
+
+	std::cout << "Mounted pack " << pack_path << " (" << pack->header->entry_count << " entries)" << std::endl;
+	return true;
+}
+
+void vfs_shutdown(Vfs* vfs)
+{
+	for (VfsMount& mount : vfs->mounts) {
+		if (mount.pack) {
+			asset_pack_close(mount.pack.get());
+		}
+	}
+	vfs->mounts.clear();
+	vfs->slots.clear();
+	vfs->count = 0;
+}
+
+bool vfs_exists(const Vfs* vfs, AssetId id)
+{
+	return find_slot(vfs, id) != nullptr;
+}
+
+int64 vfs_size(const Vfs* vfs, AssetId id)
+{
+	const VfsSlot* slot = find_slot(vfs, id);
+	if (!slot) {
+		return -1;
+	}
+
+	const VfsMount& mount = vfs->mounts[slot->mount - 1];
+	if (mount.type == VFS_MOUNT_PACK) {
+		return static_cast<int64>(mount.pack->entries[slot->index].size);
+	}
+	return directory_file_size(mount.files[slot->index]);
+}
+
+const char* vfs_name(const Vfs* vfs, AssetId id)
+{
+	const VfsSlot* slot = find_slot(vfs, id);
+	if (!slot) {
+		return nullptr;
+	}
+
+	const VfsMount& mount = vfs->mounts[slot->mount - 1];
+	if (mount.type == VFS_MOUNT_PACK) {
+		return asset_pack_entry_name(mount.pack.get(), &mount.pack->entries[slot->index]);
+	}
+	return mount.files[slot->index].c_str();
+}
+
+bool vfs_load(const Vfs* vfs, AssetId id, Arena* arena, VfsFile* file)
+{
+	const VfsSlot* slot = find_slot(vfs, id);
+	if (!slot) {
+		return false;
+	}
+
+	const VfsMount& mount = vfs->mounts[slot->mount - 1];
+	if (mount.type == VFS_MOUNT_PACK) {
+		const PackEntry* entry = &mount.pack->entries[slot->index];
+		file->data = asset_pack_load(mount.pack.get(), entry, arena);
+		file->size = entry->size;
+		return file->data != nullptr;
+	}
+
+	const std::string& path = mount.files[slot->index];
+	const int64 size = directory_file_size(path);
+	if (size < 0) {
+		return false;
+	}
+
+	void* data = engine_allocate_bytes(arena, static_cast<std::size_t>(size), 16);
+	if (!data || read_directory_file(path, data, static_cast<uint64>(size)) != size) {
+		return false;
+	}
+
+	file->data = data;
+	file->size = static_cast<uint64>(size);
+	return true;
+}
+
+const char* vfs_load_text(const Vfs* vfs, AssetId id, Arena* arena)
+{
+	const VfsSlot* slot = find_slot(vfs, id);
+	if (!slot) {
+		return nullptr;
+	}
+
+	const VfsMount& mount = vfs->mounts[slot->mount - 1];
+	char* text = nullptr;
+
+	if (mount.type == VFS_MOUNT_PACK) {
+		const PackEntry* entry = &mount.pack->entries[slot->index];
+		text = static_cast<char*>(engine_allocate_bytes(arena, static_cast<std::size_t>(entry->size) + 1, 1));
+		if (!text || !asset_pack_read(mount.pack.get(), entry, text)) {
+			return nullptr;
+		}
+		text[entry->size] = '\0';
+		return text;
+	}
+
+	const std::string& path = mount.files[slot->index];
+	const int64 size = directory_file_size(path);
+	if (size < 0) {
+		return nullptr;
+	}
+
+	text = static_cast<char*>(engine_allocate_bytes(arena, static_cast<std::size_t>(size) + 1, 1));
+	if (!text || read_directory_file(path, text, static_cast<uint64>(size)) != size) {
+		return nullptr;
+	}
+	text[size] = '\0';
+	return text;
+}
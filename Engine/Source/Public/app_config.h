@@ -4,7 +4,37 @@ struct AppConfig
 	int width{};
 	int height{};
 	const char* title;
+
+	const char* asset_root;
+	const char* asset_pack;
+
+	unsigned int asset_worker_count{};
+	unsigned long long asset_memory_budget{};
+	double asset_upload_budget_ms{};
+
+	unsigned int texture_upload_slot_count{};
+	unsigned long long texture_upload_slot_size{};
+
+	// Directory for linked shader program binaries; empty disables the cache.
+	const char* shader_cache;
+	// CSV of per-scope GPU timings written on shutdown; null skips the export.
+	const char* gpu_profile;
+
+	// Watch asset_root and rebuild shaders/assets when their files change.
+	bool hot_reload{};
+
+	// Render into an offscreen target without showing a window; works without a display.
+	bool headless{};
+	// Stop after this many frames and print frame timings; 0 runs until the window closes.
+	unsigned int frame_limit{};
+	// Run the renderer against the null backend: every GL call is checked and counted but nothing
+	// reaches a GPU, so frame times are the engine's own. Needs no display or GL driver.
+	bool null_backend{};
 };
 
 void app_config_init(AppConfig* appConfig);
 
+// Applies --headless, --frames <count> and --null-backend on top of the defaults. Returns false on
+// anything else.
+bool app_config_parse_args(AppConfig* config, int argc, char** argv);
+
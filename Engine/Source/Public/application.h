@@ -4,21 +4,48 @@
 #include "app_config.h"
 #include "engine_config.h"
 #include "engine_arena.h"
+#include "asset_stream.h"
+#include "vfs.h"
+#include "hot_reload.h"
+#include "ecs.h"
+#include <texture_upload.h>
+#include <shader_reload.h>
 
 #include <GLFW/glfw3.h>
 
+#include <memory>
+#include <vector>
 
 
+
+// With hot reload on, every asset requested from under asset_root is requested again, the same way,
+// when its file changes, until asset_stream_forget is called for its user_data. One per file and
+// user_data; upload callbacks replace what the earlier load created.
+struct AssetReload {
+	AssetStream* stream;
+	AssetRequest request;
+};
+
 struct Application
 {
 	AppConfig app_config{};
 	RendererInterface* renderer_interface{};
+	AssetStream* asset_stream{};
+	TextureUploader* texture_uploader{};
+	Vfs* vfs{};
+	// Entities and their components; chunks come out of global storage.
+	EcsWorld* world{};
+	// Only created when app_config.hot_reload is set.
+	HotReload* hot_reload{};
+	ShaderReloader* shader_reloader{};
+	std::vector<std::unique_ptr<AssetReload>> asset_reloads{};
 	GLFWwindow* game_window = nullptr;
 
 	Application() = default;
 };
 
-bool application_init(Application* app, Arena* frame_storage);
+// argv may carry the options understood by app_config_parse_args.
+bool application_init(Application* app, Arena* frame_storage, int argc = 0, char** argv = nullptr);
 
 void application_run(Application* app, Arena* frame_storage);
 
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_arena.h"
+
+#include <string>
+#include <vector>
+
+// Single-file asset archive.
+//
+//   PackHeader | entry data (each entry PACK_ALIGNMENT aligned) | chunk table | TOC | name blob
+//
+// The TOC is sorted by path hash and searched with a binary search. Entries are either stored raw,
+// so the reader can hand out pointers straight into the mapping, or split into PACK_CHUNK_SIZE chunks
+// compressed independently with LZ4.
+
+constexpr uint32 PACK_MAGIC = 0x4B415048; // "HPAK"
+constexpr uint32 PACK_VERSION = 1;
+constexpr uint64 PACK_ALIGNMENT = 4096;
+constexpr uint32 PACK_CHUNK_SIZE = 64 * 1024;
+
+enum PackEntryFlags {
+	PACK_ENTRY_COMPRESSED = 1 << 0
+};
+
+struct PackHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 entry_count;
+	uint32 chunk_count;
+	uint64 toc_offset;
+	uint64 chunk_table_offset;
+	uint64 names_offset;
+	uint64 names_size;
+};
+
+struct PackEntry {
+	uint64 path_hash;
+	uint64 offset;
+	uint64 size;
+	uint64 stored_size;
+	uint32 flags;
+	uint32 first_chunk;
+	uint32 chunk_count;
+	uint32 name_offset;
+};
+
+struct PackChunk {
+	uint64 offset;
+	uint32 stored_size;
+	uint32 size;
+};
+
+static_assert(sizeof(PackHeader) == 48, "PackHeader layout is part of the file format");
+static_assert(sizeof(PackEntry) == 48, "PackEntry layout is part of the file format");
+static_assert(sizeof(PackChunk) == 16, "PackChunk layout is part of the file format");
+
+struct AssetPack {
+	const char* base = nullptr;
+	uint64 size = 0;
+	const PackHeader* header = nullptr;
+	const PackEntry* entries = nullptr;
+	const PackChunk* chunks = nullptr;
+	const char* names = nullptr;
+
+#if defined(_WIN32)
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
+
+// Checks every entry and chunk against the file, so the functions below can trust them; a corrupt or
+// truncated pack fails to open.
+bool asset_pack_open(AssetPack* pack, const char* path);
+void asset_pack_close(AssetPack* pack);
+
+const PackEntry* asset_pack_find(const AssetPack* pack, uint64 path_hash);
+const char* asset_pack_entry_name(const AssetPack* pack, const PackEntry* entry);
+
+// Pointer into the mapping for entries stored raw, nullptr for compressed entries.
+const void* asset_pack_view(const AssetPack* pack, const PackEntry* entry);
+
+// Copies or decompresses the entry into destination, which must hold entry->size bytes.
+bool asset_pack_read(const AssetPack* pack, const PackEntry* entry, void* destination);
+
+// Raw entries are returned in place; compressed ones are decompressed into arena memory.
+const void* asset_pack_load(const AssetPack* pack, const PackEntry* entry, Arena* arena);
+
+struct AssetPackWriter {
+	struct Source {
+		std::string name;
+		std::vector<char> data;
+		bool compress;
+	};
+	std::vector<Source> sources{};
+};
+
+void asset_pack_writer_add(AssetPackWriter* writer, const char* name, const void* data, std::size_t size, bool compress);
+bool asset_pack_writer_finish(AssetPackWriter* writer, const char* output_path);
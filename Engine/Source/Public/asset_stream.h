@@ -0,0 +1,133 @@
+#pragma once
+
+#include "engine_types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum AssetPriority {
+	ASSET_PRIORITY_CRITICAL,
+	ASSET_PRIORITY_HIGH,
+	ASSET_PRIORITY_NORMAL,
+	ASSET_PRIORITY_LOW
+};
+
+enum AssetStatus {
+	ASSET_STATUS_PENDING,
+	ASSET_STATUS_LOADED,
+	ASSET_STATUS_FAILED,
+	ASSET_STATUS_CANCELLED
+};
+
+struct AssetLoad;
+
+// Runs on a worker after the file is read. Returning false marks the load as failed. Decode must not
+// touch user_data, which the draining thread may be using or have forgotten meanwhile: it reads from
+// decode_data and decodes into AssetLoad::decoded, and upload swaps the result in.
+using AssetDecodeFn = bool (*)(AssetLoad* load);
+// Runs on the thread that calls asset_stream_drain, which owns the GL context.
+using AssetUploadFn = void (*)(AssetLoad* load);
+
+struct AssetRequest {
+	std::string path{};
+	AssetPriority priority = ASSET_PRIORITY_NORMAL;
+	AssetDecodeFn decode = nullptr;
+	// Read-only input for decode, shared with the request's reloads.
+	std::shared_ptr<const void> decode_data{};
+	AssetUploadFn upload = nullptr;
+	// For loaders that wrap upload: the caller's callback, run once the asset is in place.
+	AssetUploadFn on_loaded = nullptr;
+	// Must stay alive until the upload has run, or until asset_stream_forget.
+	void* user_data = nullptr;
+};
+
+// Sees every request as it is made, on the requesting thread.
+using AssetRequestHookFn = void (*)(const AssetRequest& request, void* user_data);
+// Sees every asset_stream_forget.
+using AssetForgetHookFn = void (*)(void* request_user_data, void* user_data);
+
+struct AssetLoad {
+	AssetRequest request{};
+	AssetStatus status = ASSET_STATUS_PENDING;
+	std::vector<char> bytes{};
+	// Whatever decode produced; freed with the load, so a load that never uploads cleans up after itself.
+	std::shared_ptr<void> decoded{};
+	// Bytes charged against the stream's memory budget until the upload has run.
+	uint64 memory_bytes = 0;
+};
+
+struct AssetStreamStats {
+	uint32 requested = 0;
+	uint32 uploaded = 0;
+	uint32 failed = 0;
+	uint32 cancelled = 0;
+	uint32 pending = 0;
+	uint64 memory_in_flight = 0;
+};
+
+struct AssetStream {
+	struct Pending {
+		AssetPriority priority;
+		uint64 sequence;
+		std::unique_ptr<AssetLoad> load;
+
+		bool operator<(const Pending& other) const
+		{
+			// std::priority_queue pops the largest element: lowest enum value first, then FIFO.
+			if (priority != other.priority) return priority > other.priority;
+			return sequence > other.sequence;
+		}
+	};
+
+	std::vector<std::thread> workers{};
+
+	std::mutex request_mutex{};
+	std::condition_variable request_cv{};
+	std::priority_queue<Pending> requests{};
+	uint64 next_sequence = 0;
+	bool running = false;
+	// The load each worker is reading or decoding, nullptr when idle. Guarded by request_mutex, as is
+	// the status of those loads.
+	std::vector<AssetLoad*> decoding{};
+
+	std::mutex completed_mutex{};
+	std::vector<std::unique_ptr<AssetLoad>> completed{};
+	// Taken from completed by asset_stream_drain, and the next one it will upload. Draining thread only.
+	std::vector<std::unique_ptr<AssetLoad>> uploading{};
+	std::size_t upload_next = 0;
+
+	uint64 memory_budget = 0;
+	std::atomic<uint64> memory_in_flight{ 0 };
+
+	// Set by the application to watch requested files for hot reload.
+	AssetRequestHookFn request_hook = nullptr;
+	AssetForgetHookFn forget_hook = nullptr;
+	void* hook_data = nullptr;
+
+	std::atomic<uint32> requested{ 0 };
+	std::atomic<uint32> uploaded{ 0 };
+	std::atomic<uint32> failed{ 0 };
+	std::atomic<uint32> cancelled{ 0 };
+};
+
+void asset_stream_init(AssetStream* stream, uint32 worker_count, uint64 memory_budget);
+void asset_stream_shutdown(AssetStream* stream);
+
+void asset_stream_request(AssetStream* stream, AssetRequest request);
+
+// Drops every request made with user_data that has not uploaded yet and tells the forget hook, so hot
+// reload stops requesting it. Call from the draining thread, possibly inside an upload callback; the
+// stream no longer touches user_data once it returns.
+void asset_stream_forget(AssetStream* stream, void* user_data);
+
+// Runs upload callbacks for finished loads until the queue is empty or time_budget_ms has passed.
+// At least one upload runs per call so a slow asset can't starve the queue. Returns the number uploaded.
+uint32 asset_stream_drain(AssetStream* stream, double time_budget_ms);
+
+AssetStreamStats asset_stream_stats(AssetStream* stream);
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_arena.h"
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+struct JobSystem;
+
+// Archetype entity component system. Every distinct set of components is an archetype, and its
+// entities live in fixed ECS_CHUNK_SIZE chunks taken from the arena given to ecs_init. Inside a chunk
+// each component is one contiguous array, so a query walks chunk after chunk, array after array, and
+// never follows a pointer per entity. Removing an entity moves the archetype's last entity into the
+// hole, which keeps every chunk but the last one full. Emptied chunks go on a free list for any
+// archetype to reuse, since the arena never frees.
+//
+// Components are plain data: they are zeroed on creation and moved with memcpy. Structural changes
+// (creating and destroying entities, adding and removing components) move entities between chunks,
+// so they are not allowed while a query runs; record them in an EcsCommandBuffer and apply it after.
+// Only ecs_commands_create may be called from several threads at once.
+
+constexpr uint32 ECS_CHUNK_SIZE = 16 * 1024;
+constexpr uint32 ECS_MAX_COMPONENTS = 64;
+// Component arrays in a chunk start on a cache line.
+constexpr uint32 ECS_COLUMN_ALIGNMENT = 64;
+constexpr uint32 ECS_NONE = 0xFFFFFFFF;
+
+using EcsComponentMask = uint64;
+
+struct Entity {
+	uint32 index;
+	// Bumped when the index is freed, so stale handles stop resolving.
+	uint32 generation;
+};
+
+constexpr Entity ECS_NULL_ENTITY{ ECS_NONE, 0 };
+
+inline bool operator==(const Entity& a, const Entity& b)
+{
+	return a.index == b.index && a.generation == b.generation;
+}
+
+constexpr EcsComponentMask ecs_mask(uint32 component)
+{
+	return EcsComponentMask(1) << component;
+}
+
+struct EcsComponentInfo {
+	const char* name;
+	uint32 size;
+	uint32 alignment;
+};
+
+struct EcsChunk {
+	uint8* data;
+	uint32 count;
+};
+
+struct EcsArchetype {
+	EcsComponentMask mask;
+	// Component ids in ascending order.
+	std::vector<uint32> components{};
+	// Byte offset of each component's array in a chunk, indexed by component id; ECS_NONE if absent.
+	// The entity array is at offset 0.
+	uint32 offsets[ECS_MAX_COMPONENTS];
+	// Entities per chunk.
+	uint32 capacity;
+	std::vector<EcsChunk> chunks{};
+	uint32 count;
+	// Archetype reached by adding or removing a component, filled in as transitions happen.
+	uint32 add_edge[ECS_MAX_COMPONENTS];
+	uint32 remove_edge[ECS_MAX_COMPONENTS];
+};
+
+struct EcsEntityRecord {
+	// ECS_NONE while free, or reserved by a command buffer and not yet created.
+	uint32 archetype;
+	uint32 chunk;
+	uint32 row;
+	uint32 generation;
+};
+
+struct EcsWorld {
+	Arena* storage = nullptr;
+	EcsComponentInfo components[ECS_MAX_COMPONENTS]{};
+	uint32 component_count = 0;
+
+	std::vector<EcsArchetype> archetypes{};
+	std::unordered_map<EcsComponentMask, uint32> archetype_lookup{};
+	std::vector<uint8*> free_chunks{};
+
+	// Indexed by Entity::index. Indices handed out by ecs_commands_create may run past the end until
+	// the buffer is applied; reserving never touches entities, so systems can read it meanwhile.
+	std::vector<EcsEntityRecord> entities{};
+	std::vector<uint32> free_entities{};
+	uint32 next_entity = 0;
+	// Guards free_entities and next_entity while command buffers reserve entities.
+	std::mutex entity_mutex{};
+	uint32 entity_count = 0;
+
+	// Queries running right now; structural changes assert it is zero.
+	std::atomic<uint32> iterating{ 0 };
+};
+
+// Chunks are allocated from storage, which must outlive the world.
+void ecs_init(EcsWorld* world, Arena* storage);
+// Frees the world's heap memory; the chunks go when storage does. The world is empty afterwards, with
+// no components registered.
+void ecs_shutdown(EcsWorld* world);
+
+uint32 ecs_register_component(EcsWorld* world, const char* name, uint32 size, uint32 alignment);
+
+template<typename T>
+uint32 ecs_register_component(EcsWorld* world, const char* name)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Components are moved with memcpy");
+	return ecs_register_component(world, name, sizeof(T), alignof(T));
+}
+
+// The new entity has every component in mask, zeroed.
+Entity ecs_create(EcsWorld* world, EcsComponentMask mask = 0);
+void ecs_destroy(EcsWorld* world, Entity entity);
+bool ecs_alive(const EcsWorld* world, Entity entity);
+
+// Adding a component the entity has, or removing one it lacks, does nothing.
+void ecs_add(EcsWorld* world, Entity entity, uint32 component);
+void ecs_remove(EcsWorld* world, Entity entity, uint32 component);
+bool ecs_has(const EcsWorld* world, Entity entity, uint32 component);
+
+// nullptr if the entity lacks the component. Valid until the next structural change.
+void* ecs_get(EcsWorld* world, Entity entity, uint32 component);
+
+template<typename T>
+T* ecs_get(EcsWorld* world, Entity entity, uint32 component)
+{
+	RT_ASSERT(world->components[component].size == sizeof(T), "Component type does not match its registered size");
+	return static_cast<T*>(ecs_get(world, entity, component));
+}
+
+// Matches archetypes that have every component in all and none in none. Matching archetypes are
+// cached in the query and topped up with archetypes created since, so keep queries around.
+struct EcsQuery {
+	EcsComponentMask all;
+	EcsComponentMask none;
+	std::vector<uint32> archetypes{};
+	uint32 archetypes_seen = 0;
+};
+
+struct EcsChunkView {
+	const EcsArchetype* archetype;
+	uint8* data;
+	uint32 count;
+};
+
+EcsQuery ecs_query(EcsComponentMask all, EcsComponentMask none = 0);
+
+inline const Entity* ecs_chunk_entities(const EcsChunkView* view)
+{
+	return reinterpret_cast<const Entity*>(view->data);
+}
+
+// The component's array in the chunk; view->count entries long. nullptr if the archetype lacks it.
+template<typename T>
+T* ecs_chunk_column(const EcsChunkView* view, uint32 component)
+{
+	const uint32 offset = view->archetype->offsets[component];
+	return offset == ECS_NONE ? nullptr : reinterpret_cast<T*>(view->data + offset);
+}
+
+using EcsChunkFn = void (*)(void* user_data, const EcsChunkView* view);
+
+// Calls function once per non-empty matching chunk. With jobs, chunks are spread over the workers and
+// function must be safe to run concurrently on different chunks.
+void ecs_query_for_each(EcsWorld* world, EcsQuery* query, EcsChunkFn function, void* user_data, JobSystem* jobs = nullptr);
+uint32 ecs_query_count(EcsWorld* world, EcsQuery* query);
+
+// Structural changes recorded for later, applied in the order they were recorded.
+struct EcsCommandBuffer {
+	std::vector<uint8> data{};
+	uint32 count = 0;
+};
+
+// Reserves the entity right away, so it can be referred to by later commands; it exists once the
+// buffer is applied. A buffer that reserved entities must be applied or discarded, or their indices
+// are never reused.
+Entity ecs_commands_create(EcsCommandBuffer* commands, EcsWorld* world, EcsComponentMask mask = 0);
+void ecs_commands_destroy(EcsCommandBuffer* commands, Entity entity);
+// Adds the component if missing and copies size bytes of value into it; value may be nullptr to
+// leave it zeroed, or unchanged if the entity already had it.
+void ecs_commands_add(EcsCommandBuffer* commands, Entity entity, uint32 component, const void* value = nullptr, uint32 size = 0);
+void ecs_commands_remove(EcsCommandBuffer* commands, Entity entity, uint32 component);
+
+template<typename T>
+void ecs_commands_set(EcsCommandBuffer* commands, Entity entity, uint32 component, const T& value)
+{
+	ecs_commands_add(commands, entity, component, &value, sizeof(T));
+}
+
+// Commands on entities that are no longer alive are skipped. Empties the buffer.
+void ecs_commands_apply(EcsWorld* world, EcsCommandBuffer* commands);
+// Empties the buffer without applying it and frees the entities it reserved. Same rules as apply.
+void ecs_commands_discard(EcsWorld* world, EcsCommandBuffer* commands);
+
+// A system declares the components it reads and writes. Systems are grouped into phases: each
+// system goes into the phase after the last earlier system it conflicts with (one writes what the
+// other reads or writes), so the declared order is kept wherever it matters. Systems of a phase
+// run in parallel, each with its own command buffer; the buffers are applied in system order once
+// the phase is done.
+using EcsSystemFn = void (*)(EcsWorld* world, EcsCommandBuffer* commands, void* user_data);
+
+struct EcsSystem {
+	const char* name;
+	EcsComponentMask reads;
+	EcsComponentMask writes;
+	EcsSystemFn function;
+	void* user_data;
+};
+
+struct EcsSchedule {
+	// In phase order.
+	std::vector<EcsSystem> systems{};
+	std::vector<EcsCommandBuffer> commands{};
+	// Start of each phase in systems.
+	std::vector<uint32> phases{};
+};
+
+void ecs_schedule_build(EcsSchedule* schedule, const EcsSystem* systems, uint32 count);
+// jobs may be nullptr to run every system on the calling thread.
+void ecs_schedule_run(EcsWorld* world, EcsSchedule* schedule, JobSystem* jobs = nullptr);
@@ -37,6 +37,33 @@ T* engine_allocate(Arena* arena) {
     return nullptr;
 }
 
+inline void* engine_allocate_bytes(Arena* arena, size_t size, size_t alignment) {
+    void* aligned_ptr = static_cast<void*>(arena->buffer + arena->current_position);
+    size_t space = arena->total_size - arena->current_position;
+
+    if (std::align(alignment, size, aligned_ptr, space)) {
+        arena->current_position = arena->total_size - space + size;
+        return aligned_ptr;
+    }
+
+    RT_ASSERT(false, "Arena is full or alignment failed!");
+    return nullptr;
+}
+
+template<typename T>
+T* engine_allocate_array(Arena* arena, size_t count) {
+    void* memory = engine_allocate_bytes(arena, sizeof(T) * count, alignof(T));
+    if (!memory) {
+        return nullptr;
+    }
+
+    T* elements = static_cast<T*>(memory);
+    for (size_t i = 0; i < count; ++i) {
+        new (elements + i) T();
+    }
+    return elements;
+}
+
 inline void engine_reset_arena(Arena* arena) {
     RT_ASSERT(arena != nullptr, "Cannot reset a null arena!");
     arena->current_position = 0;
@@ -0,0 +1,48 @@
+#pragma once
+#include "engine_types.h"
+
+#include <cstddef>
+
+constexpr uint64 HASH_FNV_OFFSET = 0xcbf29ce484222325ull;
+constexpr uint64 HASH_FNV_PRIME = 0x100000001b3ull;
+
+constexpr uint64 hash_bytes(const void* data, std::size_t size, uint64 seed = HASH_FNV_OFFSET)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64 hash = seed;
+	for (std::size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= HASH_FNV_PRIME;
+	}
+	return hash;
+}
+
+// Asset paths hash case-insensitively with '\' folded to '/', so "Meshes\Rock.obj" and
+// "meshes/rock.obj" name the same asset on every platform.
+constexpr uint64 hash_path(const char* path, std::size_t length)
+{
+	uint64 hash = HASH_FNV_OFFSET;
+	for (std::size_t i = 0; i < length; ++i) {
+		char c = path[i];
+		if (c == '\\') c = '/';
+		if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+		hash ^= static_cast<unsigned char>(c);
+		hash *= HASH_FNV_PRIME;
+	}
+	return hash;
+}
+
+constexpr uint64 hash_path(const char* path)
+{
+	std::size_t length = 0;
+	while (path[length] != '\0') ++length;
+	return hash_path(path, length);
+}
+
+using AssetId = uint64;
+
+// Compile-time asset reference; data and code refer to assets by this id instead of by path.
+consteval AssetId asset_id(const char* path)
+{
+	return hash_path(path);
+}
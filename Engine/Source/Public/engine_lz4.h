@@ -0,0 +1,17 @@
+#pragma once
+#include "engine_types.h"
+
+#include <cstddef>
+
+// LZ4 block format (no frame header), compatible with LZ4_compress_default / LZ4_decompress_safe.
+
+constexpr std::size_t lz4_compress_bound(std::size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+// Returns the compressed size, or 0 if the output did not fit in capacity.
+std::size_t lz4_compress(const void* source, std::size_t size, void* destination, std::size_t capacity);
+
+// Returns the decompressed size, or -1 if the input is malformed or would overrun capacity.
+int64 lz4_decompress(const void* source, std::size_t size, void* destination, std::size_t capacity);
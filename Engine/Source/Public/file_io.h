@@ -0,0 +1,132 @@
+#pragma once
+
+#include "engine_types.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Batched asynchronous file reads. On Linux the backend is io_uring, submitted and reaped with raw
+// syscalls; elsewhere, or when the kernel refuses a ring, a small thread pool does positional reads.
+// A FileIo is owned by one thread: submit and poll from the same thread.
+
+#if defined(_WIN32)
+using FileHandle = void*;
+#else
+using FileHandle = int;
+#endif
+
+constexpr uint64 FILE_IO_DIRECT_ALIGNMENT = 4096;
+
+enum FileIoBackend {
+	FILE_IO_BACKEND_IO_URING,
+	FILE_IO_BACKEND_THREAD_POOL
+};
+
+enum FileOpenFlags {
+	FILE_OPEN_DEFAULT = 0,
+	// Bypass the page cache (O_DIRECT / FILE_FLAG_NO_BUFFERING). Offsets, sizes and destinations
+	// must be multiples of FILE_IO_DIRECT_ALIGNMENT. Meant for large pack files read once.
+	FILE_OPEN_DIRECT = 1 << 0
+};
+
+struct FileReadResult;
+using FileReadCallback = void (*)(const FileReadResult* result);
+
+struct FileReadRequest {
+	FileHandle file{};
+	void* destination = nullptr;
+	uint64 offset = 0;
+	uint64 size = 0;
+	// Index returned by file_io_register_buffer when destination lies inside a registered buffer.
+	int32 buffer_index = -1;
+	// When set, runs inside file_io_poll instead of the result being returned to the caller.
+	FileReadCallback callback = nullptr;
+	void* user_data = nullptr;
+};
+
+struct FileReadResult {
+	void* destination;
+	void* user_data;
+	// Bytes read, or a negative errno-style error code.
+	int64 result;
+};
+
+struct FileIo {
+	FileIoBackend backend = FILE_IO_BACKEND_THREAD_POOL;
+	uint32 queue_depth = 0;
+
+	struct InFlight {
+		FileReadRequest request;
+		uint64 bytes_done;
+	};
+	std::vector<InFlight> slots{};
+	std::vector<uint32> free_slots{};
+	uint32 in_flight = 0;
+
+	// Requests accepted by file_io_submit that did not fit in the ring yet.
+	std::deque<FileReadRequest> backlog{};
+
+#if defined(__linux__)
+	struct Ring {
+		int fd = -1;
+		void* sq_ring = nullptr;
+		std::size_t sq_ring_size = 0;
+		void* cq_ring = nullptr;
+		std::size_t cq_ring_size = 0;
+		void* sqes = nullptr;
+		std::size_t sqes_size = 0;
+
+		unsigned* sq_head = nullptr;
+		unsigned* sq_tail = nullptr;
+		unsigned* sq_mask = nullptr;
+		unsigned* sq_array = nullptr;
+		unsigned* cq_head = nullptr;
+		unsigned* cq_tail = nullptr;
+		unsigned* cq_mask = nullptr;
+		void* cqes = nullptr;
+		// Cleared if the kernel lost the registered buffer table; reads into them then go through plain reads.
+		bool fixed_buffers = true;
+	} ring{};
+#endif
+
+	struct Registered {
+		char* base;
+		uint64 size;
+	};
+	std::vector<Registered> registered_buffers{};
+
+	std::vector<std::thread> workers{};
+	std::mutex mutex{};
+	std::condition_variable work_cv{};
+	std::condition_variable done_cv{};
+	std::deque<uint32> work{};
+	std::vector<std::pair<uint32, int64>> done{};
+	bool running = false;
+};
+
+bool file_io_init(FileIo* io, uint32 queue_depth, uint32 fallback_worker_count);
+void file_io_shutdown(FileIo* io);
+
+FileHandle file_io_open(const char* path, uint32 open_flags);
+void file_io_close(FileHandle file);
+bool file_io_is_valid(FileHandle file);
+int64 file_io_size(FileHandle file);
+
+// Blocking positional read for callers outside the batched path. Returns bytes read or a negative error.
+int64 file_io_read(FileHandle file, void* destination, uint64 size, uint64 offset);
+
+// Registers memory (typically carved from an Arena) with the kernel so reads into it skip per-request
+// page pinning. Registered buffers must outlive the FileIo. Returns the buffer index, or -1.
+int32 file_io_register_buffer(FileIo* io, void* base, uint64 size);
+
+// Queues all requests and hands them to the kernel with a single submission.
+void file_io_submit(FileIo* io, const FileReadRequest* requests, uint32 count);
+
+// Reaps finished reads. Requests with a callback are dispatched here; the rest are copied to results.
+// Blocks until at least min_complete reads have finished. Returns the number written to results.
+uint32 file_io_poll(FileIo* io, FileReadResult* results, uint32 max_results, uint32 min_complete);
+
+uint32 file_io_pending(const FileIo* io);
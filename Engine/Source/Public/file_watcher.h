@@ -0,0 +1,43 @@
+#pragma once
+
+#include "engine_types.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Watches a directory tree on a background thread: inotify on Linux, ReadDirectoryChangesW on
+// Windows, unsupported elsewhere. Editors tend to save in several writes or through a rename, so a
+// path is only reported once it has been quiet for FILE_WATCHER_SETTLE_MS.
+
+constexpr uint32 FILE_WATCHER_SETTLE_MS = 100;
+
+struct FileWatcher {
+	std::string root{};
+	std::thread thread{};
+	bool running = false;
+
+	// Paths relative to root, '/'-separated. Both guarded by mutex.
+	std::mutex mutex{};
+	std::unordered_map<std::string, std::chrono::steady_clock::time_point> pending{};
+	std::vector<std::string> settled{};
+
+#if defined(_WIN32)
+	void* directory = nullptr;
+	void* stop_event = nullptr;
+#elif defined(__linux__)
+	int inotify_fd = -1;
+	int wake_fd = -1;
+	// Watch descriptor -> directory relative to root ("" for root itself). Watcher thread only.
+	std::unordered_map<int, std::string> directories{};
+#endif
+};
+
+bool file_watcher_init(FileWatcher* watcher, const char* root);
+void file_watcher_shutdown(FileWatcher* watcher);
+
+// Moves every settled path into changed. Returns how many were added.
+uint32 file_watcher_poll(FileWatcher* watcher, std::vector<std::string>* changed);
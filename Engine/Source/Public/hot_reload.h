@@ -0,0 +1,39 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_hash.h"
+#include "file_watcher.h"
+
+#include <string>
+#include <vector>
+
+// Maps watched asset paths to reload handlers. Handlers run from hot_reload_update, which the
+// application calls at the top of a frame, so they can start background work or swap resources
+// without racing the renderer.
+
+// path is the changed asset, relative to the watched root.
+using HotReloadFn = void (*)(const char* path, void* user_data);
+
+struct HotReloadHandler {
+	AssetId id;
+	HotReloadFn function;
+	void* user_data;
+};
+
+struct HotReload {
+	FileWatcher watcher{};
+	std::vector<HotReloadHandler> handlers{};
+	std::vector<std::string> changed{};
+};
+
+bool hot_reload_init(HotReload* hot_reload, const char* root);
+void hot_reload_shutdown(HotReload* hot_reload);
+
+// Several paths may share one handler (a shader's stages); it still runs once per update.
+void hot_reload_register(HotReload* hot_reload, const char* path, HotReloadFn function, void* user_data);
+
+// Removes every path's registration of function with user_data.
+void hot_reload_unregister(HotReload* hot_reload, HotReloadFn function, void* user_data);
+
+// Returns the number of handlers run.
+uint32 hot_reload_update(HotReload* hot_reload);
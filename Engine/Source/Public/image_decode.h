@@ -0,0 +1,25 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_arena.h"
+
+// Image decoding through stb_image. While a decode runs, every allocation stb makes is served from
+// the caller's scratch arena, so a decode costs no heap traffic and all of its memory goes away with
+// one arena reset. Allocations that do not fit fall back to the heap. Without a scratch arena
+// everything comes from the heap.
+
+struct ImageInfo {
+	uint32 width = 0;
+	uint32 height = 0;
+	// Channels stored in the source file; decoded pixels are always RGBA8.
+	uint32 channels = 0;
+};
+
+bool image_decode_info(const void* data, uint64 size, ImageInfo* info);
+
+// Decodes to tightly packed RGBA8. Returns nullptr on failure.
+uint8* image_decode_rgba8(const void* data, uint64 size, Arena* scratch, ImageInfo* info);
+
+// Pass the same scratch arena used to decode. Heap fallbacks are freed; arena memory is left for
+// the next reset.
+void image_decode_free(Arena* scratch, uint8* pixels);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "engine_types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for data-parallel work. job_system_parallel_for splits [0, count) into
+// batches that the workers and the calling thread claim from a shared counter, and returns once every
+// batch has run. It may be called from several threads at once and from inside a running job.
+
+using JobRangeFn = void (*)(void* user_data, uint32 begin, uint32 end);
+
+struct JobBatch {
+	JobRangeFn function;
+	void* user_data;
+	uint32 count;
+	uint32 batch_size;
+	std::atomic<uint32> next{ 0 };
+	std::atomic<uint32> done{ 0 };
+	// Workers currently holding a pointer to this batch; guarded by JobSystem::mutex.
+	uint32 active = 0;
+};
+
+struct JobSystem {
+	std::vector<std::thread> workers{};
+	std::mutex mutex{};
+	std::condition_variable work_cv{};
+	std::condition_variable done_cv{};
+	std::deque<JobBatch*> jobs{};
+	bool running = false;
+};
+
+// worker_count 0 picks one worker per hardware thread, minus the calling thread.
+bool job_system_init(JobSystem* jobs, uint32 worker_count);
+void job_system_shutdown(JobSystem* jobs);
+
+// Workers plus the calling thread; the useful upper bound on parallelism.
+uint32 job_system_thread_count(const JobSystem* jobs);
+
+void job_system_parallel_for(JobSystem* jobs, uint32 count, uint32 batch_size, JobRangeFn function, void* user_data);
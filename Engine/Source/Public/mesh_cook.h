@@ -0,0 +1,15 @@
+#pragma once
+
+#include "engine_types.h"
+#include "mesh_format.h"
+
+#include <vector>
+
+struct ImportedMesh;
+
+// Offline mesh cooking: import an OBJ (resolving its materials from the same directory), weld and
+// cluster it, and emit a complete .hmsh file.
+bool mesh_cook(const char* obj_path, uint64 source_hash, std::vector<uint8>* output);
+
+// Runtime side: copies a cooked mesh out of an in-memory .hmsh file.
+bool mesh_load_cooked(const void* data, uint64 size, ImportedMesh* mesh);
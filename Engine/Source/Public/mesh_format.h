@@ -0,0 +1,79 @@
+#pragma once
+
+#include "engine_types.h"
+#include <meshlet.h>
+#include <vec3.h>
+
+#include <type_traits>
+
+// Cooked mesh file (.hmsh): the welded vertex/index buffers and meshlet clusters that
+// object_loader_import builds from an OBJ, stored so the runtime only has to copy them.
+//
+//   HmshHeader | section 0 | section 1 | ...
+//
+// Every section starts on an HMSH_ALIGNMENT boundary and holds count elements of
+// hmsh_element_size(section) bytes.
+
+constexpr uint32 HMSH_MAGIC = 0x48534D48; // "HMSH"
+constexpr uint32 HMSH_VERSION = 1;
+constexpr uint64 HMSH_ALIGNMENT = 16;
+
+enum HmshSection : uint32 {
+	HMSH_SECTION_POSITIONS,
+	HMSH_SECTION_INDICES,
+	HMSH_SECTION_MESHLETS,
+	HMSH_SECTION_MESHLET_VERTICES,
+	HMSH_SECTION_MESHLET_TRIANGLES,
+	// MeshletMesh::indices, the source indices regrouped per meshlet.
+	HMSH_SECTION_MESHLET_INDICES,
+	HMSH_SECTION_COUNT
+};
+
+struct HmshRange {
+	uint64 offset;
+	uint64 count;
+};
+
+struct HmshHeader {
+	uint32 magic;
+	uint32 version;
+	// Hash of the OBJ, its materials and the cooker version; see AssetCooker.
+	uint64 source_hash;
+	HmshRange sections[HMSH_SECTION_COUNT];
+};
+
+static_assert(sizeof(HmshHeader) == 16 + 16 * HMSH_SECTION_COUNT, "HmshHeader layout is part of the file format");
+static_assert(sizeof(vec3) == 12, "positions are stored as three packed floats");
+static_assert(sizeof(Meshlet) == 52 && std::is_trivially_copyable_v<Meshlet>, "Meshlet layout is part of the file format");
+
+constexpr uint64 hmsh_element_size(HmshSection section)
+{
+	switch (section) {
+	case HMSH_SECTION_POSITIONS: return sizeof(vec3);
+	case HMSH_SECTION_MESHLETS: return sizeof(Meshlet);
+	case HMSH_SECTION_MESHLET_TRIANGLES: return sizeof(uint8);
+	default: return sizeof(uint32);
+	}
+}
+
+// Checks the header and section table of an in-memory .hmsh file against its size.
+inline const HmshHeader* hmsh_validate(const void* data, uint64 size)
+{
+	if (!data || size < sizeof(HmshHeader)) {
+		return nullptr;
+	}
+
+	const HmshHeader* header = static_cast<const HmshHeader*>(data);
+	if (header->magic != HMSH_MAGIC || header->version != HMSH_VERSION) {
+		return nullptr;
+	}
+
+	for (uint32 i = 0; i < HMSH_SECTION_COUNT; ++i) {
+		const HmshRange& range = header->sections[i];
+		const uint64 element_size = hmsh_element_size(static_cast<HmshSection>(i));
+		if (range.offset > size || range.count > (size - range.offset) / element_size) {
+			return nullptr;
+		}
+	}
+	return header;
+}
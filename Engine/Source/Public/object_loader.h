@@ -1,12 +1,31 @@
 #pragma once
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#define TINYOBJLOADER_USE_MAPBOX_EARCUT
 #include <tiny_obj_loader.h>	
+#include <meshlet.h>
+#include "asset_stream.h"
+#include <vec3.h>
 
 struct ObjectLoader {
 	std::string input_path{};
 	tinyobj::ObjReaderConfig reader_config{};
 };
 
+struct ImportedMesh {
+	std::vector<vec3> positions{};
+	std::vector<uint32> indices{};
+	MeshletMesh meshlets{};
+};
+
 void object_loader_init(ObjectLoader* objectLoader);
+
+// Reads input_path, welds the OBJ's per-corner indices into one index buffer and clusters it into meshlets.
+bool object_loader_import(ObjectLoader* objectLoader, ImportedMesh* mesh);
+
+bool object_loader_import_from_memory(ObjectLoader* objectLoader, const char* data, std::size_t size, ImportedMesh* mesh);
+
+// Reads and clusters the OBJ on an asset stream worker (a cooked .hmsh is just copied out) into a mesh
+// of its own, which replaces *mesh on the draining thread before on_loaded runs with user_data pointing
+// at mesh. With hot reload on, an edited file replaces *mesh again and on_loaded runs again. mesh must
+// stay alive until asset_stream_forget(stream, mesh), or without hot reload until on_loaded has run.
+void object_loader_import_async(AssetStream* stream, ImportedMesh* mesh, const char* path,
+	AssetPriority priority, AssetUploadFn on_loaded);
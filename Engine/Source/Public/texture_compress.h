@@ -0,0 +1,26 @@
+#pragma once
+
+#include "engine_types.h"
+#include "texture_format.h"
+
+struct JobSystem;
+
+// Block compression encoders. Every encoder takes one 4x4 block of RGBA8 pixels in row-major order
+// (64 bytes) and writes one compressed block. Endpoints come from the principal axis of the block's
+// colours and are refined with a least-squares pass over the chosen indices.
+
+// Opaque colour; alpha is ignored.
+void bc1_encode_block(const uint8* rgba, uint8* out);
+// Single channel, 8-value mode. values holds 16 bytes.
+void bc4_encode_block(const uint8* values, uint8* out);
+void bc3_encode_block(const uint8* rgba, uint8* out);
+// Red and green as two BC4 blocks.
+void bc5_encode_block(const uint8* rgba, uint8* out);
+// Mode 6 only: one subset, 7.7.7.7 endpoints with a p-bit each and 4-bit indices. Handles alpha
+// and opaque content with a single fast search.
+void bc7_encode_block(const uint8* rgba, uint8* out);
+
+// Encodes a whole RGBA8 level, spreading rows of blocks across the job system. Edge blocks of
+// dimensions that are not a multiple of 4 repeat the last row/column. out holds
+// texture_level_size(format, width, height) bytes.
+void texture_compress(JobSystem* jobs, TextureFormat format, const uint8* rgba, uint32 width, uint32 height, uint8* out);
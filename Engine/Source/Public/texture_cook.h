@@ -0,0 +1,41 @@
+#pragma once
+
+#include "engine_types.h"
+#include "texture_format.h"
+
+#include <vector>
+
+struct JobSystem;
+
+// Offline texture cooking: decode a source image with stb_image, build the mip chain in linear
+// light, block-compress every level and emit a complete .htex file.
+
+enum MipFilter {
+	// 2x2 average. Cheap, slightly blurry.
+	MIP_FILTER_BOX,
+	// Separable Kaiser-windowed sinc. Keeps more detail in the smaller levels.
+	MIP_FILTER_KAISER
+};
+
+struct TextureCookSettings {
+	TextureFormat format = TEXTURE_FORMAT_BC7;
+	// Colour channels are sRGB: filtering happens on linearised values and the texture is flagged
+	// for sRGB sampling. Turn off for normal maps and other data textures.
+	bool srgb = true;
+	bool generate_mips = true;
+	MipFilter mip_filter = MIP_FILTER_KAISER;
+};
+
+// Identifies a cook of these source bytes with these settings; stored in HtexHeader::source_hash.
+uint64 texture_cook_hash(const void* source, uint64 source_size, const TextureCookSettings* settings);
+
+// Downsamples one linear RGBA float level (4 floats per pixel) to max(1, width / 2) x max(1, height / 2).
+void texture_downsample(JobSystem* jobs, MipFilter filter, const float* source, uint32 width, uint32 height, float* destination);
+
+bool texture_cook(JobSystem* jobs, const void* source, uint64 source_size, const TextureCookSettings* settings,
+	std::vector<uint8>* output);
+
+// Cooks source_path into output_path unless output_path already holds a cook of the same bytes and
+// settings. cooked, when given, reports whether any work was done.
+bool texture_cook_file(JobSystem* jobs, const char* source_path, const char* output_path,
+	const TextureCookSettings* settings, bool* cooked);
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "engine_types.h"
+
+#include <cstddef>
+
+// Cooked texture file (.htex).
+//
+//   HtexHeader | HtexMip[mip_count] | level 0 | level 1 | ...
+//
+// Every level is stored in its final GPU layout and starts on an HTEX_ALIGNMENT boundary, so a mapped
+// file (or a raw pack entry) can be handed to the driver level by level without any copy or decode.
+
+constexpr uint32 HTEX_MAGIC = 0x58455448; // "HTEX"
+constexpr uint32 HTEX_VERSION = 1;
+constexpr uint32 HTEX_MAX_MIPS = 16;
+constexpr uint64 HTEX_ALIGNMENT = 16;
+
+enum TextureFormat : uint32 {
+	TEXTURE_FORMAT_RGBA8,
+	// Opaque RGB. 4 bpp.
+	TEXTURE_FORMAT_BC1,
+	// RGB + interpolated alpha. 8 bpp.
+	TEXTURE_FORMAT_BC3,
+	// Two independent channels (RG), for tangent-space normal maps. 8 bpp.
+	TEXTURE_FORMAT_BC5,
+	// High quality RGBA. 8 bpp.
+	TEXTURE_FORMAT_BC7,
+	TEXTURE_FORMAT_COUNT
+};
+
+enum TextureFlags : uint32 {
+	// Colour channels are sRGB encoded; sample through an sRGB internal format.
+	TEXTURE_FLAG_SRGB = 1 << 0
+};
+
+struct HtexHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 format;
+	uint32 flags;
+	uint32 width;
+	uint32 height;
+	uint32 mip_count;
+	uint32 reserved;
+	// Hash of the source bytes and cook settings, used to skip cooking unchanged inputs.
+	uint64 source_hash;
+};
+
+struct HtexMip {
+	uint64 offset;
+	uint64 size;
+	uint32 width;
+	uint32 height;
+};
+
+static_assert(sizeof(HtexHeader) == 40, "HtexHeader layout is part of the file format");
+static_assert(sizeof(HtexMip) == 24, "HtexMip layout is part of the file format");
+
+constexpr bool texture_format_is_compressed(TextureFormat format)
+{
+	return format != TEXTURE_FORMAT_RGBA8;
+}
+
+// Bytes per 4x4 block for compressed formats, bytes per pixel otherwise.
+constexpr uint32 texture_format_block_bytes(TextureFormat format)
+{
+	switch (format) {
+	case TEXTURE_FORMAT_RGBA8: return 4;
+	case TEXTURE_FORMAT_BC1: return 8;
+	case TEXTURE_FORMAT_BC3:
+	case TEXTURE_FORMAT_BC5:
+	case TEXTURE_FORMAT_BC7: return 16;
+	default: return 0;
+	}
+}
+
+constexpr uint64 texture_level_size(TextureFormat format, uint32 width, uint32 height)
+{
+	if (!texture_format_is_compressed(format)) {
+		return static_cast<uint64>(width) * height * texture_format_block_bytes(format);
+	}
+	const uint64 blocks_x = (width + 3) / 4;
+	const uint64 blocks_y = (height + 3) / 4;
+	return blocks_x * blocks_y * texture_format_block_bytes(format);
+}
+
+constexpr uint32 texture_mip_count(uint32 width, uint32 height)
+{
+	uint32 count = 1;
+	while ((width > 1 || height > 1) && count < HTEX_MAX_MIPS) {
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		count++;
+	}
+	return count;
+}
+
+// Checks the header and mip table of an in-memory .htex file against its size.
+inline const HtexHeader* htex_validate(const void* data, uint64 size)
+{
+	if (!data || size < sizeof(HtexHeader)) {
+		return nullptr;
+	}
+
+	const HtexHeader* header = static_cast<const HtexHeader*>(data);
+	if (header->magic != HTEX_MAGIC || header->version != HTEX_VERSION || header->format >= TEXTURE_FORMAT_COUNT
+		|| header->mip_count == 0 || header->mip_count > HTEX_MAX_MIPS
+		|| size < sizeof(HtexHeader) + header->mip_count * sizeof(HtexMip)) {
+		return nullptr;
+	}
+
+	const HtexMip* mips = reinterpret_cast<const HtexMip*>(header + 1);
+	for (uint32 i = 0; i < header->mip_count; ++i) {
+		if (mips[i].offset > size || mips[i].size > size - mips[i].offset) {
+			return nullptr;
+		}
+	}
+	return header;
+}
+
+inline const HtexMip* htex_mips(const HtexHeader* header)
+{
+	return reinterpret_cast<const HtexMip*>(header + 1);
+}
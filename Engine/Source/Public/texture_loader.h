@@ -0,0 +1,24 @@
+#pragma once
+
+#include <texture_upload.h>
+#include "asset_stream.h"
+
+// Streams a texture through an asset stream worker and a TextureUploader. Cooked .htex files are
+// copied level by level into a staging slot; any other image is decoded by stb_image on the worker
+// into a per-worker scratch arena, then copied into the slot. The draining thread only issues the
+// buffer-to-texture copy.
+struct TextureLoad {
+	Texture texture{};
+	TextureUploader* uploader = nullptr;
+	// Used for decoded images, as set when the load is requested; cooked files carry their own flags and mips.
+	bool srgb = true;
+	bool generate_mips = true;
+	AssetUploadFn on_loaded = nullptr;
+};
+
+// on_loaded receives the AssetLoad whose user_data is load, after load->texture has been created; it
+// does not run if the upload fails. With hot reload on, an edited file replaces load->texture with a
+// new one and on_loaded runs again. load must stay alive until asset_stream_forget(stream, load), or
+// without hot reload until on_loaded has run.
+void texture_load_async(AssetStream* stream, TextureUploader* uploader, TextureLoad* load, const char* path,
+	AssetPriority priority, AssetUploadFn on_loaded);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_hash.h"
+#include "engine_arena.h"
+#include "asset_pack.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Virtual file system. Directories and packs are mounted with a priority; when two mounts provide
+// the same path the higher priority wins (later mounts win ties). All path strings are hashed at
+// mount time into one open-addressed table, so resolving an AssetId is a constant-time probe that
+// never allocates.
+
+enum VfsMountType {
+	VFS_MOUNT_DIRECTORY,
+	VFS_MOUNT_PACK
+};
+
+struct VfsMount {
+	VfsMountType type;
+	int32 priority;
+	std::string root{};
+	// Directory mounts: full paths of every file found when mounting, indexed by VfsSlot::index.
+	std::vector<std::string> files{};
+	// Pack mounts. Held by pointer so the mapping stays put when the mount list grows.
+	std::unique_ptr<AssetPack> pack{};
+};
+
+struct VfsSlot {
+	AssetId id;
+	uint32 mount;	// index + 1, 0 marks an empty slot
+	uint32 index;	// file index for directories, TOC index for packs
+};
+
+struct Vfs {
+	std::vector<VfsMount> mounts{};
+	std::vector<VfsSlot> slots{};
+	uint32 count = 0;
+};
+
+struct VfsFile {
+	const void* data = nullptr;
+	uint64 size = 0;
+};
+
+bool vfs_mount_directory(Vfs* vfs, const char* root, int32 priority);
+bool vfs_mount_pack(Vfs* vfs, const char* pack_path, int32 priority);
+void vfs_shutdown(Vfs* vfs);
+
+bool vfs_exists(const Vfs* vfs, AssetId id);
+int64 vfs_size(const Vfs* vfs, AssetId id);
+// Debug/tool name of the file that currently backs id, or nullptr.
+const char* vfs_name(const Vfs* vfs, AssetId id);
+
+// Raw pack entries point straight into the mapping; everything else is read into arena memory.
+bool vfs_load(const Vfs* vfs, AssetId id, Arena* arena, VfsFile* file);
+// Always copies into the arena and appends a NUL so the result can be used as a C string.
+const char* vfs_load_text(const Vfs* vfs, AssetId id, Arena* arena);
@@ -1,9 +1,30 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+// Per instance; mirrors InstanceData in vertex.h.
+layout (location = 1) in mat4 instanceModel;
+layout (location = 5) in vec4 instanceColor;
+
+// Mirrors FrameUniforms and DrawUniforms in uniform_buffer.h.
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	mat4 view_projection;
+	vec3 camera_position;
+	float time;
+	vec3 light_direction;
+	float light_intensity;
+	vec3 light_color;
+};
+
+layout (std140) uniform DrawData {
+	mat4 model;
+	vec3 tint;
+	float alpha;
+};
 
 out vec4 vertexColor;
 
 void main(){
-	gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
-	vertexColor = vec4(0.1, 0.2, 0.7, 1);
-}
\ No newline at end of file
+	gl_Position = view_projection * model * instanceModel * vec4(aPos.x, aPos.y, aPos.z, 1.0);
+	vertexColor = vec4(tint, alpha) * instanceColor;
+}
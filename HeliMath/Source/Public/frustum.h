@@ -0,0 +1,109 @@
+///////////////
+// Frustum.h //
+///////////////
+
+#pragma once
+
+#include "math_defines.h"
+#include "vec3.h"
+#include "mat4.h"
+
+// Points with dot(normal, p) + d < 0 are outside the plane.
+struct plane {
+
+	vec3 normal;
+	float d;
+
+	constexpr plane()
+		: normal(), d(0)
+	{
+	}
+
+	constexpr plane(const vec3& normal, float d)
+		: normal(normal), d(d)
+	{
+	}
+
+	FORCE_INLINE float distance(const vec3& p) const
+	{
+		return normal.dot(p) + d;
+	}
+
+	FORCE_INLINE plane normalize() const
+	{
+		float m = normal.magnitude();
+		if (m <= FLT_EPSILON) return *this;
+		float inv = 1.0f / m;
+		return plane(normal * inv, d * inv);
+	}
+};
+
+enum frustumPlane {
+	FRUSTUM_LEFT,
+	FRUSTUM_RIGHT,
+	FRUSTUM_BOTTOM,
+	FRUSTUM_TOP,
+	FRUSTUM_NEAR,
+	FRUSTUM_FAR,
+	FRUSTUM_PLANE_COUNT
+};
+
+struct frustum {
+
+	plane planes[FRUSTUM_PLANE_COUNT];
+
+	// Gribb/Hartmann extraction from a column-major view-projection matrix.
+	FORCE_INLINE static frustum fromMatrix(const mat4& viewProjection)
+	{
+		auto row = [&](int r, float& x, float& y, float& z, float& w) {
+			x = viewProjection.at(r, 0);
+			y = viewProjection.at(r, 1);
+			z = viewProjection.at(r, 2);
+			w = viewProjection.at(r, 3);
+		};
+
+		float r0[4], r1[4], r2[4], r3[4];
+		row(0, r0[0], r0[1], r0[2], r0[3]);
+		row(1, r1[0], r1[1], r1[2], r1[3]);
+		row(2, r2[0], r2[1], r2[2], r2[3]);
+		row(3, r3[0], r3[1], r3[2], r3[3]);
+
+		auto make = [&](const float* a, float sign) {
+			return plane(
+				vec3(r3[0] + sign * a[0], r3[1] + sign * a[1], r3[2] + sign * a[2]),
+				r3[3] + sign * a[3]).normalize();
+		};
+
+		frustum f;
+		f.planes[FRUSTUM_LEFT] = make(r0, 1.0f);
+		f.planes[FRUSTUM_RIGHT] = make(r0, -1.0f);
+		f.planes[FRUSTUM_BOTTOM] = make(r1, 1.0f);
+		f.planes[FRUSTUM_TOP] = make(r1, -1.0f);
+		f.planes[FRUSTUM_NEAR] = make(r2, 1.0f);
+		f.planes[FRUSTUM_FAR] = make(r2, -1.0f);
+		return f;
+	}
+
+	FORCE_INLINE bool isSphereVisible(const vec3& center, float radius) const
+	{
+		for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+			if (planes[i].distance(center) < -radius) return false;
+		}
+		return true;
+	}
+
+	FORCE_INLINE bool isAabbVisible(const vec3& min, const vec3& max) const
+	{
+		for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+			const vec3& n = planes[i].normal;
+			// Test the corner furthest along the plane normal.
+			vec3 p(
+				n.x >= 0.0f ? max.x : min.x,
+				n.y >= 0.0f ? max.y : min.y,
+				n.z >= 0.0f ? max.z : min.z
+			);
+			if (planes[i].distance(p) < 0.0f) return false;
+		}
+		return true;
+	}
+};
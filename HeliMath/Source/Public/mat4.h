@@ -0,0 +1,115 @@
+////////////
+// Mat4.h //
+////////////
+
+#pragma once
+
+#include "math_defines.h"
+#include "vec3.h"
+#include <cmath>
+
+// Column-major, matches the layout glUniformMatrix4fv expects with transpose = GL_FALSE.
+// Element (row, column) lives at m[column * 4 + row].
+struct mat4 {
+
+	float m[16];
+
+	constexpr mat4()
+		: m{ 1.0f, 0.0f, 0.0f, 0.0f,
+			 0.0f, 1.0f, 0.0f, 0.0f,
+			 0.0f, 0.0f, 1.0f, 0.0f,
+			 0.0f, 0.0f, 0.0f, 1.0f }
+	{
+	}
+
+	FORCE_INLINE static mat4 identity()
+	{
+		return mat4();
+	}
+
+	FORCE_INLINE static mat4 translation(const vec3& t)
+	{
+		mat4 r;
+		r.m[12] = t.x;
+		r.m[13] = t.y;
+		r.m[14] = t.z;
+		return r;
+	}
+
+	FORCE_INLINE static mat4 scale(const vec3& s)
+	{
+		mat4 r;
+		r.m[0] = s.x;
+		r.m[5] = s.y;
+		r.m[10] = s.z;
+		return r;
+	}
+
+	// Right-handed, depth mapped to [-1, 1] like glFrustum.
+	FORCE_INLINE static mat4 perspective(float fovYRadians, float aspect, float zNear, float zFar)
+	{
+		const float f = 1.0f / std::tan(fovYRadians * 0.5f);
+		mat4 r;
+		r.m[0] = f / aspect;
+		r.m[5] = f;
+		r.m[10] = (zFar + zNear) / (zNear - zFar);
+		r.m[11] = -1.0f;
+		r.m[14] = (2.0f * zFar * zNear) / (zNear - zFar);
+		r.m[15] = 0.0f;
+		return r;
+	}
+
+	FORCE_INLINE static mat4 lookAt(const vec3& eye, const vec3& target, const vec3& up)
+	{
+		const vec3 f = (target - eye).normalize();
+		const vec3 s = f.cross(up).normalize();
+		const vec3 u = s.cross(f);
+
+		mat4 r;
+		r.m[0] = s.x; r.m[4] = s.y; r.m[8] = s.z;
+		r.m[1] = u.x; r.m[5] = u.y; r.m[9] = u.z;
+		r.m[2] = -f.x; r.m[6] = -f.y; r.m[10] = -f.z;
+		r.m[12] = -s.dot(eye);
+		r.m[13] = -u.dot(eye);
+		r.m[14] = f.dot(eye);
+		return r;
+	}
+
+	FORCE_INLINE float at(int row, int column) const
+	{
+		return m[column * 4 + row];
+	}
+
+	FORCE_INLINE vec3 transformPoint(const vec3& p) const
+	{
+		return vec3(
+			m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+			m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+			m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]
+		);
+	}
+
+	FORCE_INLINE vec3 transformDirection(const vec3& d) const
+	{
+		return vec3(
+			m[0] * d.x + m[4] * d.y + m[8] * d.z,
+			m[1] * d.x + m[5] * d.y + m[9] * d.z,
+			m[2] * d.x + m[6] * d.y + m[10] * d.z
+		);
+	}
+
+	FORCE_INLINE mat4 operator*(const mat4& other) const
+	{
+		mat4 r;
+		for (int column = 0; column < 4; ++column) {
+			for (int row = 0; row < 4; ++row) {
+				r.m[column * 4 + row] =
+					m[0 * 4 + row] * other.m[column * 4 + 0] +
+					m[1 * 4 + row] * other.m[column * 4 + 1] +
+					m[2 * 4 + row] * other.m[column * 4 + 2] +
+					m[3 * 4 + row] * other.m[column * 4 + 3];
+			}
+		}
+		return r;
+	}
+};
@@ -0,0 +1,63 @@
+////////////
+// Quat.h //
+////////////
+
+#pragma once
+
+#include "math_defines.h"
+#include "vec3.h"
+#include <cmath>
+
+// Unit quaternion rotation; w is the scalar part.
+struct quat {
+
+	float x, y, z, w;
+
+	constexpr quat(float x, float y, float z, float w)
+		: x(x), y(y), z(z), w(w)
+	{
+	}
+
+	constexpr quat()
+		: x(0), y(0), z(0), w(1)
+	{
+	}
+
+	FORCE_INLINE static quat identity()
+	{
+		return quat();
+	}
+
+	// Counter-clockwise looking down the axis, which is expected to be normalized.
+	FORCE_INLINE static quat fromAxisAngle(const vec3& axis, float radians)
+	{
+		const float s = std::sin(radians * 0.5f);
+		return quat(axis.x * s, axis.y * s, axis.z * s, std::cos(radians * 0.5f));
+	}
+
+	FORCE_INLINE quat normalize() const
+	{
+		const float m = std::sqrt(x * x + y * y + z * z + w * w);
+		if (m <= FLT_EPSILON) return quat();
+		const float inv = 1.0f / m;
+		return quat(x * inv, y * inv, z * inv, w * inv);
+	}
+
+	FORCE_INLINE vec3 rotate(const vec3& v) const
+	{
+		const vec3 u(x, y, z);
+		const vec3 t = u.cross(v) * 2.0f;
+		return v + t * w + u.cross(t);
+	}
+
+	// Applies other first, then this.
+	FORCE_INLINE quat operator*(const quat& other) const
+	{
+		return quat(
+			w * other.x + x * other.w + y * other.z - z * other.y,
+			w * other.y - x * other.z + y * other.w + z * other.x,
+			w * other.z + x * other.y - y * other.x + z * other.w,
+			w * other.w - x * other.x - y * other.y - z * other.z
+		);
+	}
+};
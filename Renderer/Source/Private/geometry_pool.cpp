@@ -0,0 +1,230 @@
+#include "geometry_pool.h"
+#include "gl_state.h"
+#include "stream_buffer.h"
+
+#include <engine_assert.h>
+
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+void create_buffer(GLuint* buffer, uint64 size)
+{
+	glGenBuffers(1, buffer);
+	gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, *buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STATIC_DRAW);
+}
+
+void upload(GLuint buffer, uint64 offset, const void* data, uint64 size)
+{
+	gl_state_bind_buffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+}
+
+template<typename T>
+T* grow(Arena* arena, T* items, uint32 count, uint32 capacity)
+{
+	// The old array stays in the arena until the frame ends, like render command storage.
+	T* grown = static_cast<T*>(engine_allocate_bytes(arena, sizeof(T) * capacity, alignof(T)));
+	if (count > 0) {
+		std::memcpy(grown, items, sizeof(T) * count);
+	}
+	return grown;
+}
+
+} // namespace
+
+void geometry_allocator_init(GeometryAllocator* allocator, uint32 capacity)
+{
+	allocator->free_ranges.clear();
+	allocator->free_ranges.push_back({ 0, capacity });
+	allocator->capacity = capacity;
+	allocator->used = 0;
+}
+
+bool geometry_allocator_allocate(GeometryAllocator* allocator, uint32 count, uint32* offset)
+{
+	for (auto it = allocator->free_ranges.begin(); it != allocator->free_ranges.end(); ++it) {
+		if (it->count < count) {
+			continue;
+		}
+		*offset = it->offset;
+		it->offset += count;
+		it->count -= count;
+		if (it->count == 0) {
+			allocator->free_ranges.erase(it);
+		}
+		allocator->used += count;
+		return true;
+	}
+	return false;
+}
+
+void geometry_allocator_free(GeometryAllocator* allocator, GeometryRange range)
+{
+	if (range.count == 0) {
+		return;
+	}
+	std::vector<GeometryRange>& ranges = allocator->free_ranges;
+	auto next = ranges.begin();
+	while (next != ranges.end() && next->offset < range.offset) {
+		++next;
+	}
+	RT_ASSERT(next == ranges.end() || range.offset + range.count <= next->offset, "Geometry range freed twice");
+
+	allocator->used -= range.count;
+	const bool joins_previous = next != ranges.begin() && (next - 1)->offset + (next - 1)->count == range.offset;
+	const bool joins_next = next != ranges.end() && range.offset + range.count == next->offset;
+	if (joins_previous && joins_next) {
+		(next - 1)->count += range.count + next->count;
+		ranges.erase(next);
+	}
+	else if (joins_previous) {
+		(next - 1)->count += range.count;
+	}
+	else if (joins_next) {
+		next->offset = range.offset;
+		next->count += range.count;
+	}
+	else {
+		ranges.insert(next, range);
+	}
+}
+
+bool geometry_pool_create(GeometryPool* pool, const VertexAttribute* attributes, uint32 attribute_count, uint32 vertex_stride,
+	uint32 vertex_capacity, uint32 index_capacity)
+{
+	RT_ASSERT(vertex_stride > 0, "Geometry pool needs a vertex stride");
+
+	// Errors left by earlier calls would otherwise be taken for this pool's.
+	while (glGetError() != GL_NO_ERROR) {
+	}
+
+	pool->vertex_stride = vertex_stride;
+	create_buffer(&pool->vertex_buffer, static_cast<uint64>(vertex_capacity) * vertex_stride);
+	create_buffer(&pool->index_buffer, static_cast<uint64>(index_capacity) * sizeof(uint32));
+	geometry_allocator_init(&pool->vertices, vertex_capacity);
+	geometry_allocator_init(&pool->indices, index_capacity);
+
+	create_vertex_array_object(&pool->vertex_array);
+	vertex_array_set_vertex_layout(&pool->vertex_array, pool->vertex_buffer, attributes, attribute_count, vertex_stride);
+	vertex_array_set_instance_layout(&pool->vertex_array, INSTANCE_DATA_ATTRIBUTES,
+		static_cast<uint32>(std::size(INSTANCE_DATA_ATTRIBUTES)), sizeof(InstanceData));
+	// Element buffer binding is vertex array state; the pool's vertex array is bound by create above.
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool->index_buffer);
+
+	if (glGetError() != GL_NO_ERROR) {
+		std::cout << "ERROR::GEOMETRY_POOL::CREATE_FAILED" << std::endl;
+		geometry_pool_destroy(pool);
+		return false;
+	}
+	return true;
+}
+
+void geometry_pool_destroy(GeometryPool* pool)
+{
+	if (pool->vertex_array.vertex_array_object != 0) {
+		gl_state_forget_vertex_array(pool->vertex_array.vertex_array_object);
+		glDeleteVertexArrays(1, &pool->vertex_array.vertex_array_object);
+	}
+	for (GLuint* buffer : { &pool->vertex_buffer, &pool->index_buffer }) {
+		if (*buffer != 0) {
+			gl_state_forget_buffer(*buffer);
+			glDeleteBuffers(1, buffer);
+		}
+	}
+	*pool = {};
+}
+
+bool geometry_pool_add(GeometryPool* pool, const void* vertices, uint32 vertex_count, const uint32* indices, uint32 index_count,
+	GeometryMesh* mesh)
+{
+	uint32 base_vertex = 0;
+	uint32 first_index = 0;
+	if (!geometry_allocator_allocate(&pool->vertices, vertex_count, &base_vertex)) {
+		std::cout << "ERROR::GEOMETRY_POOL::OUT_OF_VERTICES " << vertex_count << std::endl;
+		return false;
+	}
+	if (!geometry_allocator_allocate(&pool->indices, index_count, &first_index)) {
+		std::cout << "ERROR::GEOMETRY_POOL::OUT_OF_INDICES " << index_count << std::endl;
+		geometry_allocator_free(&pool->vertices, { base_vertex, vertex_count });
+		return false;
+	}
+
+	upload(pool->vertex_buffer, static_cast<uint64>(base_vertex) * pool->vertex_stride, vertices,
+		static_cast<uint64>(vertex_count) * pool->vertex_stride);
+	upload(pool->index_buffer, static_cast<uint64>(first_index) * sizeof(uint32), indices,
+		static_cast<uint64>(index_count) * sizeof(uint32));
+
+	*mesh = { base_vertex, vertex_count, first_index, index_count };
+	return true;
+}
+
+void geometry_pool_remove(GeometryPool* pool, const GeometryMesh& mesh)
+{
+	geometry_allocator_free(&pool->vertices, { mesh.base_vertex, mesh.vertex_count });
+	geometry_allocator_free(&pool->indices, { mesh.first_index, mesh.index_count });
+}
+
+void geometry_batch_begin(GeometryBatch* batch, Arena* arena, uint32 command_capacity, uint32 instance_capacity)
+{
+	RT_ASSERT(arena != nullptr, "Geometry batch needs an arena");
+
+	batch->arena = arena;
+	batch->command_count = 0;
+	batch->instance_count = 0;
+	batch->command_capacity = command_capacity > 0 ? command_capacity : 64;
+	batch->instance_capacity = instance_capacity > 0 ? instance_capacity : 256;
+	batch->commands = grow<DrawElementsIndirectCommand>(arena, nullptr, 0, batch->command_capacity);
+	batch->instances = grow<InstanceData>(arena, nullptr, 0, batch->instance_capacity);
+}
+
+InstanceData* geometry_batch_add(GeometryBatch* batch, const GeometryMesh& mesh, uint32 instance_count)
+{
+	if (batch->command_count == batch->command_capacity) {
+		batch->command_capacity *= 2;
+		batch->commands = grow(batch->arena, batch->commands, batch->command_count, batch->command_capacity);
+	}
+	if (batch->instance_count + instance_count > batch->instance_capacity) {
+		while (batch->instance_count + instance_count > batch->instance_capacity) {
+			batch->instance_capacity *= 2;
+		}
+		batch->instances = grow(batch->arena, batch->instances, batch->instance_count, batch->instance_capacity);
+	}
+
+	batch->commands[batch->command_count++] = { mesh.index_count, instance_count, mesh.first_index,
+		static_cast<int32>(mesh.base_vertex), batch->instance_count };
+	InstanceData* instances = batch->instances + batch->instance_count;
+	batch->instance_count += instance_count;
+	return instances;
+}
+
+bool geometry_batch_write(GeometryBatch* batch, GeometryPool* pool, StreamBuffer* stream, GLuint program,
+	RenderMultiDrawPacket* packet)
+{
+	packet->program = program;
+	packet->vertex_array = &pool->vertex_array;
+	packet->mode = GL_TRIANGLES;
+	packet->commands = batch->commands;
+	packet->draw_count = 0;
+	if (batch->command_count == 0) {
+		return false;
+	}
+
+	StreamAllocation indirect{};
+	StreamAllocation instances{};
+	if (!stream_buffer_write(stream, batch->commands, sizeof(DrawElementsIndirectCommand) * batch->command_count, 16, &indirect)
+		|| !stream_buffer_write(stream, batch->instances, sizeof(InstanceData) * batch->instance_count, 16, &instances)) {
+		std::cout << "ERROR::GEOMETRY_POOL::BATCH_TOO_LARGE " << batch->command_count << std::endl;
+		return false;
+	}
+
+	packet->indirect_buffer = indirect.buffer;
+	packet->indirect_offset = indirect.offset;
+	packet->draw_count = batch->command_count;
+	packet->instance_buffer = instances.buffer;
+	packet->instance_offset = instances.offset;
+	return true;
+}
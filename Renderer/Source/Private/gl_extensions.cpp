@@ -0,0 +1,79 @@
+#include "gl_extensions.h"
+
+#include <cstring>
+#include <iostream>
+
+GlExtensions gl_extensions{};
+
+bool gl_has_extension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+		if (extension && std::strcmp(extension, name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void gl_extensions_load(GLADloadproc load)
+{
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	const int version = major * 10 + minor;
+
+	gl_extensions = {};
+
+	if (version >= 44 || gl_has_extension("GL_ARB_buffer_storage")) {
+		gl_extensions.BufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(load("glBufferStorage"));
+		gl_extensions.buffer_storage = gl_extensions.BufferStorage != nullptr;
+	}
+
+	if (version >= 41 || gl_has_extension("GL_ARB_get_program_binary")) {
+		gl_extensions.GetProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(load("glGetProgramBinary"));
+		gl_extensions.ProgramBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(load("glProgramBinary"));
+		gl_extensions.ProgramParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(load("glProgramParameteri"));
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		gl_extensions.program_binary = gl_extensions.GetProgramBinary && gl_extensions.ProgramBinary
+			&& gl_extensions.ProgramParameteri && formats > 0;
+	}
+
+	if (gl_has_extension("GL_KHR_parallel_shader_compile")) {
+		gl_extensions.MaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsKHR"));
+	}
+	else if (gl_has_extension("GL_ARB_parallel_shader_compile")) {
+		gl_extensions.MaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsARB"));
+	}
+	if (gl_extensions.MaxShaderCompilerThreads) {
+		// 0xFFFFFFFF lets the driver pick the thread count.
+		gl_extensions.MaxShaderCompilerThreads(0xFFFFFFFFu);
+		gl_extensions.parallel_shader_compile = true;
+	}
+
+	if (version >= 42 || gl_has_extension("GL_ARB_base_instance")) {
+		gl_extensions.DrawElementsInstancedBaseVertexBaseInstance = reinterpret_cast<PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC>(
+			load("glDrawElementsInstancedBaseVertexBaseInstance"));
+		gl_extensions.base_instance = gl_extensions.DrawElementsInstancedBaseVertexBaseInstance != nullptr;
+	}
+
+	// Indirect commands carry a base instance, so multi-draw is only used together with it.
+	if (gl_extensions.base_instance && (version >= 43 || gl_has_extension("GL_ARB_multi_draw_indirect"))) {
+		gl_extensions.MultiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(load("glMultiDrawElementsIndirect"));
+		gl_extensions.multi_draw_indirect = gl_extensions.MultiDrawElementsIndirect != nullptr;
+	}
+
+	if (version >= 42 || gl_has_extension("GL_ARB_shader_image_load_store")) {
+		gl_extensions.MemoryBarrier = reinterpret_cast<PFNGLMEMORYBARRIERPROC>(load("glMemoryBarrier"));
+		gl_extensions.memory_barrier = gl_extensions.MemoryBarrier != nullptr;
+	}
+
+	std::cout << "GL " << major << "." << minor << ", buffer storage: " << gl_extensions.buffer_storage
+		<< ", program binary: " << gl_extensions.program_binary << ", parallel shader compile: " << gl_extensions.parallel_shader_compile
+		<< ", base instance: " << gl_extensions.base_instance << ", multi draw indirect: " << gl_extensions.multi_draw_indirect
+		<< ", memory barrier: " << gl_extensions.memory_barrier << std::endl;
+}
@@ -0,0 +1,259 @@
+#include "gl_state.h"
+#include "gl_extensions.h"
+
+#include <cstring>
+
+GlState gl_state{};
+
+namespace {
+
+int buffer_slot(GLenum target)
+{
+	switch (target) {
+	case GL_ARRAY_BUFFER: return GL_STATE_BUFFER_ARRAY;
+	case GL_UNIFORM_BUFFER: return GL_STATE_BUFFER_UNIFORM;
+	case GL_COPY_READ_BUFFER: return GL_STATE_BUFFER_COPY_READ;
+	case GL_COPY_WRITE_BUFFER: return GL_STATE_BUFFER_COPY_WRITE;
+	case GL_PIXEL_UNPACK_BUFFER: return GL_STATE_BUFFER_PIXEL_UNPACK;
+	case GL_DRAW_INDIRECT_BUFFER: return GL_STATE_BUFFER_DRAW_INDIRECT;
+	default: return -1;
+	}
+}
+
+int texture_slot(GLenum target)
+{
+	switch (target) {
+	case GL_TEXTURE_2D: return GL_STATE_TEXTURE_2D;
+	case GL_TEXTURE_2D_ARRAY: return GL_STATE_TEXTURE_2D_ARRAY;
+	case GL_TEXTURE_3D: return GL_STATE_TEXTURE_3D;
+	case GL_TEXTURE_CUBE_MAP: return GL_STATE_TEXTURE_CUBE_MAP;
+	default: return -1;
+	}
+}
+
+constexpr GLenum CAPABILITY_ENUMS[GL_STATE_CAPABILITY_COUNT] = { GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST };
+
+bool skip()
+{
+	gl_state.stats.skipped++;
+	return false;
+}
+
+bool issue()
+{
+	gl_state.stats.issued++;
+	return true;
+}
+
+} // namespace
+
+void gl_state_invalidate()
+{
+	const GlStateStats stats = gl_state.stats;
+	// 0xFF bytes make every name GL_STATE_UNKNOWN, every small field -1 and every float a NaN, none of
+	// which can compare equal to a real value.
+	std::memset(static_cast<void*>(&gl_state), 0xFF, sizeof(gl_state));
+	gl_state.stats = stats;
+}
+
+void gl_state_reset_stats()
+{
+	gl_state.stats = {};
+}
+
+bool gl_state_use_program(GLuint program)
+{
+	if (gl_state.program == program) {
+		return skip();
+	}
+	glUseProgram(program);
+	gl_state.program = program;
+	return issue();
+}
+
+bool gl_state_bind_vertex_array(GLuint vertex_array)
+{
+	if (gl_state.vertex_array == vertex_array) {
+		return skip();
+	}
+	glBindVertexArray(vertex_array);
+	gl_state.vertex_array = vertex_array;
+	return issue();
+}
+
+bool gl_state_bind_buffer(GLenum target, GLuint buffer)
+{
+	const int slot = buffer_slot(target);
+	if (slot >= 0 && gl_state.buffers[slot] == buffer) {
+		return skip();
+	}
+	glBindBuffer(target, buffer);
+	if (slot >= 0) {
+		gl_state.buffers[slot] = buffer;
+	}
+	return issue();
+}
+
+bool gl_state_bind_uniform_range(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	if (binding < GL_STATE_UNIFORM_BINDINGS) {
+		const GlBufferRange& range = gl_state.uniform_ranges[binding];
+		if (range.buffer == buffer && range.offset == offset && range.size == size) {
+			return skip();
+		}
+	}
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+	// Also replaces the generic GL_UNIFORM_BUFFER binding.
+	gl_state.buffers[GL_STATE_BUFFER_UNIFORM] = buffer;
+	if (binding < GL_STATE_UNIFORM_BINDINGS) {
+		gl_state.uniform_ranges[binding] = { buffer, offset, size };
+	}
+	return issue();
+}
+
+bool gl_state_bind_texture(GLuint unit, GLenum target, GLuint texture)
+{
+	const int slot = texture_slot(target);
+	if (slot >= 0 && unit < GL_STATE_TEXTURE_UNITS && gl_state.textures[unit][slot] == texture) {
+		return skip();
+	}
+
+	if (gl_state.active_texture_unit != unit) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		gl_state.active_texture_unit = unit;
+		issue();
+	}
+	glBindTexture(target, texture);
+	if (slot >= 0 && unit < GL_STATE_TEXTURE_UNITS) {
+		gl_state.textures[unit][slot] = texture;
+	}
+	return issue();
+}
+
+bool gl_state_set_capability(GlStateCapability capability, bool enabled)
+{
+	if (gl_state.capabilities[capability] == static_cast<int8>(enabled)) {
+		return skip();
+	}
+	if (enabled) {
+		glEnable(CAPABILITY_ENUMS[capability]);
+	}
+	else {
+		glDisable(CAPABILITY_ENUMS[capability]);
+	}
+	gl_state.capabilities[capability] = static_cast<int8>(enabled);
+	return issue();
+}
+
+bool gl_state_depth_mask(bool write)
+{
+	if (gl_state.depth_mask == static_cast<int8>(write)) {
+		return skip();
+	}
+	glDepthMask(write ? GL_TRUE : GL_FALSE);
+	gl_state.depth_mask = static_cast<int8>(write);
+	return issue();
+}
+
+bool gl_state_depth_func(GLenum function)
+{
+	if (gl_state.depth_func == function) {
+		return skip();
+	}
+	glDepthFunc(function);
+	gl_state.depth_func = function;
+	return issue();
+}
+
+bool gl_state_blend_func(GLenum source, GLenum destination)
+{
+	if (gl_state.blend_source == source && gl_state.blend_destination == destination) {
+		return skip();
+	}
+	glBlendFunc(source, destination);
+	gl_state.blend_source = source;
+	gl_state.blend_destination = destination;
+	return issue();
+}
+
+bool gl_state_cull_face(GLenum face)
+{
+	if (gl_state.cull_face == face) {
+		return skip();
+	}
+	glCullFace(face);
+	gl_state.cull_face = face;
+	return issue();
+}
+
+bool gl_state_polygon_mode(GLenum mode)
+{
+	if (gl_state.polygon_mode == mode) {
+		return skip();
+	}
+	glPolygonMode(GL_FRONT_AND_BACK, mode);
+	gl_state.polygon_mode = mode;
+	return issue();
+}
+
+bool gl_state_clear_color(float r, float g, float b, float a)
+{
+	const float color[4] = { r, g, b, a };
+	if (std::memcmp(gl_state.clear_color, color, sizeof(color)) == 0) {
+		return skip();
+	}
+	glClearColor(r, g, b, a);
+	std::memcpy(gl_state.clear_color, color, sizeof(color));
+	return issue();
+}
+
+bool gl_state_viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	const GLint viewport[4] = { x, y, width, height };
+	if (std::memcmp(gl_state.viewport, viewport, sizeof(viewport)) == 0) {
+		return skip();
+	}
+	glViewport(x, y, width, height);
+	std::memcpy(gl_state.viewport, viewport, sizeof(viewport));
+	return issue();
+}
+
+void gl_state_forget_program(GLuint program)
+{
+	// A deleted program stays current until another is used, but its name may be reused after that.
+	if (gl_state.program == program) {
+		gl_state.program = GL_STATE_UNKNOWN;
+	}
+}
+
+void gl_state_forget_vertex_array(GLuint vertex_array)
+{
+	if (gl_state.vertex_array == vertex_array) {
+		gl_state.vertex_array = 0;
+	}
+}
+
+void gl_state_forget_buffer(GLuint buffer)
+{
+	for (GLuint& bound : gl_state.buffers) {
+		if (bound == buffer) {
+			bound = 0;
+		}
+	}
+	for (GlBufferRange& range : gl_state.uniform_ranges) {
+		if (range.buffer == buffer) {
+			range = { 0, 0, 0 };
+		}
+	}
+}
+
+void gl_state_forget_texture(GLuint texture)
+{
+	for (auto& unit : gl_state.textures) {
+		for (GLuint& bound : unit) {
+			if (bound == texture) {
+				bound = 0;
+			}
+		}
+	}
+}
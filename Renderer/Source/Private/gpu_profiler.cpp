@@ -0,0 +1,212 @@
+#include "gpu_profiler.h"
+
+#include <engine_hash.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+uint16 find_scope(GpuProfiler* profiler, const char* name)
+{
+	const uint64 hash = hash_bytes(name, std::strlen(name));
+	for (uint32 i = 0; i < profiler->scope_count; ++i) {
+		if (profiler->scopes[i].name_hash == hash) {
+			return static_cast<uint16>(i);
+		}
+	}
+	if (profiler->scope_count == GPU_PROFILER_MAX_SCOPES) {
+		return 0xFFFF;
+	}
+
+	GpuScopeStats& scope = profiler->scopes[profiler->scope_count];
+	scope = {};
+	scope.name = name;
+	scope.name_hash = hash;
+	return static_cast<uint16>(profiler->scope_count++);
+}
+
+void add_sample(GpuScopeStats* scope, float ms)
+{
+	scope->min_ms = scope->samples == 0 ? ms : std::min(scope->min_ms, ms);
+	scope->max_ms = scope->samples == 0 ? ms : std::max(scope->max_ms, ms);
+	scope->total_ms += ms;
+	scope->samples++;
+	scope->history[scope->history_next] = ms;
+	scope->history_next = (scope->history_next + 1) % GPU_PROFILER_HISTORY;
+}
+
+void collect(GpuProfiler* profiler, GpuProfilerFrame* frame)
+{
+	if (!frame->pending) {
+		return;
+	}
+	frame->pending = false;
+	if (frame->scope_count == 0) {
+		return;
+	}
+
+	// Timestamps complete in submission order, so the last one being ready means all of them are.
+	GLuint available = GL_FALSE;
+	glGetQueryObjectuiv(frame->last_query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		profiler->dropped_frames++;
+		return;
+	}
+
+	for (uint32 i = 0; i < frame->scope_count; ++i) {
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(frame->queries[i * 2], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame->queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+		const float ms = end > begin ? static_cast<float>(static_cast<double>(end - begin) / 1.0e6) : 0.0f;
+		add_sample(&profiler->scopes[frame->scopes[i]], ms);
+	}
+}
+
+} // namespace
+
+void gpu_profiler_init(GpuProfiler* profiler)
+{
+	for (GpuProfilerFrame& frame : profiler->frames) {
+		glGenQueries(static_cast<GLsizei>(std::size(frame.queries)), frame.queries);
+		frame.scope_count = 0;
+		frame.pending = false;
+	}
+	profiler->frame = 0;
+	profiler->depth = 0;
+	profiler->overflow = 0;
+	profiler->scope_count = 0;
+	profiler->dropped_frames = 0;
+	profiler->dropped_scopes = 0;
+	profiler->initialised = true;
+}
+
+void gpu_profiler_destroy(GpuProfiler* profiler)
+{
+	if (!profiler->initialised) {
+		return;
+	}
+	for (GpuProfilerFrame& frame : profiler->frames) {
+		glDeleteQueries(static_cast<GLsizei>(std::size(frame.queries)), frame.queries);
+	}
+	profiler->initialised = false;
+}
+
+void gpu_profiler_begin_frame(GpuProfiler* profiler)
+{
+	if (!profiler->initialised) {
+		return;
+	}
+	profiler->frame = (profiler->frame + 1) % GPU_PROFILER_FRAMES_IN_FLIGHT;
+	GpuProfilerFrame& frame = profiler->frames[profiler->frame];
+	collect(profiler, &frame);
+	frame.scope_count = 0;
+	profiler->depth = 0;
+	profiler->overflow = 0;
+}
+
+void gpu_profiler_end_frame(GpuProfiler* profiler)
+{
+	if (!profiler->initialised) {
+		return;
+	}
+	if (profiler->depth != 0) {
+		std::cout << "ERROR::GPU_PROFILER::UNCLOSED_SCOPE " << profiler->depth << std::endl;
+		while (profiler->depth > 0) {
+			gpu_profiler_end(profiler);
+		}
+	}
+	profiler->frames[profiler->frame].pending = true;
+}
+
+void gpu_profiler_begin(GpuProfiler* profiler, const char* name)
+{
+	if (!profiler->initialised) {
+		return;
+	}
+	if (profiler->depth == GPU_PROFILER_MAX_DEPTH) {
+		profiler->dropped_scopes++;
+		profiler->overflow++;
+		return;
+	}
+	GpuProfilerFrame& frame = profiler->frames[profiler->frame];
+	const uint16 scope = find_scope(profiler, name);
+	if (scope == 0xFFFF || frame.scope_count == GPU_PROFILER_MAX_SCOPES) {
+		// Still pushed, so the matching end stays balanced.
+		profiler->dropped_scopes++;
+		profiler->open[profiler->depth++] = GPU_PROFILER_MAX_SCOPES;
+		return;
+	}
+
+	const uint32 index = frame.scope_count++;
+	frame.scopes[index] = scope;
+	glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+	frame.last_query = frame.queries[index * 2];
+	profiler->open[profiler->depth++] = index;
+}
+
+void gpu_profiler_end(GpuProfiler* profiler)
+{
+	if (!profiler->initialised || profiler->depth == 0) {
+		return;
+	}
+	if (profiler->overflow > 0) {
+		profiler->overflow--;
+		return;
+	}
+	const uint32 index = profiler->open[--profiler->depth];
+	if (index < GPU_PROFILER_MAX_SCOPES) {
+		GpuProfilerFrame& frame = profiler->frames[profiler->frame];
+		glQueryCounter(frame.queries[index * 2 + 1], GL_TIMESTAMP);
+		frame.last_query = frame.queries[index * 2 + 1];
+	}
+}
+
+uint32 gpu_profiler_summary(const GpuProfiler* profiler, GpuScopeSummary* summaries, uint32 capacity)
+{
+	for (uint32 i = 0; i < profiler->scope_count && i < capacity; ++i) {
+		const GpuScopeStats& scope = profiler->scopes[i];
+		GpuScopeSummary& summary = summaries[i];
+		summary.name = scope.name;
+		summary.samples = scope.samples;
+		summary.average_ms = scope.samples > 0 ? static_cast<float>(scope.total_ms / static_cast<double>(scope.samples)) : 0.0f;
+		summary.min_ms = scope.min_ms;
+		summary.max_ms = scope.max_ms;
+
+		const uint32 count = static_cast<uint32>(std::min<uint64>(scope.samples, GPU_PROFILER_HISTORY));
+		float sorted[GPU_PROFILER_HISTORY];
+		std::copy(scope.history, scope.history + count, sorted);
+		if (count > 0) {
+			const uint32 rank = (count * 99 + 99) / 100 - 1;
+			std::nth_element(sorted, sorted + rank, sorted + count);
+			summary.p99_ms = sorted[rank];
+		}
+		else {
+			summary.p99_ms = 0.0f;
+		}
+	}
+	return profiler->scope_count;
+}
+
+bool gpu_profiler_export_csv(const GpuProfiler* profiler, const char* path)
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		std::cout << "ERROR::GPU_PROFILER::EXPORT_FAILED " << path << std::endl;
+		return false;
+	}
+
+	GpuScopeSummary summaries[GPU_PROFILER_MAX_SCOPES];
+	const uint32 count = gpu_profiler_summary(profiler, summaries, GPU_PROFILER_MAX_SCOPES);
+	file << "scope,samples,average_ms,min_ms,max_ms,p99_ms\n";
+	for (uint32 i = 0; i < count; ++i) {
+		const GpuScopeSummary& summary = summaries[i];
+		file << summary.name << ',' << summary.samples << ',' << summary.average_ms << ',' << summary.min_ms << ','
+			<< summary.max_ms << ',' << summary.p99_ms << '\n';
+	}
+	return file.good();
+}
@@ -0,0 +1,276 @@
+#include "meshlet.h"
+
+#include <engine_assert.h>
+
+#include <cmath>
+#include <cfloat>
+
+namespace {
+
+struct MeshletBuilder
+{
+	std::vector<uint32> vertices{};
+	std::vector<uint32> triangles{};
+	vec3 centroid_sum{};
+};
+
+vec3 triangle_normal(const vec3* positions, const uint32* tri)
+{
+	const vec3& a = positions[tri[0]];
+	const vec3& b = positions[tri[1]];
+	const vec3& c = positions[tri[2]];
+	return (b - a).cross(c - a);
+}
+
+vec3 triangle_centroid(const vec3* positions, const uint32* tri)
+{
+	return (positions[tri[0]] + positions[tri[1]] + positions[tri[2]]) * (1.0f / 3.0f);
+}
+
+void compute_bounds(Meshlet* meshlet, const MeshletBuilder& builder, const vec3* positions, const uint32* indices)
+{
+	// Ritter's bounding sphere: seed with the two most distant points found in two sweeps, then grow.
+	const vec3& first = positions[builder.vertices[0]];
+	vec3 p0 = first;
+	float best = -1.0f;
+	for (uint32 v : builder.vertices) {
+		float d = first.distanceSquared(positions[v]);
+		if (d > best) { best = d; p0 = positions[v]; }
+	}
+	vec3 p1 = p0;
+	best = -1.0f;
+	for (uint32 v : builder.vertices) {
+		float d = p0.distanceSquared(positions[v]);
+		if (d > best) { best = d; p1 = positions[v]; }
+	}
+
+	vec3 center = (p0 + p1) * 0.5f;
+	float radius = p0.distance(p1) * 0.5f;
+	for (uint32 v : builder.vertices) {
+		float d = center.distance(positions[v]);
+		if (d > radius) {
+			float new_radius = (radius + d) * 0.5f;
+			center = center + (positions[v] - center) * ((new_radius - radius) / d);
+			radius = new_radius;
+		}
+	}
+
+	meshlet->center = center;
+	meshlet->radius = radius;
+
+	vec3 axis{};
+	for (uint32 t : builder.triangles) {
+		axis = axis + triangle_normal(positions, &indices[t * 3]).normalize();
+	}
+	axis = axis.normalize();
+
+	float min_dot = 1.0f;
+	for (uint32 t : builder.triangles) {
+		vec3 n = triangle_normal(positions, &indices[t * 3]).normalize();
+		if (n.magnitudeSquared() > 0.0f) {
+			min_dot = std::fmin(min_dot, axis.dot(n));
+		}
+	}
+
+	meshlet->cone_axis = axis;
+	meshlet->cone_cutoff = (min_dot <= 0.0f || axis.magnitudeSquared() == 0.0f)
+		? 1.0f
+		: std::sqrt(1.0f - min_dot * min_dot);
+}
+
+void flush_meshlet(MeshletMesh* mesh, MeshletBuilder& builder, std::vector<int16>& local_slot,
+	const vec3* positions, const uint32* indices)
+{
+	if (builder.triangles.empty()) {
+		return;
+	}
+
+	Meshlet meshlet{};
+	meshlet.vertex_offset = static_cast<uint32>(mesh->meshlet_vertices.size());
+	meshlet.triangle_offset = static_cast<uint32>(mesh->meshlet_triangles.size());
+	meshlet.index_offset = static_cast<uint32>(mesh->indices.size());
+	meshlet.vertex_count = static_cast<uint32>(builder.vertices.size());
+	meshlet.triangle_count = static_cast<uint32>(builder.triangles.size());
+
+	mesh->meshlet_vertices.insert(mesh->meshlet_vertices.end(), builder.vertices.begin(), builder.vertices.end());
+
+	for (uint32 t : builder.triangles) {
+		for (int corner = 0; corner < 3; ++corner) {
+			uint32 v = indices[t * 3 + corner];
+			mesh->meshlet_triangles.push_back(static_cast<uint8>(local_slot[v]));
+			mesh->indices.push_back(v);
+		}
+	}
+
+	compute_bounds(&meshlet, builder, positions, indices);
+	mesh->meshlets.push_back(meshlet);
+
+	for (uint32 v : builder.vertices) {
+		local_slot[v] = -1;
+	}
+	builder.vertices.clear();
+	builder.triangles.clear();
+	builder.centroid_sum = vec3::zero();
+}
+
+} // namespace
+
+void meshlet_build(MeshletMesh* mesh, const vec3* positions, std::size_t vertex_count,
+	const uint32* indices, std::size_t index_count)
+{
+	RT_ASSERT(mesh != nullptr, "Meshlet mesh is nullptr");
+	RT_ASSERT(index_count % 3 == 0, "Meshlet build expects a triangle list");
+
+	mesh->meshlets.clear();
+	mesh->meshlet_vertices.clear();
+	mesh->meshlet_triangles.clear();
+	mesh->indices.clear();
+	mesh->indices.reserve(index_count);
+
+	const uint32 triangle_count = static_cast<uint32>(index_count / 3);
+	if (triangle_count == 0) {
+		return;
+	}
+
+	// Vertex -> triangle adjacency in CSR form.
+	std::vector<uint32> adjacency_offsets(vertex_count + 1, 0);
+	for (std::size_t i = 0; i < index_count; ++i) {
+		adjacency_offsets[indices[i] + 1]++;
+	}
+	for (std::size_t v = 0; v < vertex_count; ++v) {
+		adjacency_offsets[v + 1] += adjacency_offsets[v];
+	}
+	std::vector<uint32> adjacency(index_count);
+	std::vector<uint32> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+	for (uint32 t = 0; t < triangle_count; ++t) {
+		for (int corner = 0; corner < 3; ++corner) {
+			adjacency[fill[indices[t * 3 + corner]]++] = t;
+		}
+	}
+
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<int16> local_slot(vertex_count, -1);
+	MeshletBuilder builder{};
+	builder.vertices.reserve(MESHLET_MAX_VERTICES);
+	builder.triangles.reserve(MESHLET_MAX_TRIANGLES);
+
+	uint32 seed_cursor = 0;
+	uint32 remaining = triangle_count;
+
+	while (remaining > 0) {
+		uint32 best_triangle = UINT32_MAX;
+		uint32 best_new_vertices = 4;
+		float best_distance = FLT_MAX;
+
+		if (!builder.triangles.empty()) {
+			vec3 centroid = builder.centroid_sum * (1.0f / static_cast<float>(builder.triangles.size()));
+
+			for (uint32 v : builder.vertices) {
+				for (uint32 a = adjacency_offsets[v]; a < adjacency_offsets[v + 1]; ++a) {
+					uint32 t = adjacency[a];
+					if (emitted[t]) {
+						continue;
+					}
+
+					uint32 new_vertices = 0;
+					for (int corner = 0; corner < 3; ++corner) {
+						new_vertices += local_slot[indices[t * 3 + corner]] < 0 ? 1 : 0;
+					}
+
+					// Triangles that close a fan are free; everything else grows the cluster outwards
+					// from its centroid so bounds stay tight.
+					float distance = new_vertices == 0
+						? -1.0f
+						: centroid.distanceSquared(triangle_centroid(positions, &indices[t * 3]));
+					if (distance < best_distance ||
+						(distance == best_distance && new_vertices < best_new_vertices)) {
+						best_triangle = t;
+						best_new_vertices = new_vertices;
+						best_distance = distance;
+					}
+				}
+			}
+		}
+
+		if (best_triangle == UINT32_MAX) {
+			// Cluster is enclosed by emitted triangles; start a new one instead of jumping across the mesh.
+			flush_meshlet(mesh, builder, local_slot, positions, indices);
+
+			while (emitted[seed_cursor]) {
+				++seed_cursor;
+			}
+			best_triangle = seed_cursor;
+			best_new_vertices = 3;
+		}
+
+		if (builder.vertices.size() + best_new_vertices > MESHLET_MAX_VERTICES ||
+			builder.triangles.size() + 1 > MESHLET_MAX_TRIANGLES) {
+			flush_meshlet(mesh, builder, local_slot, positions, indices);
+		}
+
+		for (int corner = 0; corner < 3; ++corner) {
+			uint32 v = indices[best_triangle * 3 + corner];
+			if (local_slot[v] < 0) {
+				local_slot[v] = static_cast<int16>(builder.vertices.size());
+				builder.vertices.push_back(v);
+			}
+		}
+		builder.triangles.push_back(best_triangle);
+		builder.centroid_sum = builder.centroid_sum + triangle_centroid(positions, &indices[best_triangle * 3]);
+		emitted[best_triangle] = true;
+		--remaining;
+	}
+
+	flush_meshlet(mesh, builder, local_slot, positions, indices);
+}
+
+void meshlet_cull(const MeshletMesh* mesh, const frustum& view_frustum, const vec3& camera_position,
+	MeshletDrawList* draw_list)
+{
+	RT_ASSERT(mesh != nullptr && draw_list != nullptr, "Meshlet cull passed nullptr");
+
+	draw_list->counts.clear();
+	draw_list->offsets.clear();
+	draw_list->visible_meshlets = 0;
+	draw_list->culled_meshlets = 0;
+
+	uint32 range_end = UINT32_MAX;
+
+	for (const Meshlet& meshlet : mesh->meshlets) {
+		bool visible = view_frustum.isSphereVisible(meshlet.center, meshlet.radius);
+
+		if (visible && meshlet.cone_cutoff < 1.0f) {
+			vec3 to_center = meshlet.center - camera_position;
+			visible = to_center.dot(meshlet.cone_axis) < meshlet.cone_cutoff * to_center.magnitude() + meshlet.radius;
+		}
+
+		if (!visible) {
+			draw_list->culled_meshlets++;
+			continue;
+		}
+
+		draw_list->visible_meshlets++;
+		const uint32 count = meshlet.triangle_count * 3;
+
+		// Consecutive survivors share one range, so fully visible meshes still cost a single draw.
+		if (range_end == meshlet.index_offset) {
+			draw_list->counts.back() += static_cast<GLsizei>(count);
+		}
+		else {
+			draw_list->counts.push_back(static_cast<GLsizei>(count));
+			draw_list->offsets.push_back(reinterpret_cast<const void*>(
+				static_cast<uintptr_t>(meshlet.index_offset) * sizeof(uint32)));
+		}
+		range_end = meshlet.index_offset + count;
+	}
+}
+
+void meshlet_draw(const MeshletDrawList* draw_list)
+{
+	if (draw_list->counts.empty()) {
+		return;
+	}
+
+	glMultiDrawElements(GL_TRIANGLES, draw_list->counts.data(), GL_UNSIGNED_INT,
+		draw_list->offsets.data(), static_cast<GLsizei>(draw_list->counts.size()));
+}
@@ -0,0 +1,1117 @@
+#include "null_backend.h"
+#include "gl_extensions.h"
+
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+NullBackendStats null_backend_stats{};
+
+namespace {
+
+struct NullBuffer {
+	GLsizeiptr size = 0;
+	bool immutable = false;
+	bool mapped = false;
+	// Only allocated once the buffer is mapped; nothing else reads the contents.
+	std::vector<uint8> storage{};
+};
+
+struct NullProgram {
+	uint32 attached = 0;
+	bool linked = false;
+};
+
+enum NullBufferSlot : uint8 {
+	NULL_BUFFER_ARRAY,
+	NULL_BUFFER_UNIFORM,
+	NULL_BUFFER_COPY_READ,
+	NULL_BUFFER_COPY_WRITE,
+	NULL_BUFFER_PIXEL_PACK,
+	NULL_BUFFER_PIXEL_UNPACK,
+	NULL_BUFFER_DRAW_INDIRECT,
+	NULL_BUFFER_SLOT_COUNT
+};
+
+struct NullState {
+	// One namespace for every object type, so a name used as the wrong type is always caught.
+	GLuint next_name = 1;
+	std::unordered_map<GLuint, NullBuffer> buffers{};
+	// Vertex array -> its element array buffer; 0 is the binding made with no vertex array bound.
+	std::unordered_map<GLuint, GLuint> vertex_arrays{};
+	std::unordered_set<GLuint> shaders{};
+	std::unordered_map<GLuint, NullProgram> programs{};
+	std::unordered_set<GLuint> textures{};
+	std::unordered_set<GLuint> queries{};
+	std::unordered_set<GLuint> framebuffers{};
+	std::unordered_set<GLuint> renderbuffers{};
+
+	GLuint buffer_bindings[NULL_BUFFER_SLOT_COUNT]{};
+	GLuint program = 0;
+	GLuint vertex_array = 0;
+	GLuint renderbuffer = 0;
+	uintptr_t next_sync = 1;
+
+	GLenum error = GL_NO_ERROR;
+	std::unordered_set<const char*> reported{};
+};
+
+NullState state{};
+
+// Records the first error until glGetError reads it, as GL does.
+void fail(GLenum error, const char* what)
+{
+	null_backend_stats.errors++;
+	if (state.error == GL_NO_ERROR) {
+		state.error = error;
+	}
+	if (state.reported.insert(what).second) {
+		std::cout << "ERROR::NULL_BACKEND::" << what << std::endl;
+	}
+}
+
+void count()
+{
+	null_backend_stats.calls++;
+}
+
+GLuint generate()
+{
+	return state.next_name++;
+}
+
+int buffer_slot(GLenum target)
+{
+	switch (target) {
+	case GL_ARRAY_BUFFER: return NULL_BUFFER_ARRAY;
+	case GL_UNIFORM_BUFFER: return NULL_BUFFER_UNIFORM;
+	case GL_COPY_READ_BUFFER: return NULL_BUFFER_COPY_READ;
+	case GL_COPY_WRITE_BUFFER: return NULL_BUFFER_COPY_WRITE;
+	case GL_PIXEL_PACK_BUFFER: return NULL_BUFFER_PIXEL_PACK;
+	case GL_PIXEL_UNPACK_BUFFER: return NULL_BUFFER_PIXEL_UNPACK;
+	case GL_DRAW_INDIRECT_BUFFER: return NULL_BUFFER_DRAW_INDIRECT;
+	default: return -1;
+	}
+}
+
+GLuint* binding_for(GLenum target)
+{
+	if (target == GL_ELEMENT_ARRAY_BUFFER) {
+		return &state.vertex_arrays[state.vertex_array];
+	}
+	const int slot = buffer_slot(target);
+	return slot >= 0 ? &state.buffer_bindings[slot] : nullptr;
+}
+
+// The buffer bound to target, or null after reporting why there is none.
+NullBuffer* bound_buffer(GLenum target, const char* what)
+{
+	const GLuint* binding = binding_for(target);
+	if (!binding) {
+		fail(GL_INVALID_ENUM, what);
+		return nullptr;
+	}
+	const auto found = state.buffers.find(*binding);
+	if (*binding == 0 || found == state.buffers.end()) {
+		fail(GL_INVALID_OPERATION, what);
+		return nullptr;
+	}
+	return &found->second;
+}
+
+bool in_range(const NullBuffer* buffer, uint64 offset, uint64 size)
+{
+	return offset <= static_cast<uint64>(buffer->size) && size <= static_cast<uint64>(buffer->size) - offset;
+}
+
+uint32 index_size(GLenum type)
+{
+	switch (type) {
+	case GL_UNSIGNED_BYTE: return 1;
+	case GL_UNSIGNED_SHORT: return 2;
+	case GL_UNSIGNED_INT: return 4;
+	default: return 0;
+	}
+}
+
+bool validate_draw(GLsizei count, GLsizei instances)
+{
+	const auto program = state.programs.find(state.program);
+	if (program == state.programs.end() || !program->second.linked) {
+		fail(GL_INVALID_OPERATION, "DRAW_WITHOUT_PROGRAM");
+		return false;
+	}
+	if (state.vertex_array == 0) {
+		fail(GL_INVALID_OPERATION, "DRAW_WITHOUT_VERTEX_ARRAY");
+		return false;
+	}
+	if (count < 0 || instances < 0) {
+		fail(GL_INVALID_VALUE, "DRAW_NEGATIVE_COUNT");
+		return false;
+	}
+	return true;
+}
+
+bool validate_indices(GLsizei count, GLenum type, const void* indices)
+{
+	const uint32 size = index_size(type);
+	if (size == 0) {
+		fail(GL_INVALID_ENUM, "DRAW_INDEX_TYPE");
+		return false;
+	}
+	const NullBuffer* elements = bound_buffer(GL_ELEMENT_ARRAY_BUFFER, "DRAW_WITHOUT_INDEX_BUFFER");
+	if (!elements) {
+		return false;
+	}
+	if (!in_range(elements, reinterpret_cast<uintptr_t>(indices), static_cast<uint64>(count) * size)) {
+		fail(GL_INVALID_OPERATION, "DRAW_INDICES_OUT_OF_RANGE");
+		return false;
+	}
+	return true;
+}
+
+void record_draws(uint64 draws, uint64 instances)
+{
+	null_backend_stats.draws += draws;
+	null_backend_stats.instances += instances;
+}
+
+// Queries.
+
+const GLubyte* APIENTRY get_string(GLenum name)
+{
+	count();
+	switch (name) {
+	case GL_VENDOR: return reinterpret_cast<const GLubyte*>("Helicon");
+	case GL_RENDERER: return reinterpret_cast<const GLubyte*>("Null");
+	case GL_VERSION: return reinterpret_cast<const GLubyte*>("4.5 Null");
+	case GL_SHADING_LANGUAGE_VERSION: return reinterpret_cast<const GLubyte*>("4.50");
+	default:
+		fail(GL_INVALID_ENUM, "GET_STRING");
+		return nullptr;
+	}
+}
+
+// glad refuses a context with no extensions at all, so the backend names itself as one.
+const GLubyte* APIENTRY get_string_i(GLenum name, GLuint index)
+{
+	count();
+	if (name != GL_EXTENSIONS || index != 0) {
+		fail(GL_INVALID_VALUE, "GET_STRING_INDEX");
+		return nullptr;
+	}
+	return reinterpret_cast<const GLubyte*>("GL_HELICON_null_backend");
+}
+
+void APIENTRY get_integer_v(GLenum name, GLint* data)
+{
+	count();
+	switch (name) {
+	case GL_MAJOR_VERSION: *data = 4; break;
+	case GL_MINOR_VERSION: *data = 5; break;
+	case GL_NUM_EXTENSIONS: *data = 1; break;
+	case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: *data = 256; break;
+	default: *data = 0; break;
+	}
+}
+
+GLenum APIENTRY get_error()
+{
+	count();
+	const GLenum error = state.error;
+	state.error = GL_NO_ERROR;
+	return error;
+}
+
+void APIENTRY flush()
+{
+	count();
+}
+
+// Buffers.
+
+void APIENTRY gen_buffers(GLsizei n, GLuint* buffers)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		buffers[i] = generate();
+		state.buffers.emplace(buffers[i], NullBuffer{});
+	}
+}
+
+void APIENTRY delete_buffers(GLsizei n, const GLuint* buffers)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		if (buffers[i] == 0 || state.buffers.erase(buffers[i]) == 0) {
+			continue;
+		}
+		for (GLuint& binding : state.buffer_bindings) {
+			binding = binding == buffers[i] ? 0 : binding;
+		}
+		for (auto& vertex_array : state.vertex_arrays) {
+			vertex_array.second = vertex_array.second == buffers[i] ? 0 : vertex_array.second;
+		}
+	}
+}
+
+void APIENTRY bind_buffer(GLenum target, GLuint buffer)
+{
+	count();
+	GLuint* binding = binding_for(target);
+	if (!binding) {
+		fail(GL_INVALID_ENUM, "BIND_BUFFER_TARGET");
+		return;
+	}
+	if (buffer != 0 && state.buffers.find(buffer) == state.buffers.end()) {
+		fail(GL_INVALID_OPERATION, "BIND_UNKNOWN_BUFFER");
+		return;
+	}
+	*binding = buffer;
+}
+
+void APIENTRY bind_buffer_range(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	count();
+	if (target != GL_UNIFORM_BUFFER) {
+		fail(GL_INVALID_ENUM, "BIND_BUFFER_RANGE_TARGET");
+		return;
+	}
+	const auto found = state.buffers.find(buffer);
+	if (found == state.buffers.end()) {
+		fail(GL_INVALID_OPERATION, "BIND_UNKNOWN_BUFFER");
+		return;
+	}
+	if (offset % 256 != 0 || size <= 0 || !in_range(&found->second, static_cast<uint64>(offset), static_cast<uint64>(size))) {
+		fail(GL_INVALID_VALUE, "BIND_BUFFER_RANGE");
+		return;
+	}
+	// Indexed binding points are not checked at draw time, so only the generic binding is kept.
+	(void)index;
+	state.buffer_bindings[NULL_BUFFER_UNIFORM] = buffer;
+}
+
+void APIENTRY buffer_data(GLenum target, GLsizeiptr size, const void* data, GLenum)
+{
+	count();
+	NullBuffer* buffer = bound_buffer(target, "BUFFER_DATA_UNBOUND");
+	if (!buffer) {
+		return;
+	}
+	if (buffer->immutable || size < 0) {
+		fail(buffer->immutable ? GL_INVALID_OPERATION : GL_INVALID_VALUE, "BUFFER_DATA");
+		return;
+	}
+	buffer->size = size;
+	buffer->mapped = false;
+	buffer->storage.clear();
+	null_backend_stats.buffer_bytes += data ? static_cast<uint64>(size) : 0;
+}
+
+void APIENTRY buffer_storage(GLenum target, GLsizeiptr size, const void*, GLbitfield)
+{
+	count();
+	NullBuffer* buffer = bound_buffer(target, "BUFFER_STORAGE_UNBOUND");
+	if (!buffer) {
+		return;
+	}
+	if (buffer->immutable || size <= 0) {
+		fail(buffer->immutable ? GL_INVALID_OPERATION : GL_INVALID_VALUE, "BUFFER_STORAGE");
+		return;
+	}
+	buffer->size = size;
+	buffer->immutable = true;
+}
+
+void APIENTRY buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void*)
+{
+	count();
+	NullBuffer* buffer = bound_buffer(target, "BUFFER_SUB_DATA_UNBOUND");
+	if (!buffer) {
+		return;
+	}
+	if (offset < 0 || size < 0 || !in_range(buffer, static_cast<uint64>(offset), static_cast<uint64>(size))) {
+		fail(GL_INVALID_VALUE, "BUFFER_SUB_DATA_OUT_OF_RANGE");
+		return;
+	}
+	null_backend_stats.buffer_bytes += static_cast<uint64>(size);
+}
+
+void* APIENTRY map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield)
+{
+	count();
+	NullBuffer* buffer = bound_buffer(target, "MAP_UNBOUND");
+	if (!buffer) {
+		return nullptr;
+	}
+	if (buffer->mapped) {
+		fail(GL_INVALID_OPERATION, "MAP_ALREADY_MAPPED");
+		return nullptr;
+	}
+	if (offset < 0 || length <= 0 || !in_range(buffer, static_cast<uint64>(offset), static_cast<uint64>(length))) {
+		fail(GL_INVALID_VALUE, "MAP_OUT_OF_RANGE");
+		return nullptr;
+	}
+	buffer->storage.resize(static_cast<std::size_t>(buffer->size));
+	buffer->mapped = true;
+	return buffer->storage.data() + offset;
+}
+
+GLboolean APIENTRY unmap_buffer(GLenum target)
+{
+	count();
+	NullBuffer* buffer = bound_buffer(target, "UNMAP_UNBOUND");
+	if (!buffer) {
+		return GL_FALSE;
+	}
+	if (!buffer->mapped) {
+		fail(GL_INVALID_OPERATION, "UNMAP_NOT_MAPPED");
+		return GL_FALSE;
+	}
+	buffer->mapped = false;
+	return GL_TRUE;
+}
+
+// Vertex arrays.
+
+void APIENTRY gen_vertex_arrays(GLsizei n, GLuint* arrays)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		arrays[i] = generate();
+		state.vertex_arrays.emplace(arrays[i], 0);
+	}
+}
+
+void APIENTRY delete_vertex_arrays(GLsizei n, const GLuint* arrays)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		if (arrays[i] != 0 && state.vertex_arrays.erase(arrays[i]) > 0 && state.vertex_array == arrays[i]) {
+			state.vertex_array = 0;
+		}
+	}
+}
+
+void APIENTRY bind_vertex_array(GLuint array)
+{
+	count();
+	if (array != 0 && state.vertex_arrays.find(array) == state.vertex_arrays.end()) {
+		fail(GL_INVALID_OPERATION, "BIND_UNKNOWN_VERTEX_ARRAY");
+		return;
+	}
+	state.vertex_array = array;
+}
+
+void APIENTRY enable_vertex_attrib_array(GLuint)
+{
+	count();
+	if (state.vertex_array == 0) {
+		fail(GL_INVALID_OPERATION, "ATTRIBUTE_WITHOUT_VERTEX_ARRAY");
+	}
+}
+
+void APIENTRY vertex_attrib_pointer(GLuint, GLint size, GLenum, GLboolean, GLsizei stride, const void*)
+{
+	count();
+	if (state.vertex_array == 0 || state.buffer_bindings[NULL_BUFFER_ARRAY] == 0) {
+		fail(GL_INVALID_OPERATION, "ATTRIBUTE_WITHOUT_BUFFER");
+		return;
+	}
+	if (size < 1 || size > 4 || stride < 0) {
+		fail(GL_INVALID_VALUE, "ATTRIBUTE_LAYOUT");
+	}
+}
+
+void APIENTRY vertex_attrib_divisor(GLuint, GLuint)
+{
+	count();
+	if (state.vertex_array == 0) {
+		fail(GL_INVALID_OPERATION, "ATTRIBUTE_WITHOUT_VERTEX_ARRAY");
+	}
+}
+
+// Shaders and programs. Every compile and link succeeds and reflects nothing.
+
+GLuint APIENTRY create_shader(GLenum)
+{
+	count();
+	const GLuint shader = generate();
+	state.shaders.insert(shader);
+	return shader;
+}
+
+void APIENTRY delete_shader(GLuint shader)
+{
+	count();
+	state.shaders.erase(shader);
+}
+
+void APIENTRY shader_source(GLuint shader, GLsizei, const GLchar* const*, const GLint*)
+{
+	count();
+	if (state.shaders.find(shader) == state.shaders.end()) {
+		fail(GL_INVALID_VALUE, "UNKNOWN_SHADER");
+	}
+}
+
+void APIENTRY compile_shader(GLuint shader)
+{
+	shader_source(shader, 0, nullptr, nullptr);
+}
+
+void APIENTRY get_shader_iv(GLuint shader, GLenum name, GLint* value)
+{
+	count();
+	if (state.shaders.find(shader) == state.shaders.end()) {
+		fail(GL_INVALID_VALUE, "UNKNOWN_SHADER");
+	}
+	*value = name == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+void APIENTRY get_shader_info_log(GLuint, GLsizei size, GLsizei* length, GLchar* log)
+{
+	count();
+	if (length) {
+		*length = 0;
+	}
+	if (size > 0) {
+		log[0] = '\0';
+	}
+}
+
+GLuint APIENTRY create_program()
+{
+	count();
+	const GLuint program = generate();
+	state.programs.emplace(program, NullProgram{});
+	return program;
+}
+
+void APIENTRY delete_program(GLuint program)
+{
+	count();
+	state.programs.erase(program);
+}
+
+NullProgram* find_program(GLuint program)
+{
+	const auto found = state.programs.find(program);
+	if (found == state.programs.end()) {
+		fail(GL_INVALID_VALUE, "UNKNOWN_PROGRAM");
+		return nullptr;
+	}
+	return &found->second;
+}
+
+void APIENTRY attach_shader(GLuint program, GLuint shader)
+{
+	count();
+	NullProgram* found = find_program(program);
+	if (found && state.shaders.find(shader) != state.shaders.end()) {
+		found->attached++;
+	}
+}
+
+void APIENTRY link_program(GLuint program)
+{
+	count();
+	if (NullProgram* found = find_program(program)) {
+		found->linked = found->attached > 0;
+	}
+}
+
+void APIENTRY program_parameter_i(GLuint program, GLenum, GLint)
+{
+	count();
+	find_program(program);
+}
+
+void APIENTRY get_program_iv(GLuint program, GLenum name, GLint* value)
+{
+	count();
+	const NullProgram* found = find_program(program);
+	switch (name) {
+	case GL_LINK_STATUS: *value = found && found->linked ? GL_TRUE : GL_FALSE; break;
+	case GL_COMPLETION_STATUS_KHR: *value = GL_TRUE; break;
+	default: *value = 0; break;
+	}
+}
+
+void APIENTRY get_program_info_log(GLuint, GLsizei size, GLsizei* length, GLchar* log)
+{
+	get_shader_info_log(0, size, length, log);
+}
+
+void APIENTRY get_active_uniform(GLuint, GLuint, GLsizei, GLsizei*, GLint*, GLenum*, GLchar*)
+{
+	count();
+	fail(GL_INVALID_VALUE, "ACTIVE_UNIFORM_INDEX");
+}
+
+GLint APIENTRY get_uniform_location(GLuint program, const GLchar*)
+{
+	count();
+	find_program(program);
+	return -1;
+}
+
+GLuint APIENTRY get_uniform_block_index(GLuint program, const GLchar*)
+{
+	count();
+	find_program(program);
+	return GL_INVALID_INDEX;
+}
+
+void APIENTRY uniform_block_binding(GLuint program, GLuint, GLuint)
+{
+	count();
+	find_program(program);
+	fail(GL_INVALID_VALUE, "UNIFORM_BLOCK_INDEX");
+}
+
+void APIENTRY use_program(GLuint program)
+{
+	count();
+	if (program != 0) {
+		const NullProgram* found = find_program(program);
+		if (!found || !found->linked) {
+			fail(GL_INVALID_OPERATION, "USE_UNLINKED_PROGRAM");
+			return;
+		}
+	}
+	state.program = program;
+}
+
+void check_uniform()
+{
+	count();
+	if (state.program == 0) {
+		fail(GL_INVALID_OPERATION, "UNIFORM_WITHOUT_PROGRAM");
+	}
+}
+
+void APIENTRY uniform_1i(GLint, GLint) { check_uniform(); }
+void APIENTRY uniform_1f(GLint, GLfloat) { check_uniform(); }
+void APIENTRY uniform_3f(GLint, GLfloat, GLfloat, GLfloat) { check_uniform(); }
+void APIENTRY uniform_matrix_4fv(GLint, GLsizei, GLboolean, const GLfloat*) { check_uniform(); }
+
+void APIENTRY get_program_binary(GLuint, GLsizei, GLsizei* length, GLenum*, void*)
+{
+	count();
+	fail(GL_INVALID_OPERATION, "NO_PROGRAM_BINARY_FORMATS");
+	if (length) {
+		*length = 0;
+	}
+}
+
+void APIENTRY program_binary(GLuint, GLenum, const void*, GLsizei)
+{
+	count();
+	fail(GL_INVALID_ENUM, "NO_PROGRAM_BINARY_FORMATS");
+}
+
+// Textures and framebuffers.
+
+void APIENTRY gen_textures(GLsizei n, GLuint* textures)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		textures[i] = generate();
+		state.textures.insert(textures[i]);
+	}
+}
+
+void APIENTRY delete_textures(GLsizei n, const GLuint* textures)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		state.textures.erase(textures[i]);
+	}
+}
+
+void APIENTRY active_texture(GLenum unit)
+{
+	count();
+	if (unit < GL_TEXTURE0 || unit > GL_TEXTURE31) {
+		fail(GL_INVALID_ENUM, "ACTIVE_TEXTURE");
+	}
+}
+
+void APIENTRY bind_texture(GLenum, GLuint texture)
+{
+	count();
+	if (texture != 0 && state.textures.find(texture) == state.textures.end()) {
+		fail(GL_INVALID_OPERATION, "BIND_UNKNOWN_TEXTURE");
+	}
+}
+
+void APIENTRY tex_parameter_i(GLenum, GLenum, GLint)
+{
+	count();
+}
+
+void APIENTRY tex_image_2d(GLenum, GLint level, GLint, GLsizei width, GLsizei height, GLint border, GLenum, GLenum, const void*)
+{
+	count();
+	if (level < 0 || width < 0 || height < 0 || border != 0) {
+		fail(GL_INVALID_VALUE, "TEX_IMAGE");
+	}
+}
+
+void APIENTRY compressed_tex_image_2d(GLenum target, GLint level, GLenum format, GLsizei width, GLsizei height, GLint border,
+	GLsizei, const void* data)
+{
+	tex_image_2d(target, level, static_cast<GLint>(format), width, height, border, 0, 0, data);
+}
+
+void APIENTRY generate_mipmap(GLenum)
+{
+	count();
+}
+
+void APIENTRY pixel_store_i(GLenum, GLint)
+{
+	count();
+}
+
+void APIENTRY gen_framebuffers(GLsizei n, GLuint* framebuffers)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		framebuffers[i] = generate();
+		state.framebuffers.insert(framebuffers[i]);
+	}
+}
+
+void APIENTRY delete_framebuffers(GLsizei n, const GLuint* framebuffers)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		state.framebuffers.erase(framebuffers[i]);
+	}
+}
+
+void APIENTRY bind_framebuffer(GLenum, GLuint framebuffer)
+{
+	count();
+	if (framebuffer != 0 && state.framebuffers.find(framebuffer) == state.framebuffers.end()) {
+		fail(GL_INVALID_OPERATION, "BIND_UNKNOWN_FRAMEBUFFER");
+	}
+}
+
+void APIENTRY framebuffer_texture_2d(GLenum, GLenum, GLenum, GLuint texture, GLint level)
+{
+	count();
+	if (texture != 0 && state.textures.find(texture) == state.textures.end()) {
+		fail(GL_INVALID_OPERATION, "ATTACH_UNKNOWN_TEXTURE");
+	}
+	else if (level < 0) {
+		fail(GL_INVALID_VALUE, "ATTACH_TEXTURE_LEVEL");
+	}
+}
+
+void APIENTRY draw_buffer(GLenum)
+{
+	count();
+}
+
+void APIENTRY draw_buffers(GLsizei n, const GLenum* buffers)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		if (buffers[i] != GL_NONE && (buffers[i] < GL_COLOR_ATTACHMENT0 || buffers[i] > GL_COLOR_ATTACHMENT15)) {
+			fail(GL_INVALID_ENUM, "DRAW_BUFFERS");
+			return;
+		}
+	}
+}
+
+void APIENTRY blit_framebuffer(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield mask, GLenum filter)
+{
+	count();
+	if ((mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) != 0) {
+		fail(GL_INVALID_VALUE, "BLIT_MASK");
+	}
+	else if (filter == GL_LINEAR && (mask & (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) != 0) {
+		fail(GL_INVALID_OPERATION, "BLIT_LINEAR_DEPTH");
+	}
+}
+
+GLenum APIENTRY check_framebuffer_status(GLenum)
+{
+	count();
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void APIENTRY gen_renderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		renderbuffers[i] = generate();
+		state.renderbuffers.insert(renderbuffers[i]);
+	}
+}
+
+void APIENTRY delete_renderbuffers(GLsizei n, const GLuint* renderbuffers)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		state.renderbuffers.erase(renderbuffers[i]);
+	}
+}
+
+void APIENTRY bind_renderbuffer(GLenum, GLuint renderbuffer)
+{
+	count();
+	if (renderbuffer != 0 && state.renderbuffers.find(renderbuffer) == state.renderbuffers.end()) {
+		fail(GL_INVALID_OPERATION, "BIND_UNKNOWN_RENDERBUFFER");
+		return;
+	}
+	state.renderbuffer = renderbuffer;
+}
+
+void APIENTRY renderbuffer_storage(GLenum, GLenum, GLsizei width, GLsizei height)
+{
+	count();
+	if (state.renderbuffer == 0) {
+		fail(GL_INVALID_OPERATION, "RENDERBUFFER_UNBOUND");
+	}
+	else if (width < 0 || height < 0) {
+		fail(GL_INVALID_VALUE, "RENDERBUFFER_SIZE");
+	}
+}
+
+void APIENTRY framebuffer_renderbuffer(GLenum, GLenum, GLenum, GLuint renderbuffer)
+{
+	count();
+	if (renderbuffer != 0 && state.renderbuffers.find(renderbuffer) == state.renderbuffers.end()) {
+		fail(GL_INVALID_OPERATION, "ATTACH_UNKNOWN_RENDERBUFFER");
+	}
+}
+
+void APIENTRY read_pixels(GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum type, void* pixels)
+{
+	count();
+	// Only tightly packed RGBA8 is read back anywhere; anything else is left untouched.
+	if (type == GL_UNSIGNED_BYTE && width > 0 && height > 0 && state.buffer_bindings[NULL_BUFFER_PIXEL_PACK] == 0) {
+		std::memset(pixels, 0, static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4);
+	}
+}
+
+// Fixed-function state.
+
+void APIENTRY enable(GLenum) { count(); }
+void APIENTRY disable(GLenum) { count(); }
+void APIENTRY depth_mask(GLboolean) { count(); }
+void APIENTRY depth_func(GLenum) { count(); }
+void APIENTRY blend_func(GLenum, GLenum) { count(); }
+void APIENTRY cull_face(GLenum) { count(); }
+void APIENTRY polygon_mode(GLenum, GLenum) { count(); }
+void APIENTRY clear_color(GLfloat, GLfloat, GLfloat, GLfloat) { count(); }
+void APIENTRY clear(GLbitfield) { count(); }
+
+void APIENTRY viewport(GLint, GLint, GLsizei width, GLsizei height)
+{
+	count();
+	if (width < 0 || height < 0) {
+		fail(GL_INVALID_VALUE, "VIEWPORT");
+	}
+}
+
+// Draws.
+
+void APIENTRY draw_arrays_instanced(GLenum, GLint first, GLsizei vertices, GLsizei instances)
+{
+	count();
+	if (first < 0) {
+		fail(GL_INVALID_VALUE, "DRAW_NEGATIVE_COUNT");
+		return;
+	}
+	if (validate_draw(vertices, instances)) {
+		record_draws(1, static_cast<uint64>(instances));
+	}
+}
+
+void APIENTRY draw_elements_instanced(GLenum, GLsizei indices, GLenum type, const void* offset, GLsizei instances)
+{
+	count();
+	if (validate_draw(indices, instances) && validate_indices(indices, type, offset)) {
+		record_draws(1, static_cast<uint64>(instances));
+	}
+}
+
+void APIENTRY draw_elements_instanced_base_vertex(GLenum mode, GLsizei indices, GLenum type, const void* offset,
+	GLsizei instances, GLint)
+{
+	draw_elements_instanced(mode, indices, type, offset, instances);
+}
+
+void APIENTRY draw_elements_instanced_base_vertex_base_instance(GLenum mode, GLsizei indices, GLenum type,
+	const void* offset, GLsizei instances, GLint, GLuint)
+{
+	draw_elements_instanced(mode, indices, type, offset, instances);
+}
+
+void APIENTRY multi_draw_elements(GLenum, const GLsizei* indices, GLenum type, const void* const* offsets, GLsizei draws)
+{
+	count();
+	for (GLsizei i = 0; i < draws; ++i) {
+		if (!validate_draw(indices[i], 1) || !validate_indices(indices[i], type, offsets[i])) {
+			return;
+		}
+	}
+	record_draws(static_cast<uint64>(draws), static_cast<uint64>(draws));
+}
+
+struct IndirectCommand {
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;
+};
+
+void APIENTRY multi_draw_elements_indirect(GLenum, GLenum type, const void* indirect, GLsizei draws, GLsizei stride)
+{
+	count();
+	stride = stride == 0 ? static_cast<GLsizei>(sizeof(IndirectCommand)) : stride;
+	if (!validate_draw(draws, 0)) {
+		return;
+	}
+	const NullBuffer* commands = bound_buffer(GL_DRAW_INDIRECT_BUFFER, "INDIRECT_WITHOUT_BUFFER");
+	const uint64 offset = reinterpret_cast<uintptr_t>(indirect);
+	if (!commands) {
+		return;
+	}
+	if (draws > 0 && !in_range(commands, offset, static_cast<uint64>(draws - 1) * stride + sizeof(IndirectCommand))) {
+		fail(GL_INVALID_OPERATION, "INDIRECT_OUT_OF_RANGE");
+		return;
+	}
+
+	// The commands are only readable when they were written through a mapping.
+	uint64 instances = 0;
+	for (GLsizei i = 0; i < draws && !commands->storage.empty(); ++i) {
+		IndirectCommand command{};
+		std::memcpy(&command, commands->storage.data() + offset + static_cast<uint64>(i) * stride, sizeof(command));
+		const void* first = reinterpret_cast<const void*>(static_cast<uintptr_t>(command.first_index) * index_size(type));
+		if (!validate_indices(static_cast<GLsizei>(command.count), type, first)) {
+			return;
+		}
+		instances += command.instance_count;
+	}
+	record_draws(static_cast<uint64>(draws), instances);
+}
+
+// Queries and syncs. Everything the GPU would do is already done.
+
+void APIENTRY gen_queries(GLsizei n, GLuint* queries)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		queries[i] = generate();
+		state.queries.insert(queries[i]);
+	}
+}
+
+void APIENTRY delete_queries(GLsizei n, const GLuint* queries)
+{
+	count();
+	for (GLsizei i = 0; i < n; ++i) {
+		state.queries.erase(queries[i]);
+	}
+}
+
+void APIENTRY query_counter(GLuint query, GLenum target)
+{
+	count();
+	if (target != GL_TIMESTAMP || state.queries.find(query) == state.queries.end()) {
+		fail(GL_INVALID_OPERATION, "QUERY_COUNTER");
+	}
+}
+
+void APIENTRY get_query_object_uiv(GLuint query, GLenum, GLuint* value)
+{
+	count();
+	if (state.queries.find(query) == state.queries.end()) {
+		fail(GL_INVALID_OPERATION, "UNKNOWN_QUERY");
+	}
+	*value = GL_TRUE;
+}
+
+void APIENTRY get_query_object_ui64v(GLuint query, GLenum, GLuint64* value)
+{
+	count();
+	if (state.queries.find(query) == state.queries.end()) {
+		fail(GL_INVALID_OPERATION, "UNKNOWN_QUERY");
+	}
+	*value = 0;
+}
+
+GLsync APIENTRY fence_sync(GLenum, GLbitfield)
+{
+	count();
+	return reinterpret_cast<GLsync>(state.next_sync++);
+}
+
+GLenum APIENTRY client_wait_sync(GLsync sync, GLbitfield, GLuint64)
+{
+	count();
+	if (!sync) {
+		fail(GL_INVALID_VALUE, "WAIT_NULL_SYNC");
+		return GL_WAIT_FAILED;
+	}
+	return GL_ALREADY_SIGNALED;
+}
+
+void APIENTRY delete_sync(GLsync)
+{
+	count();
+}
+
+void APIENTRY memory_barrier(GLbitfield barriers)
+{
+	count();
+	null_backend_stats.barriers++;
+	if (barriers == 0) {
+		fail(GL_INVALID_VALUE, "EMPTY_MEMORY_BARRIER");
+	}
+}
+
+struct NullProc {
+	const char* name;
+	void* proc;
+};
+
+// The casts fail to compile if a stub's signature drifts from the entry point it stands in for.
+#define NULL_PROC(name, stub) { "gl" #name, reinterpret_cast<void*>(static_cast<decltype(glad_gl##name)>(&stub)) }
+#define NULL_EXTENSION_PROC(name, stub) { "gl" #name, reinterpret_cast<void*>(static_cast<decltype(GlExtensions::name)>(&stub)) }
+
+const NullProc NULL_PROCS[] = {
+	NULL_PROC(GetString, get_string),
+	NULL_PROC(GetStringi, get_string_i),
+	NULL_PROC(GetIntegerv, get_integer_v),
+	NULL_PROC(GetError, get_error),
+	NULL_PROC(Flush, flush),
+
+	NULL_PROC(GenBuffers, gen_buffers),
+	NULL_PROC(DeleteBuffers, delete_buffers),
+	NULL_PROC(BindBuffer, bind_buffer),
+	NULL_PROC(BindBufferRange, bind_buffer_range),
+	NULL_PROC(BufferData, buffer_data),
+	NULL_PROC(BufferSubData, buffer_sub_data),
+	NULL_PROC(MapBufferRange, map_buffer_range),
+	NULL_PROC(UnmapBuffer, unmap_buffer),
+	NULL_EXTENSION_PROC(BufferStorage, buffer_storage),
+
+	NULL_PROC(GenVertexArrays, gen_vertex_arrays),
+	NULL_PROC(DeleteVertexArrays, delete_vertex_arrays),
+	NULL_PROC(BindVertexArray, bind_vertex_array),
+	NULL_PROC(EnableVertexAttribArray, enable_vertex_attrib_array),
+	NULL_PROC(VertexAttribPointer, vertex_attrib_pointer),
+	NULL_PROC(VertexAttribDivisor, vertex_attrib_divisor),
+
+	NULL_PROC(CreateShader, create_shader),
+	NULL_PROC(DeleteShader, delete_shader),
+	NULL_PROC(ShaderSource, shader_source),
+	NULL_PROC(CompileShader, compile_shader),
+	NULL_PROC(GetShaderiv, get_shader_iv),
+	NULL_PROC(GetShaderInfoLog, get_shader_info_log),
+	NULL_PROC(CreateProgram, create_program),
+	NULL_PROC(DeleteProgram, delete_program),
+	NULL_PROC(AttachShader, attach_shader),
+	NULL_PROC(LinkProgram, link_program),
+	NULL_PROC(GetProgramiv, get_program_iv),
+	NULL_PROC(GetProgramInfoLog, get_program_info_log),
+	NULL_PROC(GetActiveUniform, get_active_uniform),
+	NULL_PROC(GetUniformLocation, get_uniform_location),
+	NULL_PROC(GetUniformBlockIndex, get_uniform_block_index),
+	NULL_PROC(UniformBlockBinding, uniform_block_binding),
+	NULL_PROC(UseProgram, use_program),
+	NULL_PROC(Uniform1i, uniform_1i),
+	NULL_PROC(Uniform1f, uniform_1f),
+	NULL_PROC(Uniform3f, uniform_3f),
+	NULL_PROC(UniformMatrix4fv, uniform_matrix_4fv),
+	NULL_EXTENSION_PROC(GetProgramBinary, get_program_binary),
+	NULL_EXTENSION_PROC(ProgramBinary, program_binary),
+	NULL_EXTENSION_PROC(ProgramParameteri, program_parameter_i),
+
+	NULL_PROC(GenTextures, gen_textures),
+	NULL_PROC(DeleteTextures, delete_textures),
+	NULL_PROC(ActiveTexture, active_texture),
+	NULL_PROC(BindTexture, bind_texture),
+	NULL_PROC(TexParameteri, tex_parameter_i),
+	NULL_PROC(TexImage2D, tex_image_2d),
+	NULL_PROC(CompressedTexImage2D, compressed_tex_image_2d),
+	NULL_PROC(GenerateMipmap, generate_mipmap),
+	NULL_PROC(PixelStorei, pixel_store_i),
+	NULL_PROC(GenFramebuffers, gen_framebuffers),
+	NULL_PROC(DeleteFramebuffers, delete_framebuffers),
+	NULL_PROC(BindFramebuffer, bind_framebuffer),
+	NULL_PROC(FramebufferTexture2D, framebuffer_texture_2d),
+	NULL_PROC(DrawBuffer, draw_buffer),
+	NULL_PROC(DrawBuffers, draw_buffers),
+	NULL_PROC(BlitFramebuffer, blit_framebuffer),
+	NULL_PROC(CheckFramebufferStatus, check_framebuffer_status),
+	NULL_PROC(GenRenderbuffers, gen_renderbuffers),
+	NULL_PROC(DeleteRenderbuffers, delete_renderbuffers),
+	NULL_PROC(BindRenderbuffer, bind_renderbuffer),
+	NULL_PROC(RenderbufferStorage, renderbuffer_storage),
+	NULL_PROC(FramebufferRenderbuffer, framebuffer_renderbuffer),
+	NULL_PROC(ReadPixels, read_pixels),
+
+	NULL_PROC(Enable, enable),
+	NULL_PROC(Disable, disable),
+	NULL_PROC(DepthMask, depth_mask),
+	NULL_PROC(DepthFunc, depth_func),
+	NULL_PROC(BlendFunc, blend_func),
+	NULL_PROC(CullFace, cull_face),
+	NULL_PROC(PolygonMode, polygon_mode),
+	NULL_PROC(ClearColor, clear_color),
+	NULL_PROC(Clear, clear),
+	NULL_PROC(Viewport, viewport),
+
+	NULL_PROC(DrawArraysInstanced, draw_arrays_instanced),
+	NULL_PROC(DrawElementsInstanced, draw_elements_instanced),
+	NULL_PROC(DrawElementsInstancedBaseVertex, draw_elements_instanced_base_vertex),
+	NULL_EXTENSION_PROC(DrawElementsInstancedBaseVertexBaseInstance, draw_elements_instanced_base_vertex_base_instance),
+	NULL_PROC(MultiDrawElements, multi_draw_elements),
+	NULL_EXTENSION_PROC(MultiDrawElementsIndirect, multi_draw_elements_indirect),
+
+	NULL_PROC(GenQueries, gen_queries),
+	NULL_PROC(DeleteQueries, delete_queries),
+	NULL_PROC(QueryCounter, query_counter),
+	NULL_PROC(GetQueryObjectuiv, get_query_object_uiv),
+	NULL_PROC(GetQueryObjectui64v, get_query_object_ui64v),
+	NULL_PROC(FenceSync, fence_sync),
+	NULL_PROC(ClientWaitSync, client_wait_sync),
+	NULL_PROC(DeleteSync, delete_sync),
+	NULL_EXTENSION_PROC(MemoryBarrier, memory_barrier),
+};
+
+#undef NULL_PROC
+#undef NULL_EXTENSION_PROC
+
+} // namespace
+
+void* null_backend_get_proc(const char* name)
+{
+	for (const NullProc& proc : NULL_PROCS) {
+		if (std::strcmp(proc.name, name) == 0) {
+			return proc.proc;
+		}
+	}
+	return nullptr;
+}
+
+void null_backend_reset()
+{
+	state = NullState{};
+}
+
+void null_backend_reset_stats()
+{
+	null_backend_stats = {};
+}
@@ -0,0 +1,62 @@
+#include "offscreen_target.h"
+
+#include <iostream>
+
+bool offscreen_target_create(OffscreenTarget* target, int width, int height)
+{
+	*target = {};
+
+	GLuint renderbuffers[2] = {};
+	glGenRenderbuffers(2, renderbuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLuint framebuffer = 0;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+	const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "ERROR::OFFSCREEN_TARGET::INCOMPLETE 0x" << std::hex << status << std::dec << std::endl;
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(2, renderbuffers);
+		return false;
+	}
+
+	target->framebuffer = framebuffer;
+	target->color = renderbuffers[0];
+	target->depth_stencil = renderbuffers[1];
+	target->width = width;
+	target->height = height;
+	return true;
+}
+
+void offscreen_target_destroy(OffscreenTarget* target)
+{
+	if (target->framebuffer == 0) {
+		return;
+	}
+	glDeleteFramebuffers(1, &target->framebuffer);
+	const GLuint renderbuffers[2] = { target->color, target->depth_stencil };
+	glDeleteRenderbuffers(2, renderbuffers);
+	*target = {};
+}
+
+void offscreen_target_bind(const OffscreenTarget* target)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, target ? target->framebuffer : 0);
+}
+
+void offscreen_target_read_pixels(const OffscreenTarget* target, uint8* pixels)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target->framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, target->width, target->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
@@ -0,0 +1,166 @@
+#include "program_cache.h"
+#include "gl_extensions.h"
+
+#include <engine_hash.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+ProgramCache program_cache{};
+
+namespace {
+
+uint64 hash_string(const char* text, uint64 seed)
+{
+	return text ? hash_bytes(text, std::strlen(text) + 1, seed) : seed;
+}
+
+fs::path entry_path(const ProgramCache* cache, uint64 key)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return fs::path(cache->directory) / name;
+}
+
+} // namespace
+
+void program_cache_init(ProgramCache* cache, const char* directory)
+{
+	cache->enabled = false;
+	if (!directory || directory[0] == '\0' || !gl_extensions.program_binary) {
+		return;
+	}
+
+	std::error_code error;
+	fs::create_directories(directory, error);
+	if (error) {
+		std::cout << "ERROR::PROGRAM_CACHE::CREATE_DIRECTORY_FAILED " << directory << std::endl;
+		return;
+	}
+
+	uint64 driver = HASH_FNV_OFFSET;
+	driver = hash_string(reinterpret_cast<const char*>(glGetString(GL_VENDOR)), driver);
+	driver = hash_string(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), driver);
+	driver = hash_string(reinterpret_cast<const char*>(glGetString(GL_VERSION)), driver);
+
+	cache->directory = directory;
+	cache->driver_hash = driver;
+	cache->enabled = true;
+}
+
+uint64 program_cache_key(const ProgramCache* cache, const char* vertex_code, const char* fragment_code)
+{
+	// The terminators keep "ab" + "c" and "a" + "bc" apart.
+	uint64 key = hash_bytes(&PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION), cache->driver_hash);
+	key = hash_string(vertex_code, key);
+	return hash_string(fragment_code, key);
+}
+
+GLuint program_cache_load(ProgramCache* cache, uint64 key)
+{
+	if (!cache->enabled) {
+		return 0;
+	}
+
+	const fs::path path = entry_path(cache, key);
+	std::ifstream file(path, std::ios::binary);
+	ProgramCacheHeader header{};
+	if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		cache->misses++;
+		return 0;
+	}
+
+	// The size comes from disk; a truncated or corrupt entry must not drive a huge allocation.
+	std::error_code size_error;
+	const uintmax_t file_size = fs::file_size(path, size_error);
+	if (size_error || file_size < sizeof(header) || header.size > file_size - sizeof(header)) {
+		file.close();
+		fs::remove(path, size_error);
+		cache->misses++;
+		return 0;
+	}
+
+	std::vector<char> binary;
+	bool valid = header.magic == PROGRAM_CACHE_MAGIC && header.version == PROGRAM_CACHE_VERSION && header.key == key;
+	if (valid) {
+		binary.resize(header.size);
+		valid = file.read(binary.data(), static_cast<std::streamsize>(binary.size())).good();
+	}
+
+	GLuint program = 0;
+	if (valid) {
+		program = glCreateProgram();
+		gl_extensions.ProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked) {
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	if (program == 0) {
+		// Stale or corrupt; the caller compiles from source and stores a fresh binary.
+		file.close();
+		std::error_code error;
+		fs::remove(path, error);
+		cache->rejected++;
+		return 0;
+	}
+	cache->hits++;
+	return program;
+}
+
+void program_cache_prepare(const ProgramCache* cache, GLuint program)
+{
+	if (cache->enabled) {
+		gl_extensions.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+}
+
+void program_cache_store(ProgramCache* cache, uint64 key, GLuint program)
+{
+	if (!cache->enabled) {
+		return;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	std::vector<char> binary(static_cast<std::size_t>(length));
+	GLenum format = 0;
+	gl_extensions.GetProgramBinary(program, length, &length, &format, binary.data());
+
+	ProgramCacheHeader header{};
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	header.format = format;
+	header.size = static_cast<uint32>(length);
+
+	// Written beside the entry and renamed, so a reader never sees half a binary.
+	const fs::path path = entry_path(cache, key);
+	fs::path temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file || !file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+			|| !file.write(binary.data(), length)) {
+			std::cout << "ERROR::PROGRAM_CACHE::WRITE_FAILED " << temporary.string() << std::endl;
+			return;
+		}
+	}
+	std::error_code error;
+	fs::rename(temporary, path, error);
+	if (error) {
+		fs::remove(temporary, error);
+	}
+}
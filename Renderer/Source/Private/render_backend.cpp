@@ -0,0 +1,23 @@
+#include "render_backend.h"
+#include "gl_extensions.h"
+#include "null_backend.h"
+
+#include <GLFW/glfw3.h>
+
+bool render_backend_load(RenderBackend backend, GLFWwindow* window)
+{
+	GLADloadproc load = reinterpret_cast<GLADloadproc>(glfwGetProcAddress);
+	if (backend == RENDER_BACKEND_NULL) {
+		null_backend_reset();
+		load = null_backend_get_proc;
+	}
+	else {
+		glfwMakeContextCurrent(window);
+	}
+
+	if (!gladLoadGLLoader(load)) {
+		return false;
+	}
+	gl_extensions_load(load);
+	return true;
+}
@@ -0,0 +1,245 @@
+#include "render_commands.h"
+#include "gl_state.h"
+#include "gl_extensions.h"
+
+#include <cstring>
+#include <utility>
+
+namespace {
+
+uint64 quantize_depth(float view_depth)
+{
+	const float clamped = view_depth < 0.0f ? 0.0f : (view_depth > 1.0f ? 1.0f : view_depth);
+	return static_cast<uint64>(clamped * 65535.0f + 0.5f);
+}
+
+uint64 field(uint64 value, uint32 bits, uint32 shift)
+{
+	return (value & ((1ull << bits) - 1)) << shift;
+}
+
+void grow(RenderCommandBuffer* buffer, uint32 capacity)
+{
+	// The old array stays in the arena until the frame ends; recording just moves on to a bigger one.
+	RenderCommand* commands = static_cast<RenderCommand*>(
+		engine_allocate_bytes(buffer->arena, sizeof(RenderCommand) * capacity, alignof(RenderCommand)));
+	if (buffer->count > 0) {
+		std::memcpy(commands, buffer->commands, sizeof(RenderCommand) * buffer->count);
+	}
+	buffer->commands = commands;
+	buffer->capacity = capacity;
+}
+
+RenderPacket* allocate_packet(RenderCommandBuffer* buffer, RenderPacketType type, size_t size, size_t alignment)
+{
+	RenderPacket* packet = static_cast<RenderPacket*>(engine_allocate_bytes(buffer->arena, size, alignment));
+	std::memset(packet, 0, size);
+	packet->type = type;
+	packet->next = nullptr;
+	return packet;
+}
+
+// Least significant byte first; each pass is a stable counting sort, so earlier bytes keep their
+// order. Passes where every key has the same byte are skipped, which for typical keys (one pass, a
+// handful of programs) removes most of them.
+void radix_sort(RenderCommand* commands, RenderCommand* scratch, uint32 count)
+{
+	RenderCommand* source = commands;
+	RenderCommand* destination = scratch;
+
+	for (uint32 shift = 0; shift < 64; shift += 8) {
+		uint32 offsets[256] = {};
+		for (uint32 i = 0; i < count; ++i) {
+			offsets[(source[i].key >> shift) & 0xFF]++;
+		}
+		if (offsets[(source[0].key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		uint32 total = 0;
+		for (uint32& offset : offsets) {
+			const uint32 bucket = offset;
+			offset = total;
+			total += bucket;
+		}
+		for (uint32 i = 0; i < count; ++i) {
+			destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+		std::swap(source, destination);
+	}
+
+	if (source != commands) {
+		std::memcpy(commands, source, sizeof(RenderCommand) * count);
+	}
+}
+
+void apply_state(uint8 flags, RenderCommandStats* stats)
+{
+	bool changed = gl_state_set_capability(GL_STATE_DEPTH_TEST, flags & RENDER_STATE_DEPTH_TEST);
+	changed |= gl_state_depth_mask(flags & RENDER_STATE_DEPTH_WRITE);
+	changed |= gl_state_set_capability(GL_STATE_BLEND, flags & RENDER_STATE_BLEND);
+	changed |= gl_state_set_capability(GL_STATE_CULL_FACE, flags & RENDER_STATE_CULL);
+	if (changed) {
+		stats->state_changes++;
+	}
+}
+
+void execute_draw(const RenderDrawPacket* draw, RenderCommandStats* stats)
+{
+	if (gl_state_use_program(draw->program)) {
+		stats->program_changes++;
+	}
+	if (gl_state_bind_vertex_array(draw->vertex_array)) {
+		stats->vertex_array_changes++;
+	}
+	if (draw->texture != 0 && gl_state_bind_texture(0, GL_TEXTURE_2D, draw->texture)) {
+		stats->texture_changes++;
+	}
+
+	const GLsizei instances = draw->instance_count > 0 ? draw->instance_count : 1;
+	if (draw->index_type == 0) {
+		glDrawArraysInstanced(draw->mode, static_cast<GLint>(draw->first), draw->count, instances);
+	}
+	else {
+		glDrawElementsInstanced(draw->mode, draw->count, draw->index_type,
+			reinterpret_cast<const void*>(static_cast<uintptr_t>(draw->first)), instances);
+	}
+	stats->draws++;
+	stats->instances += static_cast<uint32>(instances);
+}
+
+void execute_multi_draw(const RenderMultiDrawPacket* multi, RenderCommandStats* stats)
+{
+	if (multi->draw_count == 0) {
+		return;
+	}
+	if (gl_state_use_program(multi->program)) {
+		stats->program_changes++;
+	}
+	VertexArray* vertex_array = multi->vertex_array;
+	if (gl_state_bind_vertex_array(vertex_array->vertex_array_object)) {
+		stats->vertex_array_changes++;
+	}
+	vertex_array_bind_instances(vertex_array, multi->instance_buffer, multi->instance_offset);
+
+	if (gl_extensions.multi_draw_indirect) {
+		gl_state_bind_buffer(GL_DRAW_INDIRECT_BUFFER, multi->indirect_buffer);
+		gl_extensions.MultiDrawElementsIndirect(multi->mode, GL_UNSIGNED_INT,
+			reinterpret_cast<const void*>(static_cast<uintptr_t>(multi->indirect_offset)),
+			static_cast<GLsizei>(multi->draw_count), sizeof(DrawElementsIndirectCommand));
+		stats->draws++;
+	}
+
+	for (uint32 i = 0; i < multi->draw_count; ++i) {
+		const DrawElementsIndirectCommand& command = multi->commands[i];
+		stats->instances += command.instance_count;
+		if (gl_extensions.multi_draw_indirect) {
+			continue;
+		}
+
+		const void* indices = reinterpret_cast<const void*>(static_cast<uintptr_t>(command.first_index) * sizeof(uint32));
+		if (gl_extensions.base_instance) {
+			gl_extensions.DrawElementsInstancedBaseVertexBaseInstance(multi->mode, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+				indices, static_cast<GLsizei>(command.instance_count), command.base_vertex, command.base_instance);
+		}
+		else {
+			// GL 3.3 has no base instance; move the instance attributes instead.
+			vertex_array_bind_instances(vertex_array, multi->instance_buffer,
+				multi->instance_offset + static_cast<uint64>(command.base_instance) * vertex_array->instance_stride);
+			glDrawElementsInstancedBaseVertex(multi->mode, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+				indices, static_cast<GLsizei>(command.instance_count), command.base_vertex);
+		}
+		stats->draws++;
+	}
+	stats->indirect_draws += multi->draw_count;
+}
+
+} // namespace
+
+uint64 render_key_opaque(RenderPass pass, uint32 program, uint32 material, uint32 vertex_array, float view_depth)
+{
+	return field(pass, 8, 56) | field(program, 12, 44) | field(material, 16, 28) | field(vertex_array, 12, 16)
+		| field(quantize_depth(view_depth), 16, 0);
+}
+
+uint64 render_key_translucent(RenderPass pass, uint32 program, uint32 material, uint32 vertex_array, float view_depth)
+{
+	return field(pass, 8, 56) | field(~quantize_depth(view_depth), 16, 40) | field(program, 12, 28)
+		| field(material, 16, 12) | field(vertex_array, 12, 0);
+}
+
+void render_commands_begin(RenderCommandBuffer* buffer, Arena* arena, uint32 capacity)
+{
+	RT_ASSERT(arena != nullptr, "Render commands need an arena");
+
+	buffer->arena = arena;
+	buffer->count = 0;
+	buffer->capacity = 0;
+	buffer->commands = nullptr;
+	buffer->stats = {};
+	grow(buffer, capacity > 0 ? capacity : 256);
+}
+
+RenderPacket* render_commands_add_packet(RenderCommandBuffer* buffer, uint64 key, RenderPacketType type, size_t size, size_t alignment)
+{
+	if (buffer->count == buffer->capacity) {
+		grow(buffer, buffer->capacity * 2);
+	}
+	RenderPacket* packet = allocate_packet(buffer, type, size, alignment);
+	buffer->commands[buffer->count++] = { key, packet };
+	return packet;
+}
+
+RenderPacket* render_commands_chain_packet(RenderCommandBuffer* buffer, RenderPacket* previous, RenderPacketType type, size_t size, size_t alignment)
+{
+	RenderPacket* packet = allocate_packet(buffer, type, size, alignment);
+	packet->next = previous->next;
+	previous->next = packet;
+	return packet;
+}
+
+void render_commands_sort(RenderCommandBuffer* buffer)
+{
+	if (buffer->count < 2) {
+		return;
+	}
+	RenderCommand* scratch = static_cast<RenderCommand*>(
+		engine_allocate_bytes(buffer->arena, sizeof(RenderCommand) * buffer->count, alignof(RenderCommand)));
+	radix_sort(buffer->commands, scratch, buffer->count);
+}
+
+void render_commands_submit(RenderCommandBuffer* buffer)
+{
+	RenderCommandStats& stats = buffer->stats;
+	stats.commands = buffer->count;
+
+	for (uint32 i = 0; i < buffer->count; ++i) {
+		for (const RenderPacket* packet = buffer->commands[i].packet; packet; packet = packet->next) {
+			switch (packet->type) {
+			case RENDER_PACKET_DRAW:
+				execute_draw(static_cast<const RenderDrawPacket*>(packet), &stats);
+				break;
+			case RENDER_PACKET_BIND_UNIFORMS: {
+				const RenderBindUniformsPacket* bind = static_cast<const RenderBindUniformsPacket*>(packet);
+				gl_state_bind_uniform_range(bind->binding, bind->buffer, static_cast<GLintptr>(bind->offset),
+					static_cast<GLsizeiptr>(bind->size));
+				break;
+			}
+			case RENDER_PACKET_STATE:
+				apply_state(static_cast<const RenderStatePacket*>(packet)->flags, &stats);
+				break;
+			case RENDER_PACKET_BIND_INSTANCES: {
+				const RenderBindInstancesPacket* bind = static_cast<const RenderBindInstancesPacket*>(packet);
+				if (gl_state_bind_vertex_array(bind->vertex_array->vertex_array_object)) {
+					stats.vertex_array_changes++;
+				}
+				vertex_array_bind_instances(bind->vertex_array, bind->buffer, bind->offset);
+				break;
+			}
+			case RENDER_PACKET_MULTI_DRAW:
+				execute_multi_draw(static_cast<const RenderMultiDrawPacket*>(packet), &stats);
+				break;
+			}
+		}
+	}
+}
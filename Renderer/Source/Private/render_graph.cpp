@@ -0,0 +1,533 @@
+#include "render_graph.h"
+#include "gl_extensions.h"
+#include "gl_state.h"
+
+#include <engine_assert.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+struct TargetFormatInfo {
+	GLenum internal_format;
+	GLenum format;
+	GLenum type;
+	uint32 bytes_per_pixel;
+	bool depth;
+};
+
+TargetFormatInfo format_info(RenderTargetFormat format)
+{
+	switch (format) {
+	case RENDER_TARGET_RGBA8: return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false };
+	case RENDER_TARGET_RGBA16F: return { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, false };
+	case RENDER_TARGET_R32F: return { GL_R32F, GL_RED, GL_FLOAT, 4, false };
+	case RENDER_TARGET_DEPTH24_STENCIL8: return { GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, true };
+	case RENDER_TARGET_DEPTH32F: return { GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4, true };
+	}
+	return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false };
+}
+
+uint64 target_bytes(const RenderTargetDesc& desc)
+{
+	return static_cast<uint64>(desc.width) * static_cast<uint64>(desc.height) * format_info(desc.format).bytes_per_pixel;
+}
+
+bool same_desc(const RenderTargetDesc& a, const RenderTargetDesc& b)
+{
+	return a.width == b.width && a.height == b.height && a.format == b.format;
+}
+
+// What has to be flushed for a pass to see earlier incoherent stores, by how it uses the resource.
+GLbitfield barrier_bit(RenderGraphAccess access)
+{
+	switch (access) {
+	case RENDER_GRAPH_COLOR_ATTACHMENT: return GL_FRAMEBUFFER_BARRIER_BIT;
+	case RENDER_GRAPH_DEPTH_ATTACHMENT: return GL_FRAMEBUFFER_BARRIER_BIT;
+	case RENDER_GRAPH_SAMPLED: return GL_TEXTURE_FETCH_BARRIER_BIT;
+	case RENDER_GRAPH_STORAGE_IMAGE: return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+	case RENDER_GRAPH_STORAGE_BUFFER: return GL_SHADER_STORAGE_BARRIER_BIT;
+	case RENDER_GRAPH_UNIFORM_BUFFER: return GL_UNIFORM_BARRIER_BIT;
+	case RENDER_GRAPH_INDIRECT_BUFFER: return GL_COMMAND_BARRIER_BIT;
+	case RENDER_GRAPH_VERTEX_BUFFER: return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+	}
+	return 0;
+}
+
+bool is_store(RenderGraphAccess access)
+{
+	return access == RENDER_GRAPH_STORAGE_IMAGE || access == RENDER_GRAPH_STORAGE_BUFFER;
+}
+
+uint32 add_resource(RenderGraph* graph, const RenderGraphResource& resource)
+{
+	RT_ASSERT(!graph->compiled, "Render graph resources must be declared before render_graph_compile");
+	graph->resources.push_back(resource);
+	return static_cast<uint32>(graph->resources.size() - 1);
+}
+
+void add_access(RenderGraph* graph, uint32 pass, uint32 resource, RenderGraphAccess access, bool write)
+{
+	RT_ASSERT(!graph->compiled, "Render graph passes must be declared before render_graph_compile");
+	RT_ASSERT(pass < graph->passes.size() && resource < graph->resources.size(), "Unknown render graph pass or resource");
+	RT_ASSERT(graph->resources[resource].kind != RENDER_GRAPH_FRAMEBUFFER || access == RENDER_GRAPH_COLOR_ATTACHMENT,
+		"Imported framebuffers can only be used as colour attachments");
+	graph->accesses.push_back({ pass, resource, access, write });
+}
+
+GLbitfield& pending_barriers(RenderGraph* graph, uint32 resource)
+{
+	RenderGraphResource& r = graph->resources[resource];
+	return r.transient ? graph->pool[r.pooled].pending_barriers : r.pending_barriers;
+}
+
+// glMemoryBarrier is global: the bits it was issued with are settled for every resource.
+void settle_barriers(RenderGraph* graph, GLbitfield barriers)
+{
+	for (RenderGraphResource& resource : graph->resources) {
+		resource.pending_barriers &= ~barriers;
+	}
+	for (RenderGraphPooledTexture& pooled : graph->pool) {
+		pooled.pending_barriers &= ~barriers;
+	}
+}
+
+GLuint create_texture(const RenderTargetDesc& desc)
+{
+	const TargetFormatInfo info = format_info(desc.format);
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	gl_state_bind_texture(0, GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(info.internal_format), desc.width, desc.height, 0, info.format, info.type, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, info.depth ? GL_NEAREST : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, info.depth ? GL_NEAREST : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+// Interval colouring in order of first use: a pooled texture is free for a transient once its last
+// holder's final pass comes before the transient's first.
+uint32 acquire_texture(RenderGraph* graph, const RenderGraphResource& resource)
+{
+	for (uint32 i = 0; i < graph->pool.size(); ++i) {
+		RenderGraphPooledTexture& pooled = graph->pool[i];
+		if (!same_desc(pooled.desc, resource.desc)) {
+			continue;
+		}
+		if (pooled.frame != graph->frame || pooled.busy_until < resource.first_use) {
+			if (pooled.frame != graph->frame) {
+				++graph->stats.textures;
+			}
+			pooled.frame = graph->frame;
+			pooled.busy_until = resource.last_use;
+			return i;
+		}
+	}
+
+	RenderGraphPooledTexture pooled{};
+	pooled.texture = create_texture(resource.desc);
+	pooled.desc = resource.desc;
+	pooled.frame = graph->frame;
+	pooled.busy_until = resource.last_use;
+	graph->pool.push_back(pooled);
+	++graph->stats.textures;
+	return static_cast<uint32>(graph->pool.size() - 1);
+}
+
+void bind_framebuffer(RenderGraph* graph, GLuint framebuffer)
+{
+	if (graph->bound_framebuffer != framebuffer) {
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		graph->bound_framebuffer = framebuffer;
+	}
+}
+
+// Framebuffers are cached by their attachments. Returns RENDER_GRAPH_NONE if GL rejects the set.
+GLuint find_framebuffer(RenderGraph* graph, const GLuint* colors, uint32 color_count, GLuint depth, bool depth_stencil,
+	bool imported)
+{
+	RenderGraphFramebuffer key{};
+	std::copy(colors, colors + color_count, key.colors);
+	key.depth = depth;
+	key.imported = imported;
+	for (RenderGraphFramebuffer& cached : graph->framebuffers) {
+		if (std::equal(key.colors, key.colors + RENDER_GRAPH_MAX_COLOR_ATTACHMENTS, cached.colors) && cached.depth == key.depth) {
+			cached.frame = graph->frame;
+			return cached.framebuffer;
+		}
+	}
+
+	glGenFramebuffers(1, &key.framebuffer);
+	bind_framebuffer(graph, key.framebuffer);
+	GLenum draw_buffers[RENDER_GRAPH_MAX_COLOR_ATTACHMENTS] = {};
+	for (uint32 i = 0; i < color_count; ++i) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colors[i], 0);
+		draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+	if (depth != 0) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, depth_stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+	}
+	if (color_count > 0) {
+		glDrawBuffers(static_cast<GLsizei>(color_count), draw_buffers);
+	}
+	else {
+		glDrawBuffer(GL_NONE);
+	}
+
+	const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "ERROR::RENDER_GRAPH::INCOMPLETE_FRAMEBUFFER 0x" << std::hex << status << std::dec << std::endl;
+		bind_framebuffer(graph, 0);
+		glDeleteFramebuffers(1, &key.framebuffer);
+		return RENDER_GRAPH_NONE;
+	}
+	key.frame = graph->frame;
+	graph->framebuffers.push_back(key);
+	return key.framebuffer;
+}
+
+// Attachments of a surviving pass, in the order they were declared. Returns false if GL rejects them.
+bool resolve_framebuffer(RenderGraph* graph, RenderGraphPass* pass)
+{
+	GLuint colors[RENDER_GRAPH_MAX_COLOR_ATTACHMENTS] = {};
+	uint32 color_count = 0;
+	GLuint depth = 0;
+	bool depth_stencil = false;
+	bool imported_texture = false;
+	uint32 imported = RENDER_GRAPH_NONE;
+	int width = 0;
+	int height = 0;
+
+	for (uint32 a = pass->first_access; a < pass->first_access + pass->access_count; ++a) {
+		const RenderGraphAccessRecord& access = graph->accesses[a];
+		if (access.access != RENDER_GRAPH_COLOR_ATTACHMENT && access.access != RENDER_GRAPH_DEPTH_ATTACHMENT) {
+			continue;
+		}
+		const RenderGraphResource& resource = graph->resources[access.resource];
+		// A target drawn over is declared as both read and written; attach it once.
+		if (imported == access.resource || (depth != 0 && depth == resource.object)
+			|| std::find(colors, colors + color_count, resource.object) != colors + color_count) {
+			continue;
+		}
+
+		width = resource.desc.width;
+		height = resource.desc.height;
+		imported_texture = imported_texture || (resource.kind == RENDER_GRAPH_TEXTURE && !resource.transient);
+		if (resource.kind == RENDER_GRAPH_FRAMEBUFFER) {
+			imported = access.resource;
+		}
+		else if (access.access == RENDER_GRAPH_DEPTH_ATTACHMENT) {
+			RT_ASSERT(depth == 0, "A pass can have one depth attachment");
+			depth = resource.object;
+			depth_stencil = resource.desc.format == RENDER_TARGET_DEPTH24_STENCIL8;
+		}
+		else {
+			RT_ASSERT(color_count < RENDER_GRAPH_MAX_COLOR_ATTACHMENTS, "Too many colour attachments");
+			colors[color_count++] = resource.object;
+		}
+	}
+
+	pass->framebuffer = RENDER_GRAPH_NONE;
+	pass->width = width;
+	pass->height = height;
+	if (imported != RENDER_GRAPH_NONE) {
+		RT_ASSERT(color_count == 0 && depth == 0, "Imported framebuffers cannot be combined with other attachments");
+		pass->framebuffer = graph->resources[imported].object;
+	}
+	else if (color_count > 0 || depth != 0) {
+		pass->framebuffer = find_framebuffer(graph, colors, color_count, depth, depth_stencil, imported_texture);
+		return pass->framebuffer != RENDER_GRAPH_NONE;
+	}
+	return true;
+}
+
+// Deletes pooled textures unused for RENDER_GRAPH_POOL_FRAMES frames, and framebuffers that are
+// unused, use a deleted texture or use an imported one. Runs before placement, which refers to the
+// pool by index.
+void trim_pool(RenderGraph* graph)
+{
+	std::vector<GLuint> deleted;
+	for (uint32 i = 0; i < graph->pool.size();) {
+		if (graph->frame - graph->pool[i].frame > RENDER_GRAPH_POOL_FRAMES) {
+			deleted.push_back(graph->pool[i].texture);
+			gl_state_forget_texture(graph->pool[i].texture);
+			glDeleteTextures(1, &graph->pool[i].texture);
+			graph->pool[i] = graph->pool.back();
+			graph->pool.pop_back();
+			continue;
+		}
+		++i;
+	}
+
+	for (uint32 i = 0; i < graph->framebuffers.size();) {
+		const RenderGraphFramebuffer& cached = graph->framebuffers[i];
+		bool stale = cached.imported || graph->frame - cached.frame > RENDER_GRAPH_POOL_FRAMES;
+		for (GLuint texture : deleted) {
+			stale = stale || cached.depth == texture
+				|| std::find(cached.colors, cached.colors + RENDER_GRAPH_MAX_COLOR_ATTACHMENTS, texture) != cached.colors + RENDER_GRAPH_MAX_COLOR_ATTACHMENTS;
+		}
+		if (stale) {
+			if (graph->bound_framebuffer == cached.framebuffer) {
+				bind_framebuffer(graph, 0);
+			}
+			glDeleteFramebuffers(1, &cached.framebuffer);
+			graph->framebuffers[i] = graph->framebuffers.back();
+			graph->framebuffers.pop_back();
+			continue;
+		}
+		++i;
+	}
+}
+
+} // namespace
+
+void render_graph_begin(RenderGraph* graph)
+{
+	graph->resources.clear();
+	graph->passes.clear();
+	graph->accesses.clear();
+	graph->bound_framebuffer = RENDER_GRAPH_NONE;
+	graph->compiled = false;
+	graph->stats = {};
+	++graph->frame;
+	trim_pool(graph);
+}
+
+uint32 render_graph_create_texture(RenderGraph* graph, const char* name, const RenderTargetDesc& desc)
+{
+	RenderGraphResource resource{};
+	resource.name = name;
+	resource.kind = RENDER_GRAPH_TEXTURE;
+	resource.transient = true;
+	resource.desc = desc;
+	return add_resource(graph, resource);
+}
+
+uint32 render_graph_import_texture(RenderGraph* graph, const char* name, GLuint texture, const RenderTargetDesc& desc)
+{
+	RenderGraphResource resource{};
+	resource.name = name;
+	resource.kind = RENDER_GRAPH_TEXTURE;
+	resource.desc = desc;
+	resource.object = texture;
+	return add_resource(graph, resource);
+}
+
+uint32 render_graph_import_buffer(RenderGraph* graph, const char* name, GLuint buffer)
+{
+	RenderGraphResource resource{};
+	resource.name = name;
+	resource.kind = RENDER_GRAPH_BUFFER;
+	resource.object = buffer;
+	return add_resource(graph, resource);
+}
+
+uint32 render_graph_import_framebuffer(RenderGraph* graph, const char* name, GLuint framebuffer, int width, int height)
+{
+	RenderGraphResource resource{};
+	resource.name = name;
+	resource.kind = RENDER_GRAPH_FRAMEBUFFER;
+	resource.output = true;
+	resource.desc = { width, height, RENDER_TARGET_RGBA8 };
+	resource.object = framebuffer;
+	return add_resource(graph, resource);
+}
+
+void render_graph_set_output(RenderGraph* graph, uint32 resource)
+{
+	RT_ASSERT(resource < graph->resources.size() && !graph->resources[resource].transient, "Only imported resources can be outputs");
+	graph->resources[resource].output = true;
+}
+
+uint32 render_graph_add_pass(RenderGraph* graph, const char* name, RenderGraphExecuteFn execute, void* user_data)
+{
+	RT_ASSERT(!graph->compiled, "Render graph passes must be declared before render_graph_compile");
+	RenderGraphPass pass{};
+	pass.name = name;
+	pass.execute = execute;
+	pass.user_data = user_data;
+	graph->passes.push_back(pass);
+	return static_cast<uint32>(graph->passes.size() - 1);
+}
+
+void render_graph_read(RenderGraph* graph, uint32 pass, uint32 resource, RenderGraphAccess access)
+{
+	add_access(graph, pass, resource, access, false);
+}
+
+void render_graph_write(RenderGraph* graph, uint32 pass, uint32 resource, RenderGraphAccess access)
+{
+	add_access(graph, pass, resource, access, true);
+}
+
+void render_graph_keep_pass(RenderGraph* graph, uint32 pass)
+{
+	graph->passes[pass].side_effects = true;
+}
+
+void render_graph_compile(RenderGraph* graph)
+{
+	RT_ASSERT(!graph->compiled, "Render graph compiled twice in one frame");
+	graph->compiled = true;
+	const uint32 pass_count = static_cast<uint32>(graph->passes.size());
+	const uint32 resource_count = static_cast<uint32>(graph->resources.size());
+
+	std::stable_sort(graph->accesses.begin(), graph->accesses.end(),
+		[](const RenderGraphAccessRecord& a, const RenderGraphAccessRecord& b) { return a.pass < b.pass; });
+	for (uint32 a = 0; a < graph->accesses.size(); ++a) {
+		RenderGraphPass& pass = graph->passes[graph->accesses[a].pass];
+		if (pass.access_count == 0) {
+			pass.first_access = a;
+		}
+		++pass.access_count;
+	}
+
+	// Backwards from the outputs: a pass survives if something later needs what it writes. What it
+	// writes without reading is no longer needed from passes before it; what it reads is.
+	std::vector<uint8> needed(resource_count, 0);
+	for (uint32 r = 0; r < resource_count; ++r) {
+		needed[r] = graph->resources[r].output ? 1 : 0;
+	}
+	for (uint32 p = pass_count; p-- > 0;) {
+		RenderGraphPass& pass = graph->passes[p];
+		const RenderGraphAccessRecord* begin = graph->accesses.data() + pass.first_access;
+		const RenderGraphAccessRecord* end = begin + pass.access_count;
+		bool used = pass.side_effects;
+		for (const RenderGraphAccessRecord* a = begin; a != end; ++a) {
+			used = used || (a->write && needed[a->resource]);
+		}
+		pass.culled = !used;
+		if (!used) {
+			++graph->stats.culled;
+			continue;
+		}
+		for (const RenderGraphAccessRecord* a = begin; a != end; ++a) {
+			if (a->write) {
+				needed[a->resource] = 0;
+			}
+		}
+		for (const RenderGraphAccessRecord* a = begin; a != end; ++a) {
+			if (!a->write) {
+				needed[a->resource] = 1;
+			}
+		}
+	}
+
+	// Lifetimes over the surviving passes, then placement in order of first use.
+	for (RenderGraphResource& resource : graph->resources) {
+		resource.first_use = RENDER_GRAPH_NONE;
+		resource.last_use = 0;
+	}
+	for (const RenderGraphAccessRecord& access : graph->accesses) {
+		if (graph->passes[access.pass].culled) {
+			continue;
+		}
+		RenderGraphResource& resource = graph->resources[access.resource];
+		resource.first_use = std::min(resource.first_use, access.pass);
+		resource.last_use = std::max(resource.last_use, access.pass);
+	}
+	std::vector<uint32> transients;
+	for (uint32 r = 0; r < resource_count; ++r) {
+		if (graph->resources[r].transient && graph->resources[r].first_use != RENDER_GRAPH_NONE) {
+			transients.push_back(r);
+		}
+	}
+	std::stable_sort(transients.begin(), transients.end(),
+		[graph](uint32 a, uint32 b) { return graph->resources[a].first_use < graph->resources[b].first_use; });
+	for (uint32 r : transients) {
+		RenderGraphResource& resource = graph->resources[r];
+		resource.pooled = acquire_texture(graph, resource);
+		resource.object = graph->pool[resource.pooled].texture;
+		++graph->stats.transients;
+		graph->stats.transient_bytes += target_bytes(resource.desc);
+	}
+
+	// A pass that can't run leaves what it writes undefined, so the passes after it that read any of
+	// it are dropped as well.
+	std::vector<uint8> broken(resource_count, 0);
+	for (uint32 p = 0; p < pass_count; ++p) {
+		RenderGraphPass& pass = graph->passes[p];
+		if (pass.culled) {
+			continue;
+		}
+		const RenderGraphAccessRecord* begin = graph->accesses.data() + pass.first_access;
+		const RenderGraphAccessRecord* end = begin + pass.access_count;
+		const bool reads_broken = std::any_of(begin, end,
+			[&broken](const RenderGraphAccessRecord& a) { return !a.write && broken[a.resource]; });
+		if (reads_broken || !resolve_framebuffer(graph, &pass)) {
+			std::cout << "ERROR::RENDER_GRAPH::PASS_DROPPED " << pass.name << std::endl;
+			pass.culled = true;
+			++graph->stats.culled;
+			for (const RenderGraphAccessRecord* a = begin; a != end; ++a) {
+				if (a->write) {
+					broken[a->resource] = 1;
+				}
+			}
+			continue;
+		}
+		++graph->stats.passes;
+		for (const RenderGraphAccessRecord* a = begin; a != end; ++a) {
+			if (a->write) {
+				broken[a->resource] = 0;
+			}
+		}
+
+		// Earlier stores are made visible to the ways this pass uses them, then its own stores are owed.
+		for (const RenderGraphAccessRecord* a = begin; a != end; ++a) {
+			pass.barriers |= pending_barriers(graph, a->resource) & barrier_bit(a->access);
+		}
+		if (pass.barriers != 0) {
+			settle_barriers(graph, pass.barriers);
+			++graph->stats.barriers;
+		}
+		for (const RenderGraphAccessRecord* a = begin; a != end; ++a) {
+			if (a->write && is_store(a->access)) {
+				pending_barriers(graph, a->resource) = GL_ALL_BARRIER_BITS;
+			}
+		}
+	}
+
+	for (const RenderGraphPooledTexture& pooled : graph->pool) {
+		graph->stats.pool_bytes += target_bytes(pooled.desc);
+	}
+}
+
+void render_graph_execute(RenderGraph* graph)
+{
+	RT_ASSERT(graph->compiled, "render_graph_compile must run before render_graph_execute");
+	for (const RenderGraphPass& pass : graph->passes) {
+		if (pass.culled) {
+			continue;
+		}
+		if (pass.barriers != 0 && gl_extensions.memory_barrier) {
+			gl_extensions.MemoryBarrier(pass.barriers);
+		}
+		if (pass.framebuffer != RENDER_GRAPH_NONE) {
+			bind_framebuffer(graph, pass.framebuffer);
+			gl_state_viewport(0, 0, pass.width, pass.height);
+		}
+		pass.execute(graph, pass.user_data);
+	}
+}
+
+GLuint render_graph_object(const RenderGraph* graph, uint32 resource)
+{
+	RT_ASSERT(resource < graph->resources.size(), "Unknown render graph resource");
+	return graph->resources[resource].object;
+}
+
+void render_graph_destroy(RenderGraph* graph)
+{
+	for (const RenderGraphFramebuffer& cached : graph->framebuffers) {
+		glDeleteFramebuffers(1, &cached.framebuffer);
+	}
+	for (const RenderGraphPooledTexture& pooled : graph->pool) {
+		gl_state_forget_texture(pooled.texture);
+		glDeleteTextures(1, &pooled.texture);
+	}
+	graph->framebuffers.clear();
+	graph->pool.clear();
+	graph->bound_framebuffer = RENDER_GRAPH_NONE;
+}
@@ -1,58 +1,313 @@
 #include "render_interface.h"
+#include "gl_extensions.h"
+#include "gl_state.h"
+#include "null_backend.h"
+#include "program_cache.h"
 
+#include <algorithm>
+#include <iterator>
 
-void renderer_init(GLFWwindow* window, RendererInterface* renderer_interface)
+
+namespace {
+
+struct ScenePass {
+	RendererInterface* renderer_interface;
+	// False until the shader has been built; the pass then only clears.
+	bool draw;
+};
+
+struct PresentPass {
+	GpuProfiler* profiler;
+	// The pass that drew the scene; its framebuffer is read from.
+	uint32 source;
+	int width;
+	int height;
+};
+
+// Culls the scene and records its draws into renderer_interface->commands for the scene pass.
+void record_scene(RendererInterface* renderer_interface, Arena* frame_arena, int framebuffer_width, int framebuffer_height)
+{
+	FrameUniforms frame{};
+	frame.time = static_cast<float>(glfwGetTime());
+	frame.light_direction = vec3(0.0f, -1.0f, 0.0f);
+	frame.light_intensity = 1.0f;
+	frame.light_color = vec3(1.0f, 1.0f, 1.0f);
+	uniform_buffer_push(&renderer_interface->frame_stream, UNIFORM_BINDING_FRAME, frame);
+
+	PassUniforms pass{};
+	pass.viewport[2] = static_cast<float>(framebuffer_width);
+	pass.viewport[3] = static_cast<float>(framebuffer_height);
+	pass.inverse_size[0] = framebuffer_width > 0 ? 1.0f / framebuffer_width : 0.0f;
+	pass.inverse_size[1] = framebuffer_height > 0 ? 1.0f / framebuffer_height : 0.0f;
+	pass.near_plane = 0.1f;
+	pass.far_plane = 1000.0f;
+	uniform_buffer_push(&renderer_interface->frame_stream, UNIFORM_BINDING_PASS, pass);
+
+	shader_use(&renderer_interface->shader);
+	shader_set_uniform(&renderer_interface->shader, renderer_interface->some_uniform, 1.0f);
+
+	RenderCommandBuffer* commands = &renderer_interface->commands;
+	render_commands_begin(commands, frame_arena, 256);
+
+	DrawUniforms draw_uniforms{};
+	draw_uniforms.tint = vec3(0.1f, 0.2f, 0.7f);
+	draw_uniforms.alpha = 1.0f;
+	StreamAllocation draw_data{};
+	uniform_buffer_write(&renderer_interface->frame_stream, draw_uniforms, &draw_data);
+
+	// The grid never moves, so after the first frame this finds nothing dirty and returns.
+	transform_update(&renderer_interface->transforms);
+	Scene* scene = &renderer_interface->scene;
+	scene_update(scene);
+	uint32* visible = engine_allocate_array<uint32>(frame_arena, scene->object_count);
+	const uint32 visible_count = scene_cull(scene, frustum::fromMatrix(frame.view_projection), visible, scene->object_count);
+	renderer_interface->visible_objects = visible_count;
+
+	// The visible grid cells as instances of the triangle, in one draw from the geometry pool.
+	constexpr uint32 grid = RENDERER_DEMO_GRID;
+	GeometryBatch batch{};
+	geometry_batch_begin(&batch, frame_arena, 1, visible_count);
+	if (visible_count > 0) {
+		InstanceData* instance = geometry_batch_add(&batch, renderer_interface->triangle, visible_count);
+		for (uint32 i = 0; i < visible_count; ++i, ++instance) {
+			const uint32 x = visible[i] % grid;
+			const uint32 y = visible[i] / grid;
+			instance->model = transform_world(&renderer_interface->transforms, renderer_interface->object_transforms[visible[i]]);
+			instance->color[0] = 0.5f + 0.5f * x / grid;
+			instance->color[1] = 0.5f + 0.5f * y / grid;
+			instance->color[2] = 1.0f;
+			instance->color[3] = 1.0f;
+		}
+	}
+
+	const GLuint program = renderer_interface->shader.ID;
+	const GLuint vertex_array = renderer_interface->geometry.vertex_array.vertex_array_object;
+
+	// The triangle is wound clockwise and the scene target has no depth.
+	RenderStatePacket* state = render_commands_add<RenderStatePacket>(commands,
+		render_key_opaque(RENDER_PASS_OPAQUE, program, 0, vertex_array, 0.0f));
+	state->flags = 0;
+
+	RenderBindUniformsPacket* bind = render_commands_chain<RenderBindUniformsPacket>(commands, state);
+	bind->binding = UNIFORM_BINDING_DRAW;
+	bind->buffer = draw_data.buffer;
+	bind->offset = draw_data.offset;
+	bind->size = sizeof(DrawUniforms);
+
+	RenderMultiDrawPacket* draw = render_commands_chain<RenderMultiDrawPacket>(commands, bind);
+	geometry_batch_write(&batch, &renderer_interface->geometry, &renderer_interface->frame_stream, program, draw);
+
+	render_commands_sort(commands);
+}
+
+void execute_scene_pass(const RenderGraph*, void* user_data)
+{
+	const ScenePass* pass = static_cast<const ScenePass*>(user_data);
+	GpuProfiler* profiler = &pass->renderer_interface->gpu_profiler;
+	gpu_profiler_begin(profiler, "clear");
+	glClear(GL_COLOR_BUFFER_BIT);
+	gpu_profiler_end(profiler);
+	if (!pass->draw) {
+		return;
+	}
+
+	gpu_profiler_begin(profiler, "scene");
+	render_commands_submit(&pass->renderer_interface->commands);
+	gpu_profiler_end(profiler);
+}
+
+// Copies the scene target into the backbuffer, which the graph has bound for drawing.
+void execute_present_pass(const RenderGraph* graph, void* user_data)
+{
+	const PresentPass* pass = static_cast<const PresentPass*>(user_data);
+	gpu_profiler_begin(pass->profiler, "present");
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, graph->passes[pass->source].framebuffer);
+	glBlitFramebuffer(0, 0, pass->width, pass->height, 0, 0, pass->width, pass->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	// The graph binds framebuffers for both; leave reads where it expects them.
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, graph->bound_framebuffer);
+	gpu_profiler_end(pass->profiler);
+}
+
+void execute_nothing(const RenderGraph*, void*)
+{
+}
+
+// Runs a graph with an unused pass, a post processing chain and a compute pass through the null
+// backend, which does no work but counts the barriers, and checks what render_graph_compile made of
+// it. The renderer's own frame is too small to cull, alias or need a barrier.
+void check_render_graph()
+{
+	RenderGraph graph{};
+	render_graph_begin(&graph);
+	const RenderTargetDesc desc{ 64, 64, RENDER_TARGET_RGBA8 };
+	const uint32 backbuffer = render_graph_import_framebuffer(&graph, "backbuffer", 0, 64, 64);
+	const uint32 debug = render_graph_create_texture(&graph, "debug", desc);
+	const uint32 color = render_graph_create_texture(&graph, "color", desc);
+	const uint32 blur_x = render_graph_create_texture(&graph, "blur_x", desc);
+	const uint32 blur_y = render_graph_create_texture(&graph, "blur_y", desc);
+	const uint32 particles = render_graph_create_texture(&graph, "particles", desc);
+
+	const uint32 unused = render_graph_add_pass(&graph, "unused", execute_nothing, nullptr);
+	render_graph_write(&graph, unused, debug, RENDER_GRAPH_COLOR_ATTACHMENT);
+	const uint32 scene = render_graph_add_pass(&graph, "scene", execute_nothing, nullptr);
+	render_graph_write(&graph, scene, color, RENDER_GRAPH_COLOR_ATTACHMENT);
+	const uint32 horizontal = render_graph_add_pass(&graph, "blur_x", execute_nothing, nullptr);
+	render_graph_read(&graph, horizontal, color, RENDER_GRAPH_SAMPLED);
+	render_graph_write(&graph, horizontal, blur_x, RENDER_GRAPH_COLOR_ATTACHMENT);
+	const uint32 vertical = render_graph_add_pass(&graph, "blur_y", execute_nothing, nullptr);
+	render_graph_read(&graph, vertical, blur_x, RENDER_GRAPH_SAMPLED);
+	render_graph_write(&graph, vertical, blur_y, RENDER_GRAPH_COLOR_ATTACHMENT);
+	const uint32 simulate = render_graph_add_pass(&graph, "particles", execute_nothing, nullptr);
+	render_graph_write(&graph, simulate, particles, RENDER_GRAPH_STORAGE_IMAGE);
+	const uint32 composite = render_graph_add_pass(&graph, "composite", execute_nothing, nullptr);
+	render_graph_read(&graph, composite, blur_y, RENDER_GRAPH_SAMPLED);
+	render_graph_read(&graph, composite, particles, RENDER_GRAPH_SAMPLED);
+	render_graph_write(&graph, composite, backbuffer, RENDER_GRAPH_COLOR_ATTACHMENT);
+
+	const uint64 barriers = null_backend_stats.barriers;
+	render_graph_compile(&graph);
+	render_graph_execute(&graph);
+
+	// blur_y reuses color's texture and particles blur_x's; only the particle stores need a barrier.
+	const RenderGraphStats& stats = graph.stats;
+	const bool expected = stats.passes == 5 && stats.culled == 1 && stats.transients == 4 && stats.textures == 2
+		&& stats.barriers == 1 && null_backend_stats.barriers - barriers == 1;
+	if (!expected) {
+		std::cout << "ERROR::RENDERER::RENDER_GRAPH_CHECK passes " << stats.passes << " culled " << stats.culled
+			<< " transients " << stats.transients << " textures " << stats.textures << " barriers " << stats.barriers
+			<< " issued " << null_backend_stats.barriers - barriers << std::endl;
+	}
+	render_graph_destroy(&graph);
+}
+
+} // namespace
+
+void renderer_init(GLFWwindow* window, RendererInterface* renderer_interface,
+	const char* vertex_source, const char* fragment_source, const char* shader_cache, RenderBackend backend)
 {
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-	glfwMakeContextCurrent(window);
-
-	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+	if (!render_backend_load(backend, window)) {
 		throw std::runtime_error("Failed to initialize glad!");
 	}
+	gl_state_invalidate();
+	program_cache_init(&program_cache, shader_cache);
 		
 
 	renderer_interface->shader.vertexPath = "shader.vert";
 	renderer_interface->shader.fragmentPath = "shader.frag"; 
-	auto result = shader_create(&renderer_interface->shader);
-	std::cout << "Shader ID: " << renderer_interface->shader.ID << std::endl;
-
-	create_vertex_array_object(&renderer_interface->vertex_array);
-	create_vertex_buffer(&renderer_interface->vertex_buffer);
-
-	bind_vertex_array(&renderer_interface->vertex_array);
-	bind_vertex_buffer(&renderer_interface->vertex_buffer);
-	
-	add_data_vertex_buffer(&renderer_interface->vertex_buffer, vertices, sizeof(vertices));
+	// Built in the background; frames are cleared but draw nothing until the program is ready.
+	if (vertex_source && fragment_source) {
+		shader_build_submit(&renderer_interface->shader_builds, &renderer_interface->shader, vertex_source, fragment_source);
+	}
+	else {
+		shader_create(&renderer_interface->shader);
+	}
+	renderer_interface->some_uniform = shader_uniform<float>(&renderer_interface->shader, "SomeUniform");
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	stream_buffer_create(&renderer_interface->frame_stream, RENDERER_FRAME_STREAM_SIZE);
+	gpu_profiler_init(&renderer_interface->gpu_profiler);
 
-	GLuint EBO;
-	glGenBuffers(1, &EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	geometry_pool_create(&renderer_interface->geometry, VERTEX_ATTRIBUTES, static_cast<uint32>(std::size(VERTEX_ATTRIBUTES)),
+		sizeof(Vertex), RENDERER_GEOMETRY_VERTICES, RENDERER_GEOMETRY_INDICES);
+	geometry_pool_add(&renderer_interface->geometry, vertices, static_cast<uint32>(std::size(vertices)),
+		indices, static_cast<uint32>(std::size(indices)), &renderer_interface->triangle);
+	TransformHierarchy* transforms = &renderer_interface->transforms;
+	const uint32 grid_root = transform_create(transforms);
+	for (uint32 y = 0; y < RENDERER_DEMO_GRID; ++y) {
+		for (uint32 x = 0; x < RENDERER_DEMO_GRID; ++x) {
+			const vec3 center = renderer_demo_cell_center(x, y);
+			const vec3 extent(RENDERER_DEMO_CELL * 0.4f, RENDERER_DEMO_CELL * 0.4f, 0.0f);
+			const uint32 object = scene_add(&renderer_interface->scene, { center - extent, center + extent });
+			const uint32 cell = transform_create(transforms, grid_root);
+			transform_set_local(transforms, cell, center, quat::identity(),
+				vec3(RENDERER_DEMO_CELL * 0.8f, RENDERER_DEMO_CELL * 0.8f, 1.0f));
+			if (object >= renderer_interface->object_transforms.size()) {
+				renderer_interface->object_transforms.resize(object + 1, TRANSFORM_NONE);
+			}
+			renderer_interface->object_transforms[object] = cell;
+		}
+	}
 
-	glViewport(0, 0, WIDTH, HEIGHT);
+	if (backend == RENDER_BACKEND_NULL) {
+		check_render_graph();
+	}
+	gl_state_viewport(0, 0, WIDTH, HEIGHT);
 	glfwSetFramebufferSizeCallback(window, rend_framebuffer_resize_cb);
 }
 
-void renderer_draw_frame(GLFWwindow* window, RendererInterface* renderer_interface, float deltaTime)
+void renderer_draw_frame(GLFWwindow* window, RendererInterface* renderer_interface, Arena* frame_arena, float deltaTime)
 {
+	GpuProfiler* profiler = &renderer_interface->gpu_profiler;
+	gpu_profiler_begin_frame(profiler);
+	gpu_profiler_begin(profiler, "frame");
+
+	gl_state_reset_stats();
+	null_backend_reset_stats();
 	if (!is_wireframe) {
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		gl_state_clear_color(0.2f, 0.3f, 0.3f, 1.0f);
 	}
 	rend_process_input(window);
-	glClear(GL_COLOR_BUFFER_BIT);
 
+	if (renderer_interface->shader_builds.pending > 0 && shader_build_poll(&renderer_interface->shader_builds) == 0) {
+		std::cout << "Shader ID: " << renderer_interface->shader.ID << std::endl;
+		shader_build_clear(&renderer_interface->shader_builds);
+	}
+
+	int framebuffer_width = renderer_interface->offscreen.width;
+	int framebuffer_height = renderer_interface->offscreen.height;
+	if (renderer_interface->offscreen.framebuffer == 0) {
+		glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+	}
 
-	shader_use(&renderer_interface->shader);
-	shader_set_float(&renderer_interface->shader, "SomeUniform", 1.0f);
-	bind_vertex_array(&renderer_interface->vertex_array);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	ScenePass* scene_pass = engine_allocate<ScenePass>(frame_arena);
+	scene_pass->renderer_interface = renderer_interface;
+	scene_pass->draw = renderer_interface->shader.ID != 0;
+	if (scene_pass->draw) {
+		record_scene(renderer_interface, frame_arena, framebuffer_width, framebuffer_height);
+	}
+
+	// The scene is drawn into a transient target and copied into the backbuffer: the target for
+	// offscreen runs, the window otherwise. A minimised window still gets a 1x1 target.
+	RenderGraph* graph = &renderer_interface->graph;
+	render_graph_begin(graph);
+	const uint32 backbuffer = render_graph_import_framebuffer(graph, "backbuffer", renderer_interface->offscreen.framebuffer,
+		framebuffer_width, framebuffer_height);
+	const RenderTargetDesc scene_desc{ std::max(framebuffer_width, 1), std::max(framebuffer_height, 1), RENDER_TARGET_RGBA8 };
+	const uint32 scene_color = render_graph_create_texture(graph, "scene_color", scene_desc);
+	const uint32 scene = render_graph_add_pass(graph, "scene", execute_scene_pass, scene_pass);
+	render_graph_write(graph, scene, scene_color, RENDER_GRAPH_COLOR_ATTACHMENT);
+
+	PresentPass* present_pass = engine_allocate<PresentPass>(frame_arena);
+	*present_pass = { profiler, scene, framebuffer_width, framebuffer_height };
+	const uint32 present = render_graph_add_pass(graph, "present", execute_present_pass, present_pass);
+	render_graph_read(graph, present, scene_color, RENDER_GRAPH_SAMPLED);
+	render_graph_write(graph, present, backbuffer, RENDER_GRAPH_COLOR_ATTACHMENT);
+	render_graph_compile(graph);
+	render_graph_execute(graph);
+
+	if (scene_pass->draw) {
+		stream_buffer_end_frame(&renderer_interface->frame_stream);
+	}
+	gpu_profiler_end(profiler);
+	gpu_profiler_end_frame(profiler);
+	renderer_interface->gl_calls = gl_state.stats;
+	renderer_interface->null_calls = null_backend_stats;
+}
+
+bool renderer_enable_offscreen(RendererInterface* renderer_interface, int width, int height)
+{
+	offscreen_target_destroy(&renderer_interface->offscreen);
+	if (!offscreen_target_create(&renderer_interface->offscreen, width, height)) {
+		return false;
+	}
+	// Frames reach it through the render graph's backbuffer; bound now for anything drawn before then.
+	offscreen_target_bind(&renderer_interface->offscreen);
+	gl_state_viewport(0, 0, width, height);
+	return true;
 }
 
 void renderer_cleanup()
@@ -66,7 +321,7 @@ void renderer_set_wireframe(bool value)
 
 
 void rend_framebuffer_resize_cb(GLFWwindow* window, int width, int height) {
-	glViewport(0, 0, width, height);
+	gl_state_viewport(0, 0, width, height);
 }
 
 void rend_process_input(GLFWwindow* window) {
@@ -84,7 +339,7 @@ void rend_process_input(GLFWwindow* window) {
 		if (is_wireframe)
 			enable_wireframe();
 		else
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			gl_state_polygon_mode(GL_FILL);
 	}
 
 	q_pressed_last_frame = q_pressed_now;
@@ -112,8 +367,8 @@ void rend_check_compiletime(compileType type, GLuint id)
 }
 
 void enable_wireframe() {
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	gl_state_clear_color(0.0f, 0.0f, 0.0f, 1.0f);
+	gl_state_polygon_mode(GL_LINE);
 }
 
 
@@ -0,0 +1,481 @@
+#include "scene.h"
+
+#include <engine_assert.h>
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SCENE_SSE2 1
+#endif
+
+namespace {
+
+vec3 min3(const vec3& a, const vec3& b)
+{
+	return vec3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+}
+
+vec3 max3(const vec3& a, const vec3& b)
+{
+	return vec3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+}
+
+float axis(const vec3& v, uint32 a)
+{
+	return a == 0 ? v.x : (a == 1 ? v.y : v.z);
+}
+
+SceneAabb empty_aabb()
+{
+	return { vec3(FLT_MAX, FLT_MAX, FLT_MAX), vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+}
+
+void grow(SceneAabb* box, const SceneAabb& other)
+{
+	box->min = min3(box->min, other.min);
+	box->max = max3(box->max, other.max);
+}
+
+// Half the surface area; only ratios matter to SAH.
+float half_area(const vec3& min, const vec3& max)
+{
+	const float x = std::max(max.x - min.x, 0.0f);
+	const float y = std::max(max.y - min.y, 0.0f);
+	const float z = std::max(max.z - min.z, 0.0f);
+	return x * y + y * z + z * x;
+}
+
+struct Bin {
+	SceneAabb bounds;
+	uint32 count;
+};
+
+// Copied out of Scene::bounds so the build partitions one contiguous array instead of gathering
+// boxes by id.
+struct BuildItem {
+	SceneAabb bounds;
+	vec3 centroid;
+	uint32 object;
+};
+
+// Turns the node's object range into a leaf or splits it into two children appended to nodes.
+void split_node(Scene* scene, uint32 index, std::vector<BuildItem>* build_items, std::vector<uint32>* pending)
+{
+	SceneNode& node = scene->nodes[index];
+	BuildItem* items = build_items->data() + node.first;
+	const uint32 count = node.count;
+
+	SceneAabb bounds = empty_aabb();
+	SceneAabb centroid_bounds = empty_aabb();
+	for (uint32 i = 0; i < count; ++i) {
+		grow(&bounds, items[i].bounds);
+		grow(&centroid_bounds, { items[i].centroid, items[i].centroid });
+	}
+	node.min = bounds.min;
+	node.max = bounds.max;
+	if (count == 1) {
+		return;
+	}
+
+	float best_cost = FLT_MAX;
+	uint32 best_axis = 0;
+	uint32 best_split = 0;
+	uint32 best_bins = SCENE_SAH_BINS;
+	for (uint32 a = 0; a < 3; ++a) {
+		const float low = axis(centroid_bounds.min, a);
+		const float extent = axis(centroid_bounds.max, a) - low;
+		if (extent <= 0.0f) {
+			continue;
+		}
+
+		// Small nodes get fewer bins; most of the tree is small nodes.
+		const uint32 bin_count = std::min(SCENE_SAH_BINS, count);
+		Bin bins[SCENE_SAH_BINS];
+		for (uint32 b = 0; b < bin_count; ++b) {
+			bins[b] = { empty_aabb(), 0 };
+		}
+		const float scale = bin_count / extent;
+		for (uint32 i = 0; i < count; ++i) {
+			const uint32 b = std::min(bin_count - 1, static_cast<uint32>((axis(items[i].centroid, a) - low) * scale));
+			grow(&bins[b].bounds, items[i].bounds);
+			bins[b].count++;
+		}
+
+		// Sweep from the right to get the cost of every right side, then from the left.
+		float right_area[SCENE_SAH_BINS];
+		uint32 right_count[SCENE_SAH_BINS];
+		SceneAabb right = empty_aabb();
+		uint32 right_total = 0;
+		for (uint32 b = bin_count - 1; b > 0; --b) {
+			grow(&right, bins[b].bounds);
+			right_total += bins[b].count;
+			right_area[b] = half_area(right.min, right.max);
+			right_count[b] = right_total;
+		}
+		SceneAabb left = empty_aabb();
+		uint32 left_total = 0;
+		for (uint32 b = 0; b < bin_count - 1; ++b) {
+			grow(&left, bins[b].bounds);
+			left_total += bins[b].count;
+			if (left_total == 0 || right_count[b + 1] == 0) {
+				continue;
+			}
+			const float cost = half_area(left.min, left.max) * left_total + right_area[b + 1] * right_count[b + 1];
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_axis = a;
+				best_split = b;
+				best_bins = bin_count;
+			}
+		}
+	}
+
+	const float area = half_area(bounds.min, bounds.max);
+	if (count <= SCENE_MAX_LEAF_SIZE && best_cost + SCENE_TRAVERSAL_COST * area >= area * count) {
+		return;
+	}
+
+	uint32 middle = 0;
+	if (best_cost < FLT_MAX) {
+		const float low = axis(centroid_bounds.min, best_axis);
+		const float scale = best_bins / (axis(centroid_bounds.max, best_axis) - low);
+		middle = static_cast<uint32>(std::partition(items, items + count, [&](const BuildItem& item) {
+			const uint32 b = std::min(best_bins - 1, static_cast<uint32>((axis(item.centroid, best_axis) - low) * scale));
+			return b <= best_split;
+		}) - items);
+	}
+	if (middle == 0 || middle == count) {
+		// Every centroid in the same place; any split is as good as another.
+		middle = count / 2;
+	}
+
+	const uint32 left = static_cast<uint32>(scene->nodes.size());
+	const uint32 first = node.first;
+	node.first = left;
+	node.count = 0;
+	// Capacity was reserved for the whole tree, so node stays valid.
+	scene->nodes.push_back({ vec3(), first, vec3(), middle });
+	scene->nodes.push_back({ vec3(), first + middle, vec3(), count - middle });
+	pending->push_back(left);
+	pending->push_back(left + 1);
+}
+
+// Recomputes every box bottom-up; children always come after their parent. Returns the SAH cost.
+float refit(Scene* scene)
+{
+	float cost = 0.0f;
+	for (size_t i = scene->nodes.size(); i-- > 0;) {
+		SceneNode& node = scene->nodes[i];
+		SceneAabb box = empty_aabb();
+		if (node.count > 0) {
+			for (uint32 j = 0; j < node.count; ++j) {
+				grow(&box, scene->bounds[scene->objects[node.first + j]]);
+			}
+		}
+		else {
+			const SceneNode& left = scene->nodes[node.first];
+			const SceneNode& right = scene->nodes[node.first + 1];
+			box = { min3(left.min, right.min), max3(left.max, right.max) };
+		}
+		node.min = box.min;
+		node.max = box.max;
+		cost += half_area(box.min, box.max) * (node.count > 0 ? node.count : SCENE_TRAVERSAL_COST);
+	}
+	const float root_area = half_area(scene->nodes[0].min, scene->nodes[0].max);
+	return root_area > 0.0f ? cost / root_area : 0.0f;
+}
+
+enum CullResult : uint8 {
+	CULL_OUTSIDE,
+	CULL_INTERSECTS,
+	CULL_INSIDE
+};
+
+// The six planes in structure-of-arrays form, padded to eight with planes everything is inside of.
+struct CullPlanes {
+#if SCENE_SSE2
+	__m128 nx[2];
+	__m128 ny[2];
+	__m128 nz[2];
+	__m128 d[2];
+#else
+	float nx[8];
+	float ny[8];
+	float nz[8];
+	float d[8];
+#endif
+};
+
+CullPlanes make_cull_planes(const frustum& view_frustum)
+{
+	alignas(16) float nx[8] = {};
+	alignas(16) float ny[8] = {};
+	alignas(16) float nz[8] = {};
+	alignas(16) float d[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+		nx[i] = view_frustum.planes[i].normal.x;
+		ny[i] = view_frustum.planes[i].normal.y;
+		nz[i] = view_frustum.planes[i].normal.z;
+		d[i] = view_frustum.planes[i].d;
+	}
+
+	CullPlanes planes{};
+#if SCENE_SSE2
+	for (int g = 0; g < 2; ++g) {
+		planes.nx[g] = _mm_load_ps(nx + g * 4);
+		planes.ny[g] = _mm_load_ps(ny + g * 4);
+		planes.nz[g] = _mm_load_ps(nz + g * 4);
+		planes.d[g] = _mm_load_ps(d + g * 4);
+	}
+#else
+	std::copy(nx, nx + 8, planes.nx);
+	std::copy(ny, ny + 8, planes.ny);
+	std::copy(nz, nz + 8, planes.nz);
+	std::copy(d, d + 8, planes.d);
+#endif
+	return planes;
+}
+
+// For each plane, the box corner furthest along the normal decides whether it is outside and the
+// nearest corner whether it is completely inside. max(n * min, n * max) picks the right coordinate
+// without branching on the sign of n.
+CullResult classify(const CullPlanes& planes, const vec3& min, const vec3& max)
+{
+#if SCENE_SSE2
+	const __m128 min_x = _mm_set1_ps(min.x);
+	const __m128 min_y = _mm_set1_ps(min.y);
+	const __m128 min_z = _mm_set1_ps(min.z);
+	const __m128 max_x = _mm_set1_ps(max.x);
+	const __m128 max_y = _mm_set1_ps(max.y);
+	const __m128 max_z = _mm_set1_ps(max.z);
+	const __m128 zero = _mm_setzero_ps();
+
+	int outside = 0;
+	int inside = 0;
+	for (int g = 0; g < 2; ++g) {
+		const __m128 x0 = _mm_mul_ps(planes.nx[g], min_x);
+		const __m128 x1 = _mm_mul_ps(planes.nx[g], max_x);
+		const __m128 y0 = _mm_mul_ps(planes.ny[g], min_y);
+		const __m128 y1 = _mm_mul_ps(planes.ny[g], max_y);
+		const __m128 z0 = _mm_mul_ps(planes.nz[g], min_z);
+		const __m128 z1 = _mm_mul_ps(planes.nz[g], max_z);
+		const __m128 far = _mm_add_ps(_mm_add_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+			_mm_add_ps(_mm_max_ps(z0, z1), planes.d[g]));
+		const __m128 near = _mm_add_ps(_mm_add_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+			_mm_add_ps(_mm_min_ps(z0, z1), planes.d[g]));
+		outside |= _mm_movemask_ps(_mm_cmplt_ps(far, zero));
+		inside |= _mm_movemask_ps(_mm_cmpge_ps(near, zero)) << (g * 4);
+	}
+	if (outside != 0) {
+		return CULL_OUTSIDE;
+	}
+	return inside == 0xFF ? CULL_INSIDE : CULL_INTERSECTS;
+#else
+	bool intersects = false;
+	for (int i = 0; i < 8; ++i) {
+		const float x0 = planes.nx[i] * min.x;
+		const float x1 = planes.nx[i] * max.x;
+		const float y0 = planes.ny[i] * min.y;
+		const float y1 = planes.ny[i] * max.y;
+		const float z0 = planes.nz[i] * min.z;
+		const float z1 = planes.nz[i] * max.z;
+		if (std::max(x0, x1) + std::max(y0, y1) + std::max(z0, z1) + planes.d[i] < 0.0f) {
+			return CULL_OUTSIDE;
+		}
+		intersects |= std::min(x0, x1) + std::min(y0, y1) + std::min(z0, z1) + planes.d[i] < 0.0f;
+	}
+	return intersects ? CULL_INTERSECTS : CULL_INSIDE;
+#endif
+}
+
+bool overlaps(const SceneAabb& a, const vec3& min, const vec3& max)
+{
+	return a.min.x <= max.x && a.max.x >= min.x && a.min.y <= max.y && a.max.y >= min.y && a.min.z <= max.z && a.max.z >= min.z;
+}
+
+void emit(uint32 object, uint32* results, uint32 capacity, uint32* count)
+{
+	if (*count < capacity) {
+		results[*count] = object;
+	}
+	(*count)++;
+}
+
+} // namespace
+
+uint32 scene_add(Scene* scene, const SceneAabb& bounds)
+{
+	uint32 object = 0;
+	if (!scene->free_ids.empty()) {
+		object = scene->free_ids.back();
+		scene->free_ids.pop_back();
+		scene->bounds[object] = bounds;
+		scene->alive[object] = 1;
+	}
+	else {
+		object = static_cast<uint32>(scene->bounds.size());
+		scene->bounds.push_back(bounds);
+		scene->alive.push_back(1);
+	}
+	scene->object_count++;
+	scene->structure_changed = true;
+	return object;
+}
+
+void scene_remove(Scene* scene, uint32 object)
+{
+	RT_ASSERT(object < scene->alive.size() && scene->alive[object], "Removing an object that is not in the scene");
+	scene->alive[object] = 0;
+	scene->free_ids.push_back(object);
+	scene->object_count--;
+	scene->structure_changed = true;
+}
+
+void scene_set_bounds(Scene* scene, uint32 object, const SceneAabb& bounds)
+{
+	RT_ASSERT(object < scene->alive.size() && scene->alive[object], "Moving an object that is not in the scene");
+	scene->bounds[object] = bounds;
+	scene->bounds_changed = true;
+}
+
+void scene_update(Scene* scene)
+{
+	if (scene->structure_changed) {
+		scene_build(scene);
+		return;
+	}
+	if (!scene->bounds_changed || scene->nodes.empty()) {
+		return;
+	}
+
+	scene->stats.cost = refit(scene);
+	scene->stats.refits++;
+	scene->bounds_changed = false;
+	if (scene->stats.cost > scene->stats.built_cost * SCENE_REBUILD_COST_RATIO) {
+		scene_build(scene);
+	}
+}
+
+void scene_build(Scene* scene)
+{
+	scene->objects.clear();
+	for (uint32 object = 0; object < scene->alive.size(); ++object) {
+		if (scene->alive[object]) {
+			scene->objects.push_back(object);
+		}
+	}
+	scene->nodes.clear();
+	scene->structure_changed = false;
+	scene->bounds_changed = false;
+	scene->stats.builds++;
+
+	const uint32 count = static_cast<uint32>(scene->objects.size());
+	if (count == 0) {
+		scene->stats.cost = 0.0f;
+		scene->stats.built_cost = 0.0f;
+		return;
+	}
+
+	std::vector<BuildItem> items(count);
+	for (uint32 i = 0; i < count; ++i) {
+		const SceneAabb& bounds = scene->bounds[scene->objects[i]];
+		items[i] = { bounds, (bounds.min + bounds.max) * 0.5f, scene->objects[i] };
+	}
+
+	// A binary tree over n leaves-worth of objects never needs more than 2n - 1 nodes.
+	scene->nodes.reserve(static_cast<size_t>(count) * 2);
+	scene->nodes.push_back({ vec3(), 0, vec3(), count });
+	std::vector<uint32> pending{ 0 };
+	while (!pending.empty()) {
+		const uint32 index = pending.back();
+		pending.pop_back();
+		split_node(scene, index, &items, &pending);
+	}
+	for (uint32 i = 0; i < count; ++i) {
+		scene->objects[i] = items[i].object;
+	}
+
+	scene->stats.cost = refit(scene);
+	scene->stats.built_cost = scene->stats.cost;
+}
+
+uint32 scene_cull(const Scene* scene, const frustum& view_frustum, uint32* visible, uint32 capacity)
+{
+	if (scene->nodes.empty()) {
+		return 0;
+	}
+
+	const CullPlanes planes = make_cull_planes(view_frustum);
+	struct Entry {
+		uint32 node;
+		// Known to be completely inside, so nothing below it needs testing.
+		bool inside;
+	};
+	std::vector<Entry> stack;
+	stack.reserve(64);
+	stack.push_back({ 0, false });
+
+	uint32 count = 0;
+	while (!stack.empty()) {
+		const Entry entry = stack.back();
+		stack.pop_back();
+		const SceneNode& node = scene->nodes[entry.node];
+
+		bool inside = entry.inside;
+		if (!inside) {
+			const CullResult result = classify(planes, node.min, node.max);
+			if (result == CULL_OUTSIDE) {
+				continue;
+			}
+			inside = result == CULL_INSIDE;
+		}
+
+		if (node.count == 0) {
+			stack.push_back({ node.first + 1, inside });
+			stack.push_back({ node.first, inside });
+			continue;
+		}
+		for (uint32 i = 0; i < node.count; ++i) {
+			const uint32 object = scene->objects[node.first + i];
+			const SceneAabb& bounds = scene->bounds[object];
+			if (inside || classify(planes, bounds.min, bounds.max) != CULL_OUTSIDE) {
+				emit(object, visible, capacity, &count);
+			}
+		}
+	}
+	return count;
+}
+
+uint32 scene_query_aabb(const Scene* scene, const SceneAabb& box, uint32* results, uint32 capacity)
+{
+	if (scene->nodes.empty()) {
+		return 0;
+	}
+
+	std::vector<uint32> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	uint32 count = 0;
+	while (!stack.empty()) {
+		const SceneNode& node = scene->nodes[stack.back()];
+		stack.pop_back();
+		if (!overlaps(box, node.min, node.max)) {
+			continue;
+		}
+		if (node.count == 0) {
+			stack.push_back(node.first + 1);
+			stack.push_back(node.first);
+			continue;
+		}
+		for (uint32 i = 0; i < node.count; ++i) {
+			const uint32 object = scene->objects[node.first + i];
+			const SceneAabb& bounds = scene->bounds[object];
+			if (overlaps(box, bounds.min, bounds.max)) {
+				emit(object, results, capacity, &count);
+			}
+		}
+	}
+	return count;
+}
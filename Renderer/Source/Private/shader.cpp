@@ -1,11 +1,79 @@
 #include "shader.h"
-#include <filesystem>
+#include "gl_state.h"
+#include "shader_build.h"
+
+#include <engine_hash.h>
+
+#include <cstring>
+
+namespace {
+
+uint64 uniform_hash(const char* name, std::size_t length)
+{
+    // 0 is reserved for empty slots.
+    const uint64 hash = hash_bytes(name, length);
+    return hash != 0 ? hash : 1;
+}
+
+// Linear probing. Returns the slot holding hash, or the empty slot where it would go, or
+// SHADER_UNIFORM_INVALID when the table is full.
+uint16 find_slot(const shader* shader, uint64 hash)
+{
+    uint32 slot = static_cast<uint32>(hash) & (SHADER_MAX_UNIFORMS - 1);
+    for (uint32 probe = 0; probe < SHADER_MAX_UNIFORMS; ++probe) {
+        const ShaderUniform& uniform = shader->uniforms[slot];
+        if (uniform.name_hash == hash || uniform.name_hash == 0) {
+            return static_cast<uint16>(slot);
+        }
+        slot = (slot + 1) & (SHADER_MAX_UNIFORMS - 1);
+    }
+    return SHADER_UNIFORM_INVALID;
+}
+
+bool is_sampler(GLenum type)
+{
+    switch (type) {
+    case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_CUBE_SHADOW: case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D:
+        return true;
+    default:
+        return false;
+    }
+}
+
+template<typename T> constexpr GLenum uniform_type();
+template<> constexpr GLenum uniform_type<bool>() { return GL_BOOL; }
+template<> constexpr GLenum uniform_type<int>() { return GL_INT; }
+template<> constexpr GLenum uniform_type<float>() { return GL_FLOAT; }
+template<> constexpr GLenum uniform_type<vec3>() { return GL_FLOAT_VEC3; }
+template<> constexpr GLenum uniform_type<mat4>() { return GL_FLOAT_MAT4; }
+
+bool type_matches(GLenum expected, GLenum declared)
+{
+    return declared == expected || (expected == GL_INT && is_sampler(declared));
+}
+
+// Returns the uniform to write when value differs from the last one sent, nullptr otherwise.
+ShaderUniform* changed_uniform(shader* shader, uint16 slot, const void* value, std::size_t size)
+{
+    if (slot == SHADER_UNIFORM_INVALID) {
+        return nullptr;
+    }
+    ShaderUniform& uniform = shader->uniforms[slot];
+    if (uniform.location < 0 || (uniform.cached && std::memcmp(uniform.value, value, size) == 0)) {
+        return nullptr;
+    }
+    std::memcpy(uniform.value, value, size);
+    uniform.cached = true;
+    return &uniform;
+}
+
+} // namespace
 
 bool shader_create(shader* shader)
 {
-    std::cerr << "WORKING DIR: "
-          << std::filesystem::current_path() << std::endl;
-    
 	std::string	vertex_code;
 	std::string fragment_code;
 	std::ifstream v_shader_file;
@@ -15,8 +83,8 @@ bool shader_create(shader* shader)
 	f_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 
 	try {
-        v_shader_file.open("shader.vert");
-        f_shader_file.open("shader.frag");
+        v_shader_file.open(shader->vertexPath);
+        f_shader_file.open(shader->fragmentPath);
         std::stringstream v_shader_stream, f_shader_stream;
         // read file's buffer contents into streams
         v_shader_stream << v_shader_file.rdbuf();
@@ -35,79 +103,142 @@ bool shader_create(shader* shader)
         return false; 
     }
 
-    const char* v_shader_code = vertex_code.c_str();
-    const char* f_shader_code = fragment_code.c_str();
+    return shader_create_from_source(shader, vertex_code.c_str(), fragment_code.c_str());
+}
 
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
+bool shader_create_from_source(shader* shader, const char* v_shader_code, const char* f_shader_code)
+{
+    ShaderBuildBatch batch{};
+    shader_build_submit(&batch, shader, v_shader_code, f_shader_code);
+    return shader_build_wait(&batch);
+}
 
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &v_shader_code, nullptr);
-    glCompileShader(vertex);
+void shader_use(shader* shader)
+{
+    gl_state_use_program(shader->ID);
+}
 
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertex, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
+void shader_reflect_uniforms(shader* shader)
+{
+    // Keep every slot, so existing handles survive; forget locations and cached values.
+    for (ShaderUniform& uniform : shader->uniforms) {
+        uniform.location = -1;
+        uniform.cached = false;
+    }
 
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &f_shader_code, nullptr);
-    glCompileShader(fragment);
+    GLint count = 0;
+    glGetProgramiv(shader->ID, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        char name[128];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(shader->ID, static_cast<GLuint>(i), sizeof(name), &length, &size, &type, name);
+
+        // Members of uniform blocks have no location and are set through their buffer.
+        const GLint location = glGetUniformLocation(shader->ID, name);
+        if (location < 0) {
+            continue;
+        }
+        // Arrays are reported as "name[0]"; handles name the array itself.
+        if (length > 3 && std::strcmp(name + length - 3, "[0]") == 0) {
+            length -= 3;
+        }
+
+        const uint64 hash = uniform_hash(name, static_cast<std::size_t>(length));
+        const uint16 slot = find_slot(shader, hash);
+        if (slot == SHADER_UNIFORM_INVALID) {
+            std::cout << "ERROR::SHADER::TOO_MANY_UNIFORMS " << name << std::endl;
+            continue;
+        }
+        ShaderUniform& uniform = shader->uniforms[slot];
+        uniform.name_hash = hash;
+        uniform.location = location;
+        uniform.type = type;
+    }
+}
 
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
-
-    shader->ID = glCreateProgram();
-    glAttachShader(shader->ID, vertex);
-    glAttachShader(shader->ID, fragment);
-    glLinkProgram(shader->ID);
-    // print linking errors if any
-    glGetProgramiv(shader->ID, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(shader->ID, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        return false;
+template<typename T>
+ShaderUniformHandle<T> shader_uniform(shader* shader, const char* name)
+{
+    if (!shader) {
+        throw std::runtime_error("ERROR::PASSED_NULLPTR");
     }
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    return true;
+    const uint64 hash = uniform_hash(name, std::strlen(name));
+    const uint16 slot = find_slot(shader, hash);
+    if (slot == SHADER_UNIFORM_INVALID) {
+        std::cout << "ERROR::SHADER::TOO_MANY_UNIFORMS " << name << std::endl;
+        return {};
+    }
+
+    ShaderUniform& uniform = shader->uniforms[slot];
+    if (uniform.name_hash == 0) {
+        uniform = {};
+        uniform.name_hash = hash;
+        uniform.location = -1;
+        uniform.type = uniform_type<T>();
+    }
+    else if (!type_matches(uniform_type<T>(), uniform.type)) {
+        std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH " << name << std::endl;
+        return {};
+    }
+    return { slot };
 }
 
-void shader_use(shader* shader)
+template ShaderUniformHandle<bool> shader_uniform<bool>(shader*, const char*);
+template ShaderUniformHandle<int> shader_uniform<int>(shader*, const char*);
+template ShaderUniformHandle<float> shader_uniform<float>(shader*, const char*);
+template ShaderUniformHandle<vec3> shader_uniform<vec3>(shader*, const char*);
+template ShaderUniformHandle<mat4> shader_uniform<mat4>(shader*, const char*);
+
+void shader_set_uniform(shader* shader, ShaderUniformHandle<bool> handle, bool value)
 {
-    glUseProgram(shader->ID);
+    const int as_int = value ? 1 : 0;
+    if (ShaderUniform* uniform = changed_uniform(shader, handle.slot, &as_int, sizeof(as_int))) {
+        glUniform1i(uniform->location, as_int);
+    }
 }
 
-void shader_set_bool(shader* shader, const std::string& name, bool value)
+void shader_set_uniform(shader* shader, ShaderUniformHandle<int> handle, int value)
 {
-    if (!shader) {
-        throw std::runtime_error("ERROR::PASSED_NULLPTR");
+    if (ShaderUniform* uniform = changed_uniform(shader, handle.slot, &value, sizeof(value))) {
+        glUniform1i(uniform->location, value);
     }
-    glUniform1i(glGetUniformLocation(shader->ID, name.c_str()), (int)value);
 }
 
-void shader_set_int(shader* shader, const std::string& name, int value)
+void shader_set_uniform(shader* shader, ShaderUniformHandle<float> handle, float value)
 {
-    if (!shader) {
-        throw std::runtime_error("ERROR::PASSED_NULLPTR");
+    if (ShaderUniform* uniform = changed_uniform(shader, handle.slot, &value, sizeof(value))) {
+        glUniform1f(uniform->location, value);
     }
-    glUniform1i(glGetUniformLocation(shader->ID, name.c_str()), value);
 }
 
-void shader_set_float(shader* shader, const std::string& name, float value)
+void shader_set_uniform(shader* shader, ShaderUniformHandle<vec3> handle, const vec3& value)
 {
-    if (!shader) {
-        throw std::runtime_error("ERROR::PASSED_NULLPTR");
+    if (ShaderUniform* uniform = changed_uniform(shader, handle.slot, &value, sizeof(value))) {
+        glUniform3f(uniform->location, value.x, value.y, value.z);
+    }
+}
+
+void shader_set_uniform(shader* shader, ShaderUniformHandle<mat4> handle, const mat4& value)
+{
+    if (ShaderUniform* uniform = changed_uniform(shader, handle.slot, value.m, sizeof(value.m))) {
+        glUniformMatrix4fv(uniform->location, 1, GL_FALSE, value.m);
     }
-    glUniform1f(glGetUniformLocation(shader->ID, name.c_str()), value);
+}
+
+void shader_set_bool(shader* shader, const char* name, bool value)
+{
+    shader_set_uniform(shader, shader_uniform<bool>(shader, name), value);
+}
 
+void shader_set_int(shader* shader, const char* name, int value)
+{
+    shader_set_uniform(shader, shader_uniform<int>(shader, name), value);
+}
+
+void shader_set_float(shader* shader, const char* name, float value)
+{
+    shader_set_uniform(shader, shader_uniform<float>(shader, name), value);
 }
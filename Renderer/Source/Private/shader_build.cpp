@@ -0,0 +1,127 @@
+#include "shader_build.h"
+#include "shader.h"
+#include "gl_extensions.h"
+#include "program_cache.h"
+#include "uniform_buffer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+GLuint compile_stage(GLenum type, const char* code)
+{
+	const GLuint stage = glCreateShader(type);
+	glShaderSource(stage, 1, &code, nullptr);
+	glCompileShader(stage);
+	return stage;
+}
+
+void print_stage_log(GLuint stage, const char* error)
+{
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(stage, GL_COMPILE_STATUS, &compiled);
+	if (!compiled) {
+		char info_log[512];
+		glGetShaderInfoLog(stage, sizeof(info_log), nullptr, info_log);
+		std::cout << error << "\n" << info_log << std::endl;
+	}
+}
+
+bool is_complete(const ShaderBuild& build)
+{
+	if (!gl_extensions.parallel_shader_compile) {
+		return true;
+	}
+	GLint complete = GL_FALSE;
+	glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+void finish(ShaderBuildBatch* batch, ShaderBuild* build)
+{
+	GLint linked = GL_FALSE;
+	glGetProgramiv(build->program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		// A failed compile also fails the link; report whichever stage went wrong first.
+		print_stage_log(build->vertex, "ERROR::SHADER::VERTEX::COMPILATION_FAILED");
+		print_stage_log(build->fragment, "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED");
+		char info_log[512];
+		glGetProgramInfoLog(build->program, sizeof(info_log), nullptr, info_log);
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << info_log << std::endl;
+		glDeleteProgram(build->program);
+	}
+	else {
+		program_cache_store(&program_cache, build->cache_key, build->program);
+		build->target->ID = build->program;
+		uniform_buffer_bind_blocks(build->program);
+		shader_reflect_uniforms(build->target);
+	}
+
+	glDeleteShader(build->vertex);
+	glDeleteShader(build->fragment);
+	build->vertex = 0;
+	build->fragment = 0;
+	build->status = linked ? SHADER_BUILD_DONE : SHADER_BUILD_FAILED;
+	batch->pending--;
+	batch->failed += linked ? 0 : 1;
+}
+
+} // namespace
+
+void shader_build_submit(ShaderBuildBatch* batch, shader* target, const char* vertex_code, const char* fragment_code)
+{
+	ShaderBuild build{};
+	build.target = target;
+	build.cache_key = program_cache_key(&program_cache, vertex_code, fragment_code);
+
+	if (const GLuint cached = program_cache_load(&program_cache, build.cache_key)) {
+		target->ID = cached;
+		uniform_buffer_bind_blocks(cached);
+		shader_reflect_uniforms(target);
+		build.program = cached;
+		build.status = SHADER_BUILD_DONE;
+		batch->builds.push_back(build);
+		return;
+	}
+
+	// Linking a program whose stages failed to compile is allowed and just fails, so nothing here
+	// needs to wait for the compiler.
+	build.vertex = compile_stage(GL_VERTEX_SHADER, vertex_code);
+	build.fragment = compile_stage(GL_FRAGMENT_SHADER, fragment_code);
+	build.program = glCreateProgram();
+	glAttachShader(build.program, build.vertex);
+	glAttachShader(build.program, build.fragment);
+	program_cache_prepare(&program_cache, build.program);
+	glLinkProgram(build.program);
+	build.status = SHADER_BUILD_PENDING;
+
+	batch->builds.push_back(build);
+	batch->pending++;
+}
+
+uint32 shader_build_poll(ShaderBuildBatch* batch)
+{
+	for (ShaderBuild& build : batch->builds) {
+		if (build.status == SHADER_BUILD_PENDING && is_complete(build)) {
+			finish(batch, &build);
+		}
+	}
+	return batch->pending;
+}
+
+bool shader_build_wait(ShaderBuildBatch* batch)
+{
+	while (shader_build_poll(batch) > 0) {
+		std::this_thread::yield();
+	}
+	return batch->failed == 0;
+}
+
+void shader_build_clear(ShaderBuildBatch* batch)
+{
+	batch->builds.erase(std::remove_if(batch->builds.begin(), batch->builds.end(),
+		[](const ShaderBuild& build) { return build.status != SHADER_BUILD_PENDING; }), batch->builds.end());
+	batch->failed = 0;
+}
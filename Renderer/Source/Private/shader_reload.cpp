@@ -0,0 +1,181 @@
+#include "shader_reload.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+bool read_text(const std::string& path, std::string* text)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	std::stringstream stream;
+	stream << file.rdbuf();
+	*text = stream.str();
+	return true;
+}
+
+ShaderReloadResult build(const ShaderReloadJob& job)
+{
+	ShaderReloadResult result{ job.target, 0, nullptr };
+
+	std::string vertex_code;
+	std::string fragment_code;
+	if (!read_text(job.vertex_path, &vertex_code) || !read_text(job.fragment_path, &fragment_code)) {
+		std::cout << "ERROR::SHADER_RELOAD::FILE_NOT_SUCCESSFULLY_READ " << job.vertex_path << ", " << job.fragment_path << std::endl;
+		return result;
+	}
+
+	shader rebuilt{};
+	if (!shader_create_from_source(&rebuilt, vertex_code.c_str(), fragment_code.c_str())) {
+		std::cout << "Shader reload failed, keeping the previous program: " << job.vertex_path << ", " << job.fragment_path << std::endl;
+		return result;
+	}
+
+	result.program = rebuilt.ID;
+	result.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	return result;
+}
+
+void reload_main(ShaderReloader* reloader)
+{
+	glfwMakeContextCurrent(reloader->context);
+
+	std::unique_lock lock(reloader->mutex);
+	for (;;) {
+		reloader->cv.wait(lock, [reloader] { return !reloader->running || !reloader->jobs.empty(); });
+		if (!reloader->running) {
+			break;
+		}
+
+		ShaderReloadJob job = std::move(reloader->jobs.front());
+		reloader->jobs.pop_front();
+		lock.unlock();
+
+		const ShaderReloadResult result = build(job);
+
+		lock.lock();
+		if (result.program != 0) {
+			reloader->results.push_back(result);
+		}
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
+
+} // namespace
+
+bool shader_reloader_init(ShaderReloader* reloader, GLFWwindow* main_window)
+{
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	reloader->context = glfwCreateWindow(1, 1, "shader reload", nullptr, main_window);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	// Creating a window can change the current context on some platforms.
+	glfwMakeContextCurrent(main_window);
+
+	if (!reloader->context) {
+		std::cout << "Shader reload: no shared context, rebuilding on the main thread" << std::endl;
+		return false;
+	}
+
+	reloader->running = true;
+	reloader->thread = std::thread(reload_main, reloader);
+	return true;
+}
+
+void shader_reloader_shutdown(ShaderReloader* reloader)
+{
+	{
+		std::lock_guard lock(reloader->mutex);
+		reloader->running = false;
+	}
+	reloader->cv.notify_all();
+	if (reloader->thread.joinable()) {
+		reloader->thread.join();
+	}
+
+	for (const ShaderReloadResult& result : reloader->results) {
+		glDeleteSync(result.fence);
+		glDeleteProgram(result.program);
+	}
+	reloader->results.clear();
+	reloader->jobs.clear();
+
+	if (reloader->context) {
+		glfwDestroyWindow(reloader->context);
+		reloader->context = nullptr;
+	}
+}
+
+void shader_reloader_request(ShaderReloader* reloader, shader* target, const char* vertex_path, const char* fragment_path)
+{
+	{
+		std::lock_guard lock(reloader->mutex);
+		// A newer request for the same shader supersedes one that has not started yet.
+		auto queued = std::find_if(reloader->jobs.begin(), reloader->jobs.end(),
+			[target](const ShaderReloadJob& job) { return job.target == target; });
+		if (queued != reloader->jobs.end()) {
+			reloader->jobs.erase(queued);
+		}
+		reloader->jobs.push_back({ target, vertex_path, fragment_path });
+	}
+	reloader->cv.notify_one();
+}
+
+uint32_t shader_reloader_apply(ShaderReloader* reloader)
+{
+	// Without a shared context the builds run here, outside the lock.
+	if (!reloader->context) {
+		std::deque<ShaderReloadJob> jobs;
+		{
+			std::lock_guard lock(reloader->mutex);
+			jobs.swap(reloader->jobs);
+		}
+
+		std::vector<ShaderReloadResult> built;
+		for (const ShaderReloadJob& job : jobs) {
+			const ShaderReloadResult result = build(job);
+			if (result.program != 0) {
+				built.push_back(result);
+			}
+		}
+
+		if (!built.empty()) {
+			std::lock_guard lock(reloader->mutex);
+			reloader->results.insert(reloader->results.end(), built.begin(), built.end());
+		}
+	}
+
+	std::vector<ShaderReloadResult> ready;
+	{
+		std::lock_guard lock(reloader->mutex);
+		for (auto it = reloader->results.begin(); it != reloader->results.end();) {
+			const GLenum status = glClientWaitSync(it->fence, 0, 0);
+			if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+				ready.push_back(*it);
+				it = reloader->results.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	for (const ShaderReloadResult& result : ready) {
+		glDeleteSync(result.fence);
+		if (result.target->ID != 0) {
+			gl_state_forget_program(result.target->ID);
+			glDeleteProgram(result.target->ID);
+		}
+		result.target->ID = result.program;
+		shader_reflect_uniforms(result.target);
+		std::cout << "Reloaded shader program " << result.program << std::endl;
+	}
+	return static_cast<uint32_t>(ready.size());
+}
@@ -0,0 +1,172 @@
+#include "stream_buffer.h"
+#include "gl_extensions.h"
+#include "gl_state.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+uint64 align_up(uint64 value, uint64 alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+bool overlaps(const StreamBufferFence& fence, uint64 begin, uint64 end)
+{
+	return fence.begin < end && begin < fence.end;
+}
+
+// Waits for every fenced region that intersects [begin, end). Fences retire in order, so waiting on
+// the oldest one first never waits longer than needed.
+void wait_for_range(StreamBuffer* stream, uint64 begin, uint64 end)
+{
+	for (;;) {
+		bool blocked = false;
+		for (const StreamBufferFence& fence : stream->fences) {
+			if (overlaps(fence, begin, end)) {
+				blocked = true;
+				break;
+			}
+		}
+		if (!blocked) {
+			return;
+		}
+
+		const StreamBufferFence oldest = stream->fences.front();
+		stream->fences.pop_front();
+		GLenum status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (status == GL_TIMEOUT_EXPIRED) {
+			status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		glDeleteSync(oldest.fence);
+	}
+}
+
+// All buffer calls go through GL_COPY_WRITE_BUFFER so they never disturb the array, element or
+// uniform bindings the caller has set up.
+constexpr GLenum STREAM_BINDING = GL_COPY_WRITE_BUFFER;
+
+} // namespace
+
+bool stream_buffer_create(StreamBuffer* stream, uint64 capacity)
+{
+	stream->capacity = capacity;
+	stream->persistent = gl_extensions.buffer_storage;
+	stream->head = 0;
+	stream->frame_begin = 0;
+
+	glGenBuffers(1, &stream->buffer);
+	gl_state_bind_buffer(STREAM_BINDING, stream->buffer);
+
+	if (stream->persistent) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		gl_extensions.BufferStorage(STREAM_BINDING, static_cast<GLsizeiptr>(capacity), nullptr, flags);
+		stream->mapped = static_cast<uint8*>(glMapBufferRange(STREAM_BINDING, 0, static_cast<GLsizeiptr>(capacity), flags));
+		if (!stream->mapped) {
+			std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED" << std::endl;
+			gl_state_bind_buffer(STREAM_BINDING, 0);
+			stream_buffer_destroy(stream);
+			return false;
+		}
+	}
+	else {
+		glBufferData(STREAM_BINDING, static_cast<GLsizeiptr>(capacity), nullptr, GL_STREAM_DRAW);
+	}
+
+	gl_state_bind_buffer(STREAM_BINDING, 0);
+	return true;
+}
+
+void stream_buffer_destroy(StreamBuffer* stream)
+{
+	for (const StreamBufferFence& fence : stream->fences) {
+		glDeleteSync(fence.fence);
+	}
+	stream->fences.clear();
+
+	if (stream->buffer != 0) {
+		if (stream->mapped) {
+			gl_state_bind_buffer(STREAM_BINDING, stream->buffer);
+			glUnmapBuffer(STREAM_BINDING);
+			gl_state_bind_buffer(STREAM_BINDING, 0);
+		}
+		gl_state_forget_buffer(stream->buffer);
+		glDeleteBuffers(1, &stream->buffer);
+	}
+	stream->buffer = 0;
+	stream->mapped = nullptr;
+}
+
+bool stream_buffer_map(StreamBuffer* stream, uint64 size, uint64 alignment, StreamAllocation* allocation)
+{
+	if (size == 0 || size > stream->capacity) {
+		std::cout << "ERROR::STREAM_BUFFER::ALLOCATION_TOO_LARGE " << size << std::endl;
+		return false;
+	}
+
+	uint64 offset = align_up(stream->head, alignment > 0 ? alignment : 1);
+	const bool wraps = offset + size > stream->capacity;
+	if (wraps) {
+		offset = 0;
+	}
+
+	if (stream->persistent) {
+		if (wraps) {
+			// The tail past head is skipped; fence what this frame wrote there so it is not lost.
+			if (stream->head > stream->frame_begin) {
+				stream->fences.push_back({ stream->frame_begin, stream->head, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+			}
+			stream->frame_begin = 0;
+		}
+		wait_for_range(stream, offset, offset + size);
+
+		allocation->data = stream->mapped + offset;
+	}
+	else {
+		gl_state_bind_buffer(STREAM_BINDING, stream->buffer);
+		if (wraps) {
+			glBufferData(STREAM_BINDING, static_cast<GLsizeiptr>(stream->capacity), nullptr, GL_STREAM_DRAW);
+		}
+		allocation->data = glMapBufferRange(STREAM_BINDING, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (!allocation->data) {
+			std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED" << std::endl;
+			gl_state_bind_buffer(STREAM_BINDING, 0);
+			return false;
+		}
+	}
+
+	allocation->buffer = stream->buffer;
+	allocation->offset = offset;
+	stream->head = offset + size;
+	return true;
+}
+
+void stream_buffer_unmap(StreamBuffer* stream)
+{
+	if (stream->persistent) {
+		return;
+	}
+	glUnmapBuffer(STREAM_BINDING);
+	gl_state_bind_buffer(STREAM_BINDING, 0);
+}
+
+bool stream_buffer_write(StreamBuffer* stream, const void* data, uint64 size, uint64 alignment, StreamAllocation* allocation)
+{
+	if (!stream_buffer_map(stream, size, alignment, allocation)) {
+		return false;
+	}
+	std::memcpy(allocation->data, data, size);
+	stream_buffer_unmap(stream);
+	return true;
+}
+
+void stream_buffer_end_frame(StreamBuffer* stream)
+{
+	if (!stream->persistent || stream->head == stream->frame_begin) {
+		return;
+	}
+	stream->fences.push_back({ stream->frame_begin, stream->head, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+	stream->frame_begin = stream->head;
+}
@@ -0,0 +1,108 @@
+#include "texture.h"
+#include "gl_state.h"
+
+#include <iostream>
+
+// S3TC and BPTC are extensions on a 3.3 context (BPTC is core from 4.2); glad is generated for the
+// core profile only, so the enums are spelled out here.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+namespace {
+
+GLenum internal_format(TextureFormat format, bool srgb)
+{
+	switch (format) {
+	case TEXTURE_FORMAT_RGBA8: return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+	case TEXTURE_FORMAT_BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case TEXTURE_FORMAT_BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case TEXTURE_FORMAT_BC5: return GL_COMPRESSED_RG_RGTC2;
+	case TEXTURE_FORMAT_BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	default: return 0;
+	}
+}
+
+// base is a client pointer, or nullptr when the levels are sourced from a bound unpack buffer.
+bool create_levels(Texture* texture, const HtexHeader* header, const HtexMip* mips, const char* base, bool generate_mips)
+{
+	const TextureFormat format = static_cast<TextureFormat>(header->format);
+	const GLenum gl_format = internal_format(format, (header->flags & TEXTURE_FLAG_SRGB) != 0);
+	// Compressed formats can't be mipmapped by the driver.
+	generate_mips = generate_mips && header->mip_count == 1 && !texture_format_is_compressed(format);
+
+	texture->format = format;
+	texture->width = header->width;
+	texture->height = header->height;
+	texture->mip_count = generate_mips ? texture_mip_count(header->width, header->height) : header->mip_count;
+
+	glGenTextures(1, &texture->id);
+	gl_state_bind_texture(0, GL_TEXTURE_2D, texture->id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture->mip_count - 1));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture->mip_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	for (uint32 level = 0; level < header->mip_count; ++level) {
+		const HtexMip& mip = mips[level];
+		const void* pixels = base ? base + mip.offset : reinterpret_cast<const void*>(static_cast<uintptr_t>(mip.offset));
+		if (texture_format_is_compressed(format)) {
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), gl_format, mip.width, mip.height, 0,
+				static_cast<GLsizei>(mip.size), pixels);
+		}
+		else {
+			glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), gl_format, mip.width, mip.height, 0,
+				GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+	}
+	if (generate_mips) {
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	if (glGetError() != GL_NO_ERROR) {
+		std::cout << "ERROR::TEXTURE::UPLOAD_FAILED format " << header->format << std::endl;
+		texture_destroy(texture);
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+bool texture_create(Texture* texture, const void* htex_data, uint64 size)
+{
+	const HtexHeader* header = htex_validate(htex_data, size);
+	if (!header) {
+		std::cout << "ERROR::TEXTURE::INVALID_HTEX" << std::endl;
+		return false;
+	}
+	return create_levels(texture, header, htex_mips(header), static_cast<const char*>(htex_data), false);
+}
+
+bool texture_create_from_unpack_buffer(Texture* texture, const HtexHeader* header, const HtexMip* mips, bool generate_mips)
+{
+	return create_levels(texture, header, mips, nullptr, generate_mips);
+}
+
+void texture_bind(const Texture* texture, uint32 unit)
+{
+	gl_state_bind_texture(unit, GL_TEXTURE_2D, texture->id);
+}
+
+void texture_destroy(Texture* texture)
+{
+	if (texture->id != 0) {
+		gl_state_forget_texture(texture->id);
+		glDeleteTextures(1, &texture->id);
+		texture->id = 0;
+	}
+}
@@ -0,0 +1,157 @@
+#include "texture_upload.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+bool map_slot(TextureUploadSlot* slot)
+{
+	// Only called once the GPU is done with the buffer, so an unsynchronised map can't stall.
+	gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+	slot->mapped = static_cast<uint8*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(slot->capacity),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return slot->mapped != nullptr;
+}
+
+uint32 slot_index(const TextureUploader* uploader, const TextureUploadSlot* slot)
+{
+	return static_cast<uint32>(slot - uploader->slots.data());
+}
+
+} // namespace
+
+bool texture_uploader_init(TextureUploader* uploader, uint32 slot_count, uint64 slot_size)
+{
+	uploader->slots.resize(slot_count);
+	uploader->free_slots.clear();
+	uploader->in_flight.clear();
+
+	for (uint32 i = 0; i < slot_count; ++i) {
+		TextureUploadSlot& slot = uploader->slots[i];
+		slot.capacity = slot_size;
+		glGenBuffers(1, &slot.buffer);
+		gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(slot_size), nullptr, GL_STREAM_DRAW);
+
+		if (!map_slot(&slot)) {
+			std::cout << "ERROR::TEXTURE_UPLOAD::MAP_FAILED" << std::endl;
+			texture_uploader_shutdown(uploader);
+			return false;
+		}
+		uploader->free_slots.push_back(i);
+	}
+
+	uploader->running = true;
+	return true;
+}
+
+void texture_uploader_stop(TextureUploader* uploader)
+{
+	{
+		std::lock_guard lock(uploader->mutex);
+		uploader->running = false;
+	}
+	uploader->slot_cv.notify_all();
+}
+
+void texture_uploader_shutdown(TextureUploader* uploader)
+{
+	texture_uploader_stop(uploader);
+
+	for (TextureUploadSlot& slot : uploader->slots) {
+		if (slot.mapped) {
+			gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		if (slot.fence) {
+			glDeleteSync(slot.fence);
+		}
+		gl_state_forget_buffer(slot.buffer);
+		glDeleteBuffers(1, &slot.buffer);
+	}
+	uploader->slots.clear();
+	uploader->free_slots.clear();
+	uploader->in_flight.clear();
+}
+
+TextureUploadSlot* texture_uploader_acquire(TextureUploader* uploader, uint64 size)
+{
+	std::unique_lock lock(uploader->mutex);
+	if (uploader->slots.empty() || size > uploader->slots[0].capacity) {
+		std::cout << "ERROR::TEXTURE_UPLOAD::TOO_LARGE " << size << " bytes" << std::endl;
+		return nullptr;
+	}
+
+	uploader->slot_cv.wait(lock, [uploader] { return !uploader->running || !uploader->free_slots.empty(); });
+	if (!uploader->running) {
+		return nullptr;
+	}
+
+	const uint32 index = uploader->free_slots.back();
+	uploader->free_slots.pop_back();
+	return &uploader->slots[index];
+}
+
+void texture_uploader_release(TextureUploader* uploader, TextureUploadSlot* slot)
+{
+	{
+		std::lock_guard lock(uploader->mutex);
+		uploader->free_slots.push_back(slot_index(uploader, slot));
+	}
+	uploader->slot_cv.notify_one();
+}
+
+bool texture_uploader_upload(TextureUploader* uploader, TextureUploadSlot* slot, Texture* texture,
+	const HtexHeader* header, const HtexMip* mips, bool generate_mips)
+{
+	gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	slot->mapped = nullptr;
+
+	const bool created = texture_create_from_unpack_buffer(texture, header, mips, generate_mips);
+	gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	uploader->in_flight.push_back(slot_index(uploader, slot));
+	return created;
+}
+
+void texture_uploader_update(TextureUploader* uploader)
+{
+	uint32 recycled = 0;
+
+	for (std::size_t i = 0; i < uploader->in_flight.size();) {
+		TextureUploadSlot& slot = uploader->slots[uploader->in_flight[i]];
+		const GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			++i;
+			continue;
+		}
+
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		const uint32 index = uploader->in_flight[i];
+		uploader->in_flight[i] = uploader->in_flight.back();
+		uploader->in_flight.pop_back();
+
+		if (!map_slot(&slot)) {
+			// The slot is dropped; the remaining ones keep uploads going.
+			std::cout << "ERROR::TEXTURE_UPLOAD::MAP_FAILED" << std::endl;
+			continue;
+		}
+
+		{
+			std::lock_guard lock(uploader->mutex);
+			uploader->free_slots.push_back(index);
+		}
+		recycled++;
+	}
+
+	if (recycled > 0) {
+		uploader->slot_cv.notify_all();
+	}
+}
@@ -0,0 +1,457 @@
+#include "transform.h"
+
+#include <engine_assert.h>
+#include <job_system.h>
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TRANSFORM_SSE2 1
+#endif
+
+namespace {
+
+constexpr uint8 TRANSFORM_DIRTY = 1;
+constexpr uint8 TRANSFORM_DESTROYED = 2;
+// A group of four starting at the last transform stays inside the component arrays.
+constexpr uint32 TRANSFORM_PADDING = 3;
+
+// Rotation and scale columns of four local matrices, then their translations: entry [column * 3 + row]
+// for the upper 3x3 and [9 + row] for the translation, one lane per transform.
+using LocalColumns = float[12][4];
+
+void resize(TransformHierarchy* hierarchy, uint32 count)
+{
+	const std::size_t padded = static_cast<std::size_t>(count) + TRANSFORM_PADDING;
+	hierarchy->position_x.resize(padded);
+	hierarchy->position_y.resize(padded);
+	hierarchy->position_z.resize(padded);
+	hierarchy->rotation_x.resize(padded);
+	hierarchy->rotation_y.resize(padded);
+	hierarchy->rotation_z.resize(padded);
+	hierarchy->rotation_w.resize(padded);
+	hierarchy->scale_x.resize(padded);
+	hierarchy->scale_y.resize(padded);
+	hierarchy->scale_z.resize(padded);
+	hierarchy->parent.resize(count);
+	hierarchy->depth.resize(count);
+	hierarchy->flags.resize(count);
+	hierarchy->world.resize(count);
+	hierarchy->ids.resize(count);
+	hierarchy->count = count;
+}
+
+template <typename T>
+void permute(std::vector<T>* values, const std::vector<uint32>& order, std::size_t size)
+{
+	std::vector<T> moved(size);
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		moved[i] = (*values)[order[i]];
+	}
+	values->swap(moved);
+}
+
+uint32 index_of(const TransformHierarchy* hierarchy, uint32 transform)
+{
+	RT_ASSERT(transform < hierarchy->index.size() && hierarchy->index[transform] != TRANSFORM_NONE, "Transform id is not alive");
+	return hierarchy->index[transform];
+}
+
+void mark_dirty(TransformHierarchy* hierarchy, uint32 index)
+{
+	hierarchy->flags[index] |= TRANSFORM_DIRTY;
+	hierarchy->first_dirty = std::min(hierarchy->first_dirty, index);
+}
+
+// Drops destroyed transforms and their descendants and restores breadth-first order with a stable
+// counting sort on depth, so transforms that did not change level keep their relative order.
+void reorder(TransformHierarchy* hierarchy)
+{
+	constexpr uint32 unresolved = TRANSFORM_NONE;
+	constexpr uint32 destroyed = TRANSFORM_NONE - 1;
+
+	const uint32 count = hierarchy->count;
+	std::vector<uint32> depth(count, unresolved);
+	std::vector<uint32> chain;
+	uint32 max_depth = 0;
+	for (uint32 i = 0; i < count; ++i) {
+		// Reparenting can put a parent after its child, so walk up to the first resolved ancestor and
+		// resolve the chain back down.
+		for (uint32 a = i; a != TRANSFORM_NONE && depth[a] == unresolved; a = hierarchy->parent[a]) {
+			chain.push_back(a);
+		}
+		while (!chain.empty()) {
+			const uint32 c = chain.back();
+			chain.pop_back();
+			const uint32 p = hierarchy->parent[c];
+			if ((hierarchy->flags[c] & TRANSFORM_DESTROYED) || (p != TRANSFORM_NONE && depth[p] == destroyed)) {
+				depth[c] = destroyed;
+				continue;
+			}
+			depth[c] = p == TRANSFORM_NONE ? 0 : depth[p] + 1;
+			max_depth = std::max(max_depth, depth[c]);
+		}
+	}
+
+	std::vector<uint32> offsets(max_depth + 2, 0);
+	for (uint32 i = 0; i < count; ++i) {
+		if (depth[i] != destroyed) {
+			++offsets[depth[i] + 1];
+		}
+	}
+	for (uint32 d = 1; d < offsets.size(); ++d) {
+		offsets[d] += offsets[d - 1];
+	}
+	const uint32 alive = offsets.back();
+	hierarchy->levels.assign(offsets.begin(), offsets.end() - 1);
+	if (alive == 0) {
+		hierarchy->levels.clear();
+	}
+
+	std::vector<uint32> order(alive);
+	std::vector<uint32> remap(count, TRANSFORM_NONE);
+	for (uint32 i = 0; i < count; ++i) {
+		if (depth[i] == destroyed) {
+			hierarchy->index[hierarchy->ids[i]] = TRANSFORM_NONE;
+			hierarchy->free_ids.push_back(hierarchy->ids[i]);
+			continue;
+		}
+		const uint32 k = offsets[depth[i]]++;
+		order[k] = i;
+		remap[i] = k;
+	}
+
+	const std::size_t padded = static_cast<std::size_t>(alive) + TRANSFORM_PADDING;
+	permute(&hierarchy->position_x, order, padded);
+	permute(&hierarchy->position_y, order, padded);
+	permute(&hierarchy->position_z, order, padded);
+	permute(&hierarchy->rotation_x, order, padded);
+	permute(&hierarchy->rotation_y, order, padded);
+	permute(&hierarchy->rotation_z, order, padded);
+	permute(&hierarchy->rotation_w, order, padded);
+	permute(&hierarchy->scale_x, order, padded);
+	permute(&hierarchy->scale_y, order, padded);
+	permute(&hierarchy->scale_z, order, padded);
+	permute(&hierarchy->flags, order, alive);
+	permute(&hierarchy->world, order, alive);
+	permute(&hierarchy->ids, order, alive);
+
+	std::vector<uint32> parent(alive);
+	hierarchy->depth.resize(alive);
+	hierarchy->first_dirty = alive;
+	for (uint32 k = 0; k < alive; ++k) {
+		const uint32 old_parent = hierarchy->parent[order[k]];
+		parent[k] = old_parent == TRANSFORM_NONE ? TRANSFORM_NONE : remap[old_parent];
+		hierarchy->depth[k] = depth[order[k]];
+		hierarchy->index[hierarchy->ids[k]] = k;
+		if ((hierarchy->flags[k] & TRANSFORM_DIRTY) && hierarchy->first_dirty == alive) {
+			hierarchy->first_dirty = k;
+		}
+	}
+	hierarchy->parent.swap(parent);
+	hierarchy->count = alive;
+	hierarchy->order_changed = false;
+	++hierarchy->stats.reorders;
+}
+
+// Local matrices of the transforms at first .. first + 3 from their components.
+void local_columns(const TransformHierarchy* hierarchy, uint32 first, LocalColumns columns)
+{
+#if TRANSFORM_SSE2
+	const __m128 x = _mm_loadu_ps(&hierarchy->rotation_x[first]);
+	const __m128 y = _mm_loadu_ps(&hierarchy->rotation_y[first]);
+	const __m128 z = _mm_loadu_ps(&hierarchy->rotation_z[first]);
+	const __m128 w = _mm_loadu_ps(&hierarchy->rotation_w[first]);
+	const __m128 sx = _mm_loadu_ps(&hierarchy->scale_x[first]);
+	const __m128 sy = _mm_loadu_ps(&hierarchy->scale_y[first]);
+	const __m128 sz = _mm_loadu_ps(&hierarchy->scale_z[first]);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	const __m128 x2 = _mm_add_ps(x, x);
+	const __m128 y2 = _mm_add_ps(y, y);
+	const __m128 z2 = _mm_add_ps(z, z);
+	const __m128 xx = _mm_mul_ps(x, x2);
+	const __m128 yy = _mm_mul_ps(y, y2);
+	const __m128 zz = _mm_mul_ps(z, z2);
+	const __m128 xy = _mm_mul_ps(x, y2);
+	const __m128 xz = _mm_mul_ps(x, z2);
+	const __m128 yz = _mm_mul_ps(y, z2);
+	const __m128 wx = _mm_mul_ps(w, x2);
+	const __m128 wy = _mm_mul_ps(w, y2);
+	const __m128 wz = _mm_mul_ps(w, z2);
+
+	_mm_storeu_ps(columns[0], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx));
+	_mm_storeu_ps(columns[1], _mm_mul_ps(_mm_add_ps(xy, wz), sx));
+	_mm_storeu_ps(columns[2], _mm_mul_ps(_mm_sub_ps(xz, wy), sx));
+	_mm_storeu_ps(columns[3], _mm_mul_ps(_mm_sub_ps(xy, wz), sy));
+	_mm_storeu_ps(columns[4], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy));
+	_mm_storeu_ps(columns[5], _mm_mul_ps(_mm_add_ps(yz, wx), sy));
+	_mm_storeu_ps(columns[6], _mm_mul_ps(_mm_add_ps(xz, wy), sz));
+	_mm_storeu_ps(columns[7], _mm_mul_ps(_mm_sub_ps(yz, wx), sz));
+	_mm_storeu_ps(columns[8], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz));
+	_mm_storeu_ps(columns[9], _mm_loadu_ps(&hierarchy->position_x[first]));
+	_mm_storeu_ps(columns[10], _mm_loadu_ps(&hierarchy->position_y[first]));
+	_mm_storeu_ps(columns[11], _mm_loadu_ps(&hierarchy->position_z[first]));
+#else
+	for (uint32 l = 0; l < 4; ++l) {
+		const uint32 i = first + l;
+		const float x = hierarchy->rotation_x[i];
+		const float y = hierarchy->rotation_y[i];
+		const float z = hierarchy->rotation_z[i];
+		const float w = hierarchy->rotation_w[i];
+		const float sx = hierarchy->scale_x[i];
+		const float sy = hierarchy->scale_y[i];
+		const float sz = hierarchy->scale_z[i];
+		const float xx = 2.0f * x * x, yy = 2.0f * y * y, zz = 2.0f * z * z;
+		const float xy = 2.0f * x * y, xz = 2.0f * x * z, yz = 2.0f * y * z;
+		const float wx = 2.0f * w * x, wy = 2.0f * w * y, wz = 2.0f * w * z;
+
+		columns[0][l] = (1.0f - (yy + zz)) * sx;
+		columns[1][l] = (xy + wz) * sx;
+		columns[2][l] = (xz - wy) * sx;
+		columns[3][l] = (xy - wz) * sy;
+		columns[4][l] = (1.0f - (xx + zz)) * sy;
+		columns[5][l] = (yz + wx) * sy;
+		columns[6][l] = (xz + wy) * sz;
+		columns[7][l] = (yz - wx) * sz;
+		columns[8][l] = (1.0f - (xx + yy)) * sz;
+		columns[9][l] = hierarchy->position_x[i];
+		columns[10][l] = hierarchy->position_y[i];
+		columns[11][l] = hierarchy->position_z[i];
+	}
+#endif
+}
+
+// world = parent world * local, using that the bottom row of a local matrix is (0, 0, 0, 1).
+void compose(TransformHierarchy* hierarchy, uint32 index, const LocalColumns columns, uint32 lane)
+{
+	float* out = hierarchy->world[index].m;
+	const uint32 parent = hierarchy->parent[index];
+	if (parent == TRANSFORM_NONE) {
+		for (uint32 c = 0; c < 4; ++c) {
+			out[c * 4 + 0] = columns[c * 3 + 0][lane];
+			out[c * 4 + 1] = columns[c * 3 + 1][lane];
+			out[c * 4 + 2] = columns[c * 3 + 2][lane];
+			out[c * 4 + 3] = c == 3 ? 1.0f : 0.0f;
+		}
+		return;
+	}
+
+	const float* p = hierarchy->world[parent].m;
+#if TRANSFORM_SSE2
+	const __m128 p0 = _mm_loadu_ps(p + 0);
+	const __m128 p1 = _mm_loadu_ps(p + 4);
+	const __m128 p2 = _mm_loadu_ps(p + 8);
+	const __m128 p3 = _mm_loadu_ps(p + 12);
+	for (uint32 c = 0; c < 4; ++c) {
+		__m128 column = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(columns[c * 3 + 0][lane])), _mm_mul_ps(p1, _mm_set1_ps(columns[c * 3 + 1][lane]))),
+			_mm_mul_ps(p2, _mm_set1_ps(columns[c * 3 + 2][lane])));
+		if (c == 3) {
+			column = _mm_add_ps(column, p3);
+		}
+		_mm_storeu_ps(out + c * 4, column);
+	}
+#else
+	for (uint32 c = 0; c < 4; ++c) {
+		const float l0 = columns[c * 3 + 0][lane];
+		const float l1 = columns[c * 3 + 1][lane];
+		const float l2 = columns[c * 3 + 2][lane];
+		for (uint32 row = 0; row < 4; ++row) {
+			out[c * 4 + row] = p[row] * l0 + p[4 + row] * l1 + p[8 + row] * l2 + (c == 3 ? p[12 + row] : 0.0f);
+		}
+	}
+#endif
+}
+
+struct UpdateJob {
+	TransformHierarchy* hierarchy = nullptr;
+	// Start of the level range being updated; batch bounds are relative to it.
+	uint32 begin = 0;
+	std::atomic<uint32> recomputed{ 0 };
+};
+
+// Parents are on the previous level, which is complete, so their flags and world matrices are final.
+void update_range(void* user_data, uint32 begin, uint32 end)
+{
+	UpdateJob* job = static_cast<UpdateJob*>(user_data);
+	TransformHierarchy* hierarchy = job->hierarchy;
+	begin += job->begin;
+	end += job->begin;
+
+	uint32 recomputed = 0;
+	for (uint32 first = begin; first < end; first += 4) {
+		const uint32 lanes = std::min(end - first, 4u);
+		uint32 dirty = 0;
+		for (uint32 l = 0; l < lanes; ++l) {
+			const uint32 parent = hierarchy->parent[first + l];
+			if (parent != TRANSFORM_NONE) {
+				hierarchy->flags[first + l] |= hierarchy->flags[parent] & TRANSFORM_DIRTY;
+			}
+			dirty |= (hierarchy->flags[first + l] & TRANSFORM_DIRTY) << l;
+		}
+		if (dirty == 0) {
+			continue;
+		}
+
+		LocalColumns columns;
+		local_columns(hierarchy, first, columns);
+		for (uint32 l = 0; l < lanes; ++l) {
+			if (dirty & (1u << l)) {
+				compose(hierarchy, first + l, columns, l);
+				++recomputed;
+			}
+		}
+	}
+	job->recomputed += recomputed;
+}
+
+} // namespace
+
+uint32 transform_create(TransformHierarchy* hierarchy, uint32 parent)
+{
+	uint32 id = static_cast<uint32>(hierarchy->index.size());
+	if (!hierarchy->free_ids.empty()) {
+		id = hierarchy->free_ids.back();
+		hierarchy->free_ids.pop_back();
+	}
+	else {
+		hierarchy->index.push_back(TRANSFORM_NONE);
+	}
+
+	const uint32 parent_index = parent == TRANSFORM_NONE ? TRANSFORM_NONE : index_of(hierarchy, parent);
+	const uint32 i = hierarchy->count;
+	resize(hierarchy, i + 1);
+	hierarchy->position_x[i] = 0.0f;
+	hierarchy->position_y[i] = 0.0f;
+	hierarchy->position_z[i] = 0.0f;
+	hierarchy->rotation_x[i] = 0.0f;
+	hierarchy->rotation_y[i] = 0.0f;
+	hierarchy->rotation_z[i] = 0.0f;
+	hierarchy->rotation_w[i] = 1.0f;
+	hierarchy->scale_x[i] = 1.0f;
+	hierarchy->scale_y[i] = 1.0f;
+	hierarchy->scale_z[i] = 1.0f;
+	hierarchy->parent[i] = parent_index;
+	hierarchy->depth[i] = parent_index == TRANSFORM_NONE ? 0 : hierarchy->depth[parent_index] + 1;
+	hierarchy->flags[i] = 0;
+	hierarchy->world[i] = mat4();
+	hierarchy->ids[i] = id;
+	hierarchy->index[id] = i;
+	mark_dirty(hierarchy, i);
+
+	// Appending keeps breadth-first order as long as depth does not decrease.
+	if (i > 0 && hierarchy->depth[i] < hierarchy->depth[i - 1]) {
+		hierarchy->order_changed = true;
+	}
+	else if (hierarchy->depth[i] == hierarchy->levels.size()) {
+		hierarchy->levels.push_back(i);
+	}
+	return id;
+}
+
+void transform_destroy(TransformHierarchy* hierarchy, uint32 transform)
+{
+	hierarchy->flags[index_of(hierarchy, transform)] |= TRANSFORM_DESTROYED;
+	hierarchy->order_changed = true;
+}
+
+void transform_set_parent(TransformHierarchy* hierarchy, uint32 transform, uint32 parent)
+{
+	const uint32 i = index_of(hierarchy, transform);
+	uint32 parent_index = TRANSFORM_NONE;
+	if (parent != TRANSFORM_NONE) {
+		parent_index = index_of(hierarchy, parent);
+		for (uint32 a = parent_index; a != TRANSFORM_NONE; a = hierarchy->parent[a]) {
+			RT_ASSERT(a != i, "Transform cannot be parented below itself");
+		}
+	}
+	hierarchy->parent[i] = parent_index;
+	hierarchy->order_changed = true;
+	mark_dirty(hierarchy, i);
+}
+
+void transform_set_local(TransformHierarchy* hierarchy, uint32 transform, const vec3& position, const quat& rotation, const vec3& scale)
+{
+	const uint32 i = index_of(hierarchy, transform);
+	hierarchy->position_x[i] = position.x;
+	hierarchy->position_y[i] = position.y;
+	hierarchy->position_z[i] = position.z;
+	hierarchy->rotation_x[i] = rotation.x;
+	hierarchy->rotation_y[i] = rotation.y;
+	hierarchy->rotation_z[i] = rotation.z;
+	hierarchy->rotation_w[i] = rotation.w;
+	hierarchy->scale_x[i] = scale.x;
+	hierarchy->scale_y[i] = scale.y;
+	hierarchy->scale_z[i] = scale.z;
+	mark_dirty(hierarchy, i);
+}
+
+void transform_set_position(TransformHierarchy* hierarchy, uint32 transform, const vec3& position)
+{
+	const uint32 i = index_of(hierarchy, transform);
+	hierarchy->position_x[i] = position.x;
+	hierarchy->position_y[i] = position.y;
+	hierarchy->position_z[i] = position.z;
+	mark_dirty(hierarchy, i);
+}
+
+void transform_set_rotation(TransformHierarchy* hierarchy, uint32 transform, const quat& rotation)
+{
+	const uint32 i = index_of(hierarchy, transform);
+	hierarchy->rotation_x[i] = rotation.x;
+	hierarchy->rotation_y[i] = rotation.y;
+	hierarchy->rotation_z[i] = rotation.z;
+	hierarchy->rotation_w[i] = rotation.w;
+	mark_dirty(hierarchy, i);
+}
+
+void transform_set_scale(TransformHierarchy* hierarchy, uint32 transform, const vec3& scale)
+{
+	const uint32 i = index_of(hierarchy, transform);
+	hierarchy->scale_x[i] = scale.x;
+	hierarchy->scale_y[i] = scale.y;
+	hierarchy->scale_z[i] = scale.z;
+	mark_dirty(hierarchy, i);
+}
+
+uint32 transform_parent(const TransformHierarchy* hierarchy, uint32 transform)
+{
+	const uint32 parent = hierarchy->parent[index_of(hierarchy, transform)];
+	return parent == TRANSFORM_NONE ? TRANSFORM_NONE : hierarchy->ids[parent];
+}
+
+const mat4& transform_world(const TransformHierarchy* hierarchy, uint32 transform)
+{
+	return hierarchy->world[index_of(hierarchy, transform)];
+}
+
+void transform_update(TransformHierarchy* hierarchy, JobSystem* jobs)
+{
+	++hierarchy->stats.updates;
+	hierarchy->stats.recomputed = 0;
+	if (hierarchy->order_changed) {
+		reorder(hierarchy);
+	}
+	if (hierarchy->first_dirty >= hierarchy->count) {
+		return;
+	}
+
+	// Levels before the first dirty transform hold nothing dirty and are skipped whole.
+	const std::vector<uint32>& levels = hierarchy->levels;
+	const uint32 first_level = static_cast<uint32>(std::upper_bound(levels.begin(), levels.end(), hierarchy->first_dirty) - levels.begin()) - 1;
+	UpdateJob job;
+	job.hierarchy = hierarchy;
+	for (uint32 level = first_level; level < levels.size(); ++level) {
+		const uint32 begin = std::max(levels[level], hierarchy->first_dirty);
+		const uint32 end = level + 1 < levels.size() ? levels[level + 1] : hierarchy->count;
+		job.begin = begin;
+		job_system_parallel_for(jobs, end - begin, TRANSFORM_UPDATE_BATCH, update_range, &job);
+	}
+
+	std::fill(hierarchy->flags.begin() + hierarchy->first_dirty, hierarchy->flags.end(), uint8(0));
+	hierarchy->stats.recomputed = job.recomputed;
+	hierarchy->first_dirty = hierarchy->count;
+}
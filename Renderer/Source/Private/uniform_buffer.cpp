@@ -1 +1,44 @@
-#include "uniform_buffer.h"
\ No newline at end of file
+#include "uniform_buffer.h"
+#include "stream_buffer.h"
+#include "gl_state.h"
+
+namespace {
+
+uint64 offset_alignment()
+{
+	static const uint64 alignment = [] {
+		GLint value = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+		return static_cast<uint64>(value > 0 ? value : 256);
+	}();
+	return alignment;
+}
+
+} // namespace
+
+void uniform_buffer_bind_blocks(GLuint program)
+{
+	for (GLuint binding = 0; binding < UNIFORM_BINDING_COUNT; ++binding) {
+		const GLuint index = glGetUniformBlockIndex(program, UNIFORM_BLOCK_NAMES[binding]);
+		if (index != GL_INVALID_INDEX) {
+			glUniformBlockBinding(program, index, binding);
+		}
+	}
+}
+
+bool uniform_buffer_write(StreamBuffer* stream, const void* data, uint64 size, StreamAllocation* allocation)
+{
+	return stream_buffer_write(stream, data, size, offset_alignment(), allocation);
+}
+
+bool uniform_buffer_push(StreamBuffer* stream, UniformBinding binding, const void* data, uint64 size)
+{
+	StreamAllocation allocation{};
+	if (!uniform_buffer_write(stream, data, size, &allocation)) {
+		std::cout << "ERROR::UNIFORM_BUFFER::PUSH_FAILED " << UNIFORM_BLOCK_NAMES[binding] << std::endl;
+		return false;
+	}
+	gl_state_bind_uniform_range(binding, allocation.buffer, static_cast<GLintptr>(allocation.offset),
+		static_cast<GLsizeiptr>(size));
+	return true;
+}
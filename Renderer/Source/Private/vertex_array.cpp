@@ -1,12 +1,61 @@
 #include "vertex_array.h"
+#include "gl_state.h"
+
+#include <engine_assert.h>
 
 void create_vertex_array_object(VertexArray* vertex_array)
 {
 	glGenVertexArrays(1, &vertex_array->vertex_array_object);
-	glBindVertexArray(vertex_array->vertex_array_object);
+	gl_state_bind_vertex_array(vertex_array->vertex_array_object);
 }
 
 void bind_vertex_array(VertexArray* vertex_array)
 {
-	glBindVertexArray(vertex_array->vertex_array_object);
+	gl_state_bind_vertex_array(vertex_array->vertex_array_object);
+}
+
+void vertex_array_set_vertex_layout(VertexArray* vertex_array, GLuint buffer, const VertexAttribute* attributes, uint32 count, uint32 stride)
+{
+	gl_state_bind_vertex_array(vertex_array->vertex_array_object);
+	gl_state_bind_buffer(GL_ARRAY_BUFFER, buffer);
+	for (uint32 i = 0; i < count; ++i) {
+		glVertexAttribPointer(attributes[i].location, attributes[i].components, attributes[i].type, attributes[i].normalized,
+			static_cast<GLsizei>(stride), reinterpret_cast<const void*>(static_cast<uintptr_t>(attributes[i].offset)));
+		glEnableVertexAttribArray(attributes[i].location);
+	}
+}
+
+void vertex_array_set_instance_layout(VertexArray* vertex_array, const VertexAttribute* attributes, uint32 count, uint32 stride)
+{
+	RT_ASSERT(count <= VERTEX_ARRAY_MAX_INSTANCE_ATTRIBUTES, "Too many instance attributes");
+
+	gl_state_bind_vertex_array(vertex_array->vertex_array_object);
+	for (uint32 i = 0; i < count; ++i) {
+		vertex_array->instance_attributes[i] = attributes[i];
+		glEnableVertexAttribArray(attributes[i].location);
+		glVertexAttribDivisor(attributes[i].location, 1);
+	}
+	vertex_array->instance_attribute_count = count;
+	vertex_array->instance_stride = stride;
+	vertex_array->instance_buffer = 0;
+	vertex_array->instance_offset = 0;
+}
+
+void vertex_array_bind_instances(VertexArray* vertex_array, GLuint buffer, uint64 offset)
+{
+	gl_state_bind_vertex_array(vertex_array->vertex_array_object);
+	if (vertex_array->instance_buffer == buffer && vertex_array->instance_offset == offset) {
+		return;
+	}
+
+	// Attribute pointers capture the GL_ARRAY_BUFFER binding at the time they are set.
+	gl_state_bind_buffer(GL_ARRAY_BUFFER, buffer);
+	for (uint32 i = 0; i < vertex_array->instance_attribute_count; ++i) {
+		const VertexAttribute& attribute = vertex_array->instance_attributes[i];
+		glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized,
+			static_cast<GLsizei>(vertex_array->instance_stride),
+			reinterpret_cast<const void*>(static_cast<uintptr_t>(offset + attribute.offset)));
+	}
+	vertex_array->instance_buffer = buffer;
+	vertex_array->instance_offset = offset;
 }
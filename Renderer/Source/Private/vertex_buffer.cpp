@@ -1,4 +1,5 @@
 #include "vertex_buffer.h"
+#include "gl_state.h"
 
 #include <iostream>
 
@@ -9,7 +10,7 @@ void create_vertex_buffer(VertexBuffer* vertex_buffer)
 
 void bind_vertex_buffer(VertexBuffer* vertex_buffer)
 {
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer->vertex_buffer_object);
+	gl_state_bind_buffer(GL_ARRAY_BUFFER, vertex_buffer->vertex_buffer_object);
 }
 
 void add_data_vertex_buffer(VertexBuffer* vertex_buffer, const void* data, std::size_t size)
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+#include <engine_arena.h>
+
+#include "render_commands.h"
+#include "vertex.h"
+#include "vertex_array.h"
+
+#include <vector>
+
+struct StreamBuffer;
+
+// Shared geometry for one vertex format: every mesh lives in the same vertex and index buffer, so
+// all of them draw from one vertex array and a frame's draws can be merged into a few indirect calls.
+//
+// Indices are stored relative to their mesh and offset by the base vertex at draw time, so a mesh is
+// uploaded exactly as it was imported.
+
+// Element ranges, in vertices or indices rather than bytes.
+struct GeometryRange {
+	uint32 offset;
+	uint32 count;
+};
+
+// First fit over a free list kept sorted by offset; freed ranges merge with their neighbours.
+struct GeometryAllocator {
+	std::vector<GeometryRange> free_ranges{};
+	uint32 capacity = 0;
+	uint32 used = 0;
+};
+
+void geometry_allocator_init(GeometryAllocator* allocator, uint32 capacity);
+bool geometry_allocator_allocate(GeometryAllocator* allocator, uint32 count, uint32* offset);
+void geometry_allocator_free(GeometryAllocator* allocator, GeometryRange range);
+
+struct GeometryMesh {
+	uint32 base_vertex;
+	uint32 vertex_count;
+	uint32 first_index;
+	uint32 index_count;
+};
+
+struct GeometryPool {
+	// Vertex layout, the pool's element buffer and the InstanceData layout for per-draw data.
+	VertexArray vertex_array{};
+	GLuint vertex_buffer = 0;
+	GLuint index_buffer = 0;
+	uint32 vertex_stride = 0;
+	GeometryAllocator vertices{};
+	GeometryAllocator indices{};
+};
+
+// Indices are 32-bit. The vertex format is given as attributes plus the size of one vertex.
+bool geometry_pool_create(GeometryPool* pool, const VertexAttribute* attributes, uint32 attribute_count, uint32 vertex_stride,
+	uint32 vertex_capacity, uint32 index_capacity);
+void geometry_pool_destroy(GeometryPool* pool);
+
+// Reserves space and uploads the mesh. Returns false when either buffer has no room left.
+bool geometry_pool_add(GeometryPool* pool, const void* vertices, uint32 vertex_count, const uint32* indices, uint32 index_count,
+	GeometryMesh* mesh);
+void geometry_pool_remove(GeometryPool* pool, const GeometryMesh& mesh);
+
+// One frame's draws from a pool. Each draw gets a contiguous run of InstanceData, addressed through
+// its command's base instance; a single copy is a draw with one instance.
+struct GeometryBatch {
+	Arena* arena = nullptr;
+	DrawElementsIndirectCommand* commands = nullptr;
+	uint32 command_count = 0;
+	uint32 command_capacity = 0;
+	InstanceData* instances = nullptr;
+	uint32 instance_count = 0;
+	uint32 instance_capacity = 0;
+};
+
+// Batch storage comes from arena and is gone when the arena is reset.
+void geometry_batch_begin(GeometryBatch* batch, Arena* arena, uint32 command_capacity, uint32 instance_capacity);
+
+// Returns instance_count slots for the caller to fill.
+InstanceData* geometry_batch_add(GeometryBatch* batch, const GeometryMesh& mesh, uint32 instance_count);
+
+// Copies commands and instance data into stream and fills packet (from render_commands_add or _chain)
+// to draw them all. On failure the packet draws nothing.
+bool geometry_batch_write(GeometryBatch* batch, GeometryPool* pool, StreamBuffer* stream, GLuint program,
+	RenderMultiDrawPacket* packet);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// The glad loader is generated for GL 3.3 core. Newer entry points that the renderer can use when the
+// driver offers them are resolved here at startup; every feature has a flag and a 3.3 fallback.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_UNIFORM_BARRIER_BIT 0x00000004
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)(GLenum mode, GLsizei count, GLenum type,
+	const void* indices, GLsizei instance_count, GLint base_vertex, GLuint base_instance);
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei buffer_size, GLsizei* length, GLenum* binary_format, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum name, GLint value);
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei draw_count, GLsizei stride);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+
+struct GlExtensions {
+	// GL 4.4 / ARB_buffer_storage: immutable storage that can stay mapped while the GPU reads it.
+	bool buffer_storage = false;
+	PFNGLBUFFERSTORAGEPROC BufferStorage = nullptr;
+
+	// GL 4.1 / ARB_get_program_binary: linked programs can be saved and reloaded without compiling.
+	// Also false when the driver offers the entry points but no binary format.
+	bool program_binary = false;
+	PFNGLGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+	PFNGLPROGRAMBINARYPROC ProgramBinary = nullptr;
+	PFNGLPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+
+	// KHR_parallel_shader_compile / ARB_parallel_shader_compile: compiles and links run on driver
+	// threads and GL_COMPLETION_STATUS_KHR reports when they are done without waiting for them.
+	bool parallel_shader_compile = false;
+	PFNGLMAXSHADERCOMPILERTHREADSKHRPROC MaxShaderCompilerThreads = nullptr;
+
+	// GL 4.2 / ARB_base_instance: instance attributes start at base_instance, so per-draw data can
+	// live in one buffer.
+	bool base_instance = false;
+	PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC DrawElementsInstancedBaseVertexBaseInstance = nullptr;
+
+	// GL 4.3 / ARB_multi_draw_indirect: many draws read from a buffer in one call.
+	bool multi_draw_indirect = false;
+	PFNGLMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect = nullptr;
+
+	// GL 4.2 / ARB_shader_image_load_store: image and storage buffer writes only become visible to
+	// later reads after glMemoryBarrier. Without it nothing can write that way, so there is nothing
+	// to wait for.
+	bool memory_barrier = false;
+	PFNGLMEMORYBARRIERPROC MemoryBarrier = nullptr;
+};
+
+extern GlExtensions gl_extensions;
+
+// Needs a current context. load is the same proc loader glad was initialised with.
+void gl_extensions_load(GLADloadproc load);
+
+bool gl_has_extension(const char* name);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+
+// Shadow of the main context's GL state. Every bind and state change in the renderer goes through
+// these calls, which skip the driver entirely when the value is already set and count issued and
+// skipped calls. GL code that bypasses them must call gl_state_invalidate afterwards.
+//
+// Element array bindings belong to the vertex array object and are not shadowed.
+
+constexpr uint32 GL_STATE_TEXTURE_UNITS = 16;
+constexpr uint32 GL_STATE_UNIFORM_BINDINGS = 16;
+
+enum GlStateBuffer : uint8 {
+	GL_STATE_BUFFER_ARRAY,
+	GL_STATE_BUFFER_UNIFORM,
+	GL_STATE_BUFFER_COPY_READ,
+	GL_STATE_BUFFER_COPY_WRITE,
+	GL_STATE_BUFFER_PIXEL_UNPACK,
+	GL_STATE_BUFFER_DRAW_INDIRECT,
+	GL_STATE_BUFFER_COUNT
+};
+
+enum GlStateTexture : uint8 {
+	GL_STATE_TEXTURE_2D,
+	GL_STATE_TEXTURE_2D_ARRAY,
+	GL_STATE_TEXTURE_3D,
+	GL_STATE_TEXTURE_CUBE_MAP,
+	GL_STATE_TEXTURE_TARGET_COUNT
+};
+
+enum GlStateCapability : uint8 {
+	GL_STATE_BLEND,
+	GL_STATE_DEPTH_TEST,
+	GL_STATE_CULL_FACE,
+	GL_STATE_SCISSOR_TEST,
+	GL_STATE_CAPABILITY_COUNT
+};
+
+struct GlStateStats {
+	uint32 issued = 0;
+	uint32 skipped = 0;
+};
+
+struct GlBufferRange {
+	GLuint buffer;
+	GLintptr offset;
+	GLsizeiptr size;
+};
+
+// Values equal to GL_STATE_UNKNOWN (or -1 for the small fields) are not known and always issue.
+constexpr GLuint GL_STATE_UNKNOWN = 0xFFFFFFFFu;
+
+struct GlState {
+	GLuint program;
+	GLuint vertex_array;
+	GLuint buffers[GL_STATE_BUFFER_COUNT];
+	GlBufferRange uniform_ranges[GL_STATE_UNIFORM_BINDINGS];
+
+	GLuint active_texture_unit;
+	GLuint textures[GL_STATE_TEXTURE_UNITS][GL_STATE_TEXTURE_TARGET_COUNT];
+
+	int8 capabilities[GL_STATE_CAPABILITY_COUNT];
+	int8 depth_mask;
+	GLenum depth_func;
+	GLenum blend_source;
+	GLenum blend_destination;
+	GLenum cull_face;
+	GLenum polygon_mode;
+	float clear_color[4];
+	GLint viewport[4];
+
+	GlStateStats stats;
+};
+
+extern GlState gl_state;
+
+// Forgets everything, so the next call of each kind is issued. Call after context creation and after
+// any code that changes state behind the cache's back.
+void gl_state_invalidate();
+void gl_state_reset_stats();
+
+// Each returns true when the call reached GL.
+bool gl_state_use_program(GLuint program);
+bool gl_state_bind_vertex_array(GLuint vertex_array);
+bool gl_state_bind_buffer(GLenum target, GLuint buffer);
+bool gl_state_bind_uniform_range(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size);
+bool gl_state_bind_texture(GLuint unit, GLenum target, GLuint texture);
+bool gl_state_set_capability(GlStateCapability capability, bool enabled);
+bool gl_state_depth_mask(bool write);
+bool gl_state_depth_func(GLenum function);
+bool gl_state_blend_func(GLenum source, GLenum destination);
+bool gl_state_cull_face(GLenum face);
+bool gl_state_polygon_mode(GLenum mode);
+bool gl_state_clear_color(float r, float g, float b, float a);
+bool gl_state_viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+// GL unbinds deleted objects from the current context and may hand their names out again; call these
+// when deleting so the shadow does not keep a stale name.
+void gl_state_forget_program(GLuint program);
+void gl_state_forget_vertex_array(GLuint vertex_array);
+void gl_state_forget_buffer(GLuint buffer);
+void gl_state_forget_texture(GLuint texture);
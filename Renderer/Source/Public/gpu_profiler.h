@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+
+// GPU time per named scope, measured with GL_TIMESTAMP queries at the start and end of each scope so
+// scopes can nest. Queries of a frame are read GPU_PROFILER_FRAMES_IN_FLIGHT frames later, by which
+// time the GPU has normally finished them; results that still are not ready are dropped rather than
+// waited for, so profiling never stalls the pipeline.
+//
+// Scope names are expected to be string literals; only the pointer is kept.
+
+constexpr uint32 GPU_PROFILER_FRAMES_IN_FLIGHT = 4;
+constexpr uint32 GPU_PROFILER_MAX_SCOPES = 64;
+constexpr uint32 GPU_PROFILER_MAX_DEPTH = 16;
+// Samples kept per scope for the percentile.
+constexpr uint32 GPU_PROFILER_HISTORY = 256;
+
+struct GpuProfilerFrame {
+	GLuint queries[GPU_PROFILER_MAX_SCOPES * 2];
+	uint16 scopes[GPU_PROFILER_MAX_SCOPES];
+	uint32 scope_count;
+	// Issued last; nested scopes end out of order, so it is not simply the last in queries.
+	GLuint last_query;
+	bool pending;
+};
+
+struct GpuScopeStats {
+	const char* name;
+	uint64 name_hash;
+	uint64 samples;
+	double total_ms;
+	float min_ms;
+	float max_ms;
+	float history[GPU_PROFILER_HISTORY];
+	uint32 history_next;
+};
+
+struct GpuProfiler {
+	bool initialised = false;
+	GpuProfilerFrame frames[GPU_PROFILER_FRAMES_IN_FLIGHT]{};
+	uint32 frame = 0;
+
+	// Open scopes of the current frame, as indices into its scope list.
+	uint32 open[GPU_PROFILER_MAX_DEPTH]{};
+	uint32 depth = 0;
+	// Scopes opened beyond GPU_PROFILER_MAX_DEPTH; their ends are ignored.
+	uint32 overflow = 0;
+
+	GpuScopeStats scopes[GPU_PROFILER_MAX_SCOPES]{};
+	uint32 scope_count = 0;
+	// Frames whose results were not ready in time, and scopes that did not fit.
+	uint32 dropped_frames = 0;
+	uint32 dropped_scopes = 0;
+};
+
+struct GpuScopeSummary {
+	const char* name;
+	uint64 samples;
+	float average_ms;
+	float min_ms;
+	float max_ms;
+	// Over the last GPU_PROFILER_HISTORY samples.
+	float p99_ms;
+};
+
+// Needs a current context.
+void gpu_profiler_init(GpuProfiler* profiler);
+void gpu_profiler_destroy(GpuProfiler* profiler);
+
+// Collects the results of the frame whose queries are about to be reused, then starts a new frame.
+void gpu_profiler_begin_frame(GpuProfiler* profiler);
+void gpu_profiler_end_frame(GpuProfiler* profiler);
+
+void gpu_profiler_begin(GpuProfiler* profiler, const char* name);
+void gpu_profiler_end(GpuProfiler* profiler);
+
+// Fills up to capacity summaries in first-seen order and returns how many scopes there are.
+uint32 gpu_profiler_summary(const GpuProfiler* profiler, GpuScopeSummary* summaries, uint32 capacity);
+
+// One line per scope: name, samples, average, min, max and p99 in milliseconds.
+bool gpu_profiler_export_csv(const GpuProfiler* profiler, const char* path);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+#include <vec3.h>
+#include <frustum.h>
+#include <vector>
+
+constexpr uint32 MESHLET_MAX_VERTICES = 64;
+constexpr uint32 MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet
+{
+	uint32 vertex_offset;	// into MeshletMesh::meshlet_vertices
+	uint32 triangle_offset;	// into MeshletMesh::meshlet_triangles, 3 local indices per triangle
+	uint32 index_offset;	// into MeshletMesh::indices, first index of this cluster's draw range
+	uint32 vertex_count;
+	uint32 triangle_count;
+
+	vec3 center;
+	float radius;
+
+	// Cluster is back-facing from every point where
+	// dot(center - eye, cone_axis) >= cone_cutoff * |center - eye| + radius.
+	// A cutoff of 1 disables the cone test for clusters whose normals spread over 90 degrees.
+	vec3 cone_axis;
+	float cone_cutoff;
+};
+
+struct MeshletMesh
+{
+	std::vector<Meshlet> meshlets{};
+	std::vector<uint32> meshlet_vertices{};
+	std::vector<uint8> meshlet_triangles{};
+
+	// Source indices reordered so every meshlet is one contiguous range,
+	// ready to be uploaded as the element buffer of the mesh.
+	std::vector<uint32> indices{};
+};
+
+struct MeshletDrawList
+{
+	std::vector<GLsizei> counts{};
+	std::vector<const void*> offsets{};
+	uint32 visible_meshlets = 0;
+	uint32 culled_meshlets = 0;
+};
+
+void meshlet_build(MeshletMesh* mesh, const vec3* positions, std::size_t vertex_count,
+	const uint32* indices, std::size_t index_count);
+
+// Frustum and camera position are expected in the mesh's local space.
+void meshlet_cull(const MeshletMesh* mesh, const frustum& view_frustum, const vec3& camera_position,
+	MeshletDrawList* draw_list);
+
+void meshlet_draw(const MeshletDrawList* draw_list);
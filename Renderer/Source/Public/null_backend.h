@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+
+// A stand-in GL implementation that does no GPU work, for measuring what the engine itself spends
+// building and submitting frames. Loading glad through null_backend_get_proc points the GL entry
+// points the renderer uses at stubs that track object names, bindings and buffer sizes, count calls
+// and check them the way a debug driver would: unknown names, draws without a program or vertex
+// array, index and indirect reads past the end of a buffer, misaligned uniform ranges, and mapping
+// a buffer twice. Failures set the error glGetError reports and are printed once per kind.
+//
+// It reports GL 4.5 with no real extensions and no program binary formats, so the renderer takes its
+// buffer storage and multi-draw-indirect paths and skips the program cache. Mapped buffers are
+// backed by host memory. Entry points outside the renderer's set are left null. Not thread safe,
+// like a GL context.
+
+struct NullBackendStats {
+	uint64 calls;
+	// Every draw of a multi-draw counts, as does every instance of an instanced draw.
+	uint64 draws;
+	uint64 instances;
+	// Passed to glBufferData and glBufferSubData.
+	uint64 buffer_bytes;
+	uint64 barriers;
+	uint64 errors;
+};
+
+extern NullBackendStats null_backend_stats;
+
+// Proc loader for gladLoadGLLoader and gl_extensions_load.
+void* null_backend_get_proc(const char* name);
+
+// Forgets every object and binding, as if the context were recreated. Stats are kept.
+void null_backend_reset();
+void null_backend_reset_stats();
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+
+// A framebuffer object standing in for the window's default framebuffer, for contexts that have no
+// surface to draw to (headless runs on machines without a display). Colour is RGBA8 and depth is
+// 24-bit with an 8-bit stencil, matching what GLFW asks for by default.
+
+struct OffscreenTarget {
+	GLuint framebuffer = 0;
+	GLuint color = 0;
+	GLuint depth_stencil = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// Returns false and leaves target empty when the framebuffer is incomplete.
+bool offscreen_target_create(OffscreenTarget* target, int width, int height);
+void offscreen_target_destroy(OffscreenTarget* target);
+
+// Binds the target for drawing and reading; 0 goes back to the default framebuffer.
+void offscreen_target_bind(const OffscreenTarget* target);
+
+// Reads the colour attachment as tightly packed RGBA8 rows, bottom row first. pixels must hold
+// width * height * 4 bytes. Waits for the GPU; meant for checks, not per-frame use.
+void offscreen_target_read_pixels(const OffscreenTarget* target, uint8* pixels);
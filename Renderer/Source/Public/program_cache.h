@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+
+#include <atomic>
+#include <string>
+
+// On-disk cache of linked program binaries. Programs are keyed by a hash of their sources and of the
+// driver (vendor, renderer and version string), so a driver update or a different GPU simply misses.
+// A binary the driver rejects is deleted and the program is compiled from source as if it had missed.
+//
+// Safe to use from the shader reload thread; each key is one file, written atomically.
+
+constexpr uint32 PROGRAM_CACHE_MAGIC = 0x42525048; // "HPRB"
+constexpr uint32 PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader {
+	uint32 magic;
+	uint32 version;
+	uint64 key;
+	uint32 format;
+	uint32 size;
+};
+
+struct ProgramCache {
+	bool enabled = false;
+	std::string directory{};
+	uint64 driver_hash = 0;
+
+	std::atomic<uint32> hits{ 0 };
+	std::atomic<uint32> misses{ 0 };
+	std::atomic<uint32> rejected{ 0 };
+};
+
+extern ProgramCache program_cache;
+
+// Needs a current context and gl_extensions loaded. Stays disabled when directory is null or empty or
+// the driver has no program binary support.
+void program_cache_init(ProgramCache* cache, const char* directory);
+
+uint64 program_cache_key(const ProgramCache* cache, const char* vertex_code, const char* fragment_code);
+
+// Returns a linked program, or 0 when the cache is disabled, has no entry or the driver refuses it.
+GLuint program_cache_load(ProgramCache* cache, uint64 key);
+
+// Call before linking a program that will be stored.
+void program_cache_prepare(const ProgramCache* cache, GLuint program);
+void program_cache_store(ProgramCache* cache, uint64 key, GLuint program);
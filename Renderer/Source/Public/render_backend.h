@@ -0,0 +1,17 @@
+#pragma once
+
+#include <engine_types.h>
+
+struct GLFWwindow;
+
+// What the renderer's GL calls go to. The renderer always calls through glad's entry points, so a
+// backend is just the loader they and gl_extensions are resolved with.
+enum RenderBackend : uint8 {
+	// The window's GL context.
+	RENDER_BACKEND_GL,
+	// null_backend: validates and counts calls without touching a GPU; the window needs no context.
+	RENDER_BACKEND_NULL
+};
+
+// Loads glad and gl_extensions for backend and makes the window's context current when it has one.
+bool render_backend_load(RenderBackend backend, GLFWwindow* window);
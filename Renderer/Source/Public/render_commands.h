@@ -0,0 +1,168 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+#include <engine_arena.h>
+
+#include "vertex_array.h"
+
+// Frame command list. Game and renderer code record packets into the frame arena instead of calling
+// GL directly. Each command pairs a 64-bit sort key with a chain of packets; the list is radix sorted
+// on the key and then executed by one backend loop that only touches GL state that actually changes.
+//
+// Opaque keys sort by pass, then program, material and vertex array so that state changes are
+// grouped, and finally front to back. Translucent keys sort by pass, then back to front.
+//
+//   opaque       | pass:8 | program:12 | material:16 | vertex array:12 | depth:16 |
+//   translucent  | pass:8 | ~depth:16  | program:12  | material:16 | vertex array:12 |
+
+enum RenderPass : uint8 {
+	RENDER_PASS_SHADOW,
+	RENDER_PASS_OPAQUE,
+	RENDER_PASS_TRANSLUCENT,
+	RENDER_PASS_UI
+};
+
+// view_depth is normalised to [0, 1], 0 at the near plane. IDs are truncated to their field width,
+// which only ever costs a redundant state change, never a wrong draw.
+uint64 render_key_opaque(RenderPass pass, uint32 program, uint32 material, uint32 vertex_array, float view_depth);
+uint64 render_key_translucent(RenderPass pass, uint32 program, uint32 material, uint32 vertex_array, float view_depth);
+
+enum RenderPacketType : uint8 {
+	RENDER_PACKET_DRAW,
+	RENDER_PACKET_BIND_UNIFORMS,
+	RENDER_PACKET_STATE,
+	RENDER_PACKET_BIND_INSTANCES,
+	RENDER_PACKET_MULTI_DRAW
+};
+
+struct RenderPacket {
+	RenderPacketType type;
+	// Packets of one command execute in chain order; a draw usually comes last.
+	RenderPacket* next;
+};
+
+struct RenderDrawPacket : RenderPacket {
+	GLuint program;
+	GLuint vertex_array;
+	// Bound to texture unit 0 when non-zero.
+	GLuint texture;
+	GLenum mode;
+	GLsizei count;
+	// 0 draws arrays starting at first; otherwise an element type, with first as the byte offset.
+	GLenum index_type;
+	uint64 first;
+	// Copies drawn with one call; chain a RenderBindInstancesPacket before the draw to give each copy
+	// its own instance data.
+	GLsizei instance_count;
+};
+
+struct RenderBindUniformsPacket : RenderPacket {
+	GLuint binding;
+	GLuint buffer;
+	uint64 offset;
+	uint64 size;
+};
+
+// Points the vertex array's instance attributes at instance data written this frame, usually a
+// StreamAllocation from the frame stream.
+struct RenderBindInstancesPacket : RenderPacket {
+	VertexArray* vertex_array;
+	GLuint buffer;
+	uint64 offset;
+};
+
+// Matches the layout glMultiDrawElementsIndirect reads.
+struct DrawElementsIndirectCommand {
+	uint32 count;
+	uint32 instance_count;
+	uint32 first_index;
+	int32 base_vertex;
+	uint32 base_instance;
+};
+
+// Many indexed draws (32-bit indices) from one vertex array. Instance data for all of them starts at
+// instance_offset and each command reaches its own through base_instance. With multi-draw indirect the
+// whole list is one call reading indirect_buffer; otherwise the CPU copy in commands is replayed.
+struct RenderMultiDrawPacket : RenderPacket {
+	GLuint program;
+	VertexArray* vertex_array;
+	GLenum mode;
+	GLuint indirect_buffer;
+	uint64 indirect_offset;
+	const DrawElementsIndirectCommand* commands;
+	uint32 draw_count;
+	GLuint instance_buffer;
+	uint64 instance_offset;
+};
+
+enum RenderStateFlags : uint8 {
+	RENDER_STATE_DEPTH_TEST = 1 << 0,
+	RENDER_STATE_DEPTH_WRITE = 1 << 1,
+	RENDER_STATE_BLEND = 1 << 2,
+	RENDER_STATE_CULL = 1 << 3,
+	RENDER_STATE_DEFAULT = RENDER_STATE_DEPTH_TEST | RENDER_STATE_DEPTH_WRITE | RENDER_STATE_CULL
+};
+
+struct RenderStatePacket : RenderPacket {
+	uint8 flags;
+};
+
+struct RenderCommand {
+	uint64 key;
+	RenderPacket* packet;
+};
+
+struct RenderCommandStats {
+	uint32 commands = 0;
+	uint32 draws = 0;
+	uint32 instances = 0;
+	// Draws that went through multi-draw packets, however many GL calls they took.
+	uint32 indirect_draws = 0;
+	uint32 program_changes = 0;
+	uint32 vertex_array_changes = 0;
+	uint32 texture_changes = 0;
+	uint32 state_changes = 0;
+};
+
+struct RenderCommandBuffer {
+	Arena* arena = nullptr;
+	RenderCommand* commands = nullptr;
+	uint32 count = 0;
+	uint32 capacity = 0;
+	RenderCommandStats stats{};
+};
+
+// Everything recorded lives in arena and is gone once the arena is reset, so begin, record, sort and
+// submit all happen within one frame.
+void render_commands_begin(RenderCommandBuffer* buffer, Arena* arena, uint32 capacity);
+
+RenderPacket* render_commands_add_packet(RenderCommandBuffer* buffer, uint64 key, RenderPacketType type, size_t size, size_t alignment);
+RenderPacket* render_commands_chain_packet(RenderCommandBuffer* buffer, RenderPacket* previous, RenderPacketType type, size_t size, size_t alignment);
+
+template<typename T> constexpr RenderPacketType render_packet_type();
+template<> constexpr RenderPacketType render_packet_type<RenderDrawPacket>() { return RENDER_PACKET_DRAW; }
+template<> constexpr RenderPacketType render_packet_type<RenderBindUniformsPacket>() { return RENDER_PACKET_BIND_UNIFORMS; }
+template<> constexpr RenderPacketType render_packet_type<RenderStatePacket>() { return RENDER_PACKET_STATE; }
+template<> constexpr RenderPacketType render_packet_type<RenderBindInstancesPacket>() { return RENDER_PACKET_BIND_INSTANCES; }
+template<> constexpr RenderPacketType render_packet_type<RenderMultiDrawPacket>() { return RENDER_PACKET_MULTI_DRAW; }
+
+// Starts a new command with key whose first packet is a T.
+template<typename T>
+T* render_commands_add(RenderCommandBuffer* buffer, uint64 key)
+{
+	return static_cast<T*>(render_commands_add_packet(buffer, key, render_packet_type<T>(), sizeof(T), alignof(T)));
+}
+
+// Appends a T to the chain that previous belongs to, to run after previous.
+template<typename T>
+T* render_commands_chain(RenderCommandBuffer* buffer, RenderPacket* previous)
+{
+	return static_cast<T*>(render_commands_chain_packet(buffer, previous, render_packet_type<T>(), sizeof(T), alignof(T)));
+}
+
+void render_commands_sort(RenderCommandBuffer* buffer);
+
+// Executes every command in order. All binds and state changes go through the gl_state cache, so
+// state left by the previous frame or by code outside the command list is not set again.
+void render_commands_submit(RenderCommandBuffer* buffer);
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+
+#include <vector>
+
+// Frame graph. Every frame the renderer declares its passes in execution order, what each one reads
+// and writes, and which resources leave the frame; render_graph_compile then works out what has to
+// run and with what:
+//
+// - Passes that contribute nothing to an output are dropped. A write that is not also declared as a
+//   read replaces the resource's contents, so a pass that draws over what an earlier pass left in a
+//   target has to read it as well.
+// - Transient render targets live from their first to their last surviving use. Targets of the same
+//   size and format whose lifetimes do not overlap share one pooled texture, so a chain of post
+//   processing passes needs two textures rather than one per step.
+// - A resource written through image or storage buffer stores is made visible with one
+//   glMemoryBarrier before the next pass that touches it, with the bits for how that pass uses it.
+//   GL orders framebuffer writes against later texture reads by itself, so render-to-texture needs
+//   no barrier. Imported resources start every frame with nothing pending; stores made to them
+//   outside the graph need their own barrier.
+// - A pass whose attachments GL rejects as an incomplete framebuffer is dropped with an error, and so
+//   is every later pass that reads something it would have written.
+//
+// Pooled textures and their framebuffers stay alive across frames and are deleted once unused for
+// RENDER_GRAPH_POOL_FRAMES frames.
+
+struct RenderGraph;
+
+constexpr uint32 RENDER_GRAPH_NONE = 0xFFFFFFFF;
+constexpr uint32 RENDER_GRAPH_MAX_COLOR_ATTACHMENTS = 4;
+constexpr uint32 RENDER_GRAPH_POOL_FRAMES = 8;
+
+enum RenderTargetFormat : uint8 {
+	RENDER_TARGET_RGBA8,
+	RENDER_TARGET_RGBA16F,
+	RENDER_TARGET_R32F,
+	RENDER_TARGET_DEPTH24_STENCIL8,
+	RENDER_TARGET_DEPTH32F
+};
+
+enum RenderGraphAccess : uint8 {
+	RENDER_GRAPH_COLOR_ATTACHMENT,
+	RENDER_GRAPH_DEPTH_ATTACHMENT,
+	RENDER_GRAPH_SAMPLED,
+	RENDER_GRAPH_STORAGE_IMAGE,
+	RENDER_GRAPH_STORAGE_BUFFER,
+	RENDER_GRAPH_UNIFORM_BUFFER,
+	RENDER_GRAPH_INDIRECT_BUFFER,
+	RENDER_GRAPH_VERTEX_BUFFER
+};
+
+enum RenderGraphResourceKind : uint8 {
+	RENDER_GRAPH_TEXTURE,
+	RENDER_GRAPH_BUFFER,
+	// A whole framebuffer, like the window's or an OffscreenTarget; only usable as a colour attachment.
+	RENDER_GRAPH_FRAMEBUFFER
+};
+
+struct RenderTargetDesc {
+	int width;
+	int height;
+	RenderTargetFormat format;
+};
+
+struct RenderGraphResource {
+	const char* name;
+	RenderGraphResourceKind kind;
+	bool transient;
+	bool output;
+	RenderTargetDesc desc;
+	// Imported GL name, or for transients the pooled texture once compiled.
+	GLuint object;
+	// Transients: entry in RenderGraph::pool once compiled.
+	uint32 pooled;
+	// First and last surviving pass that uses it.
+	uint32 first_use;
+	uint32 last_use;
+	// Barrier bits still owed to image or storage buffer stores made to it. Transients use the
+	// pooled texture's instead, which carries over between frames.
+	GLbitfield pending_barriers;
+};
+
+struct RenderGraphAccessRecord {
+	uint32 pass;
+	uint32 resource;
+	RenderGraphAccess access;
+	bool write;
+};
+
+using RenderGraphExecuteFn = void (*)(const RenderGraph* graph, void* user_data);
+
+struct RenderGraphPass {
+	const char* name;
+	RenderGraphExecuteFn execute;
+	void* user_data;
+	// Kept even if none of its writes are used, e.g. for readbacks.
+	bool side_effects;
+	bool culled;
+	// Range in RenderGraph::accesses once compiled.
+	uint32 first_access;
+	uint32 access_count;
+	// Bound before execute when the pass has attachments; RENDER_GRAPH_NONE when it has none.
+	GLuint framebuffer;
+	int width;
+	int height;
+	GLbitfield barriers;
+};
+
+struct RenderGraphPooledTexture {
+	GLuint texture;
+	RenderTargetDesc desc;
+	// Frame it was last handed out, and the last pass of its current holder in that frame.
+	uint32 frame;
+	uint32 busy_until;
+	GLbitfield pending_barriers;
+};
+
+struct RenderGraphFramebuffer {
+	GLuint framebuffer;
+	GLuint colors[RENDER_GRAPH_MAX_COLOR_ATTACHMENTS];
+	GLuint depth;
+	uint32 frame;
+	// Attaches an imported texture. The graph can't tell when those are deleted and their names
+	// reused, so these only live for the frame.
+	bool imported;
+};
+
+struct RenderGraphStats {
+	uint32 passes;
+	uint32 culled;
+	uint32 barriers;
+	uint32 transients;
+	// Textures the transients were placed in this frame.
+	uint32 textures;
+	// Bytes of the transients this frame if each had its own texture, and bytes of the whole pool.
+	uint64 transient_bytes;
+	uint64 pool_bytes;
+};
+
+struct RenderGraph {
+	// Declared this frame.
+	std::vector<RenderGraphResource> resources{};
+	std::vector<RenderGraphPass> passes{};
+	std::vector<RenderGraphAccessRecord> accesses{};
+
+	// Kept across frames.
+	std::vector<RenderGraphPooledTexture> pool{};
+	std::vector<RenderGraphFramebuffer> framebuffers{};
+	uint32 frame = 0;
+	// Last framebuffer the graph bound. Other code binds framebuffers too, so it is forgotten every frame.
+	GLuint bound_framebuffer = RENDER_GRAPH_NONE;
+	bool compiled = false;
+	RenderGraphStats stats{};
+};
+
+// Forgets last frame's passes and resources; pooled textures are kept.
+void render_graph_begin(RenderGraph* graph);
+
+uint32 render_graph_create_texture(RenderGraph* graph, const char* name, const RenderTargetDesc& desc);
+uint32 render_graph_import_texture(RenderGraph* graph, const char* name, GLuint texture, const RenderTargetDesc& desc);
+uint32 render_graph_import_buffer(RenderGraph* graph, const char* name, GLuint buffer);
+// Imported framebuffers are always outputs; framebuffer 0 is the window's.
+uint32 render_graph_import_framebuffer(RenderGraph* graph, const char* name, GLuint framebuffer, int width, int height);
+// Keeps the passes that produce an imported texture or buffer, for resources used after the frame.
+void render_graph_set_output(RenderGraph* graph, uint32 resource);
+
+uint32 render_graph_add_pass(RenderGraph* graph, const char* name, RenderGraphExecuteFn execute, void* user_data);
+void render_graph_read(RenderGraph* graph, uint32 pass, uint32 resource, RenderGraphAccess access);
+void render_graph_write(RenderGraph* graph, uint32 pass, uint32 resource, RenderGraphAccess access);
+void render_graph_keep_pass(RenderGraph* graph, uint32 pass);
+
+// Culls passes, places transients in pooled textures and works out framebuffers and barriers.
+void render_graph_compile(RenderGraph* graph);
+// Runs the surviving passes in order, each with its barrier issued, framebuffer bound and viewport
+// covering its attachments.
+void render_graph_execute(RenderGraph* graph);
+
+// The GL name behind a resource; for transients only valid from render_graph_compile on.
+GLuint render_graph_object(const RenderGraph* graph, uint32 resource);
+
+// Deletes the pooled textures and framebuffers. Needs the context.
+void render_graph_destroy(RenderGraph* graph);
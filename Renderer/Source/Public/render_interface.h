@@ -4,21 +4,80 @@
 
 #include <GLFW/glfw3.h>
 #include "shader.h"
+#include "shader_build.h"
 #include "vertex_array.h"
 #include "vertex_buffer.h"
+#include "stream_buffer.h"
+#include "uniform_buffer.h"
+#include "render_commands.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
+#include "vertex.h"
+#include "geometry_pool.h"
+#include "scene.h"
+#include "transform.h"
+#include "render_graph.h"
+#include "offscreen_target.h"
+#include "render_backend.h"
+#include "null_backend.h"
 #include <vec3.h>
 
 
 struct RendererInterface {
 	shader shader{};
-	VertexArray vertex_array{};
-	VertexBuffer vertex_buffer{};
+	// Program builds still in flight; polled once per frame.
+	ShaderBuildBatch shader_builds{};
+	ShaderUniformHandle<float> some_uniform{};
+	// Every mesh's vertices and indices; the demo triangle is the only one so far.
+	GeometryPool geometry{};
+	GeometryMesh triangle{};
+	// One object per demo grid cell, object id y * RENDERER_DEMO_GRID + x; culled every frame.
+	Scene scene{};
+	uint32 visible_objects = 0;
+	// The demo grid is one root with a child per cell; object_transforms maps scene object ids to them.
+	TransformHierarchy transforms{};
+	std::vector<uint32> object_transforms{};
+	// Per-frame vertex and uniform data; fenced at the end of renderer_draw_frame.
+	StreamBuffer frame_stream{};
+	// Rebuilt from the frame arena every frame; the stats of the last submit stay readable.
+	RenderCommandBuffer commands{};
+	// Declared again every frame; its pooled render targets persist.
+	RenderGraph graph{};
+	// GL calls issued and filtered out by the state cache during the last frame.
+	GlStateStats gl_calls{};
+	// What the null backend saw during the last frame; all zero with the GL backend.
+	NullBackendStats null_calls{};
+	// GPU time of the "frame", "clear" and "scene" scopes.
+	GpuProfiler gpu_profiler{};
+	// Drawn into instead of the window when the context has no default framebuffer.
+	OffscreenTarget offscreen{};
 };
 
-void renderer_init(GLFWwindow* window, RendererInterface* renderer_interface);
+inline constexpr uint64 RENDERER_FRAME_STREAM_SIZE = 8ull * 1024 * 1024;
+inline constexpr uint32 RENDERER_GEOMETRY_VERTICES = 1u << 20;
+inline constexpr uint32 RENDERER_GEOMETRY_INDICES = 3u << 20;
+// The demo triangle is drawn as a RENDERER_DEMO_GRID x RENDERER_DEMO_GRID grid of instances.
+inline constexpr uint32 RENDERER_DEMO_GRID = 8;
+inline constexpr float RENDERER_DEMO_CELL = 2.0f / RENDERER_DEMO_GRID;
+
+inline vec3 renderer_demo_cell_center(uint32 x, uint32 y)
+{
+	return vec3(-1.0f + RENDERER_DEMO_CELL * (x + 0.5f), -1.0f + RENDERER_DEMO_CELL * (y + 0.5f), 0.0f);
+}
+
+// Shader sources are optional; without them the shader is read from its vertexPath/fragmentPath.
+// shader_cache is the program binary cache directory; null disables it. With RENDER_BACKEND_NULL the
+// window needs no GL context, and a test graph is compiled first to check culling, transient aliasing
+// and barrier placement; a mismatch prints ERROR::RENDERER::RENDER_GRAPH_CHECK.
+void renderer_init(GLFWwindow* window, RendererInterface* renderer_interface,
+	const char* vertex_source = nullptr, const char* fragment_source = nullptr, const char* shader_cache = nullptr,
+	RenderBackend backend = RENDER_BACKEND_GL);
+// Redirects every following frame into an offscreen target of the given size. Returns false, and
+// keeps drawing to the window, if the target can't be created.
+bool renderer_enable_offscreen(RendererInterface* renderer_interface, int width, int height);
 void renderer_swap_buffers(GLFWwindow* window);
 void renderer_poll_events();
-void renderer_draw_frame(GLFWwindow* window, RendererInterface* renderer_interface, float deltaTime);
+void renderer_draw_frame(GLFWwindow* window, RendererInterface* renderer_interface, Arena* frame_arena, float deltaTime);
 void renderer_cleanup();
 
 void renderer_set_wireframe(bool value);
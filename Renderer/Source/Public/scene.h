@@ -0,0 +1,78 @@
+#pragma once
+
+#include <engine_types.h>
+#include <vec3.h>
+#include <frustum.h>
+
+#include <vector>
+
+// Scene objects are world-space bounding boxes behind stable ids, held in a bounding volume
+// hierarchy for frustum culling and overlap queries. The tree is built top-down with binned SAH.
+// Moving objects only refit it, which keeps the topology and grows boxes; once refitting has made
+// the tree noticeably worse than a fresh build (by SAH cost) it is rebuilt. Adding or removing
+// objects always rebuilds, at the next scene_update.
+
+struct SceneAabb {
+	vec3 min;
+	vec3 max;
+};
+
+struct SceneNode {
+	vec3 min;
+	// Interior: index of the left child; the right child follows it. Leaf: first entry in Scene::objects.
+	uint32 first;
+	vec3 max;
+	// Objects in a leaf; 0 for interior nodes.
+	uint32 count;
+};
+
+constexpr uint32 SCENE_INVALID_OBJECT = 0xFFFFFFFF;
+constexpr uint32 SCENE_SAH_BINS = 16;
+// Leaves are split while SAH says it pays off, and always above this size.
+constexpr uint32 SCENE_MAX_LEAF_SIZE = 8;
+// Cost of visiting a node relative to testing one object against it.
+constexpr float SCENE_TRAVERSAL_COST = 1.0f;
+// Refit trees whose SAH cost grows past this multiple of the cost right after the build are rebuilt.
+constexpr float SCENE_REBUILD_COST_RATIO = 1.5f;
+
+struct SceneStats {
+	uint32 builds;
+	uint32 refits;
+	// SAH cost of the tree now and right after the last build, relative to the root's area.
+	float cost;
+	float built_cost;
+};
+
+struct Scene {
+	// Indexed by object id. Removed ids are reused.
+	std::vector<SceneAabb> bounds{};
+	std::vector<uint8> alive{};
+	std::vector<uint32> free_ids{};
+	uint32 object_count = 0;
+
+	// Object ids in leaf order; every subtree covers one contiguous range.
+	std::vector<SceneNode> nodes{};
+	std::vector<uint32> objects{};
+
+	bool structure_changed = false;
+	bool bounds_changed = false;
+	SceneStats stats{};
+};
+
+uint32 scene_add(Scene* scene, const SceneAabb& bounds);
+void scene_remove(Scene* scene, uint32 object);
+// Moves an object; cheap until the next scene_update refits the tree.
+void scene_set_bounds(Scene* scene, uint32 object, const SceneAabb& bounds);
+
+// Brings the tree up to date: a build after adds and removes, otherwise a refit after moves, and a
+// rebuild if the refit degraded it too far. Call once per frame before culling.
+void scene_update(Scene* scene);
+// Builds from scratch regardless of what changed.
+void scene_build(Scene* scene);
+
+// Writes the ids of objects whose bounds intersect the frustum, up to capacity, and returns how many
+// there are in total. Order follows the tree, so nearby objects come out together.
+uint32 scene_cull(const Scene* scene, const frustum& view_frustum, uint32* visible, uint32 capacity);
+
+// Same for objects whose bounds overlap box.
+uint32 scene_query_aabb(const Scene* scene, const SceneAabb& box, uint32* results, uint32 capacity);
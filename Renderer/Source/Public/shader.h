@@ -1,6 +1,9 @@
 #pragma once
 
 #include <glad/glad.h> 
+#include <engine_types.h>
+#include <mat4.h>
+#include <vec3.h>
 
 #include <string>
 #include <fstream>
@@ -8,18 +11,63 @@
 #include <iostream>
 #include <stdexcept>
 
+// Active uniforms are reflected once after linking into a small open-addressed table keyed by name
+// hash. Callers resolve a typed handle once and set through it: no string work or driver lookup per
+// call, and a value equal to the last one set is not sent again.
+
+constexpr uint32 SHADER_MAX_UNIFORMS = 64;
+constexpr uint16 SHADER_UNIFORM_INVALID = 0xFFFF;
+
+struct ShaderUniform {
+	// 0 marks an empty slot.
+	uint64 name_hash;
+	// -1 while the linked program has no such uniform (not declared, or optimised out).
+	GLint location;
+	GLenum type;
+	bool cached;
+	alignas(16) uint8 value[sizeof(mat4)];
+};
+
+template<typename T>
+struct ShaderUniformHandle {
+	uint16 slot = SHADER_UNIFORM_INVALID;
+};
+
 struct shader {
 	const char* vertexPath;
 	const char* fragmentPath;
 	GLuint ID; 
+	ShaderUniform uniforms[SHADER_MAX_UNIFORMS];
 };
 
 bool shader_create(shader* shader);
+// Leaves shader->ID untouched when compiling or linking fails. Goes through program_cache, so a
+// program built before with the same sources on the same driver is loaded instead of compiled.
+// Blocks until the program is ready; shader_build.h builds many programs without blocking.
+bool shader_create_from_source(shader* shader, const char* vertex_code, const char* fragment_code);
 void shader_use(shader* shader);
 
-void shader_set_bool(shader* shader, const std::string& name, bool value);
-void shader_set_int(shader* shader, const std::string& name, int value);
-void shader_set_float(shader* shader, const std::string& name, float value);
+// Refreshes the uniform table from shader->ID. Entries are updated in place, so handles resolved
+// against an older program stay valid across relinks and hot reloads.
+void shader_reflect_uniforms(shader* shader);
+
+// Resolves name once. A uniform the program does not have yet still gets a handle, which starts
+// working if a later relink adds it; setting through it until then does nothing. Returns an invalid
+// handle when the type does not match the declaration or the table is full.
+template<typename T>
+ShaderUniformHandle<T> shader_uniform(shader* shader, const char* name);
+
+// The shader must be in use.
+void shader_set_uniform(shader* shader, ShaderUniformHandle<bool> uniform, bool value);
+void shader_set_uniform(shader* shader, ShaderUniformHandle<int> uniform, int value);
+void shader_set_uniform(shader* shader, ShaderUniformHandle<float> uniform, float value);
+void shader_set_uniform(shader* shader, ShaderUniformHandle<vec3> uniform, const vec3& value);
+void shader_set_uniform(shader* shader, ShaderUniformHandle<mat4> uniform, const mat4& value);
+
+// By-name convenience for setup code; hot paths should keep a handle.
+void shader_set_bool(shader* shader, const char* name, bool value);
+void shader_set_int(shader* shader, const char* name, int value);
+void shader_set_float(shader* shader, const char* name, float value);
 
 
 
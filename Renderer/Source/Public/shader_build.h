@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+
+#include <vector>
+
+struct shader;
+
+// Batched, non-blocking program builds. Submitting issues every compile and link at once without
+// asking GL how they went; any status or log query makes the driver finish that work first, so all
+// of them wait until a build is known to be complete. With GL_KHR_parallel_shader_compile (or the ARB
+// version) completion is polled, and the driver compiles on its own threads across frames; without
+// it, polling finishes each build in turn.
+
+enum ShaderBuildStatus : uint8 {
+	SHADER_BUILD_PENDING,
+	SHADER_BUILD_DONE,
+	SHADER_BUILD_FAILED
+};
+
+struct ShaderBuild {
+	shader* target;
+	GLuint vertex;
+	GLuint fragment;
+	GLuint program;
+	uint64 cache_key;
+	ShaderBuildStatus status;
+};
+
+struct ShaderBuildBatch {
+	std::vector<ShaderBuild> builds{};
+	uint32 pending = 0;
+	uint32 failed = 0;
+};
+
+// Loads from program_cache when possible, otherwise starts compiling and linking. target->ID is set
+// once the build is done and left untouched if it fails; target must stay alive until then.
+void shader_build_submit(ShaderBuildBatch* batch, shader* target, const char* vertex_code, const char* fragment_code);
+
+// Finishes the builds that have completed and returns how many are still pending. Without parallel
+// compile support this finishes them all.
+uint32 shader_build_poll(ShaderBuildBatch* batch);
+
+// Polls until nothing is pending. Returns true when every build succeeded.
+bool shader_build_wait(ShaderBuildBatch* batch);
+
+// Forgets finished builds; pending ones stay.
+void shader_build_clear(ShaderBuildBatch* batch);
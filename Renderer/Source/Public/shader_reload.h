@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "shader.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Rebuilds shader programs on a background thread that owns a hidden GL context shared with the main
+// window, so reading and compiling never block a frame. Finished programs are swapped into their
+// shader by shader_reloader_apply at a frame boundary once a fence shows the build is visible to the
+// main context. A failed build is dropped and the shader keeps its previous program.
+
+struct ShaderReloadJob {
+	shader* target;
+	std::string vertex_path;
+	std::string fragment_path;
+};
+
+struct ShaderReloadResult {
+	shader* target;
+	GLuint program;
+	GLsync fence;
+};
+
+struct ShaderReloader {
+	// Hidden window whose context shares objects with the main one. nullptr when it could not be
+	// created; requests then build on the main thread inside shader_reloader_apply.
+	GLFWwindow* context = nullptr;
+	std::thread thread{};
+
+	std::mutex mutex{};
+	std::condition_variable cv{};
+	std::deque<ShaderReloadJob> jobs{};
+	std::vector<ShaderReloadResult> results{};
+	bool running = false;
+};
+
+// Main thread, with main_window's context current.
+bool shader_reloader_init(ShaderReloader* reloader, GLFWwindow* main_window);
+void shader_reloader_shutdown(ShaderReloader* reloader);
+
+void shader_reloader_request(ShaderReloader* reloader, shader* target, const char* vertex_path, const char* fragment_path);
+
+// Main thread, at a frame boundary. Returns the number of shaders swapped.
+uint32_t shader_reloader_apply(ShaderReloader* reloader);
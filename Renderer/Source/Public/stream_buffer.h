@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <engine_types.h>
+
+#include <deque>
+
+// Ring buffer for data that changes every frame (dynamic vertices, instance data, uniform blocks).
+//
+// With buffer storage the whole ring is mapped once, persistent and coherent, so writing is a plain
+// memcpy. Every frame's region is fenced at stream_buffer_end_frame; allocating over a region the GPU
+// may still be reading waits on its fence, which only happens when the ring is smaller than the
+// frames in flight.
+//
+// Without buffer storage each write maps its range unsynchronised and the buffer is orphaned when the
+// ring wraps, so the driver hands out fresh storage instead of stalling.
+
+struct StreamBufferFence {
+	uint64 begin;
+	uint64 end;
+	GLsync fence;
+};
+
+struct StreamBuffer {
+	GLuint buffer = 0;
+	uint64 capacity = 0;
+	bool persistent = false;
+	uint8* mapped = nullptr;
+
+	uint64 head = 0;
+	// Start of the region written since the last stream_buffer_end_frame.
+	uint64 frame_begin = 0;
+	// Oldest first.
+	std::deque<StreamBufferFence> fences{};
+};
+
+struct StreamAllocation {
+	void* data;
+	GLuint buffer;
+	// Byte offset of data in buffer: a vertex attribute offset or a glBindBufferRange offset.
+	uint64 offset;
+};
+
+// Usable as any buffer type; bind allocation.buffer wherever the data is consumed.
+bool stream_buffer_create(StreamBuffer* stream, uint64 capacity);
+void stream_buffer_destroy(StreamBuffer* stream);
+
+// Reserves size bytes at a multiple of alignment (e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT) and returns
+// where to write them. The pointer is valid until stream_buffer_unmap, which must come before the data
+// is drawn from.
+bool stream_buffer_map(StreamBuffer* stream, uint64 size, uint64 alignment, StreamAllocation* allocation);
+void stream_buffer_unmap(StreamBuffer* stream);
+
+// stream_buffer_map + memcpy + stream_buffer_unmap.
+bool stream_buffer_write(StreamBuffer* stream, const void* data, uint64 size, uint64 alignment, StreamAllocation* allocation);
+
+// Fences everything written this frame. Call once per frame after the draws that read it.
+void stream_buffer_end_frame(StreamBuffer* stream);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "texture_format.h"
+
+struct Texture {
+	GLuint id = 0;
+	TextureFormat format = TEXTURE_FORMAT_RGBA8;
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 mip_count = 0;
+};
+
+// Creates a 2D texture from a cooked .htex file in memory. Levels are passed to the driver exactly as
+// stored, so data can point straight into a mapped file or pack entry.
+bool texture_create(Texture* texture, const void* htex_data, uint64 size);
+// Same, but level offsets in mips are byte offsets into the currently bound GL_PIXEL_UNPACK_BUFFER,
+// so the driver copies buffer-to-texture without touching client memory. A single-level texture
+// gets its chain from glGenerateMipmap when generate_mips is set.
+bool texture_create_from_unpack_buffer(Texture* texture, const HtexHeader* header, const HtexMip* mips, bool generate_mips);
+void texture_bind(const Texture* texture, uint32 unit);
+void texture_destroy(Texture* texture);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "texture.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Staging for asynchronous texture uploads. Each slot is a pixel-unpack buffer that the GL thread
+// keeps mapped while it is idle. Worker threads claim a mapped slot and decode or copy straight into
+// it. The GL thread then unmaps it and issues a buffer-to-texture copy, which the driver can DMA
+// without stalling on client memory. A fence marks when the copy has consumed the buffer, after which
+// the slot is mapped again and handed back.
+//
+// GL 3.3 has no persistent mapping, so a slot is never mapped while a copy out of it is in flight.
+
+struct TextureUploadSlot {
+	GLuint buffer = 0;
+	uint64 capacity = 0;
+	uint8* mapped = nullptr;
+	GLsync fence = nullptr;
+};
+
+struct TextureUploader {
+	std::vector<TextureUploadSlot> slots{};
+
+	std::mutex mutex{};
+	std::condition_variable slot_cv{};
+	// Mapped and unclaimed. Guarded by mutex.
+	std::vector<uint32> free_slots{};
+	bool running = false;
+
+	// Copies issued but not yet fenced off. GL thread only.
+	std::vector<uint32> in_flight{};
+};
+
+// GL thread.
+bool texture_uploader_init(TextureUploader* uploader, uint32 slot_count, uint64 slot_size);
+// Wakes workers blocked in texture_uploader_acquire and makes further acquires fail. Call before
+// shutting down the threads that acquire slots, then call texture_uploader_shutdown.
+void texture_uploader_stop(TextureUploader* uploader);
+// GL thread, once no other thread can touch a slot.
+void texture_uploader_shutdown(TextureUploader* uploader);
+
+// Any thread. Blocks until a mapped slot is free. Returns nullptr when size exceeds the slot size or
+// the uploader is stopping.
+TextureUploadSlot* texture_uploader_acquire(TextureUploader* uploader, uint64 size);
+// Returns a claimed slot that will not be uploaded. It stays mapped.
+void texture_uploader_release(TextureUploader* uploader, TextureUploadSlot* slot);
+
+// GL thread. Creates texture from the slot contents, described by header and mips with offsets into
+// the slot, and fences the copy. The slot returns to the free list once the fence has passed.
+bool texture_uploader_upload(TextureUploader* uploader, TextureUploadSlot* slot, Texture* texture,
+	const HtexHeader* header, const HtexMip* mips, bool generate_mips);
+
+// GL thread, once per frame. Re-maps slots whose copies have completed.
+void texture_uploader_update(TextureUploader* uploader);
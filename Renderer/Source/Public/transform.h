@@ -0,0 +1,78 @@
+#pragma once
+
+#include <engine_types.h>
+#include <vec3.h>
+#include <quat.h>
+#include <mat4.h>
+
+#include <vector>
+
+struct JobSystem;
+
+// Transforms are a local translation, rotation and scale under an optional parent, behind stable ids.
+// Local values are stored as one array per component and sorted breadth first, so every parent comes
+// before its children and each depth level is one contiguous range. Setting a local value only marks
+// the transform dirty; transform_update walks the arrays once from the first dirty entry, recomputes
+// world matrices four at a time for dirty transforms and everything below them, and skips the rest.
+// A hierarchy with nothing dirty costs nothing to update. Transforms of one level never depend on each
+// other, so each level is split across the job system.
+//
+// Creating a transform deeper than the last one, reparenting and destroying reorder the arrays at the
+// next transform_update. Indices move then; ids do not.
+
+constexpr uint32 TRANSFORM_NONE = 0xFFFFFFFF;
+// Levels are split into batches of this many transforms; a multiple of the SIMD width.
+constexpr uint32 TRANSFORM_UPDATE_BATCH = 256;
+
+struct TransformStats {
+	uint32 updates;
+	uint32 reorders;
+	// World matrices recomputed by the last update.
+	uint32 recomputed;
+};
+
+struct TransformHierarchy {
+	// Indexed by position in breadth-first order. The component arrays carry a few entries of padding
+	// past count so a group of four can always be loaded whole.
+	std::vector<uint32> parent{};
+	std::vector<uint32> depth{};
+	std::vector<float> position_x{}, position_y{}, position_z{};
+	std::vector<float> rotation_x{}, rotation_y{}, rotation_z{}, rotation_w{};
+	std::vector<float> scale_x{}, scale_y{}, scale_z{};
+	std::vector<uint8> flags{};
+	std::vector<mat4> world{};
+	std::vector<uint32> ids{};
+	uint32 count = 0;
+
+	// Start of each depth level in breadth-first order.
+	std::vector<uint32> levels{};
+
+	// Indexed by id; TRANSFORM_NONE for free ids. Destroyed ids are reused.
+	std::vector<uint32> index{};
+	std::vector<uint32> free_ids{};
+
+	// Lowest dirty index, or count when nothing is dirty.
+	uint32 first_dirty = 0;
+	bool order_changed = false;
+	TransformStats stats{};
+};
+
+// Starts at the identity. parent is TRANSFORM_NONE for a root.
+uint32 transform_create(TransformHierarchy* hierarchy, uint32 parent = TRANSFORM_NONE);
+// Destroys the transform and everything below it at the next transform_update.
+void transform_destroy(TransformHierarchy* hierarchy, uint32 transform);
+// Keeps the local values, so the world matrix changes with the new parent.
+void transform_set_parent(TransformHierarchy* hierarchy, uint32 transform, uint32 parent);
+
+void transform_set_local(TransformHierarchy* hierarchy, uint32 transform, const vec3& position, const quat& rotation, const vec3& scale);
+void transform_set_position(TransformHierarchy* hierarchy, uint32 transform, const vec3& position);
+void transform_set_rotation(TransformHierarchy* hierarchy, uint32 transform, const quat& rotation);
+void transform_set_scale(TransformHierarchy* hierarchy, uint32 transform, const vec3& scale);
+
+uint32 transform_parent(const TransformHierarchy* hierarchy, uint32 transform);
+// As of the last transform_update.
+const mat4& transform_world(const TransformHierarchy* hierarchy, uint32 transform);
+
+// Recomputes the world matrices of dirty transforms and their descendants. jobs may be nullptr to
+// update on the calling thread.
+void transform_update(TransformHierarchy* hierarchy, JobSystem* jobs = nullptr);
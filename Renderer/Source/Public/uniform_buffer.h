@@ -1,5 +1,106 @@
 #pragma once 
 
 #include <glad/glad.h>
+#include <engine_types.h>
+#include <mat4.h>
+#include <vec3.h>
+
+#include <cstddef>
 #include <iostream>
 
+struct StreamBuffer;
+struct StreamAllocation;
+
+// Uniform blocks shared by every program. Each block has a fixed binding point; programs are
+// pointed at them when they are linked (uniform_buffer_bind_blocks), so block data is uploaded once
+// and seen by every shader that declares it.
+//
+// The structs below mirror std140 blocks declared in GLSL under the same names. std140 aligns vec3
+// and vec4 to 16 bytes, so every vec3 is followed by a float that shares its slot; the static_asserts
+// catch any member that drifts from its GLSL offset.
+
+enum UniformBinding : GLuint {
+	// Camera and lighting; written once per frame.
+	UNIFORM_BINDING_FRAME,
+	// Render target dimensions and clip planes; written once per pass.
+	UNIFORM_BINDING_PASS,
+	// Object transform and tint; written per draw.
+	UNIFORM_BINDING_DRAW,
+	UNIFORM_BINDING_COUNT
+};
+
+// GLSL block names, indexed by UniformBinding.
+inline constexpr const char* UNIFORM_BLOCK_NAMES[UNIFORM_BINDING_COUNT] = { "FrameData", "PassData", "DrawData" };
+
+struct FrameUniforms {
+	mat4 view;
+	mat4 projection;
+	mat4 view_projection;
+	vec3 camera_position;
+	float time;
+	vec3 light_direction;
+	float light_intensity;
+	vec3 light_color;
+	float padding0;
+};
+
+struct PassUniforms {
+	// x, y, width, height in pixels.
+	float viewport[4];
+	float inverse_size[2];
+	float near_plane;
+	float far_plane;
+};
+
+struct DrawUniforms {
+	mat4 model;
+	vec3 tint;
+	float alpha;
+};
+
+#define UNIFORM_STD140_OFFSET(type, member, offset) \
+	static_assert(offsetof(type, member) == (offset), #type "::" #member " does not match its std140 offset")
+
+UNIFORM_STD140_OFFSET(FrameUniforms, view, 0);
+UNIFORM_STD140_OFFSET(FrameUniforms, projection, 64);
+UNIFORM_STD140_OFFSET(FrameUniforms, view_projection, 128);
+UNIFORM_STD140_OFFSET(FrameUniforms, camera_position, 192);
+UNIFORM_STD140_OFFSET(FrameUniforms, time, 204);
+UNIFORM_STD140_OFFSET(FrameUniforms, light_direction, 208);
+UNIFORM_STD140_OFFSET(FrameUniforms, light_intensity, 220);
+UNIFORM_STD140_OFFSET(FrameUniforms, light_color, 224);
+static_assert(sizeof(FrameUniforms) == 240, "FrameUniforms does not match its std140 size");
+
+UNIFORM_STD140_OFFSET(PassUniforms, viewport, 0);
+UNIFORM_STD140_OFFSET(PassUniforms, inverse_size, 16);
+UNIFORM_STD140_OFFSET(PassUniforms, near_plane, 24);
+UNIFORM_STD140_OFFSET(PassUniforms, far_plane, 28);
+static_assert(sizeof(PassUniforms) == 32, "PassUniforms does not match its std140 size");
+
+UNIFORM_STD140_OFFSET(DrawUniforms, model, 0);
+UNIFORM_STD140_OFFSET(DrawUniforms, tint, 64);
+UNIFORM_STD140_OFFSET(DrawUniforms, alpha, 76);
+static_assert(sizeof(DrawUniforms) == 80, "DrawUniforms does not match its std140 size");
+
+// Points every block of program that matches a name in UNIFORM_BLOCK_NAMES at its binding.
+void uniform_buffer_bind_blocks(GLuint program);
+
+// Copies data into the stream at GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT without binding it, for callers
+// that bind later (a RenderBindUniformsPacket).
+bool uniform_buffer_write(StreamBuffer* stream, const void* data, uint64 size, StreamAllocation* allocation);
+
+// Copies data into the stream at GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT and binds that range to binding.
+// The data stays valid until the stream's frame fence retires, so it can be drawn with straight away.
+bool uniform_buffer_push(StreamBuffer* stream, UniformBinding binding, const void* data, uint64 size);
+
+template<typename T>
+bool uniform_buffer_write(StreamBuffer* stream, const T& block, StreamAllocation* allocation)
+{
+	return uniform_buffer_write(stream, &block, sizeof(T), allocation);
+}
+
+template<typename T>
+bool uniform_buffer_push(StreamBuffer* stream, UniformBinding binding, const T& block)
+{
+	return uniform_buffer_push(stream, binding, &block, sizeof(T));
+}
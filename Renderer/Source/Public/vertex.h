@@ -1,9 +1,39 @@
 #pragma once
 
 #include <vec3.h>
+#include <mat4.h>
+
+#include "vertex_array.h"
+
+#include <cstddef>
 
 struct Vertex
 {
 	vec3 positions;
 };
 
+// Per-instance data read by shader.vert. The model matrix takes four locations, one per column.
+struct InstanceData
+{
+	mat4 model;
+	float color[4];
+};
+
+static_assert(sizeof(InstanceData) == 80, "InstanceData must match the instance attribute layout");
+
+inline constexpr GLuint VERTEX_LOCATION_POSITION = 0;
+
+inline constexpr VertexAttribute VERTEX_ATTRIBUTES[] = {
+	{ VERTEX_LOCATION_POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, positions) },
+};
+
+inline constexpr GLuint INSTANCE_LOCATION_MODEL = 1;
+inline constexpr GLuint INSTANCE_LOCATION_COLOR = 5;
+
+inline constexpr VertexAttribute INSTANCE_DATA_ATTRIBUTES[] = {
+	{ INSTANCE_LOCATION_MODEL + 0, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, model) + 0 * sizeof(float) * 4 },
+	{ INSTANCE_LOCATION_MODEL + 1, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, model) + 1 * sizeof(float) * 4 },
+	{ INSTANCE_LOCATION_MODEL + 2, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, model) + 2 * sizeof(float) * 4 },
+	{ INSTANCE_LOCATION_MODEL + 3, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, model) + 3 * sizeof(float) * 4 },
+	{ INSTANCE_LOCATION_COLOR, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, color) },
+};
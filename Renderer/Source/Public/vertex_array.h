@@ -1,10 +1,43 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <engine_types.h>
+
+constexpr uint32 VERTEX_ARRAY_MAX_INSTANCE_ATTRIBUTES = 8;
+
+// One vertex or instance attribute. Float, or normalised integer when normalized is set; a mat4 is four
+// vec4 attributes on consecutive locations.
+struct VertexAttribute {
+	GLuint location;
+	GLint components;
+	GLenum type;
+	GLboolean normalized;
+	uint32 offset;
+};
 
 struct VertexArray {
 	GLuint vertex_array_object;
+
+	// Instance data lives in a per-frame buffer whose offset changes every frame, so the attribute
+	// pointers are set at draw time by vertex_array_bind_instances rather than once at setup.
+	VertexAttribute instance_attributes[VERTEX_ARRAY_MAX_INSTANCE_ATTRIBUTES];
+	uint32 instance_attribute_count;
+	uint32 instance_stride;
+	// Where the instance attributes point now.
+	GLuint instance_buffer;
+	uint64 instance_offset;
 };
 
 void create_vertex_array_object(VertexArray* vertex_array);
-void bind_vertex_array(VertexArray* vertex_array);
\ No newline at end of file
+void bind_vertex_array(VertexArray* vertex_array);
+
+// Points per-vertex attributes at buffer. Their pointers are fixed, so this happens once at setup.
+void vertex_array_set_vertex_layout(VertexArray* vertex_array, GLuint buffer, const VertexAttribute* attributes, uint32 count, uint32 stride);
+
+// Per-instance attributes advance once per instance (divisor 1). Enables them and sets their divisor;
+// stride is the size of one instance.
+void vertex_array_set_instance_layout(VertexArray* vertex_array, const VertexAttribute* attributes, uint32 count, uint32 stride);
+
+// Binds the vertex array and points its instance attributes at offset in buffer; nothing is re-specified
+// when they already point there.
+void vertex_array_bind_instances(VertexArray* vertex_array, GLuint buffer, uint64 offset);
@@ -0,0 +1,226 @@
+#include "cook_graph.h"
+#include "job_system.h"
+#include "mesh_cook.h"
+#include "texture_cook.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void print_usage()
+{
+	std::cout << "usage: AssetCooker <source directory> <output directory> [options]\n"
+		<< "  --cache <directory>  cooked data cache (default <output directory>.cache)\n"
+		<< "  --threads <count>    worker threads (default: one per core)\n"
+		<< "  --force              cook everything even when the cache already holds it\n";
+}
+
+bool read_file(const fs::path& path, std::vector<uint8>* bytes)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	const std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	bytes->resize(static_cast<std::size_t>(size));
+	return size == 0 || file.read(reinterpret_cast<char*>(bytes->data()), size).good();
+}
+
+// Writes beside the destination and renames, so a cache entry is either complete or absent.
+bool write_atomic(const fs::path& path, const std::vector<uint8>& bytes)
+{
+	std::error_code error;
+	fs::create_directories(path.parent_path(), error);
+
+	const fs::path temporary = fs::path(path).concat(".tmp");
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file || !file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+			return false;
+		}
+	}
+	fs::rename(temporary, path, error);
+	return !error;
+}
+
+struct CookJob {
+	CookGraph* graph = nullptr;
+	JobSystem* jobs = nullptr;
+	fs::path cache_root{};
+	std::vector<uint32> nodes{};
+	std::vector<uint8> succeeded{};
+	std::mutex log_mutex{};
+};
+
+void cook_nodes(void* user_data, uint32 begin, uint32 end)
+{
+	CookJob* job = static_cast<CookJob*>(user_data);
+
+	for (uint32 i = begin; i < end; ++i) {
+		const CookNode& node = job->graph->nodes[job->nodes[i]];
+		const fs::path source = job->graph->source_root / node.path;
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<uint8> output;
+		bool success = false;
+		if (node.kind == COOK_KIND_TEXTURE) {
+			std::vector<uint8> bytes;
+			success = read_file(source, &bytes)
+				&& texture_cook(job->jobs, bytes.data(), bytes.size(), &node.texture, &output);
+		}
+		else if (node.kind == COOK_KIND_MESH) {
+			success = mesh_cook(source.string().c_str(), node.key, &output);
+		}
+
+		success = success && write_atomic(cook_cache_path(job->cache_root, node.key), output);
+		job->succeeded[i] = success;
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::lock_guard lock(job->log_mutex);
+		if (success) {
+			std::cout << "Cooked " << node.path << " in " << seconds << "s" << std::endl;
+		}
+		else {
+			std::cout << "ERROR::ASSET_COOKER::COOK_FAILED " << node.path << std::endl;
+		}
+	}
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		print_usage();
+		return EXIT_FAILURE;
+	}
+
+	const fs::path source_root = argv[1];
+	const fs::path output_root = argv[2];
+	fs::path cache_root = fs::path(argv[2]).concat(".cache");
+	uint32 thread_count = 0;
+	bool force = false;
+
+	for (int i = 3; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--cache" && i + 1 < argc) {
+			cache_root = argv[++i];
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			thread_count = static_cast<uint32>(std::stoul(argv[++i]));
+		}
+		else if (arg == "--force") {
+			force = true;
+		}
+		else {
+			print_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!fs::is_directory(source_root)) {
+		std::cout << "ERROR::ASSET_COOKER::NOT_A_DIRECTORY " << source_root << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const fs::path state_path = cache_root / "cook_state.txt";
+
+	JobSystem jobs{};
+	job_system_init(&jobs, thread_count);
+
+	CookState previous{};
+	cook_state_load(&previous, state_path);
+
+	CookGraph graph{};
+	cook_graph_scan(&graph, source_root);
+	uint32 rehashed = 0;
+	if (!cook_graph_hash(&graph, &jobs, &previous, &rehashed)) {
+		job_system_shutdown(&jobs);
+		return EXIT_FAILURE;
+	}
+	cook_graph_resolve(&graph);
+
+	// Identical inputs share a key; cook each key once.
+	CookJob cook{};
+	cook.graph = &graph;
+	cook.jobs = &jobs;
+	cook.cache_root = cache_root;
+	std::unordered_set<uint64> queued;
+	for (uint32 i = 0; i < graph.nodes.size(); ++i) {
+		const CookNode& node = graph.nodes[i];
+		if (node.kind != COOK_KIND_TEXTURE && node.kind != COOK_KIND_MESH) {
+			continue;
+		}
+		if ((force || !fs::exists(cook_cache_path(cache_root, node.key))) && queued.insert(node.key).second) {
+			cook.nodes.push_back(i);
+		}
+	}
+	cook.succeeded.assign(cook.nodes.size(), 0);
+
+	// One node per batch: cooks vary from microseconds to seconds, and texture cooks fan out over
+	// the same workers themselves.
+	job_system_parallel_for(&jobs, static_cast<uint32>(cook.nodes.size()), 1, cook_nodes, &cook);
+	job_system_shutdown(&jobs);
+
+	uint32 failed = 0;
+	for (uint8 success : cook.succeeded) {
+		failed += success ? 0 : 1;
+	}
+
+	// Bring the output tree in line with the graph. Outputs whose cook failed keep their old file.
+	CookState state{};
+	uint32 written = 0;
+	for (const CookNode& node : graph.nodes) {
+		state.sources[node.path] = node.record;
+		if (node.output.empty()) {
+			continue;
+		}
+
+		const fs::path cooked = node.kind == COOK_KIND_COPY ? source_root / node.path : cook_cache_path(cache_root, node.key);
+		const fs::path destination = output_root / node.output;
+		const auto last = previous.outputs.find(node.output);
+		const bool current = last != previous.outputs.end() && last->second == node.key && fs::exists(destination);
+
+		if (!current) {
+			std::error_code error;
+			fs::create_directories(destination.parent_path(), error);
+			if (!fs::exists(cooked) || !fs::copy_file(cooked, destination, fs::copy_options::overwrite_existing, error)) {
+				if (last != previous.outputs.end()) {
+					state.outputs[node.output] = last->second;
+				}
+				continue;
+			}
+			written++;
+		}
+		state.outputs[node.output] = node.key;
+	}
+
+	uint32 removed = 0;
+	for (const auto& [output, key] : previous.outputs) {
+		if (state.outputs.find(output) == state.outputs.end()) {
+			std::error_code error;
+			removed += fs::remove(output_root / output, error) ? 1 : 0;
+		}
+	}
+
+	std::error_code error;
+	fs::create_directories(cache_root, error);
+	cook_state_save(&state, state_path);
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << graph.nodes.size() << " files, " << rehashed << " rehashed, " << cook.nodes.size() - failed << " cooked, "
+		<< failed << " failed, " << written << " outputs written, " << removed << " removed in " << seconds << "s" << std::endl;
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,398 @@
+#include "cook_graph.h"
+#include "engine_hash.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string lower_extension(const fs::path& path)
+{
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return extension;
+}
+
+void classify(CookNode* node)
+{
+	static const char* const texture_extensions[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".gif", ".hdr" };
+
+	const fs::path path = node->path;
+	const std::string extension = lower_extension(path);
+
+	if (extension == ".obj") {
+		node->kind = COOK_KIND_MESH;
+		node->output = fs::path(path).replace_extension(".hmsh").generic_string();
+		return;
+	}
+	if (extension == ".mtl") {
+		node->kind = COOK_KIND_DEPENDENCY;
+		return;
+	}
+	for (const char* texture_extension : texture_extensions) {
+		if (extension == texture_extension) {
+			node->kind = COOK_KIND_TEXTURE;
+			node->output = fs::path(path).replace_extension(".htex").generic_string();
+			return;
+		}
+	}
+	node->kind = COOK_KIND_COPY;
+	node->output = node->path;
+}
+
+std::string_view trim(std::string_view text)
+{
+	while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+	while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+	return text;
+}
+
+// References in OBJ and MTL files are relative to the referencing file.
+std::string resolve(const std::string& referrer, std::string_view name)
+{
+	std::string file(name);
+	std::replace(file.begin(), file.end(), '\\', '/');
+	return (fs::path(referrer).parent_path() / file).lexically_normal().generic_string();
+}
+
+CookUsage material_usage(std::string_view keyword)
+{
+	if (keyword == "map_Kd" || keyword == "map_Ka" || keyword == "map_Ks" || keyword == "map_Ke") {
+		return COOK_USAGE_COLOR;
+	}
+	if (keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump" || keyword == "norm" || keyword == "map_Kn") {
+		return COOK_USAGE_NORMAL;
+	}
+	if (keyword.substr(0, 4) == "map_" || keyword == "disp" || keyword == "refl") {
+		return COOK_USAGE_DATA;
+	}
+	return COOK_USAGE_NONE;
+}
+
+// mtllib lines of an OBJ, texture maps of an MTL. Texture statements may carry options
+// ("map_Kd -s 2 2 1 rock.png"); the file name is the last token.
+void parse_references(const CookNode& node, const std::vector<char>& bytes, std::vector<CookReference>* references)
+{
+	const bool is_mesh = node.kind == COOK_KIND_MESH;
+	std::string_view text(bytes.data(), bytes.size());
+
+	while (!text.empty()) {
+		const std::size_t end = text.find('\n');
+		const std::string_view line = trim(text.substr(0, end));
+		text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+		const std::size_t split = line.find_first_of(" \t");
+		if (split == std::string_view::npos) {
+			continue;
+		}
+		const std::string_view keyword = line.substr(0, split);
+		const std::string_view arguments = trim(line.substr(split));
+
+		if (is_mesh) {
+			if (keyword != "mtllib") {
+				continue;
+			}
+			std::istringstream names{ std::string(arguments) };
+			std::string name;
+			while (names >> name) {
+				references->push_back({ COOK_USAGE_LIBRARY, resolve(node.path, name) });
+			}
+		}
+		else {
+			const CookUsage usage = material_usage(keyword);
+			if (usage == COOK_USAGE_NONE) {
+				continue;
+			}
+			const std::size_t last = arguments.find_last_of(" \t");
+			const std::string_view name = last == std::string_view::npos ? arguments : arguments.substr(last + 1);
+			references->push_back({ usage, resolve(node.path, name) });
+		}
+	}
+}
+
+bool read_file(const fs::path& path, std::vector<char>* bytes)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	const std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	bytes->resize(static_cast<std::size_t>(size));
+	return size == 0 || file.read(bytes->data(), size).good();
+}
+
+enum HashFailure : uint8 {
+	HASH_OK,
+	HASH_STAT_FAILED,
+	HASH_READ_FAILED
+};
+
+struct HashJob {
+	CookGraph* graph;
+	const CookState* previous;
+	std::atomic<uint32> rehashed{ 0 };
+	// One per node, written by whichever worker hashes it and printed once they are all done, so
+	// the messages don't interleave.
+	std::vector<HashFailure> failures{};
+};
+
+void hash_nodes(void* user_data, uint32 begin, uint32 end)
+{
+	HashJob* job = static_cast<HashJob*>(user_data);
+	thread_local std::vector<char> bytes;
+
+	for (uint32 i = begin; i < end; ++i) {
+		CookNode& node = job->graph->nodes[i];
+		const fs::path source = job->graph->source_root / node.path;
+
+		// Each call resets error, so it is checked after both.
+		std::error_code error;
+		const uint64 size = fs::file_size(source, error);
+		if (error) {
+			job->failures[i] = HASH_STAT_FAILED;
+			continue;
+		}
+		const int64 write_time = static_cast<int64>(fs::last_write_time(source, error).time_since_epoch().count());
+		if (error) {
+			job->failures[i] = HASH_STAT_FAILED;
+			continue;
+		}
+
+		const auto cached = job->previous->sources.find(node.path);
+		if (cached != job->previous->sources.end() && cached->second.size == size && cached->second.write_time == write_time) {
+			node.record = cached->second;
+			continue;
+		}
+
+		if (!read_file(source, &bytes)) {
+			job->failures[i] = HASH_READ_FAILED;
+			continue;
+		}
+
+		node.record.size = size;
+		node.record.write_time = write_time;
+		node.record.content_hash = hash_bytes(bytes.data(), bytes.size());
+		node.record.references.clear();
+		if (node.kind == COOK_KIND_MESH || node.kind == COOK_KIND_DEPENDENCY) {
+			parse_references(node, bytes, &node.record.references);
+		}
+		job->rehashed.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+const CookNode* find_node(const CookGraph* graph, const std::string& path)
+{
+	const auto found = graph->lookup.find(hash_path(path.c_str(), path.size()));
+	return found == graph->lookup.end() ? nullptr : &graph->nodes[found->second];
+}
+
+void apply_usage(CookNode* texture, CookUsage usage, const std::string& referrer)
+{
+	if (texture->usage != COOK_USAGE_NONE) {
+		if (texture->usage != usage) {
+			std::cout << "Asset cooker: " << texture->path << " is used with conflicting settings (" << referrer
+				<< "); keeping the first" << std::endl;
+		}
+		return;
+	}
+
+	texture->usage = usage;
+	if (usage == COOK_USAGE_NORMAL) {
+		texture->texture.format = TEXTURE_FORMAT_BC5;
+		texture->texture.srgb = false;
+	}
+	else if (usage == COOK_USAGE_DATA) {
+		texture->texture.srgb = false;
+	}
+}
+
+uint64 compute_key(CookGraph* graph, uint32 index)
+{
+	CookNode& node = graph->nodes[index];
+	if (node.hashed) {
+		return node.key;
+	}
+	// Marked before recursing so a reference cycle terminates instead of overflowing the stack.
+	node.hashed = true;
+
+	const uint32 header[3] = { COOK_VERSION, node.kind, static_cast<uint32>(node.texture.format) };
+	uint64 key = hash_bytes(header, sizeof(header));
+	key = hash_bytes(&node.record.content_hash, sizeof(node.record.content_hash), key);
+	if (node.kind == COOK_KIND_TEXTURE) {
+		const uint8 settings[3] = { node.texture.srgb, node.texture.generate_mips, static_cast<uint8>(node.texture.mip_filter) };
+		key = hash_bytes(settings, sizeof(settings), key);
+	}
+	for (uint32 dependency : node.dependencies) {
+		const uint64 dependency_key = compute_key(graph, dependency);
+		key = hash_bytes(&dependency_key, sizeof(dependency_key), key);
+	}
+
+	node.key = key;
+	return key;
+}
+
+} // namespace
+
+bool cook_state_load(CookState* state, const fs::path& path)
+{
+	state->sources.clear();
+	state->outputs.clear();
+
+	std::ifstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	// S <size> <write time> <content hash> <path>
+	//   R <usage> <path>          one per reference of the preceding source
+	// O <key> <output path>
+	CookSourceRecord* current = nullptr;
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		std::string tag;
+		fields >> tag;
+
+		if (tag == "S") {
+			CookSourceRecord record{};
+			std::string name;
+			fields >> record.size >> record.write_time >> std::hex >> record.content_hash >> std::ws;
+			std::getline(fields, name);
+			current = &(state->sources[name] = record);
+		}
+		else if (tag == "R" && current) {
+			char usage = COOK_USAGE_NONE;
+			std::string name;
+			fields >> usage >> std::ws;
+			std::getline(fields, name);
+			current->references.push_back({ static_cast<CookUsage>(usage), name });
+		}
+		else if (tag == "O") {
+			uint64 key = 0;
+			std::string name;
+			fields >> std::hex >> key >> std::ws;
+			std::getline(fields, name);
+			state->outputs[name] = key;
+		}
+	}
+	return true;
+}
+
+bool cook_state_save(const CookState* state, const fs::path& path)
+{
+	// Written next to the real file and renamed over it, so an interrupted run leaves the old state.
+	const fs::path temporary = fs::path(path).concat(".tmp");
+	{
+		std::ofstream file(temporary, std::ios::trunc);
+		if (!file) {
+			std::cout << "ERROR::ASSET_COOKER::STATE_WRITE_FAILED " << path << std::endl;
+			return false;
+		}
+
+		for (const auto& [name, record] : state->sources) {
+			file << "S " << record.size << ' ' << record.write_time << ' ' << std::hex << record.content_hash << std::dec
+				<< ' ' << name << '\n';
+			for (const CookReference& reference : record.references) {
+				file << "R " << static_cast<char>(reference.usage) << ' ' << reference.path << '\n';
+			}
+		}
+		for (const auto& [name, key] : state->outputs) {
+			file << "O " << std::hex << key << std::dec << ' ' << name << '\n';
+		}
+		if (!file.flush()) {
+			return false;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(temporary, path, error);
+	return !error;
+}
+
+void cook_graph_scan(CookGraph* graph, const fs::path& source_root)
+{
+	graph->source_root = source_root;
+	graph->nodes.clear();
+	graph->lookup.clear();
+
+	std::vector<std::string> paths;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(source_root)) {
+		if (entry.is_regular_file()) {
+			paths.push_back(fs::relative(entry.path(), source_root).generic_string());
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+
+	graph->nodes.resize(paths.size());
+	for (uint32 i = 0; i < paths.size(); ++i) {
+		CookNode& node = graph->nodes[i];
+		node.path = std::move(paths[i]);
+		classify(&node);
+		graph->lookup[hash_path(node.path.c_str(), node.path.size())] = i;
+	}
+}
+
+bool cook_graph_hash(CookGraph* graph, JobSystem* jobs, const CookState* previous, uint32* rehashed)
+{
+	HashJob job{ graph, previous };
+	job.failures.assign(graph->nodes.size(), HASH_OK);
+	job_system_parallel_for(jobs, static_cast<uint32>(graph->nodes.size()), 16, hash_nodes, &job);
+	if (rehashed) {
+		*rehashed = job.rehashed.load();
+	}
+
+	bool ok = true;
+	for (std::size_t i = 0; i < graph->nodes.size(); ++i) {
+		if (job.failures[i] == HASH_OK) {
+			continue;
+		}
+		const fs::path source = graph->source_root / graph->nodes[i].path;
+		std::cout << (job.failures[i] == HASH_STAT_FAILED ? "ERROR::ASSET_COOKER::STAT_FAILED " : "ERROR::ASSET_COOKER::READ_FAILED ")
+			<< source << std::endl;
+		ok = false;
+	}
+	return ok;
+}
+
+void cook_graph_resolve(CookGraph* graph)
+{
+	for (CookNode& node : graph->nodes) {
+		for (const CookReference& reference : node.record.references) {
+			const CookNode* target = find_node(graph, reference.path);
+			if (!target) {
+				std::cout << "Asset cooker: " << node.path << " references missing file " << reference.path << std::endl;
+				continue;
+			}
+
+			const uint32 index = static_cast<uint32>(target - graph->nodes.data());
+			if (reference.usage == COOK_USAGE_LIBRARY) {
+				node.dependencies.push_back(index);
+			}
+			else if (graph->nodes[index].kind == COOK_KIND_TEXTURE) {
+				apply_usage(&graph->nodes[index], reference.usage, node.path);
+			}
+		}
+	}
+
+	for (uint32 i = 0; i < graph->nodes.size(); ++i) {
+		compute_key(graph, i);
+	}
+}
+
+fs::path cook_cache_path(const fs::path& cache_root, uint64 key)
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+	return cache_root / std::string(name, 2) / (name + 2);
+}
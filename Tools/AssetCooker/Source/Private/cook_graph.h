@@ -0,0 +1,95 @@
+#pragma once
+
+#include "engine_types.h"
+#include "texture_cook.h"
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct JobSystem;
+
+// The cooker's view of a source tree. Every file is a node; OBJ files reference their .mtl libraries
+// and materials reference textures. A node's key hashes its own content, its cook settings and the
+// keys of every file its cook reads, so a key that is already in the cache never has to be cooked
+// again, and editing a material re-cooks exactly the meshes that use it.
+
+// Bump whenever the cooker produces different output for the same inputs.
+constexpr uint32 COOK_VERSION = 1;
+
+enum CookKind : uint32 {
+	// Read by other cooks (.mtl) but not emitted on its own.
+	COOK_KIND_DEPENDENCY,
+	// Emitted unchanged.
+	COOK_KIND_COPY,
+	COOK_KIND_TEXTURE,
+	COOK_KIND_MESH
+};
+
+enum CookUsage : char {
+	COOK_USAGE_NONE = '-',
+	// mtllib: the referencing cook reads the file.
+	COOK_USAGE_LIBRARY = 'l',
+	COOK_USAGE_COLOR = 'c',
+	COOK_USAGE_NORMAL = 'n',
+	COOK_USAGE_DATA = 'd'
+};
+
+struct CookReference {
+	CookUsage usage;
+	// Relative to the source root, '/'-separated.
+	std::string path;
+};
+
+// What the previous run knew about a source file. A file whose size and write time still match is
+// not read again.
+struct CookSourceRecord {
+	uint64 size = 0;
+	int64 write_time = 0;
+	uint64 content_hash = 0;
+	std::vector<CookReference> references{};
+};
+
+struct CookState {
+	std::unordered_map<std::string, CookSourceRecord> sources{};
+	// Output path -> key of the cook it was last written from.
+	std::unordered_map<std::string, uint64> outputs{};
+};
+
+struct CookNode {
+	std::string path{};
+	std::string output{};
+	CookKind kind = COOK_KIND_COPY;
+	CookUsage usage = COOK_USAGE_NONE;
+	TextureCookSettings texture{};
+
+	CookSourceRecord record{};
+	// Nodes whose content this node's cook reads.
+	std::vector<uint32> dependencies{};
+	uint64 key = 0;
+	bool hashed = false;
+};
+
+struct CookGraph {
+	std::filesystem::path source_root{};
+	std::vector<CookNode> nodes{};
+	// hash_path(node.path) -> node index.
+	std::unordered_map<uint64, uint32> lookup{};
+};
+
+bool cook_state_load(CookState* state, const std::filesystem::path& path);
+bool cook_state_save(const CookState* state, const std::filesystem::path& path);
+
+void cook_graph_scan(CookGraph* graph, const std::filesystem::path& source_root);
+
+// Fills every node's record, rereading only files that changed since previous. Returns false when a
+// file could not be read. rehashed, when given, counts the files that were read.
+bool cook_graph_hash(CookGraph* graph, JobSystem* jobs, const CookState* previous, uint32* rehashed);
+
+// Links references into dependencies, derives texture settings from how materials use each texture
+// and computes every key.
+void cook_graph_resolve(CookGraph* graph);
+
+// Content-addressed location of a cooked key under the cache root.
+std::filesystem::path cook_cache_path(const std::filesystem::path& cache_root, uint64 key);
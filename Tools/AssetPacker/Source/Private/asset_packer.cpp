@@ -0,0 +1,104 @@
+#include "asset_pack.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void print_usage()
+{
+	std::cout << "usage: AssetPacker <source directory> <output.hpak> [--no-compress] [--store <.ext>]...\n"
+		<< "  --no-compress   store every entry raw\n"
+		<< "  --store <.ext>  store files with this extension raw (already compressed formats)\n";
+}
+
+bool read_file(const fs::path& path, std::vector<char>* bytes)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	const std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	bytes->resize(static_cast<std::size_t>(size));
+	return size == 0 || file.read(bytes->data(), size).good();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		print_usage();
+		return EXIT_FAILURE;
+	}
+
+	const fs::path source_root = argv[1];
+	const char* output_path = argv[2];
+	bool compress = true;
+	std::vector<std::string> stored_extensions = { ".png", ".jpg", ".jpeg", ".ogg" };
+
+	for (int i = 3; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--no-compress") {
+			compress = false;
+		}
+		else if (arg == "--store" && i + 1 < argc) {
+			stored_extensions.emplace_back(argv[++i]);
+		}
+		else {
+			print_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!fs::is_directory(source_root)) {
+		std::cout << "ERROR::ASSET_PACKER::NOT_A_DIRECTORY " << source_root << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Sorted by path so files from the same directory end up adjacent in the pack.
+	std::vector<fs::path> files;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(source_root)) {
+		if (entry.is_regular_file()) {
+			files.push_back(entry.path());
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	AssetPackWriter writer{};
+	std::vector<char> bytes;
+	uint64 total_bytes = 0;
+
+	for (const fs::path& file : files) {
+		if (!read_file(file, &bytes)) {
+			std::cout << "ERROR::ASSET_PACKER::READ_FAILED " << file << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		std::string extension = file.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		const bool store_raw = std::find(stored_extensions.begin(), stored_extensions.end(), extension)
+			!= stored_extensions.end();
+
+		const std::string name = fs::relative(file, source_root).generic_string();
+		asset_pack_writer_add(&writer, name.c_str(), bytes.data(), bytes.size(), compress && !store_raw);
+		total_bytes += bytes.size();
+	}
+
+	if (!asset_pack_writer_finish(&writer, output_path)) {
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "Packed " << files.size() << " files (" << total_bytes << " bytes) into " << output_path
+		<< " (" << fs::file_size(output_path) << " bytes)" << std::endl;
+	return EXIT_SUCCESS;
+}
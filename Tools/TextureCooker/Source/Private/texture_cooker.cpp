@@ -0,0 +1,103 @@
+#include "texture_cook.h"
+#include "job_system.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void print_usage()
+{
+	std::cout << "usage: TextureCooker <source image> <output.htex> [options]\n"
+		<< "  --format <rgba8|bc1|bc3|bc5|bc7>  target format (default bc7)\n"
+		<< "  --linear                        data texture; no sRGB conversion when filtering\n"
+		<< "  --no-mips                       only cook the top level\n"
+		<< "  --box                           box mip filter instead of Kaiser\n"
+		<< "  --force                         cook even when the output is up to date\n";
+}
+
+bool parse_format(const std::string& name, TextureFormat* format)
+{
+	static const struct { const char* name; TextureFormat format; } formats[] = {
+		{ "rgba8", TEXTURE_FORMAT_RGBA8 },
+		{ "bc1", TEXTURE_FORMAT_BC1 },
+		{ "bc3", TEXTURE_FORMAT_BC3 },
+		{ "bc5", TEXTURE_FORMAT_BC5 },
+		{ "bc7", TEXTURE_FORMAT_BC7 }
+	};
+	for (const auto& entry : formats) {
+		if (name == entry.name) {
+			*format = entry.format;
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		print_usage();
+		return EXIT_FAILURE;
+	}
+
+	const char* source_path = argv[1];
+	const char* output_path = argv[2];
+	TextureCookSettings settings{};
+	bool force = false;
+
+	for (int i = 3; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--format" && i + 1 < argc) {
+			if (!parse_format(argv[++i], &settings.format)) {
+				print_usage();
+				return EXIT_FAILURE;
+			}
+		}
+		else if (arg == "--linear") {
+			settings.srgb = false;
+		}
+		else if (arg == "--no-mips") {
+			settings.generate_mips = false;
+		}
+		else if (arg == "--box") {
+			settings.mip_filter = MIP_FILTER_BOX;
+		}
+		else if (arg == "--force") {
+			force = true;
+		}
+		else {
+			print_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (force) {
+		std::remove(output_path);
+	}
+
+	JobSystem jobs{};
+	job_system_init(&jobs, 0);
+
+	const auto start = std::chrono::steady_clock::now();
+	bool cooked = false;
+	const bool success = texture_cook_file(&jobs, source_path, output_path, &settings, &cooked);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	job_system_shutdown(&jobs);
+
+	if (!success) {
+		return EXIT_FAILURE;
+	}
+	if (cooked) {
+		std::cout << "Cooked " << source_path << " -> " << output_path << " in " << seconds << "s" << std::endl;
+	}
+	else {
+		std::cout << output_path << " is up to date" << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
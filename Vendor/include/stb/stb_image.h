@@ -1100,7 +1100,7 @@ static int stbi__mul2shorts_valid(int a, int b)
 
 STBIDEF void stbi_image_free(void* retval_from_stbi_load)
 {
-    
+    STBI_FREE(retval_from_stbi_load);
 }
 
 #ifndef STBI_NO_LINEAR